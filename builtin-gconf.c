@@ -141,6 +141,8 @@ static void gconf_client_notify_free(GConfClientNotify *self);
 static void gconf_client_notify_free_cb(gpointer self);
 static GConfClientNotify *gconf_client_notify_new(const gchar *namespace_section, GConfClientNotifyFunc func, gpointer user_data, GFreeFunc destroy_notify);
 static void gconf_client_notify_change(GConfClient *client, const gchar *namespace_section);
+void gconf_client_batch_begin(GConfClient *client);
+void gconf_client_batch_end(GConfClient *client);
 guint gconf_client_notify_add(GConfClient *client, const gchar *namespace_section, GConfClientNotifyFunc func, gpointer user_data, GFreeFunc destroy_notify, GError **err);
 void gconf_client_notify_remove(GConfClient *client, guint cnxn);
 gboolean gconf_client_set_bool(GConfClient *client, const gchar *key, gboolean val, GError **err);
@@ -1094,6 +1096,7 @@ gconf_entry_init(const char *key, const char *type, const char *data)
 
   self->notify_entered = false;
   self->notify_changed = false;
+  self->generation     = 0;
 
   return self;
 }
@@ -2251,6 +2254,8 @@ static void gconf_client_free_default(void)
     g_slist_free_full(default_client->notify_list,
                       gconf_client_notify_free_cb);
 
+    g_slist_free(default_client->batch_entries);
+
     free(default_client), default_client = 0;
   }
 
@@ -2720,6 +2725,10 @@ gconf_client_notify_change(GConfClient           *client,
     goto EXIT;
   }
 
+  /* stamp the change so that cached / incremental
+   * D-Bus queries can tell what has been modified */
+  entry->generation = ++client->generation;
+
   entry->notify_changed = true;
 
   if( entry->notify_entered )
@@ -2761,7 +2770,18 @@ gconf_client_notify_change(GConfClient           *client,
   entry->notify_entered = false;
 
   /* broadcast change also on dbus */
-  if( broadcast )
+  if( !broadcast )
+  {
+    // nop
+  }
+  else if( client->batch_depth > 0 )
+  {
+    if( !g_slist_find(client->batch_entries, entry) )
+    {
+      client->batch_entries = g_slist_prepend(client->batch_entries, entry);
+    }
+  }
+  else
   {
     mce_dbus_send_config_notification(entry);
   }
@@ -2771,6 +2791,56 @@ EXIT:
   g_clear_error(&err);
 }
 
+/** Start collecting D-Bus change broadcasts
+ *
+ * Internal notifications are dispatched immediately as usual, but
+ * D-Bus signals are held back until the matching
+ * gconf_client_batch_end() call, so that the whole batch can be
+ * broadcast as one after all values have been updated.
+ *
+ * Calls can be nested.
+ */
+void
+gconf_client_batch_begin(GConfClient *client)
+{
+  if( gconf_client_is_valid(client, 0) )
+  {
+    client->batch_depth += 1;
+  }
+}
+
+/** Stop collecting D-Bus change broadcasts
+ *
+ * When the outermost batch ends, changes made during the
+ * batch are broadcast.
+ */
+void
+gconf_client_batch_end(GConfClient *client)
+{
+  if( !gconf_client_is_valid(client, 0) || client->batch_depth == 0 )
+  {
+    goto EXIT;
+  }
+
+  if( --client->batch_depth > 0 )
+  {
+    goto EXIT;
+  }
+
+  GSList *entries = g_slist_reverse(client->batch_entries);
+  client->batch_entries = 0;
+
+  if( entries )
+  {
+    mce_dbus_send_config_batch_notification(entries);
+  }
+
+  g_slist_free(entries);
+
+EXIT:
+  return;
+}
+
 /** See GConf API documentation */
 guint
 gconf_client_notify_add(GConfClient *client,
@@ -109,6 +109,8 @@ typedef struct GConfEntry
   bool notify_entered; // already withing gconf_client_notify_change()
   bool notify_changed; // another round of notifications needed within gconf_client_notify_change()
 
+  unsigned generation; // client generation at the time of the last value change
+
 } GConfEntry;
 
 typedef struct GConfClient
@@ -123,6 +125,11 @@ typedef struct GConfClient
 
   GSList  *notify_list;
 
+  unsigned generation; // incremented whenever any value changes
+
+  unsigned batch_depth;   // nesting level of gconf_client_batch_begin()
+  GSList  *batch_entries; // entries to broadcast at gconf_client_batch_end()
+
 } GConfClient;
 
 typedef enum
@@ -181,6 +188,8 @@ gboolean gconf_client_set_float(GConfClient *client, const gchar *key, double va
 gboolean gconf_client_set_string(GConfClient *client, const gchar *key, const gchar *val, GError **err);
 gboolean gconf_client_set_list(GConfClient *client, const gchar *key, GConfValueType list_type, GSList *list, GError **err);
 void gconf_client_suggest_sync(GConfClient *client, GError **err);
+void gconf_client_batch_begin(GConfClient *client);
+void gconf_client_batch_end(GConfClient *client);
 guint gconf_client_notify_add(GConfClient *client, const gchar *namespace_section, GConfClientNotifyFunc func, gpointer user_data, GFreeFunc destroy_notify, GError **err);
 void gconf_client_notify_remove(GConfClient *client, guint cnxn);
 
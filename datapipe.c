@@ -27,6 +27,8 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-lib.h"
+#include "mce-lagmon.h"
+#include "mce-conf.h"
 #include "evdev.h"
 
 #include <mce/mode-names.h>
@@ -34,6 +36,9 @@
 #include <linux/input.h>
 
 #include <stdio.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
 
 /* ========================================================================= *
  * Macros
@@ -55,6 +60,49 @@
  * Types
  * ========================================================================= */
 
+/** Maximum number of released payload buffers to keep for reuse */
+#define DATAPIPE_PAYLOAD_POOL_MAX 4
+
+/** Datapipe graph edge between datapipe and module / source file */
+typedef struct
+{
+    /** Module or source file name, interned string */
+    const char  *dge_name;
+
+    /** Edge type: "input", "filter", "output" or "exec" */
+    const char  *dge_kind;
+
+    /** Number of callback invocations / datapipe executions */
+    guint        dge_count;
+
+    /** Cumulative time spent [us] */
+    int64_t      dge_time_us;
+} datapipe_edge_t;
+
+/** Placeholder type for aligning struct datapipe values */
+typedef union
+{
+    gint64   dpa_int;
+    gdouble  dpa_double;
+    gpointer dpa_pointer;
+} datapipe_align_t;
+
+/** Refcounted immutable buffer for struct datapipe values */
+typedef struct datapipe_payload_t
+{
+    /** Datapipe the buffer belongs to */
+    datapipe_t                *dpp_owner;
+
+    /** Next buffer in datapipe payload pool */
+    struct datapipe_payload_t *dpp_next;
+
+    /** Number of references held */
+    guint                      dpp_refcount;
+
+    /** Struct value, dp_datasize bytes */
+    datapipe_align_t           dpp_data[];
+} datapipe_payload_t;
+
 struct datapipe_t
 {
     const char           *dp_name;             /**< Name of the datapipe */
@@ -62,16 +110,26 @@ struct datapipe_t
     GSList               *dp_input_triggers;   /**< Triggers called on indata */
     GSList               *dp_output_triggers;  /**< Triggers called on outdata */
     gconstpointer         dp_cached_data;      /**< Latest cached data */
-    gsize                 dp_datasize;         /**< Size of data; NULL == automagic */
+    gsize                 dp_datasize;         /**< Size of struct value; 0 = value is carried in pointer */
+    datapipe_payload_t   *dp_payload_pool;     /**< Released struct value buffers */
+    guint                 dp_payload_pooled;   /**< Number of pooled buffers */
     datapipe_filtering_t  dp_read_only;        /**< Datapipe is read only */
     datapipe_cache_t      dp_cache;
     guint                 dp_gc_id;
     guint                 dp_token;
+    bool                  dp_deferred;         /**< Coalesce executions, latest value wins */
+    guint                 dp_dispatch_id;      /**< Deferred execution idle callback */
+    gconstpointer         dp_pending_data;     /**< Value for deferred execution */
+    const char           *dp_pending_file;     /**< Source file of latest deferred exec */
+    const char           *dp_pending_func;     /**< Function of latest deferred exec */
+    const char           *dp_pending_producer; /**< Graph context of latest deferred exec */
+    GHashTable           *dp_consumers;        /**< Graph edges: [callback] -> datapipe_edge_t */
+    GHashTable           *dp_producers;        /**< Graph edges: [name] -> datapipe_edge_t */
     const char         *(*dp_value_repr_cb)(gconstpointer value);
     const char         *(*dp_change_repr_cb)(gconstpointer prev, gconstpointer curr);
 };
 
-#define DATAPIPE_INIT(NAME_,TYPE_,VALUE_,SIZE_,FILTERING_,CACHING_)\
+#define DATAPIPE_INIT_FULL(NAME_,TYPE_,VALUE_,SIZE_,FILTERING_,CACHING_,DEFERRED_)\
      {\
          .dp_name = #NAME_ "_pipe",\
          .dp_filters = 0,\
@@ -79,14 +137,53 @@ struct datapipe_t
          .dp_output_triggers = 0,\
          .dp_cached_data = GINT_TO_POINTER(VALUE_),\
          .dp_datasize = SIZE_,\
+         .dp_payload_pool = 0,\
+         .dp_payload_pooled = 0,\
          .dp_read_only = FILTERING_,\
          .dp_cache = CACHING_,\
          .dp_gc_id = 0,\
          .dp_token = 0,\
+         .dp_deferred = DEFERRED_,\
+         .dp_dispatch_id = 0,\
+         .dp_pending_data = 0,\
+         .dp_pending_file = 0,\
+         .dp_pending_func = 0,\
+         .dp_pending_producer = 0,\
+         .dp_consumers = 0,\
+         .dp_producers = 0,\
          .dp_value_repr_cb = cat3(datapipe_hook_,TYPE_,_value),\
          .dp_change_repr_cb = cat3(datapipe_hook_,TYPE_,_change),\
      }
 
+#define DATAPIPE_INIT(NAME_,TYPE_,VALUE_,SIZE_,FILTERING_,CACHING_)\
+     DATAPIPE_INIT_FULL(NAME_,TYPE_,VALUE_,SIZE_,FILTERING_,CACHING_,false)
+
+/** Initializer for datapipes where only the latest value matters
+ *
+ * Executing such datapipe updates the cached value immediately, but
+ * triggers are called from idle callback - so that a burst of updates
+ * results in just one round of notifications with the latest value.
+ *
+ * The idle callback uses default priority so that it can not be
+ * starved by other default priority sources. Datapipes whose
+ * producers compare against state updated by the triggers must
+ * not be deferred.
+ *
+ * As filters would be executed only after the delay too, deferred
+ * datapipes must be read only.
+ */
+#define DATAPIPE_INIT_DEFERRED(NAME_,TYPE_,VALUE_,CACHING_)\
+     DATAPIPE_INIT_FULL(NAME_,TYPE_,VALUE_,0,DATAPIPE_FILTERING_DENIED,CACHING_,true)
+
+/** Initializer for datapipes that carry struct values
+ *
+ * Values fed to such datapipe are copied into refcounted buffers,
+ * and triggers get pointers to the copies. The datapipe value is
+ * NULL until something is cached.
+ */
+#define DATAPIPE_INIT_STRUCT(NAME_,TYPE_,CTYPE_,FILTERING_,CACHING_)\
+     DATAPIPE_INIT(NAME_,TYPE_,0,sizeof(CTYPE_),FILTERING_,CACHING_)
+
 /* ========================================================================= *
  * Prototypes
  * ========================================================================= */
@@ -100,7 +197,6 @@ static const char  *datapipe_hook_boolean_value            (gconstpointer data);
 static const char  *datapipe_hook_string_value             (gconstpointer data);
 static const char  *datapipe_hook_impulse_value            (gconstpointer data);
 static const char  *datapipe_hook_input_event_value        (gconstpointer data);
-static const char  *datapipe_hook_input_event_ptr_value    (gconstpointer data);
 static const char  *datapipe_hook_display_state_value      (gconstpointer data);
 static const char  *datapipe_hook_uiexception_type_value   (gconstpointer data);
 static const char  *datapipe_hook_lockkey_state_value      (gconstpointer data);
@@ -127,6 +223,40 @@ static const char  *datapipe_hook_devicelock_state_value   (gconstpointer data);
 static const char  *datapipe_hook_fpstate_value            (gconstpointer data);
 static const char  *datapipe_hook_memnotify_level_value    (gconstpointer data);
 
+/* ------------------------------------------------------------------------- *
+ * DATAPIPE_PAYLOAD
+ * ------------------------------------------------------------------------- */
+
+static datapipe_payload_t *datapipe_payload_header (gconstpointer data);
+static gconstpointer       datapipe_payload_create (datapipe_t *self, gconstpointer data);
+gconstpointer              datapipe_payload_ref    (gconstpointer data);
+void                       datapipe_payload_unref  (gconstpointer data);
+static void                datapipe_payload_flush  (datapipe_t *self);
+
+/* ------------------------------------------------------------------------- *
+ * DATAPIPE_GRAPH
+ * ------------------------------------------------------------------------- */
+
+static datapipe_edge_t *datapipe_edge_create         (const char *name, const char *kind);
+static void             datapipe_edge_delete         (datapipe_edge_t *self);
+static void             datapipe_edge_delete_cb      (void *aptr);
+static gint             datapipe_edge_compare_cb     (gconstpointer a, gconstpointer b);
+static void             datapipe_graph_attach        (datapipe_t *self);
+static void             datapipe_graph_detach        (datapipe_t *self);
+static void             datapipe_graph_add_alias     (const char *file, const char *module);
+static const char      *datapipe_graph_identity      (const char *file);
+static void             datapipe_graph_add_consumer  (datapipe_t *self, gpointer callback, const char *module, const char *kind);
+static void             datapipe_graph_rem_consumer  (datapipe_t *self, gpointer callback);
+static datapipe_edge_t *datapipe_graph_consumer      (const datapipe_t *self, gconstpointer callback);
+static datapipe_edge_t *datapipe_graph_producer      (datapipe_t *self, const char *file);
+static int64_t          datapipe_graph_enter         (const datapipe_edge_t *edge, const char **context);
+static void             datapipe_graph_leave         (datapipe_edge_t *edge, const char *context, int64_t started);
+static GPtrArray       *datapipe_graph_sorted_edges  (GHashTable *lut);
+static bool             datapipe_graph_feeds         (const datapipe_t *from, const datapipe_t *to);
+static void             datapipe_graph_find_cycles   (datapipe_t *pipe, GHashTable *state, GPtrArray *stack, GPtrArray *cycles);
+static void             datapipe_graph_json_string   (GString *out, const char *text);
+gchar                  *mce_datapipe_graph_export    (const char *format);
+
 /* ------------------------------------------------------------------------- *
  * DATAPIPE
  * ------------------------------------------------------------------------- */
@@ -134,10 +264,15 @@ static const char  *datapipe_hook_memnotify_level_value    (gconstpointer data);
 const char       *datapipe_name                 (const datapipe_t *self);
 gconstpointer     datapipe_value                (const datapipe_t *self);
 void              datapipe_set_value            (datapipe_t *self, gconstpointer data);
+static void       datapipe_cache_value          (datapipe_t *self, gconstpointer data, gconstpointer payload);
 static void       datapipe_gc                   (datapipe_t *self);
 static gboolean   datapipe_gc_cb                (gpointer aptr);
 static void       datapipe_schedule_gc          (datapipe_t *self);
 static void       datapipe_cancel_gc            (datapipe_t *self);
+static gconstpointer datapipe_exec_now          (datapipe_t *self, gconstpointer indata, const char *file, const char *func);
+static gconstpointer datapipe_exec_deferred     (datapipe_t *self, gconstpointer indata, const char *file, const char *func);
+static gboolean   datapipe_dispatch_cb          (gpointer aptr);
+static void       datapipe_cancel_dispatch      (datapipe_t *self);
 gconstpointer     datapipe_exec_full_real       (datapipe_t *self, gconstpointer indata, const char *file, const char *func);
 static void       datapipe_add_filter           (datapipe_t *self, gpointer (*filter)(gpointer data));
 static void       datapipe_remove_filter        (datapipe_t *self, gpointer (*filter)(gpointer data));
@@ -153,7 +288,7 @@ static void       datapipe_free                 (datapipe_t *self);
 
 void             mce_datapipe_init               (void);
 void             mce_datapipe_quit               (void);
-static void      mce_datapipe_install_handlers   (datapipe_handler_t *bindings);
+static void      mce_datapipe_install_handlers   (datapipe_handler_t *bindings, const char *module);
 static void      mce_datapipe_remove_handlers    (datapipe_handler_t *bindings);
 static void      mce_datapipe_execute_handlers   (datapipe_handler_t *bindings);
 static gboolean  mce_datapipe_execute_handlers_cb(gpointer aptr);
@@ -381,16 +516,6 @@ datapipe_hook_input_event_value(gconstpointer data)
 }
 #define datapipe_hook_input_event_change 0
 
-static const char *
-datapipe_hook_input_event_ptr_value(gconstpointer data)
-{
-    const struct input_event *const*evp = data;
-    if( !evp )
-        return "NULL event ptr!";
-    return datapipe_hook_input_event_value(*evp);
-}
-#define datapipe_hook_input_event_ptr_change 0
-
 static const char *
 datapipe_hook_display_state_value(gconstpointer data)
 {
@@ -616,7 +741,7 @@ datapipe_t led_pattern_deactivate_pipe          = DATAPIPE_INIT(led_pattern_deac
 datapipe_t resume_detected_event_pipe           = DATAPIPE_INIT(resume_detected_event, impulse, 0, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_NOTHING);
 
 /** Non-synthetized user activity; read only */
-datapipe_t user_activity_event_pipe             = DATAPIPE_INIT(user_activity_event, input_event, 0, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_NOTHING);
+datapipe_t user_activity_event_pipe             = DATAPIPE_INIT_STRUCT(user_activity_event, input_event, struct input_event, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_NOTHING);
 
 /** State of display; read only */
 datapipe_t display_state_curr_pipe              = DATAPIPE_INIT(display_state_curr, display_state, MCE_DISPLAY_UNDEF, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
@@ -641,10 +766,10 @@ datapipe_t display_brightness_pipe              = DATAPIPE_INIT(display_brightne
 datapipe_t key_backlight_brightness_pipe        = DATAPIPE_INIT(key_backlight_brightness, int, 0, 0, DATAPIPE_FILTERING_ALLOWED, DATAPIPE_CACHE_INDATA);
 
 /** A key has been pressed */
-datapipe_t keypress_event_pipe                  = DATAPIPE_INIT(keypress_event, input_event_ptr, 0, sizeof (struct input_event), DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_NOTHING);
+datapipe_t keypress_event_pipe                  = DATAPIPE_INIT_STRUCT(keypress_event, input_event, struct input_event, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_NOTHING);
 
 /** Touchscreen activity took place */
-datapipe_t touchscreen_event_pipe               = DATAPIPE_INIT(touchscreen_event, input_event_ptr, 0, sizeof (struct input_event), DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_NOTHING);
+datapipe_t touchscreen_event_pipe               = DATAPIPE_INIT_STRUCT(touchscreen_event, input_event, struct input_event, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_NOTHING);
 
 /** The lock-key has been pressed; read only */
 datapipe_t lockkey_state_pipe                   = DATAPIPE_INIT(lockkey_state, lockkey_state, KEY_STATE_UNDEF, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
@@ -702,7 +827,7 @@ datapipe_t proximity_sensor_required_pipe       = DATAPIPE_INIT(proximity_sensor
 datapipe_t proximity_blanked_pipe               = DATAPIPE_INIT(proximity_blanked, boolean, false, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
 
 /** Ambient light sensor; read only */
-datapipe_t light_sensor_actual_pipe             = DATAPIPE_INIT(light_sensor_actual, int, 400, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
+datapipe_t light_sensor_actual_pipe             = DATAPIPE_INIT_DEFERRED(light_sensor_actual, int, 400, DATAPIPE_CACHE_DEFAULT);
 
 /** Filtered ambient light level; read only */
 datapipe_t light_sensor_filtered_pipe           = DATAPIPE_INIT(light_sensor_filtered, int, 400, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
@@ -711,7 +836,7 @@ datapipe_t light_sensor_filtered_pipe           = DATAPIPE_INIT(light_sensor_fil
 datapipe_t light_sensor_poll_request_pipe       = DATAPIPE_INIT(light_sensor_poll_request, boolean, false, 0, DATAPIPE_FILTERING_ALLOWED, DATAPIPE_CACHE_DEFAULT);
 
 /** Orientation sensor; read only */
-datapipe_t orientation_sensor_actual_pipe       = DATAPIPE_INIT(orientation_sensor_actual, orientation_state, MCE_ORIENTATION_UNDEFINED, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
+datapipe_t orientation_sensor_actual_pipe       = DATAPIPE_INIT_DEFERRED(orientation_sensor_actual, orientation_state, MCE_ORIENTATION_UNDEFINED, DATAPIPE_CACHE_DEFAULT);
 
 /** The alarm UI state */
 datapipe_t alarm_ui_state_pipe                  = DATAPIPE_INIT(alarm_ui_state, alarm_ui_state, MCE_ALARM_UI_INVALID_INT32, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
@@ -757,7 +882,7 @@ datapipe_t battery_status_pipe                  = DATAPIPE_INIT(battery_status,
 datapipe_t battery_state_pipe                   = DATAPIPE_INIT(battery_state, battery_state, BATTERY_STATE_UNKNOWN, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
 
 /** Battery charge level; read only */
-datapipe_t battery_level_pipe                   = DATAPIPE_INIT(battery_level, int, MCE_BATTERY_LEVEL_UNKNOWN, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
+datapipe_t battery_level_pipe                   = DATAPIPE_INIT_DEFERRED(battery_level, int, MCE_BATTERY_LEVEL_UNKNOWN, DATAPIPE_CACHE_DEFAULT);
 
 /** Topmost window PID; read only */
 datapipe_t topmost_window_pid_pipe              = DATAPIPE_INIT(topmost_window_pid, int, -1, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
@@ -855,6 +980,674 @@ datapipe_t enroll_in_progress_pipe              = DATAPIPE_INIT(enroll_in_progre
 /** Memory pressure level; read only */
 datapipe_t memnotify_level_pipe                 = DATAPIPE_INIT(memnotify_level, memnotify_level, MEMNOTIFY_LEVEL_UNKNOWN, 0, DATAPIPE_FILTERING_DENIED, DATAPIPE_CACHE_DEFAULT);
 
+/* ========================================================================= *
+ * DATAPIPE_PAYLOAD
+ * ========================================================================= */
+
+/** Get payload header from payload data pointer
+ *
+ * @param data Payload data, as returned by datapipe_payload_create()
+ *
+ * @return payload header
+ */
+static datapipe_payload_t *
+datapipe_payload_header(gconstpointer data)
+{
+    return (datapipe_payload_t *)((char *)data -
+                                  offsetof(datapipe_payload_t, dpp_data));
+}
+
+/** Copy struct value into a payload buffer owned by datapipe
+ *
+ * Buffers released via datapipe_payload_unref() are recycled via
+ * datapipe specific pool, so that in steady state passing struct
+ * values through datapipes does not involve heap allocations.
+ *
+ * @param self The datapipe
+ * @param data The struct value to copy
+ *
+ * @return payload data with one reference held by the caller
+ */
+static gconstpointer
+datapipe_payload_create(datapipe_t *self, gconstpointer data)
+{
+    datapipe_payload_t *payload = self->dp_payload_pool;
+
+    if( payload ) {
+        self->dp_payload_pool = payload->dpp_next;
+        self->dp_payload_pooled -= 1;
+    }
+    else {
+        payload = g_malloc(offsetof(datapipe_payload_t, dpp_data) +
+                           self->dp_datasize);
+        payload->dpp_owner = self;
+    }
+
+    payload->dpp_next     = 0;
+    payload->dpp_refcount = 1;
+    memcpy(payload->dpp_data, data, self->dp_datasize);
+
+    return payload->dpp_data;
+}
+
+/** Add a reference to struct datapipe payload
+ *
+ * Values passed to triggers of struct datapipes, and values returned
+ * by datapipe_value() for them, are valid only until the next datapipe
+ * execution. Holding a reference keeps the value valid and unchanged
+ * until a matching datapipe_payload_unref() call.
+ *
+ * @param data Payload data, or NULL
+ *
+ * @return data
+ */
+gconstpointer
+datapipe_payload_ref(gconstpointer data)
+{
+    if( data )
+        datapipe_payload_header(data)->dpp_refcount += 1;
+    return data;
+}
+
+/** Remove a reference from struct datapipe payload
+ *
+ * @param data Payload data, or NULL
+ */
+void
+datapipe_payload_unref(gconstpointer data)
+{
+    datapipe_payload_t *payload = 0;
+
+    if( !data )
+        goto EXIT;
+
+    payload = datapipe_payload_header(data);
+
+    if( --payload->dpp_refcount > 0 )
+        goto EXIT;
+
+    datapipe_t *owner = payload->dpp_owner;
+
+    if( owner->dp_payload_pooled < DATAPIPE_PAYLOAD_POOL_MAX ) {
+        payload->dpp_next = owner->dp_payload_pool;
+        owner->dp_payload_pool = payload;
+        owner->dp_payload_pooled += 1;
+    }
+    else {
+        g_free(payload);
+    }
+
+EXIT:
+    return;
+}
+
+/** Release pooled payload buffers
+ *
+ * @param self The datapipe
+ */
+static void
+datapipe_payload_flush(datapipe_t *self)
+{
+    datapipe_payload_t *payload;
+
+    while( (payload = self->dp_payload_pool) ) {
+        self->dp_payload_pool = payload->dpp_next;
+        g_free(payload);
+    }
+    self->dp_payload_pooled = 0;
+}
+
+/* ========================================================================= *
+ * DATAPIPE_GRAPH
+ * ========================================================================= */
+
+/** Maximum number of dependency cycles to report */
+#define DATAPIPE_GRAPH_CYCLES_MAX 32
+
+/** Flag for: datapipe executions are tracked */
+static bool datapipe_graph_enabled = MCE_DEFAULT_DATAPIPE_TRACK_GRAPH;
+
+/** Datapipes that have bindings or have been executed */
+static GSList *datapipe_graph_pipes = 0;
+
+/** Source file to module name lookup table: [file] -> module */
+static GHashTable *datapipe_graph_aliases = 0;
+
+/** Module whose trigger / filter is currently being executed */
+static const char *datapipe_graph_context = 0;
+
+/** Create datapipe graph edge
+ *
+ * @param name Module or source file name
+ * @param kind Edge type: "input", "filter", "output" or "exec"
+ *
+ * @return edge object
+ */
+static datapipe_edge_t *
+datapipe_edge_create(const char *name, const char *kind)
+{
+    datapipe_edge_t *self = g_malloc0(sizeof *self);
+
+    self->dge_name    = g_intern_string(name);
+    self->dge_kind    = kind;
+    self->dge_count   = 0;
+    self->dge_time_us = 0;
+
+    return self;
+}
+
+/** Delete datapipe graph edge
+ *
+ * @param self edge object, or NULL
+ */
+static void
+datapipe_edge_delete(datapipe_edge_t *self)
+{
+    if( !self )
+        goto EXIT;
+
+    g_free(self);
+
+EXIT:
+    return;
+}
+
+/** GDestroyNotify compatible delete callback
+ *
+ * @param aptr edge object, as void pointer
+ */
+static void
+datapipe_edge_delete_cb(void *aptr)
+{
+    datapipe_edge_delete(aptr);
+}
+
+/** Sort edges to descending cumulative time order
+ *
+ * @param a edge object pointer, as void pointer
+ * @param b edge object pointer, as void pointer
+ */
+static gint
+datapipe_edge_compare_cb(gconstpointer a, gconstpointer b)
+{
+    const datapipe_edge_t *lhs = *(const datapipe_edge_t * const *)a;
+    const datapipe_edge_t *rhs = *(const datapipe_edge_t * const *)b;
+
+    if( lhs->dge_time_us != rhs->dge_time_us )
+        return (lhs->dge_time_us < rhs->dge_time_us) ? 1 : -1;
+
+    return strcmp(lhs->dge_name, rhs->dge_name);
+}
+
+/** Make sure datapipe has graph lookup tables
+ *
+ * @param self The datapipe
+ */
+static void
+datapipe_graph_attach(datapipe_t *self)
+{
+    if( self->dp_consumers )
+        goto EXIT;
+
+    self->dp_consumers = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                               0, datapipe_edge_delete_cb);
+    self->dp_producers = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               0, datapipe_edge_delete_cb);
+
+    datapipe_graph_pipes = g_slist_prepend(datapipe_graph_pipes, self);
+
+EXIT:
+    return;
+}
+
+/** Release datapipe graph lookup tables
+ *
+ * @param self The datapipe
+ */
+static void
+datapipe_graph_detach(datapipe_t *self)
+{
+    if( !self->dp_consumers )
+        goto EXIT;
+
+    datapipe_graph_pipes = g_slist_remove(datapipe_graph_pipes, self);
+
+    g_hash_table_unref(self->dp_consumers), self->dp_consumers = 0;
+    g_hash_table_unref(self->dp_producers), self->dp_producers = 0;
+
+EXIT:
+    return;
+}
+
+/** Register source file as belonging to a module
+ *
+ * Datapipe executions made outside module callbacks are attributed
+ * to the source file of the caller. Mapping files with bindings to
+ * module names keeps producer and consumer identities consistent,
+ * so that dependency cycles are detected.
+ *
+ * @param file   Source file of the module
+ * @param module Name of the module
+ */
+static void
+datapipe_graph_add_alias(const char *file, const char *module)
+{
+    if( !file || !module )
+        goto EXIT;
+
+    if( !datapipe_graph_aliases )
+        datapipe_graph_aliases = g_hash_table_new(g_str_hash, g_str_equal);
+
+    g_hash_table_replace(datapipe_graph_aliases,
+                         (gpointer)g_intern_string(file),
+                         (gpointer)g_intern_string(module));
+
+EXIT:
+    return;
+}
+
+/** Get graph identity of code executing a datapipe
+ *
+ * @param file Source file of the caller
+ *
+ * @return module name if known, otherwise source file name
+ */
+static const char *
+datapipe_graph_identity(const char *file)
+{
+    const char *name = 0;
+
+    if( datapipe_graph_context )
+        name = datapipe_graph_context;
+    else if( file && datapipe_graph_aliases )
+        name = g_hash_table_lookup(datapipe_graph_aliases, file);
+
+    return name ?: file ?: "unknown";
+}
+
+/** Register module callback as datapipe consumer
+ *
+ * @param self     The datapipe
+ * @param callback Trigger or filter function
+ * @param module   Name of the module that owns the callback
+ * @param kind     Edge type: "input", "filter" or "output"
+ */
+static void
+datapipe_graph_add_consumer(datapipe_t *self, gpointer callback,
+                            const char *module, const char *kind)
+{
+    datapipe_graph_attach(self);
+
+    if( !g_hash_table_lookup(self->dp_consumers, callback) ) {
+        g_hash_table_replace(self->dp_consumers, callback,
+                             datapipe_edge_create(module ?: "unknown", kind));
+    }
+}
+
+/** Unregister module callback as datapipe consumer
+ *
+ * Edges are keyed by callback address, which can be reused by
+ * another module after the owning module has been unloaded.
+ *
+ * @param self     The datapipe
+ * @param callback Trigger or filter function
+ */
+static void
+datapipe_graph_rem_consumer(datapipe_t *self, gpointer callback)
+{
+    if( self->dp_consumers )
+        g_hash_table_remove(self->dp_consumers, callback);
+}
+
+/** Lookup consumer edge by callback
+ *
+ * @param self     The datapipe
+ * @param callback Trigger or filter function
+ *
+ * @return edge object, or NULL if not known or tracking is disabled
+ */
+static datapipe_edge_t *
+datapipe_graph_consumer(const datapipe_t *self, gconstpointer callback)
+{
+    datapipe_edge_t *edge = 0;
+
+    if( datapipe_graph_enabled && self->dp_consumers )
+        edge = g_hash_table_lookup(self->dp_consumers, callback);
+
+    return edge;
+}
+
+/** Lookup or create producer edge for datapipe execution
+ *
+ * Executions made from module triggers and from source files that
+ * have module bindings are attributed to the module, others to the
+ * source file making the call.
+ *
+ * @param self The datapipe
+ * @param file Source file of the caller
+ *
+ * @return edge object, or NULL if tracking is disabled
+ */
+static datapipe_edge_t *
+datapipe_graph_producer(datapipe_t *self, const char *file)
+{
+    const char      *name = 0;
+    datapipe_edge_t *edge = 0;
+
+    if( !datapipe_graph_enabled )
+        goto EXIT;
+
+    name = datapipe_graph_identity(file);
+
+    datapipe_graph_attach(self);
+
+    if( !(edge = g_hash_table_lookup(self->dp_producers, name)) ) {
+        edge = datapipe_edge_create(name, "exec");
+        g_hash_table_replace(self->dp_producers, (gpointer)edge->dge_name,
+                             edge);
+    }
+
+EXIT:
+    return edge;
+}
+
+/** Start timing a graph edge
+ *
+ * @param edge    edge object, or NULL
+ * @param context where to store the execution context to restore
+ *
+ * @return start time [us], or 0 if edge is NULL
+ */
+static int64_t
+datapipe_graph_enter(const datapipe_edge_t *edge, const char **context)
+{
+    *context = datapipe_graph_context;
+
+    if( !edge )
+        return 0;
+
+    if( g_strcmp0(edge->dge_kind, "exec") )
+        datapipe_graph_context = edge->dge_name;
+
+    return g_get_monotonic_time();
+}
+
+/** Stop timing a graph edge
+ *
+ * @param edge    edge object, or NULL
+ * @param context execution context to restore
+ * @param started start time from datapipe_graph_enter() [us]
+ */
+static void
+datapipe_graph_leave(datapipe_edge_t *edge, const char *context,
+                     int64_t started)
+{
+    datapipe_graph_context = context;
+
+    if( edge ) {
+        edge->dge_count   += 1;
+        edge->dge_time_us += g_get_monotonic_time() - started;
+    }
+}
+
+/** Get edges of a datapipe in descending cumulative time order
+ *
+ * @param lut Consumer or producer lookup table
+ *
+ * @return array of edge pointers, to be released with g_ptr_array_free()
+ */
+static GPtrArray *
+datapipe_graph_sorted_edges(GHashTable *lut)
+{
+    GPtrArray     *vec = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer       val;
+
+    g_hash_table_iter_init(&iter, lut);
+    while( g_hash_table_iter_next(&iter, 0, &val) )
+        g_ptr_array_add(vec, val);
+
+    g_ptr_array_sort(vec, datapipe_edge_compare_cb);
+
+    return vec;
+}
+
+/** Predicate for: module consuming one datapipe executes another one
+ *
+ * @param from Datapipe with consumer modules
+ * @param to   Datapipe with producers
+ *
+ * @return true if some consumer of from is a producer of to
+ */
+static bool
+datapipe_graph_feeds(const datapipe_t *from, const datapipe_t *to)
+{
+    GHashTableIter iter;
+    gpointer       val;
+
+    g_hash_table_iter_init(&iter, from->dp_consumers);
+    while( g_hash_table_iter_next(&iter, 0, &val) ) {
+        const datapipe_edge_t *edge = val;
+        if( g_hash_table_lookup(to->dp_producers, edge->dge_name) )
+            return true;
+    }
+    return false;
+}
+
+/** Depth first search for datapipe dependency cycles
+ *
+ * @param pipe   Datapipe to visit
+ * @param state  Visit state lookup table: 1 = on stack, 2 = done
+ * @param stack  Datapipes on current search path
+ * @param cycles Where to append cycles, as arrays of datapipe names
+ */
+static void
+datapipe_graph_find_cycles(datapipe_t *pipe, GHashTable *state,
+                           GPtrArray *stack, GPtrArray *cycles)
+{
+    g_hash_table_replace(state, pipe, GINT_TO_POINTER(1));
+    g_ptr_array_add(stack, pipe);
+
+    for( GSList *item = datapipe_graph_pipes; item; item = item->next ) {
+        datapipe_t *next = item->data;
+
+        if( !datapipe_graph_feeds(pipe, next) )
+            continue;
+
+        gpointer mark = g_hash_table_lookup(state, next);
+
+        switch( GPOINTER_TO_INT(mark) ) {
+        case 0:
+            datapipe_graph_find_cycles(next, state, stack, cycles);
+            break;
+
+        case 1:
+            if( cycles->len >= DATAPIPE_GRAPH_CYCLES_MAX )
+                break;
+            {
+                GPtrArray *cycle = g_ptr_array_new();
+                guint      i     = stack->len;
+
+                while( i-- > 0 && g_ptr_array_index(stack, i) != next )
+                    ;
+                for( ; i < stack->len; ++i )
+                    g_ptr_array_add(cycle, g_ptr_array_index(stack, i));
+                g_ptr_array_add(cycles, cycle);
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    g_ptr_array_set_size(stack, stack->len - 1);
+    g_hash_table_replace(state, pipe, GINT_TO_POINTER(2));
+}
+
+/** Append string to JSON output with escaping
+ *
+ * @param out  Output buffer
+ * @param text String to append
+ */
+static void
+datapipe_graph_json_string(GString *out, const char *text)
+{
+    g_string_append_c(out, '"');
+    for( ; *text; ++text ) {
+        if( *text == '"' || *text == '\\' )
+            g_string_append_c(out, '\\');
+        g_string_append_c(out, *text);
+    }
+    g_string_append_c(out, '"');
+}
+
+/** Export live datapipe graph
+ *
+ * Nodes are datapipes, and modules / source files that execute
+ * datapipes or have triggers and filters bound to them. Edges carry
+ * the number of executions and cumulative execution time.
+ *
+ * Dependency cycles, i.e. chains where a module triggered by one
+ * datapipe executes other datapipes that eventually lead back to
+ * the first one, are listed separately.
+ *
+ * @param format "dot" or "json"
+ *
+ * @return graph description to be released with g_free(), or NULL
+ *         if the format is not supported
+ */
+gchar *
+mce_datapipe_graph_export(const char *format)
+{
+    GString    *out    = 0;
+    GHashTable *state  = 0;
+    GPtrArray  *stack  = 0;
+    GPtrArray  *cycles = 0;
+    bool        dot    = !g_strcmp0(format, "dot");
+
+    if( !dot && g_strcmp0(format, "json") )
+        goto EXIT;
+
+    /* Static analysis */
+    state  = g_hash_table_new(g_direct_hash, g_direct_equal);
+    stack  = g_ptr_array_new();
+    cycles = g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
+
+    for( GSList *item = datapipe_graph_pipes; item; item = item->next ) {
+        if( !g_hash_table_lookup(state, item->data) )
+            datapipe_graph_find_cycles(item->data, state, stack, cycles);
+    }
+
+    out = g_string_new(0);
+
+    if( dot )
+        g_string_append(out, "digraph datapipes {\n  rankdir=LR;\n");
+    else
+        g_string_append(out, "{\"datapipes\":[");
+
+    for( GSList *item = datapipe_graph_pipes; item; item = item->next ) {
+        datapipe_t *pipe      = item->data;
+        const char *name      = datapipe_name(pipe);
+        GPtrArray  *producers = datapipe_graph_sorted_edges(pipe->dp_producers);
+        GPtrArray  *consumers = datapipe_graph_sorted_edges(pipe->dp_consumers);
+
+        if( dot ) {
+            g_string_append_printf(out, "  \"%s\" [shape=box,label=\"%s\\nfan-out %u\"];\n",
+                                   name, name, consumers->len);
+        }
+        else {
+            if( item != datapipe_graph_pipes )
+                g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            datapipe_graph_json_string(out, name);
+            g_string_append_printf(out, ",\"fanout\":%u,\"producers\":[",
+                                   consumers->len);
+        }
+
+        for( guint i = 0; i < producers->len; ++i ) {
+            const datapipe_edge_t *edge = g_ptr_array_index(producers, i);
+            if( dot ) {
+                g_string_append_printf(out, "  \"%s\" -> \"%s\" [label=\"%u / %"PRId64" us\"];\n",
+                                       edge->dge_name, name,
+                                       edge->dge_count, edge->dge_time_us);
+                continue;
+            }
+            if( i )
+                g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            datapipe_graph_json_string(out, edge->dge_name);
+            g_string_append_printf(out, ",\"count\":%u,\"time_us\":%"PRId64"}",
+                                   edge->dge_count, edge->dge_time_us);
+        }
+
+        if( !dot )
+            g_string_append(out, "],\"consumers\":[");
+
+        for( guint i = 0; i < consumers->len; ++i ) {
+            const datapipe_edge_t *edge = g_ptr_array_index(consumers, i);
+            if( dot ) {
+                g_string_append_printf(out, "  \"%s\" -> \"%s\" [label=\"%s %u / %"PRId64" us\"%s];\n",
+                                       name, edge->dge_name, edge->dge_kind,
+                                       edge->dge_count, edge->dge_time_us,
+                                       strcmp(edge->dge_kind, "filter") ? "" : ",style=dashed");
+                continue;
+            }
+            if( i )
+                g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            datapipe_graph_json_string(out, edge->dge_name);
+            g_string_append_printf(out, ",\"kind\":\"%s\",\"count\":%u,\"time_us\":%"PRId64"}",
+                                   edge->dge_kind, edge->dge_count,
+                                   edge->dge_time_us);
+        }
+
+        if( !dot )
+            g_string_append(out, "]}");
+
+        g_ptr_array_free(producers, TRUE);
+        g_ptr_array_free(consumers, TRUE);
+    }
+
+    if( !dot )
+        g_string_append(out, "],\"cycles\":[");
+
+    for( guint i = 0; i < cycles->len; ++i ) {
+        GPtrArray *cycle = g_ptr_array_index(cycles, i);
+
+        g_string_append(out, dot ? "  // cycle:" : (i ? ",[" : "["));
+
+        for( guint j = 0; j < cycle->len; ++j ) {
+            const char *name = datapipe_name(g_ptr_array_index(cycle, j));
+            if( dot ) {
+                g_string_append_printf(out, " %s ->", name);
+                continue;
+            }
+            if( j )
+                g_string_append_c(out, ',');
+            datapipe_graph_json_string(out, name);
+        }
+
+        if( dot )
+            g_string_append_printf(out, " %s\n",
+                                   datapipe_name(g_ptr_array_index(cycle, 0)));
+        else
+            g_string_append_c(out, ']');
+    }
+
+    g_string_append(out, dot ? "}\n" : "]}\n");
+
+EXIT:
+    if( cycles )
+        g_ptr_array_free(cycles, TRUE);
+    if( stack )
+        g_ptr_array_free(stack, TRUE);
+    if( state )
+        g_hash_table_unref(state);
+
+    return out ? g_string_free(out, FALSE) : 0;
+}
+
 /* ========================================================================= *
  * Functions
  * ========================================================================= */
@@ -875,6 +1668,9 @@ datapipe_name(const datapipe_t *self)
 }
 
 /** Get value of datapipe
+ *
+ * For struct datapipes the value is a pointer to cached struct,
+ * see datapipe_payload_ref() for lifetime rules.
  *
  * @param self The datapipe
  *
@@ -904,11 +1700,47 @@ datapipe_value(const datapipe_t *self)
  */
 void
 datapipe_set_value(datapipe_t *self, gconstpointer data)
+{
+    datapipe_cache_value(self, data, 0);
+}
+
+/** Update cached value of datapipe
+ *
+ * For struct datapipes the cache holds a reference to payload
+ * buffer. Data that is not the payload of the ongoing datapipe
+ * execution, e.g. something returned by a filter, gets copied.
+ *
+ * @param self    The datapipe
+ * @param data    The value, as void pointer
+ * @param payload Payload of the ongoing execution, or NULL
+ */
+static void
+datapipe_cache_value(datapipe_t *self, gconstpointer data,
+                     gconstpointer payload)
 {
     gconstpointer prev = self->dp_cached_data;
+
+    if( self->dp_datasize && data ) {
+        if( data == payload )
+            datapipe_payload_ref(data);
+        else
+            data = datapipe_payload_create(self, data);
+    }
+
     self->dp_cached_data = data;
 
-    if( prev != data ) {
+    if( self->dp_datasize ) {
+        /* Compare struct values instead of buffer addresses */
+        bool changed = (!prev || !data ||
+                        memcmp(prev, data, self->dp_datasize));
+        if( changed && self->dp_value_repr_cb ) {
+            datapipe_log(self, "%s: %s",
+                         datapipe_name(self),
+                         self->dp_value_repr_cb(data));
+        }
+        datapipe_payload_unref(prev);
+    }
+    else if( prev != data ) {
         if( self->dp_change_repr_cb ) {
             datapipe_log(self, "%s: %s",
                          datapipe_name(self),
@@ -996,6 +1828,9 @@ datapipe_cancel_gc(datapipe_t *self)
  * Note: Use #datapipe_exec_full() macro instead of calling
  *       this function directly.
  *
+ * For datapipes declared with #DATAPIPE_INIT_DEFERRED() the cached
+ * value is updated immediately, but triggers are executed later on.
+ *
  * @param self The datapipe to execute
  * @param indata The input data to run through the datapipe
  * @return The processed data
@@ -1013,6 +1848,129 @@ datapipe_exec_full_real(datapipe_t *self, gconstpointer indata,
         goto EXIT;
     }
 
+    if( self->dp_deferred )
+        outdata = datapipe_exec_deferred(self, indata, file, func);
+    else
+        outdata = datapipe_exec_now(self, indata, file, func);
+
+EXIT:
+    return outdata;
+}
+
+/** Store value for deferred datapipe execution
+ *
+ * The cached value is updated right away, so that datapipe polling
+ * yields the latest value. Triggers are called from idle callback
+ * with whatever value is the latest at that time.
+ *
+ * @param self The datapipe to execute
+ * @param indata The input data to run through the datapipe
+ * @param file Source file of the caller, for logging purposes
+ * @param func Function of the caller, for logging purposes
+ *
+ * @return indata
+ */
+static gconstpointer
+datapipe_exec_deferred(datapipe_t *self, gconstpointer indata,
+                       const char *file, const char *func)
+{
+    gconstpointer prev = self->dp_pending_data;
+
+    if( self->dp_datasize && indata )
+        self->dp_pending_data = datapipe_payload_create(self, indata);
+    else
+        self->dp_pending_data = indata;
+
+    if( self->dp_datasize && self->dp_dispatch_id )
+        datapipe_payload_unref(prev);
+
+    self->dp_pending_file = file;
+    self->dp_pending_func = func;
+    self->dp_pending_producer = datapipe_graph_context;
+
+    if( self->dp_cache & (DATAPIPE_CACHE_INDATA | DATAPIPE_CACHE_OUTDATA) ) {
+        datapipe_cache_value(self, self->dp_pending_data,
+                             self->dp_datasize ? self->dp_pending_data : 0);
+    }
+
+    if( !self->dp_dispatch_id ) {
+        self->dp_dispatch_id = g_idle_add_full(G_PRIORITY_DEFAULT,
+                                               datapipe_dispatch_cb,
+                                               self, 0);
+    }
+
+    return indata;
+}
+
+/** Idle callback for executing deferred datapipe
+ *
+ * @param aptr The datapipe, as void pointer
+ *
+ * @return G_SOURCE_REMOVE
+ */
+static gboolean
+datapipe_dispatch_cb(gpointer aptr)
+{
+    datapipe_t   *self = aptr;
+    gconstpointer data = self->dp_pending_data;
+
+    self->dp_dispatch_id  = 0;
+    self->dp_pending_data = 0;
+
+    /* Attribute to the module that made the latest request */
+    const char *context = datapipe_graph_context;
+    datapipe_graph_context = self->dp_pending_producer;
+
+    datapipe_exec_now(self, data,
+                      self->dp_pending_file,
+                      self->dp_pending_func);
+
+    datapipe_graph_context = context;
+
+    if( self->dp_datasize )
+        datapipe_payload_unref(data);
+
+    return G_SOURCE_REMOVE;
+}
+
+/** Cancel deferred datapipe execution
+ *
+ * @param self The datapipe
+ */
+static void
+datapipe_cancel_dispatch(datapipe_t *self)
+{
+    if( self->dp_dispatch_id ) {
+        g_source_remove(self->dp_dispatch_id),
+            self->dp_dispatch_id = 0;
+
+        if( self->dp_datasize )
+            datapipe_payload_unref(self->dp_pending_data);
+        self->dp_pending_data = 0;
+    }
+}
+
+/** Execute the datapipe synchronously
+ *
+ * @param self The datapipe to execute
+ * @param indata The input data to run through the datapipe
+ * @param file Source file of the caller, for logging purposes
+ * @param func Function of the caller, for logging purposes
+ *
+ * @return The processed data
+ */
+static gconstpointer
+datapipe_exec_now(datapipe_t *self, gconstpointer indata,
+                  const char *file, const char *func)
+{
+    gconstpointer outdata = NULL;
+    gconstpointer payload = NULL;
+    int           lagmon  = -1;
+
+    datapipe_edge_t *producer = datapipe_graph_producer(self, file);
+    const char      *context  = 0;
+    int64_t          started  = datapipe_graph_enter(producer, &context);
+
     if( mce_log_p(LL_DEBUG) ||
         mce_log_p_(LL_DEBUG, file, func) ||
         mce_log_p_(LL_DEBUG, __FILE__, datapipe_name(self)) ) {
@@ -1028,13 +1986,24 @@ datapipe_exec_full_real(datapipe_t *self, gconstpointer indata,
         }
     }
 
+    lagmon = mce_lagmon_enter(MCE_LAGMON_KIND_DATAPIPE, datapipe_name(self));
+
     guint token = ++self->dp_token;
 
     datapipe_cache_t cache_indata = self->dp_cache;
 
+    /* Struct values are passed on as immutable copies, so that
+     * caching does not depend on lifetime of caller data */
+    if( self->dp_datasize && indata )
+        payload = datapipe_payload_create(self, indata);
+
+    gconstpointer calldata = indata;
+    if( payload )
+        indata = payload;
+
     /* Optionally cache the value at the input stage */
     if( cache_indata & (DATAPIPE_CACHE_INDATA | DATAPIPE_CACHE_OUTDATA) ) {
-        datapipe_set_value(self, indata);
+        datapipe_cache_value(self, indata, payload);
     }
 
     /* Execute input value callbacks */
@@ -1049,7 +2018,11 @@ datapipe_exec_full_real(datapipe_t *self, gconstpointer indata,
             goto EXIT;
         }
 
+        datapipe_edge_t *edge = datapipe_graph_consumer(self, trigger);
+        const char      *prev = 0;
+        int64_t          t0   = datapipe_graph_enter(edge, &prev);
         trigger(indata);
+        datapipe_graph_leave(edge, prev, t0);
     }
 
     /* Determine output value */
@@ -1066,12 +2039,16 @@ datapipe_exec_full_real(datapipe_t *self, gconstpointer indata,
                 goto EXIT;
             }
 
+            datapipe_edge_t *edge = datapipe_graph_consumer(self, filter);
+            const char      *prev = 0;
+            int64_t          t0   = datapipe_graph_enter(edge, &prev);
             outdata = filter(outdata);
+            datapipe_graph_leave(edge, prev, t0);
         }
     }
     /* Optionally cache the value at the output stage */
     if( cache_indata & DATAPIPE_CACHE_OUTDATA ) {
-        datapipe_set_value(self, outdata);
+        datapipe_cache_value(self, outdata, payload);
     }
 
     /* Execute output value callbacks */
@@ -1086,10 +2063,25 @@ datapipe_exec_full_real(datapipe_t *self, gconstpointer indata,
             goto EXIT;
         }
 
+        datapipe_edge_t *edge = datapipe_graph_consumer(self, trigger);
+        const char      *prev = 0;
+        int64_t          t0   = datapipe_graph_enter(edge, &prev);
         trigger(outdata);
+        datapipe_graph_leave(edge, prev, t0);
     }
 
 EXIT:
+    mce_lagmon_leave(lagmon);
+
+    datapipe_graph_leave(producer, context, started);
+
+    /* Do not leak payload pointers that might get recycled */
+    if( payload ) {
+        if( outdata == payload )
+            outdata = calldata;
+        datapipe_payload_unref(payload);
+    }
+
     return outdata;
 }
 
@@ -1294,6 +2286,19 @@ datapipe_free(datapipe_t *self)
 
     datapipe_gc(self);
 
+    /* Drop pending deferred execution */
+    datapipe_cancel_dispatch(self);
+
+    /* Release graph statistics */
+    datapipe_graph_detach(self);
+
+    /* Release cached struct value and recycled buffers */
+    if( self->dp_datasize ) {
+        datapipe_payload_unref(self->dp_cached_data);
+        self->dp_cached_data = 0;
+        datapipe_payload_flush(self);
+    }
+
     /* Warn about still registered filters/triggers */
     if (self->dp_filters != NULL) {
         mce_log(LL_INFO,
@@ -1321,9 +2326,12 @@ EXIT:
  */
 void mce_datapipe_init(void)
 {
-    /* Currently all datapipes are initialized statically
-     * and this function exists for the sake of symmetry.
-     */
+    /* Currently all datapipes are initialized statically,
+     * only runtime options need to be set up here. */
+    datapipe_graph_enabled =
+        mce_conf_get_bool(MCE_CONF_DATAPIPE_GROUP,
+                          MCE_CONF_DATAPIPE_TRACK_GRAPH,
+                          MCE_DEFAULT_DATAPIPE_TRACK_GRAPH);
 }
 
 /** Free all datapipes
@@ -1409,6 +2417,9 @@ void mce_datapipe_quit(void)
     datapipe_free(&fpstate_pipe);
     datapipe_free(&enroll_in_progress_pipe);
     datapipe_free(&memnotify_level_pipe);
+
+    if( datapipe_graph_aliases )
+        g_hash_table_unref(datapipe_graph_aliases), datapipe_graph_aliases = 0;
 }
 
 /** Convert submode_t bitmap changes to human readable string
@@ -2250,7 +3261,8 @@ memnotify_level_repr(memnotify_level_t lev)
 }
 
 static void
-mce_datapipe_install_handlers(datapipe_handler_t *bindings)
+mce_datapipe_install_handlers(datapipe_handler_t *bindings,
+                              const char *module)
 {
     if( !bindings )
         goto EXIT;
@@ -2259,17 +3271,29 @@ mce_datapipe_install_handlers(datapipe_handler_t *bindings)
         if( bindings[i].bound )
             continue;
 
-        if( bindings[i].filter_cb )
+        if( bindings[i].filter_cb ) {
             datapipe_add_filter(bindings[i].datapipe,
                                 bindings[i].filter_cb);
+            datapipe_graph_add_consumer(bindings[i].datapipe,
+                                        bindings[i].filter_cb,
+                                        module, "filter");
+        }
 
-        if( bindings[i].input_cb )
+        if( bindings[i].input_cb ) {
             datapipe_add_input_trigger(bindings[i].datapipe,
                                        bindings[i].input_cb);
+            datapipe_graph_add_consumer(bindings[i].datapipe,
+                                        bindings[i].input_cb,
+                                        module, "input");
+        }
 
-        if( bindings[i].output_cb )
+        if( bindings[i].output_cb ) {
             datapipe_add_output_trigger(bindings[i].datapipe,
                                         bindings[i].output_cb);
+            datapipe_graph_add_consumer(bindings[i].datapipe,
+                                        bindings[i].output_cb,
+                                        module, "output");
+        }
         bindings[i].bound = true;
     }
 
@@ -2287,17 +3311,26 @@ mce_datapipe_remove_handlers(datapipe_handler_t *bindings)
         if( !bindings[i].bound )
             continue;
 
-        if( bindings[i].filter_cb )
+        if( bindings[i].filter_cb ) {
             datapipe_remove_filter(bindings[i].datapipe,
                                    bindings[i].filter_cb);
+            datapipe_graph_rem_consumer(bindings[i].datapipe,
+                                        bindings[i].filter_cb);
+        }
 
-        if( bindings[i].input_cb )
+        if( bindings[i].input_cb ) {
             datapipe_remove_input_trigger(bindings[i].datapipe,
                                           bindings[i].input_cb);
+            datapipe_graph_rem_consumer(bindings[i].datapipe,
+                                        bindings[i].input_cb);
+        }
 
-        if( bindings[i].output_cb )
+        if( bindings[i].output_cb ) {
             datapipe_remove_output_trigger(bindings[i].datapipe,
                                            bindings[i].output_cb);
+            datapipe_graph_rem_consumer(bindings[i].datapipe,
+                                        bindings[i].output_cb);
+        }
         bindings[i].bound = false;
     }
 
@@ -2343,13 +3376,20 @@ EXIT:
 }
 
 /** Append triggers/filters to datapipes
+ *
+ * @param self Module bindings
+ * @param file Source file of the module, for graph tracking purposes
  */
-void mce_datapipe_init_bindings(datapipe_bindings_t *self)
+void mce_datapipe_init_bindings_real(datapipe_bindings_t *self,
+                                     const char *file)
 {
     mce_log(LL_INFO, "module=%s", self->module ?: "unknown");
 
+    /* Attribute executions from the module source to the module */
+    datapipe_graph_add_alias(file, self->module);
+
     /* Set up datapipe callbacks */
-    mce_datapipe_install_handlers(self->handlers);
+    mce_datapipe_install_handlers(self->handlers, self->module);
 
     /* Get initial values for output triggers from idle
      * callback, i.e. when all modules have been loaded */
@@ -28,6 +28,17 @@
 # include <stdint.h>
 # include <glib.h>
 
+/* ========================================================================= *
+ * Configuration
+ * ========================================================================= */
+
+/** Configuration group for datapipe settings */
+# define MCE_CONF_DATAPIPE_GROUP          "Datapipe"
+
+/** Whether datapipe executions are tracked for the dependency graph */
+# define MCE_CONF_DATAPIPE_TRACK_GRAPH    "TrackGraph"
+# define MCE_DEFAULT_DATAPIPE_TRACK_GRAPH false
+
 /* ========================================================================= *
  * Types
  * ========================================================================= */
@@ -133,18 +144,30 @@ void            datapipe_set_value(datapipe_t *self, gconstpointer data);
 #define datapipe_exec_full(PIPE_,DATA_)\
    datapipe_exec_full_real(PIPE_,DATA_,__FILE__,__func__)
 
+/* ------------------------------------------------------------------------- *
+ * DATAPIPE_PAYLOAD
+ * ------------------------------------------------------------------------- */
+
+gconstpointer   datapipe_payload_ref  (gconstpointer data);
+void            datapipe_payload_unref(gconstpointer data);
+
 /* ------------------------------------------------------------------------- *
  * MCE_DATAPIPE
  * ------------------------------------------------------------------------- */
 
 void  mce_datapipe_init         (void);
 void  mce_datapipe_quit         (void);
-void  mce_datapipe_init_bindings(datapipe_bindings_t *self);
+void  mce_datapipe_init_bindings_real(datapipe_bindings_t *self, const char *file);
 void  mce_datapipe_quit_bindings(datapipe_bindings_t *self);
 
 void  mce_datapipe_generate_activity   (void);
 void  mce_datapipe_generate_inactivity (void);
 
+gchar *mce_datapipe_graph_export(const char *format);
+
+#define mce_datapipe_init_bindings(BINDINGS_)\
+   mce_datapipe_init_bindings_real(BINDINGS_,__FILE__)
+
 /* ========================================================================= *
  * Macros
  * ========================================================================= */
@@ -57,6 +57,10 @@ typedef enum {
                                     * Nokia N9 kernel driver */
     GESTURE_FPWAKEUP          = 16,
 
+    /* Touchscreen gestures detected in software */
+    GESTURE_TWOFINGER_TAP     = 17,
+    GESTURE_LONGPRESS         = 18,
+
     /* Modifiers */
     GESTURE_SYNTHESIZED       = (1<<8),
 } gesture_t;
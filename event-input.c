@@ -141,6 +141,12 @@ static void         evin_event_mapper_translate_event           (struct input_ev
 static void         evin_event_mapper_init                      (void);
 static void         evin_event_mapper_quit                      (void);
 
+/* ------------------------------------------------------------------------- *
+ * TOUCH_GESTURES  -- configuration for sw touch gesture recognition
+ * ------------------------------------------------------------------------- */
+
+static void         evin_gesture_config_init                    (void);
+
 /* ------------------------------------------------------------------------- *
  * EVDEVBITS
  * ------------------------------------------------------------------------- */
@@ -472,9 +478,9 @@ static void         evin_setting_quit                           (void);
  * DBUS_HOOKS
  * ------------------------------------------------------------------------- */
 
-static void         evin_dbus_send_keypad_input_policy      (DBusMessage *const req);
+static void         evin_dbus_publish_keypad_input_policy   (void);
 static gboolean     evin_dbus_keypad_input_policy_get_req_cb(DBusMessage *const msg);
-static void         evin_dbus_send_touch_input_policy       (DBusMessage *const req);
+static void         evin_dbus_publish_touch_input_policy    (void);
 static gboolean     evin_dbus_touch_input_policy_get_req_cb (DBusMessage *const msg);
 static void         evin_dbus_init                         (void);
 static void         evin_dbus_quit                         (void);
@@ -1002,6 +1008,58 @@ evin_event_mapper_quit(void)
         evin_event_mapper_cnt = 0;
 }
 
+/* ========================================================================= *
+ * TOUCH_GESTURES
+ * ========================================================================= */
+
+/** Tuning for gesture recognition from touch input */
+static mt_config_t evin_gesture_config;
+
+/** Initialize touch gesture recognition tuning from configuration
+ */
+static void
+evin_gesture_config_init(void)
+{
+    static const char grp[] = MCE_CONF_TOUCH_GESTURE_GROUP;
+
+    mt_config_t *config = &evin_gesture_config;
+
+    mt_config_set_defaults(config);
+
+    if( !mce_conf_has_group(grp) )
+        goto EXIT;
+
+    config->mtc_doubletap_enabled =
+        mce_conf_get_bool(grp, "DoubleTap", config->mtc_doubletap_enabled);
+    config->mtc_twofinger_tap_enabled =
+        mce_conf_get_bool(grp, "TwoFingerTap", config->mtc_twofinger_tap_enabled);
+    config->mtc_longpress_enabled =
+        mce_conf_get_bool(grp, "LongPress", config->mtc_longpress_enabled);
+    config->mtc_edge_swipe_enabled =
+        mce_conf_get_bool(grp, "EdgeSwipe", config->mtc_edge_swipe_enabled);
+
+    config->mtc_tap_dist_max =
+        mce_conf_get_int(grp, "TapDistanceMax", config->mtc_tap_dist_max);
+    config->mtc_tap_delay_max =
+        mce_conf_get_int(grp, "TapDelayMax", config->mtc_tap_delay_max);
+    config->mtc_longpress_delay_min =
+        mce_conf_get_int(grp, "LongPressDelayMin", config->mtc_longpress_delay_min);
+    config->mtc_edge_size =
+        mce_conf_get_int(grp, "EdgeSize", config->mtc_edge_size);
+    config->mtc_swipe_dist_min =
+        mce_conf_get_int(grp, "SwipeDistanceMin", config->mtc_swipe_dist_min);
+    config->mtc_swipe_delay_max =
+        mce_conf_get_int(grp, "SwipeDelayMax", config->mtc_swipe_delay_max);
+
+EXIT:
+    mce_log(LL_DEBUG, "gestures: doubletap=%d twofinger_tap=%d "
+            "longpress=%d edge_swipe=%d",
+            config->mtc_doubletap_enabled,
+            config->mtc_twofinger_tap_enabled,
+            config->mtc_longpress_enabled,
+            config->mtc_edge_swipe_enabled);
+}
+
 /* ------------------------------------------------------------------------- *
  * EVDEVBITS
  * ------------------------------------------------------------------------- */
@@ -1990,6 +2048,15 @@ evin_iomon_extra_create(int fd, const char *name)
         bool protocol_b = evin_evdevinfo_has_code(self->ex_info,
                                                   EV_ABS, ABS_MT_SLOT);
         self->ex_mt_state = mt_state_create(protocol_b);
+        mt_state_set_config(self->ex_mt_state, &evin_gesture_config);
+
+        /* Panel size is needed for edge swipe detection */
+        struct input_absinfo abs_x = {}, abs_y = {};
+        if( ioctl(fd, EVIOCGABS(ABS_MT_POSITION_X), &abs_x) == 0 &&
+            ioctl(fd, EVIOCGABS(ABS_MT_POSITION_Y), &abs_y) == 0 ) {
+            mt_state_set_range(self->ex_mt_state,
+                               abs_x.maximum, abs_y.maximum);
+        }
     }
 
     g_free(config);
@@ -2217,12 +2284,12 @@ evin_iomon_touchscreen_cb(mce_io_mon_t *iomon, gpointer data, gsize bytes_read)
 
     bool grabbed = touch_grab_wanted;
 
-    bool doubletap = false;
+    int gesture = MT_GESTURE_NONE;
 
     evin_iomon_extra_t *extra = mce_io_mon_get_user_data(iomon);
     if( extra && extra->ex_mt_state ) {
         bool touching_prev = mt_state_touching(extra->ex_mt_state);
-        doubletap = mt_state_handle_event(extra->ex_mt_state, ev);
+        gesture = mt_state_handle_event(extra->ex_mt_state, ev);
         bool touching_curr = mt_state_touching(extra->ex_mt_state);
 
         if( touching_prev != touching_curr )
@@ -2230,12 +2297,14 @@ evin_iomon_touchscreen_cb(mce_io_mon_t *iomon, gpointer data, gsize bytes_read)
     }
 
 #ifdef ENABLE_DOUBLETAP_EMULATION
-    if( doubletap && evin_iomon_sw_gestures_allowed() ) {
-        mce_log(LL_DEVEL, "[doubletap] emulated from touch input");
+    if( gesture != MT_GESTURE_NONE && evin_iomon_sw_gestures_allowed() ) {
+        mce_log(LL_DEVEL, "[gesture %d] emulated from touch input", gesture);
         ev->type  = EV_MSC;
         ev->code  = MSC_GESTURE;
-        ev->value = GESTURE_DOUBLETAP | GESTURE_SYNTHESIZED;
+        ev->value = gesture | GESTURE_SYNTHESIZED;
     }
+#else
+    (void)gesture;
 #endif
 
     /* Power key up event from touch screen -> double tap gesture event */
@@ -2274,12 +2343,12 @@ evin_iomon_touchscreen_cb(mce_io_mon_t *iomon, gpointer data, gsize bytes_read)
         evin_iomon_generate_activity(ev, false, true);
 
         /* But otherwise are handled in powerkey.c. */
-        datapipe_exec_full(&keypress_event_pipe, &ev);
+        datapipe_exec_full(&keypress_event_pipe, ev);
     }
     else if( (ev->type == EV_ABS && ev->code == ABS_PRESSURE) ||
              (ev->type == EV_KEY && ev->code == BTN_TOUCH ) ) {
         /* Only send pressure events */
-        datapipe_exec_full(&touchscreen_event_pipe, &ev);
+        datapipe_exec_full(&touchscreen_event_pipe, ev);
     }
 
 EXIT:
@@ -2425,7 +2494,7 @@ evin_iomon_keypress_cb(mce_io_mon_t *iomon, gpointer data, gsize bytes_read)
              ((((submode & MCE_SUBMODE_EVEATER) == 0) &&
                (ev->value == 1)) || (ev->value == 0))) &&
             ((submode & MCE_SUBMODE_PROXIMITY_TKLOCK) == 0)) {
-            datapipe_exec_full(&keypress_event_pipe, &ev);
+            datapipe_exec_full(&keypress_event_pipe, ev);
         }
     }
 
@@ -3642,7 +3711,7 @@ evin_ts_policy_changed(evin_input_grab_t *ctrl)
 {
     (void)ctrl;
     evin_ts_grab_rethink_led();
-    evin_dbus_send_touch_input_policy(0);
+    evin_dbus_publish_touch_input_policy();
 }
 
 enum
@@ -3861,7 +3930,7 @@ static void
 evin_kp_policy_changed(evin_input_grab_t *ctrl)
 {
     (void)ctrl;
-    evin_dbus_send_keypad_input_policy(0);
+    evin_dbus_publish_keypad_input_policy();
 }
 
 /** State data for volumekey input grab state machine */
@@ -4018,38 +4087,19 @@ static void evin_setting_quit(void)
  * DBUS_HOOKS
  * ========================================================================= */
 
-/** Send the keypad input policy
+/** Publish the keypad input policy
  *
- * @param req A method call message to be replied, or
- *            NULL to broadcast a keypad input policy signal
+ * The value is cached for replying to policy queries, and
+ * a signal is broadcast if it differs from the last one sent.
  */
 static void
-evin_dbus_send_keypad_input_policy(DBusMessage *const req)
+evin_dbus_publish_keypad_input_policy(void)
 {
-    DBusMessage *rsp = 0;
-
-    if( req )
-        rsp = dbus_new_method_reply(req);
-    else
-        rsp = dbus_new_signal(MCE_SIGNAL_PATH, MCE_SIGNAL_IF,
-                              MCE_VOLKEY_INPUT_POLICY_SIG);
-    if( !rsp )
-        goto EXIT;
-
     const char *arg = evin_state_to_dbus(evin_kp_grab_state.ig_state);
 
-    mce_log(LL_DEBUG, "send keypad input policy %s: %s",
-            req ? "reply" : "signal", arg);
-
-    if( !dbus_message_append_args(rsp,
-                                  DBUS_TYPE_STRING, &arg,
-                                  DBUS_TYPE_INVALID) )
-        goto EXIT;
-
-    dbus_send_message(rsp), rsp = 0;
-
-EXIT:
-    if( rsp ) dbus_message_unref(rsp);
+    if( mce_dbus_property_publish(MCE_VOLKEY_INPUT_POLICY_SIG,
+                                  DBUS_TYPE_STRING, &arg) )
+        mce_log(LL_DEBUG, "send keypad input policy signal: %s", arg);
 }
 
 /** D-Bus callback for the get keypad input policy method call
@@ -4064,43 +4114,22 @@ evin_dbus_keypad_input_policy_get_req_cb(DBusMessage *const msg)
     mce_log(LL_DEVEL, "Received keypad input policy get request from %s",
             mce_dbus_get_message_sender_ident(msg));
 
-    evin_dbus_send_keypad_input_policy(msg);
-
-    return TRUE;
+    return mce_dbus_property_reply(msg, MCE_VOLKEY_INPUT_POLICY_SIG);
 }
 
-/** Send the touch input policy
+/** Publish the touch input policy
  *
- * @param req A method call message to be replied, or
- *            NULL to broadcast a touch input policy signal
+ * The value is cached for replying to policy queries, and
+ * a signal is broadcast if it differs from the last one sent.
  */
 static void
-evin_dbus_send_touch_input_policy(DBusMessage *const req)
+evin_dbus_publish_touch_input_policy(void)
 {
-    DBusMessage *rsp = 0;
-
-    if( req )
-        rsp = dbus_new_method_reply(req);
-    else
-        rsp = dbus_new_signal(MCE_SIGNAL_PATH, MCE_SIGNAL_IF,
-                              MCE_TOUCH_INPUT_POLICY_SIG);
-    if( !rsp )
-        goto EXIT;
-
     const char *arg = evin_state_to_dbus(evin_ts_grab_state.ig_state);
 
-    mce_log(LL_DEBUG, "send touch input policy %s: %s",
-            req ? "reply" : "signal", arg);
-
-    if( !dbus_message_append_args(rsp,
-                                  DBUS_TYPE_STRING, &arg,
-                                  DBUS_TYPE_INVALID) )
-        goto EXIT;
-
-    dbus_send_message(rsp), rsp = 0;
-
-EXIT:
-    if( rsp ) dbus_message_unref(rsp);
+    if( mce_dbus_property_publish(MCE_TOUCH_INPUT_POLICY_SIG,
+                                  DBUS_TYPE_STRING, &arg) )
+        mce_log(LL_DEBUG, "send touch input policy signal: %s", arg);
 }
 
 /** D-Bus callback for the get touch input policy method call
@@ -4112,12 +4141,10 @@ EXIT:
 static gboolean
 evin_dbus_touch_input_policy_get_req_cb(DBusMessage *const msg)
 {
-    mce_log(LL_DEVEL, "Received keypad input policy get request from %s",
+    mce_log(LL_DEVEL, "Received touch input policy get request from %s",
             mce_dbus_get_message_sender_ident(msg));
 
-    evin_dbus_send_touch_input_policy(msg);
-
-    return TRUE;
+    return mce_dbus_property_reply(msg, MCE_TOUCH_INPUT_POLICY_SIG);
 }
 
 /** Array of dbus message handlers */
@@ -4166,6 +4193,10 @@ static mce_dbus_handler_t evin_dbus_handlers[] =
 static void evin_dbus_init(void)
 {
     mce_dbus_handler_register_array(evin_dbus_handlers);
+
+    /* Have values available for policy queries */
+    evin_dbus_publish_keypad_input_policy();
+    evin_dbus_publish_touch_input_policy();
 }
 
 /** Remove dbus handlers
@@ -4402,6 +4433,8 @@ mce_input_init(void)
 
     evin_event_mapper_init();
 
+    evin_gesture_config_init();
+
     evin_dbus_init();
 
     evin_ts_grab_init();
@@ -71,6 +71,15 @@
  */
 #define MCE_CONF_EVDEV_TYPE_GROUP       "EVDEV_TYPE"
 
+/** Name of the touch gesture configuration group
+ *
+ * This configuration group can be used to enable and tune gestures
+ * that mce detects from touch input in software while display is off.
+ *
+ * See inifiles/evdev.ini for details and examples.
+ */
+#define MCE_CONF_TOUCH_GESTURE_GROUP    "TouchGestures"
+
 /* ========================================================================= *
  * Settings
  * ========================================================================= */
@@ -347,6 +347,9 @@ common_on_proximity_quit(void)
  * DBUS_FUNCTIONS
  * ========================================================================= */
 
+/** Minimum time between non-escalating memory level signals [ms] */
+#define COMMON_MEMNOTIFY_SIGNAL_INTERVAL 1000
+
 /* ------------------------------------------------------------------------- *
  * usb_cable_state
  * ------------------------------------------------------------------------- */
@@ -386,7 +389,10 @@ common_dbus_send_usb_cable_state(DBusMessage *const req)
             req ? "reply" : "broadcast",
             "usb_cable_state", value);
 
-    dbus_send_message(msg), msg = 0;
+    if( req )
+        dbus_send_message(msg), msg = 0;
+    else
+        dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
 
 EXIT:
 
@@ -449,7 +455,10 @@ common_dbus_send_charger_type(DBusMessage *const req)
             req ? "reply" : "broadcast",
             "charger_type", value);
 
-    dbus_send_message(msg), msg = 0;
+    if( req )
+        dbus_send_message(msg), msg = 0;
+    else
+        dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
 
 EXIT:
 
@@ -512,7 +521,10 @@ common_dbus_send_charger_state(DBusMessage *const req)
             req ? "reply" : "broadcast",
             "charger_state", value);
 
-    dbus_send_message(msg), msg = 0;
+    if( req )
+        dbus_send_message(msg), msg = 0;
+    else
+        dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
 
 EXIT:
 
@@ -575,7 +587,10 @@ common_dbus_send_battery_status(DBusMessage *const req)
             req ? "reply" : "broadcast",
             "battery_status", value);
 
-    dbus_send_message(msg), msg = 0;
+    if( req )
+        dbus_send_message(msg), msg = 0;
+    else
+        dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
 
 EXIT:
 
@@ -638,7 +653,10 @@ common_dbus_send_battery_state(DBusMessage *const req)
             req ? "reply" : "broadcast",
             "battery_state", value);
 
-    dbus_send_message(msg), msg = 0;
+    if( req )
+        dbus_send_message(msg), msg = 0;
+    else
+        dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
 
 EXIT:
 
@@ -707,7 +725,10 @@ common_dbus_send_battery_level(DBusMessage *const req)
             req ? "reply" : "broadcast",
             "battery_level", value);
 
-    dbus_send_message(msg), msg = 0;
+    if( req )
+        dbus_send_message(msg), msg = 0;
+    else
+        dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
 
 EXIT:
 
@@ -744,12 +765,28 @@ common_dbus_send_memnotify_level(void)
     static memnotify_level_t last = MEMNOTIFY_LEVEL_COUNT;
 
     if( last != memnotify_level ) {
+        /* Memory level can flap near thresholds; rate limit repeats
+         * and de-escalations, but let escalations through without
+         * delay so that clients can start releasing memory asap */
+        bool escalate = (memnotify_level == MEMNOTIFY_LEVEL_WARNING ||
+                         memnotify_level == MEMNOTIFY_LEVEL_CRITICAL) &&
+                        (last > MEMNOTIFY_LEVEL_CRITICAL ||
+                         last < memnotify_level);
+        int interval = escalate ? 0 : COMMON_MEMNOTIFY_SIGNAL_INTERVAL;
+
         last = memnotify_level;
         const char *sig = MCE_MEMORY_LEVEL_SIG;
         const char *arg = memnotify_level_repr(memnotify_level);
         mce_log(LL_DEVEL, "sending dbus signal: %s %s", sig, arg);
-        dbus_send(0, MCE_SIGNAL_PATH, MCE_SIGNAL_IF, sig, 0,
-                  DBUS_TYPE_STRING, &arg, DBUS_TYPE_INVALID);
+
+        DBusMessage *msg = dbus_new_signal(MCE_SIGNAL_PATH,
+                                           MCE_SIGNAL_IF, sig);
+        if( dbus_message_append_args(msg,
+                                     DBUS_TYPE_STRING, &arg,
+                                     DBUS_TYPE_INVALID) )
+            dbus_send_signal_coalesced(msg, 0, interval);
+        else
+            dbus_message_unref(msg);
     }
 }
 
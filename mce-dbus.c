@@ -29,6 +29,7 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-lib.h"
+#include "mce-lagmon.h"
 #include "mce-wakelock.h"
 
 #include "systemui/dbus-names.h"
@@ -329,6 +330,7 @@ DBusMessage             *dbus_new_signal                       (const gchar *con
 static DBusMessage      *dbus_new_error                        (DBusMessage *req, const char *err, const char *fmt, ...);
 DBusMessage             *dbus_new_method_call                  (const gchar *const service, const gchar *const path, const gchar *const interface, const gchar *const name);
 DBusMessage             *dbus_new_method_reply                 (DBusMessage *const message);
+static gboolean          dbus_send_message_now                 (DBusMessage *const msg);
 gboolean                 dbus_send_message                     (DBusMessage *const msg);
 static gboolean          dbus_send_message_with_reply_handler  (DBusMessage *const msg, DBusPendingCallNotifyFunction callback, int timeout, void *user_data, DBusFreeFunction user_free, DBusPendingCall **ppc);
 static gboolean          dbus_send_va                          (const char *service, const char *path, const char *interface, const char *name, DBusPendingCallNotifyFunction callback, int timeout, void *user_data, DBusFreeFunction user_free, DBusPendingCall **ppc, int first_arg_type, va_list va);
@@ -336,18 +338,66 @@ gboolean                 dbus_send_ex                          (const char *serv
 gboolean                 dbus_send_ex2                         (const char *service, const char *path, const char *interface, const char *name, DBusPendingCallNotifyFunction callback, int timeout, void *user_data, DBusFreeFunction user_free, DBusPendingCall **ppc, int first_arg_type, ...);
 gboolean                 dbus_send                             (const gchar *const service, const gchar *const path, const gchar *const interface, const gchar *const name, DBusPendingCallNotifyFunction callback, int first_arg_type, ...);
 
+/* ------------------------------------------------------------------------- *
+ * SIGNAL_COALESCING
+ * ------------------------------------------------------------------------- */
+
+typedef struct sigslot_t sigslot_t;
+
+static sigslot_t        *sigslot_create                        (const char *key);
+static void              sigslot_delete                        (sigslot_t *self);
+static void              sigslot_delete_cb                     (void *self);
+static void              sigslot_cancel                        (sigslot_t *self);
+static void              sigslot_emit                          (sigslot_t *self);
+static gboolean          sigslot_timer_cb                      (gpointer aptr);
+static gboolean          sigslot_flush_cb                      (gpointer aptr);
+static void              sigslot_flush                         (void);
+gboolean                 dbus_send_signal_coalesced            (DBusMessage *const msg, const char *tag, int min_interval);
+static void              sigslot_quit                          (void);
+
+/* ------------------------------------------------------------------------- *
+ * PROPERTY_CACHE
+ * ------------------------------------------------------------------------- */
+
+typedef struct dbusprop_t dbusprop_t;
+
+static bool              dbusprop_type_is_string               (int type);
+static size_t            dbusprop_type_size                    (int type);
+static dbusprop_t       *dbusprop_create                       (const char *name, int type);
+static void              dbusprop_delete                       (dbusprop_t *self);
+static void              dbusprop_delete_cb                    (void *self);
+static bool              dbusprop_set_value                    (dbusprop_t *self, const void *value);
+static gboolean          dbusprop_flush_cb                     (gpointer aptr);
+static void              dbusprop_flush                        (void);
+gboolean                 mce_dbus_property_publish             (const char *name, int type, const void *value);
+gboolean                 mce_dbus_property_reply               (DBusMessage *const req, const char *name);
+static void              dbusprop_quit                         (void);
+
 /* ------------------------------------------------------------------------- *
  * METHOD_CALL_HANDLERS
  * ------------------------------------------------------------------------- */
 
 static gboolean          version_get_dbus_cb                   (DBusMessage *const msg);
 static gboolean          suspend_stats_get_dbus_cb             (DBusMessage *const req);
+static void              wakeup_report_collect_cb              (const char *tag, unsigned wakes, unsigned holds, int64_t held_ms, void *aptr);
+static gint              wakeup_report_compare_cb              (gconstpointer a, gconstpointer b);
+static gboolean          wakeup_report_get_dbus_cb             (DBusMessage *const req);
+static gboolean          datapipe_graph_get_dbus_cb            (DBusMessage *const req);
 static gboolean          verbosity_get_dbus_cb                 (DBusMessage *const req);
 static gboolean          config_get_dbus_cb                    (DBusMessage *const msg);
 static gboolean          verbosity_set_dbus_cb                 (DBusMessage *const req);
+static DBusMessage      *config_get_all_cached_reply           (DBusMessage *const req, GConfClient *cli);
+static void              config_get_all_cache_flush            (void);
 static gboolean          config_get_all_dbus_cb                (DBusMessage *const req);
+static gboolean          config_get_changes_dbus_cb            (DBusMessage *const req);
 static gboolean          config_reset_dbus_cb                  (DBusMessage *const msg);
+static GConfValueType    config_type_from_dbus_type            (int type);
+static const char       *config_check_value_from_iter          (GConfClient *client, const char *key, DBusMessageIter *iter);
+static const char       *config_set_value_from_iter            (GConfClient *client, const char *key, DBusMessageIter *iter, GError **err);
+static void              config_restore_value                  (GConfClient *client, const char *key, const GConfValue *value);
 static gboolean          config_set_dbus_cb                    (DBusMessage *const msg);
+static gboolean          config_set_batch_dbus_cb              (DBusMessage *const msg);
+static gboolean          config_get_batch_dbus_cb              (DBusMessage *const req);
 static gboolean          introspect_dbus_cb                    (DBusMessage *const req);
 
 /* ------------------------------------------------------------------------- *
@@ -365,6 +415,7 @@ static bool              append_gconf_entry_to_dbus_iterator   (DBusMessageIter
 static bool              append_gconf_entries_to_dbus_iterator (DBusMessageIter *iter, GSList *entries);
 static bool              append_gconf_value_to_dbus_message    (DBusMessage *reply, GConfValue *conf);
 void                     mce_dbus_send_config_notification     (GConfEntry *entry);
+void                     mce_dbus_send_config_batch_notification(GSList *entries);
 static void              value_list_free                       (GSList *list);
 static GSList           *value_list_from_string_array          (DBusMessageIter *iter);
 static GSList           *value_list_from_int_array             (DBusMessageIter *iter);
@@ -2449,13 +2500,13 @@ DBusMessage *dbus_new_method_reply(DBusMessage *const message)
 }
 
 /**
- * Send a D-Bus message
+ * Send a D-Bus message without flushing coalesced signals
  * Side-effects: frees msg
  *
  * @param msg The D-Bus message to send
  * @return TRUE on success, FALSE on out of memory
  */
-gboolean dbus_send_message(DBusMessage *const msg)
+static gboolean dbus_send_message_now(DBusMessage *const msg)
 {
 	gboolean status = FALSE;
 
@@ -2475,6 +2526,23 @@ EXIT:
 	return status;
 }
 
+/**
+ * Send a D-Bus message
+ * Side-effects: frees msg
+ *
+ * Signals queued via dbus_send_signal_coalesced() are sent first,
+ * so that clients see messages in the order they were posted.
+ *
+ * @param msg The D-Bus message to send
+ * @return TRUE on success, FALSE on out of memory
+ */
+gboolean dbus_send_message(DBusMessage *const msg)
+{
+	sigslot_flush();
+
+	return dbus_send_message_now(msg);
+}
+
 /**
  * Send a D-Bus message and setup a reply callback
  * Side-effects: frees msg
@@ -2499,6 +2567,9 @@ dbus_send_message_with_reply_handler(DBusMessage *const msg,
 	if( !msg )
 		goto EXIT;
 
+	/* Keep ordering with respect to queued coalesced signals */
+	sigslot_flush();
+
 	if( !dbus_connection_send_with_reply(dbus_connection, msg, &pc,
 					     timeout) ) {
 		mce_log(LL_CRIT, "Out of memory when sending D-Bus message");
@@ -2726,216 +2797,1126 @@ gboolean dbus_send(const gchar *const service, const gchar *const path,
 }
 
 /* ========================================================================= *
- * METHOD_CALL_HANDLERS
+ * SIGNAL_COALESCING
  * ========================================================================= */
 
-/**
- * D-Bus callback for the version get method call
+/** Broadcast signal slot for deduplicating and coalescing emissions */
+struct sigslot_t
+{
+	/** Lookup key: path, interface, member and optional tag */
+	gchar       *ss_key;
+
+	/** Signal waiting to be sent, or NULL */
+	DBusMessage *ss_pending;
+
+	/** Content representation of the pending signal */
+	char        *ss_pending_repr;
+
+	/** Content representation of the last sent signal, or NULL */
+	char        *ss_last_repr;
+
+	/** Monotonic time of the last emission [ms] */
+	int64_t      ss_last_tick;
+
+	/** Minimum time between emissions [ms] */
+	int          ss_min_interval;
+
+	/** Timer id for delayed emission */
+	guint        ss_timer_id;
+
+	/** Flag for: slot is in sigslot_queue */
+	bool         ss_queued;
+
+	/** Number of signals sent */
+	guint        ss_sent;
+
+	/** Number of signals dropped as duplicates */
+	guint        ss_dropped;
+
+	/** Number of signals superseded before sending */
+	guint        ss_superseded;
+};
+
+/** Lookup table for signal slots: key -> sigslot_t */
+static GHashTable *sigslot_lut = 0;
+
+/** Slots with pending signals, in posting order */
+static GQueue sigslot_queue = G_QUEUE_INIT;
+
+/** Idle callback id for flushing queued signals */
+static guint sigslot_flush_id = 0;
+
+/** Create signal slot
  *
- * @param msg The D-Bus message to reply to
- * @return TRUE on success, FALSE on failure
+ * @param key  slot lookup key
+ *
+ * @return signal slot object
  */
-static gboolean version_get_dbus_cb(DBusMessage *const msg)
+static sigslot_t *
+sigslot_create(const char *key)
 {
-	static const gchar *const versionstring = G_STRINGIFY(PRG_VERSION);
-	DBusMessage *reply = NULL;
-	gboolean status = FALSE;
+	sigslot_t *self = g_malloc0(sizeof *self);
 
-	mce_log(LL_DEBUG, "Received version information request");
+	self->ss_key          = g_strdup(key);
+	self->ss_pending      = 0;
+	self->ss_pending_repr = 0;
+	self->ss_last_repr    = 0;
+	self->ss_last_tick    = 0;
+	self->ss_min_interval = 0;
+	self->ss_timer_id     = 0;
+	self->ss_queued       = false;
 
-	/* Create a reply */
-	reply = dbus_new_method_reply(msg);
+	return self;
+}
 
-	/* Append the version information */
-	if (dbus_message_append_args(reply,
-				     DBUS_TYPE_STRING, &versionstring,
-				     DBUS_TYPE_INVALID) == FALSE) {
-		mce_log(LL_CRIT,
-			"Failed to append reply argument to D-Bus message "
-			"for %s.%s",
-			MCE_REQUEST_IF, MCE_VERSION_GET);
-		dbus_message_unref(reply);
+/** Delete signal slot
+ *
+ * @param self  signal slot object, or NULL
+ */
+static void
+sigslot_delete(sigslot_t *self)
+{
+	if( !self )
 		goto EXIT;
-	}
 
-	/* Send the message */
-	status = dbus_send_message(reply);
+	mce_log(LL_DEBUG, "%s: sent=%u dropped=%u superseded=%u",
+		self->ss_key, self->ss_sent, self->ss_dropped,
+		self->ss_superseded);
+
+	sigslot_cancel(self);
+
+	if( self->ss_timer_id )
+		g_source_remove(self->ss_timer_id), self->ss_timer_id = 0;
+
+	free(self->ss_last_repr);
+	g_free(self->ss_key);
+	g_free(self);
 
 EXIT:
-	return status;
+	return;
 }
 
-/** D-Bus callback for the get suspend time statistics method call
+/** Type agnostic callback for deleting signal slots
  *
- * @param req The D-Bus message to reply to
+ * @param self  signal slot object, or NULL
+ */
+static void
+sigslot_delete_cb(void *self)
+{
+	sigslot_delete(self);
+}
+
+/** Drop pending signal from slot
  *
- * @return TRUE
+ * @param self  signal slot object
  */
-static gboolean suspend_stats_get_dbus_cb(DBusMessage *const req)
+static void
+sigslot_cancel(sigslot_t *self)
 {
-	DBusMessage *rsp = 0;
+	if( self->ss_pending )
+		dbus_message_unref(self->ss_pending), self->ss_pending = 0;
 
-	mce_log(LL_DEVEL, "suspend info request from %s",
-		mce_dbus_get_message_sender_ident(req));
+	free(self->ss_pending_repr), self->ss_pending_repr = 0;
 
-	/* Get time values - in an order that is less
-	 * likely to produce negative values on subtract.
-	 */
-	dbus_int64_t active_ms  = mce_lib_get_mono_tick();
-	dbus_int64_t uptime_ms  = mce_lib_get_boot_tick();
-	dbus_int64_t suspend_ms = uptime_ms - active_ms;
+	if( self->ss_queued ) {
+		g_queue_remove(&sigslot_queue, self);
+		self->ss_queued = false;
+	}
+}
 
-	/* create and send reply message */
-	rsp = dbus_new_method_reply(req);
+/** Send pending signal from slot
+ *
+ * @param self  signal slot object
+ */
+static void
+sigslot_emit(sigslot_t *self)
+{
+	if( self->ss_queued ) {
+		g_queue_remove(&sigslot_queue, self);
+		self->ss_queued = false;
+	}
 
-	if( !dbus_message_append_args(rsp,
-				      DBUS_TYPE_INT64, &uptime_ms,
-				      DBUS_TYPE_INT64, &suspend_ms,
-				      DBUS_TYPE_INVALID) ) {
-		mce_log(LL_ERR, "Failed to append arguments");
+	if( !self->ss_pending )
 		goto EXIT;
-	}
 
-	dbus_send_message(rsp), rsp = 0;
+	dbus_send_message_now(self->ss_pending), self->ss_pending = 0;
 
-EXIT:
-	if( rsp )
-		dbus_message_unref(rsp);
+	free(self->ss_last_repr);
+	self->ss_last_repr = self->ss_pending_repr, self->ss_pending_repr = 0;
+	self->ss_last_tick = mce_lib_get_mono_tick();
+	self->ss_sent += 1;
 
-	return TRUE;
+EXIT:
+	return;
 }
 
-/** D-Bus callback for: get mce verbosity method call
+/** Timer callback for emitting rate limited signal
  *
- * @param req The D-Bus message to reply to
+ * @param aptr  signal slot object (as void pointer)
  *
- * @return TRUE
+ * @return FALSE to stop the timer from repeating
  */
-static gboolean verbosity_get_dbus_cb(DBusMessage *const req)
+static gboolean
+sigslot_timer_cb(gpointer aptr)
 {
-	DBusMessage *rsp = 0;
+	sigslot_t *self = aptr;
 
-	mce_log(LL_DEVEL, "verbosity get from %s",
-		mce_dbus_get_message_sender_ident(req));
+	self->ss_timer_id = 0;
+	sigslot_emit(self);
 
-	dbus_int32_t verbosity = mce_log_get_verbosity();
+	return FALSE;
+}
 
-	rsp = dbus_new_method_reply(req);
+/** Idle callback for emitting queued signals
+ *
+ * @param aptr  (unused)
+ *
+ * @return FALSE to stop the idle callback from repeating
+ */
+static gboolean
+sigslot_flush_cb(gpointer aptr)
+{
+	(void)aptr;
 
-	if( !dbus_message_append_args(rsp,
-				      DBUS_TYPE_INT32, &verbosity,
-				      DBUS_TYPE_INVALID) ) {
-		mce_log(LL_ERR, "Failed to append arguments");
-		goto EXIT;
-	}
+	sigslot_flush_id = 0;
+	sigslot_flush();
 
-	dbus_send_message(rsp), rsp = 0;
+	return FALSE;
+}
 
-EXIT:
-	if( rsp )
-		dbus_message_unref(rsp);
+/** Emit all queued signals in posting order
+ */
+static void
+sigslot_flush(void)
+{
+	sigslot_t *slot;
 
-	return TRUE;
+	while( (slot = g_queue_peek_head(&sigslot_queue)) )
+		sigslot_emit(slot);
 }
 
-/** D-Bus callback for: set mce verbosity method call
+/** Broadcast signal with deduplication and coalescing
  *
- * @param req The D-Bus message to reply to
+ * Signals are identified by path, interface and member, plus an
+ * optional tag for signals that carry per-object state under the
+ * same member name.
  *
- * @return TRUE
+ * - A signal identical to the last one sent is dropped.
+ * - Signals posted during one mainloop iteration are collapsed
+ *   so that only the latest one is sent, from an idle callback.
+ *   Sending any other message flushes the queued signals first,
+ *   so ordering relative to non-coalesced messages is preserved.
+ * - If min_interval is positive, emissions are spaced at least
+ *   that many milliseconds apart; the latest value always gets
+ *   sent eventually. The interval passed with the latest signal
+ *   applies, so urgent changes can bypass an active rate limit.
+ *
+ * @param msg           signal message; ownership is transferred
+ * @param tag           instance tag, or NULL
+ * @param min_interval  minimum time between emissions [ms]
+ *
+ * @return TRUE if the signal was queued or dropped as redundant,
+ *         FALSE on failure
  */
-static gboolean verbosity_set_dbus_cb(DBusMessage *const req)
+gboolean
+dbus_send_signal_coalesced(DBusMessage *const msg, const char *tag,
+			   int min_interval)
 {
-	dbus_bool_t  ack = false;
-	DBusError    err = DBUS_ERROR_INIT;
+	gboolean   status = FALSE;
+	gchar     *key    = 0;
+	char      *repr   = 0;
+	sigslot_t *slot   = 0;
 
-	mce_log(LL_DEVEL, "verbosity set from %s",
-		mce_dbus_get_message_sender_ident(req));
+	if( !msg )
+		goto EXIT;
 
-	dbus_int32_t verbosity = LL_WARN;
+	if( dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_SIGNAL ||
+	    dbus_message_get_destination(msg) ) {
+		/* Only broadcast signals can be coalesced */
+		status = dbus_send_message(msg);
+		goto EXIT;
+	}
 
-	if( !dbus_message_get_args(req, &err,
-				   DBUS_TYPE_INT32, &verbosity,
-				   DBUS_TYPE_INVALID) ) {
-		mce_log(LL_ERR, "%s: %s", err.name, err.message);
+	if( !sigslot_lut )
+		sigslot_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
+						    0, sigslot_delete_cb);
+
+	key = g_strdup_printf("%s %s %s%s%s",
+			      dbus_message_get_path(msg),
+			      dbus_message_get_interface(msg),
+			      dbus_message_get_member(msg),
+			      tag ? " " : "", tag ?: "");
+
+	if( !(slot = g_hash_table_lookup(sigslot_lut, key)) ) {
+		slot = sigslot_create(key);
+		g_hash_table_replace(sigslot_lut, slot->ss_key, slot);
+	}
+
+	slot->ss_min_interval = min_interval;
+
+	repr = mce_dbus_message_repr(msg);
+
+	if( slot->ss_pending ) {
+		/* Latest value wins */
+		slot->ss_superseded += 1;
+		sigslot_cancel(slot);
+	}
+
+	if( !g_strcmp0(slot->ss_last_repr, repr) ) {
+		/* Nothing changed since the last emission */
+		slot->ss_dropped += 1;
+		dbus_message_unref(msg);
+		status = TRUE;
 		goto EXIT;
 	}
 
-	mce_log_set_verbosity(verbosity);
-	ack = true;
+	slot->ss_pending = msg;
+	slot->ss_pending_repr = repr, repr = 0;
+
+	int64_t now = mce_lib_get_mono_tick();
+	int64_t due = slot->ss_last_tick + slot->ss_min_interval;
+
+	if( slot->ss_last_repr && now < due ) {
+		/* Rate limited */
+		if( !slot->ss_timer_id )
+			slot->ss_timer_id = g_timeout_add((guint)(due - now),
+							  sigslot_timer_cb,
+							  slot);
+	}
+	else {
+		/* Rate limit does not apply, e.g. due to caller passing
+		 * smaller min_interval - stale timer is not needed */
+		if( slot->ss_timer_id )
+			g_source_remove(slot->ss_timer_id), slot->ss_timer_id = 0;
+
+		g_queue_push_tail(&sigslot_queue, slot);
+		slot->ss_queued = true;
+
+		if( !sigslot_flush_id )
+			sigslot_flush_id = g_idle_add(sigslot_flush_cb, 0);
+	}
+
+	status = TRUE;
 
 EXIT:
-	if( !dbus_message_get_no_reply(req) ) {
-		DBusMessage *rsp = dbus_new_method_reply(req);
-		if( !dbus_message_append_args(rsp,
-					      DBUS_TYPE_BOOLEAN, &ack,
-					      DBUS_TYPE_INVALID) ) {
-			mce_log(LL_ERR, "Failed to append arguments");
-			dbus_message_unref(rsp), rsp = 0;
-		}
-		else {
-			dbus_send_message(rsp), rsp = 0;
+	free(repr);
+	g_free(key);
+
+	return status;
+}
+
+/** Send pending signals and release signal slots
+ */
+static void
+sigslot_quit(void)
+{
+	if( sigslot_flush_id )
+		g_source_remove(sigslot_flush_id), sigslot_flush_id = 0;
+
+	/* Rate limited signals are sent too */
+	if( sigslot_lut ) {
+		GHashTableIter iter;
+		gpointer       val;
+
+		g_hash_table_iter_init(&iter, sigslot_lut);
+		while( g_hash_table_iter_next(&iter, 0, &val) ) {
+			sigslot_t *slot = val;
+			if( slot->ss_pending && !slot->ss_queued ) {
+				g_queue_push_tail(&sigslot_queue, slot);
+				slot->ss_queued = true;
+			}
 		}
 	}
 
-	dbus_error_free(&err);
+	sigslot_flush();
 
-	return TRUE;
+	if( sigslot_lut )
+		g_hash_table_unref(sigslot_lut), sigslot_lut = 0;
 }
 
 /* ========================================================================= *
- * CONFIG_VALUES
+ * PROPERTY_CACHE
  * ========================================================================= */
 
-/** Helper for appending gconf string list to dbus message
- *
- * @param conf GConfValue of string list type
- * @param pcount number of items in the returned array is stored here
- * @return array of string pointers that can be easily added to DBusMessage
- */
-static const char **string_array_from_gconf_value(GConfValue *conf, int *pcount)
+/** Published property value with preserialized reply */
+struct dbusprop_t
 {
-	const char **array = 0;
-	int    count = 0;
+	/** Property name, i.e. member name of the change signal */
+	gchar          *dbp_name;
 
-	GSList *list, *item;
+	/** D-Bus type of the value */
+	int             dbp_type;
 
-	if( conf->type != GCONF_VALUE_LIST )
-		goto EXIT;
+	/** Current value; strings are owned by the property */
+	DBusBasicValue  dbp_value;
 
-	if( gconf_value_get_list_type(conf) != GCONF_VALUE_STRING )
-		goto EXIT;
+	/** Method return template with the value appended */
+	DBusMessage    *dbp_reply;
 
-	list = gconf_value_get_list(conf);
+	/** Flag for: property is in dbusprop_changed */
+	bool            dbp_queued;
+};
 
-	for( item = list; item; item = item->next )
-		++count;
+/** Lookup table for published properties: name -> dbusprop_t */
+static GHashTable *dbusprop_lut = 0;
 
-	array = g_malloc_n(count, sizeof *array);
-	count = 0;
+/** Properties changed since the last batch signal, in change order */
+static GQueue dbusprop_changed = G_QUEUE_INIT;
 
-	for( item = list; item; item = item->next )
-		array[count++] = gconf_value_get_string(item->data);
+/** Idle callback id for sending the batch signal */
+static guint dbusprop_flush_id = 0;
 
-EXIT:
-	return *pcount = count, array;
+/** Predicate for: type is passed as string pointer
+ *
+ * @param type D-Bus type
+ *
+ * @return true for string like types, false otherwise
+ */
+static bool
+dbusprop_type_is_string(int type)
+{
+	return (type == DBUS_TYPE_STRING ||
+		type == DBUS_TYPE_OBJECT_PATH ||
+		type == DBUS_TYPE_SIGNATURE);
 }
 
-/** Helper for appending gconf int list to dbus message
+/** Get storage size of basic D-Bus type
  *
- * @param conf GConfValue of int list type
- * @param pcount number of items in the returned array is stored here
- * @return array of integers that can be easily added to DBusMessage
+ * @param type D-Bus type
+ *
+ * @return size in bytes, or zero for unsupported types
  */
-static dbus_int32_t *int_array_from_gconf_value(GConfValue *conf, int *pcount)
+static size_t
+dbusprop_type_size(int type)
 {
-	dbus_int32_t *array = 0;
-	int           count = 0;
-
-	GSList *list, *item;
+	switch( type ) {
+	case DBUS_TYPE_BYTE:    return sizeof(unsigned char);
+	case DBUS_TYPE_BOOLEAN: return sizeof(dbus_bool_t);
+	case DBUS_TYPE_INT16:   return sizeof(dbus_int16_t);
+	case DBUS_TYPE_UINT16:  return sizeof(dbus_uint16_t);
+	case DBUS_TYPE_INT32:   return sizeof(dbus_int32_t);
+	case DBUS_TYPE_UINT32:  return sizeof(dbus_uint32_t);
+	case DBUS_TYPE_INT64:   return sizeof(dbus_int64_t);
+	case DBUS_TYPE_UINT64:  return sizeof(dbus_uint64_t);
+	case DBUS_TYPE_DOUBLE:  return sizeof(double);
+	default: break;
+	}
+	return dbusprop_type_is_string(type) ? sizeof(char *) : 0;
+}
 
-	if( conf->type != GCONF_VALUE_LIST )
-		goto EXIT;
+/** Create property object
+ *
+ * @param name Property name
+ * @param type D-Bus type of the value
+ *
+ * @return property object
+ */
+static dbusprop_t *
+dbusprop_create(const char *name, int type)
+{
+	dbusprop_t *self = g_malloc0(sizeof *self);
+
+	self->dbp_name   = g_strdup(name);
+	self->dbp_type   = type;
+	self->dbp_reply  = 0;
+	self->dbp_queued = false;
+	memset(&self->dbp_value, 0, sizeof self->dbp_value);
+
+	return self;
+}
+
+/** Delete property object
+ *
+ * @param self property object, or NULL
+ */
+static void
+dbusprop_delete(dbusprop_t *self)
+{
+	if( !self )
+		goto EXIT;
+
+	if( self->dbp_queued )
+		g_queue_remove(&dbusprop_changed, self);
+
+	if( self->dbp_reply )
+		dbus_message_unref(self->dbp_reply);
+
+	if( dbusprop_type_is_string(self->dbp_type) )
+		g_free(self->dbp_value.str);
+
+	g_free(self->dbp_name);
+	g_free(self);
+
+EXIT:
+	return;
+}
+
+/** Type agnostic callback for deleting property objects
+ *
+ * @param self property object, or NULL
+ */
+static void
+dbusprop_delete_cb(void *self)
+{
+	dbusprop_delete(self);
+}
+
+/** Update property value
+ *
+ * @param self  property object
+ * @param value pointer to value, as with dbus_message_append_args()
+ *
+ * @return true if the value changed, false otherwise
+ */
+static bool
+dbusprop_set_value(dbusprop_t *self, const void *value)
+{
+	bool changed = false;
+
+	if( dbusprop_type_is_string(self->dbp_type) ) {
+		const char *str = *(const char * const *)value;
+
+		if( self->dbp_reply && !g_strcmp0(self->dbp_value.str, str) )
+			goto EXIT;
+
+		g_free(self->dbp_value.str);
+		self->dbp_value.str = g_strdup(str ?: "");
+	}
+	else {
+		size_t size = dbusprop_type_size(self->dbp_type);
+
+		if( self->dbp_reply && !memcmp(&self->dbp_value, value, size) )
+			goto EXIT;
+
+		memcpy(&self->dbp_value, value, size);
+	}
+
+	/* Preserialize method return that can be copied as-is */
+	if( self->dbp_reply )
+		dbus_message_unref(self->dbp_reply);
+
+	self->dbp_reply = dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_RETURN);
+	if( !self->dbp_reply )
+		mce_abort();
+
+	dbus_message_set_no_reply(self->dbp_reply, TRUE);
+	dbus_message_append_args(self->dbp_reply,
+				 self->dbp_type, &self->dbp_value,
+				 DBUS_TYPE_INVALID);
+
+	changed = true;
+
+EXIT:
+	return changed;
+}
+
+/** Idle callback for sending the batch signal
+ *
+ * @param aptr (unused)
+ *
+ * @return FALSE to stop the idle callback from repeating
+ */
+static gboolean
+dbusprop_flush_cb(gpointer aptr)
+{
+	(void)aptr;
+
+	dbusprop_flush_id = 0;
+	dbusprop_flush();
+
+	return FALSE;
+}
+
+/** Send batch signal for properties changed since the last one
+ */
+static void
+dbusprop_flush(void)
+{
+	DBusMessage    *sig = 0;
+	DBusMessageIter body, dict, entry, variant;
+	dbusprop_t     *self;
+
+	if( g_queue_is_empty(&dbusprop_changed) )
+		goto EXIT;
+
+	sig = dbus_new_signal(MCE_SIGNAL_PATH, MCE_SIGNAL_IF,
+			      MCE_PROPERTIES_CHANGED_SIG);
+
+	dbus_message_iter_init_append(sig, &body);
+
+	if( !dbus_message_iter_open_container(&body, DBUS_TYPE_ARRAY,
+					      DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+					      DBUS_TYPE_STRING_AS_STRING
+					      DBUS_TYPE_VARIANT_AS_STRING
+					      DBUS_DICT_ENTRY_END_CHAR_AS_STRING,
+					      &dict) )
+		goto EXIT;
+
+	while( (self = g_queue_pop_head(&dbusprop_changed)) ) {
+		char signature[2] = { (char)self->dbp_type, 0 };
+
+		self->dbp_queued = false;
+
+		if( !dbus_message_iter_open_container(&dict,
+						      DBUS_TYPE_DICT_ENTRY,
+						      0, &entry) )
+			goto ABANDON_DICT;
+
+		if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING,
+						    &self->dbp_name) )
+			goto ABANDON_ENTRY;
+
+		if( !dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT,
+						      signature, &variant) )
+			goto ABANDON_ENTRY;
+
+		if( !dbus_message_iter_append_basic(&variant, self->dbp_type,
+						    &self->dbp_value) ) {
+			dbus_message_iter_abandon_container(&entry, &variant);
+			goto ABANDON_ENTRY;
+		}
+
+		if( !dbus_message_iter_close_container(&entry, &variant) ||
+		    !dbus_message_iter_close_container(&dict, &entry) )
+			goto ABANDON_DICT;
+	}
+
+	if( !dbus_message_iter_close_container(&body, &dict) )
+		goto EXIT;
+
+	dbus_send_message(sig), sig = 0;
+
+	goto EXIT;
+
+ABANDON_ENTRY:
+	dbus_message_iter_abandon_container(&dict, &entry);
+
+ABANDON_DICT:
+	dbus_message_iter_abandon_container(&body, &dict);
+
+EXIT:
+	/* Do not retry after failures */
+	while( (self = g_queue_pop_head(&dbusprop_changed)) )
+		self->dbp_queued = false;
+
+	if( sig )
+		dbus_message_unref(sig);
+
+	return;
+}
+
+/** Publish property value
+ *
+ * The value is cached as preserialized method return, that
+ * mce_dbus_property_reply() can use for replying to queries.
+ *
+ * When the value changes, a signal named after the property is
+ * broadcast via dbus_send_signal_coalesced(). Properties changed
+ * during one mainloop iteration are also reported together in one
+ * #MCE_PROPERTIES_CHANGED_SIG signal.
+ *
+ * @param name  property name, i.e. member name of the change signal
+ * @param type  basic D-Bus type of the value
+ * @param value pointer to value, as with dbus_message_append_args()
+ *
+ * @return TRUE if the value changed, FALSE otherwise
+ */
+gboolean
+mce_dbus_property_publish(const char *name, int type, const void *value)
+{
+	gboolean    changed = FALSE;
+	dbusprop_t *self    = 0;
+	DBusMessage *sig    = 0;
+
+	if( !name || !value || !dbusprop_type_size(type) ) {
+		mce_log(LL_ERR, "invalid property %s", name ?: "<null>");
+		goto EXIT;
+	}
+
+	if( !dbusprop_lut )
+		dbusprop_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
+						     0, dbusprop_delete_cb);
+
+	if( !(self = g_hash_table_lookup(dbusprop_lut, name)) ) {
+		self = dbusprop_create(name, type);
+		g_hash_table_replace(dbusprop_lut, self->dbp_name, self);
+	}
+	else if( self->dbp_type != type ) {
+		mce_log(LL_ERR, "property %s: type changed", name);
+		goto EXIT;
+	}
+
+	if( !dbusprop_set_value(self, value) )
+		goto EXIT;
+
+	changed = TRUE;
+
+	sig = dbus_new_signal(MCE_SIGNAL_PATH, MCE_SIGNAL_IF, name);
+	if( !dbus_message_append_args(sig, type, value, DBUS_TYPE_INVALID) ) {
+		mce_log(LL_ERR, "Failed to append arguments");
+		goto EXIT;
+	}
+	dbus_send_signal_coalesced(sig, 0, 0), sig = 0;
+
+	if( !self->dbp_queued ) {
+		g_queue_push_tail(&dbusprop_changed, self);
+		self->dbp_queued = true;
+	}
+
+	if( !dbusprop_flush_id )
+		dbusprop_flush_id = g_idle_add(dbusprop_flush_cb, 0);
+
+EXIT:
+	if( sig )
+		dbus_message_unref(sig);
+
+	return changed;
+}
+
+/** Reply to property query from cached value
+ *
+ * @param req  method call message to reply to
+ * @param name property name, as used with mce_dbus_property_publish()
+ *
+ * @return TRUE
+ */
+gboolean
+mce_dbus_property_reply(DBusMessage *const req, const char *name)
+{
+	DBusMessage *rsp  = 0;
+	dbusprop_t  *self = 0;
+
+	if( dbus_message_get_no_reply(req) )
+		goto EXIT;
+
+	if( dbusprop_lut )
+		self = g_hash_table_lookup(dbusprop_lut, name);
+
+	if( !self || !self->dbp_reply ) {
+		rsp = dbus_new_error(req, DBUS_ERROR_FAILED,
+				     "%s: value not available", name);
+	}
+	else {
+		/* Copying retains the already marshaled body */
+		if( !(rsp = dbus_message_copy(self->dbp_reply)) )
+			mce_abort();
+
+		const char *sender = dbus_message_get_sender(req);
+		if( sender )
+			dbus_message_set_destination(rsp, sender);
+		dbus_message_set_reply_serial(rsp, dbus_message_get_serial(req));
+	}
+
+	dbus_send_message(rsp), rsp = 0;
+
+EXIT:
+	return TRUE;
+}
+
+/** Send pending batch signal and release published properties
+ */
+static void
+dbusprop_quit(void)
+{
+	if( dbusprop_flush_id )
+		g_source_remove(dbusprop_flush_id), dbusprop_flush_id = 0;
+
+	dbusprop_flush();
+
+	if( dbusprop_lut )
+		g_hash_table_unref(dbusprop_lut), dbusprop_lut = 0;
+}
+
+/* ========================================================================= *
+ * METHOD_CALL_HANDLERS
+ * ========================================================================= */
+
+/**
+ * D-Bus callback for the version get method call
+ *
+ * @param msg The D-Bus message to reply to
+ * @return TRUE on success, FALSE on failure
+ */
+static gboolean version_get_dbus_cb(DBusMessage *const msg)
+{
+	static const gchar *const versionstring = G_STRINGIFY(PRG_VERSION);
+	DBusMessage *reply = NULL;
+	gboolean status = FALSE;
+
+	mce_log(LL_DEBUG, "Received version information request");
+
+	/* Create a reply */
+	reply = dbus_new_method_reply(msg);
+
+	/* Append the version information */
+	if (dbus_message_append_args(reply,
+				     DBUS_TYPE_STRING, &versionstring,
+				     DBUS_TYPE_INVALID) == FALSE) {
+		mce_log(LL_CRIT,
+			"Failed to append reply argument to D-Bus message "
+			"for %s.%s",
+			MCE_REQUEST_IF, MCE_VERSION_GET);
+		dbus_message_unref(reply);
+		goto EXIT;
+	}
+
+	/* Send the message */
+	status = dbus_send_message(reply);
+
+EXIT:
+	return status;
+}
+
+/** D-Bus callback for the get suspend time statistics method call
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean suspend_stats_get_dbus_cb(DBusMessage *const req)
+{
+	DBusMessage *rsp = 0;
+
+	mce_log(LL_DEVEL, "suspend info request from %s",
+		mce_dbus_get_message_sender_ident(req));
+
+	/* Get time values - in an order that is less
+	 * likely to produce negative values on subtract.
+	 */
+	dbus_int64_t active_ms  = mce_lib_get_mono_tick();
+	dbus_int64_t uptime_ms  = mce_lib_get_boot_tick();
+	dbus_int64_t suspend_ms = uptime_ms - active_ms;
+
+	/* create and send reply message */
+	rsp = dbus_new_method_reply(req);
+
+	if( !dbus_message_append_args(rsp,
+				      DBUS_TYPE_INT64, &uptime_ms,
+				      DBUS_TYPE_INT64, &suspend_ms,
+				      DBUS_TYPE_INVALID) ) {
+		mce_log(LL_ERR, "Failed to append arguments");
+		goto EXIT;
+	}
+
+	dbus_send_message(rsp), rsp = 0;
+
+EXIT:
+	if( rsp )
+		dbus_message_unref(rsp);
+
+	return TRUE;
+}
+
+/** Wakeup accounting data for one tag */
+typedef struct
+{
+	const char    *tag;      /**< Originating subsystem and object */
+	dbus_uint32_t  wakes;    /**< Holds started from idle */
+	dbus_uint32_t  holds;    /**< Holds in total */
+	dbus_int64_t   held_ms;  /**< Cumulative hold time [ms] */
+} wakeup_report_entry_t;
+
+/** Callback for collecting wakeup accounting data into an array
+ *
+ * @param tag      originating subsystem and object
+ * @param wakes    number of holds started from idle
+ * @param holds    number of holds
+ * @param held_ms  cumulative time held [ms]
+ * @param aptr     GArray of wakeup_report_entry_t (as void pointer)
+ */
+static void wakeup_report_collect_cb(const char *tag, unsigned wakes,
+				     unsigned holds, int64_t held_ms,
+				     void *aptr)
+{
+	GArray *vec = aptr;
+
+	wakeup_report_entry_t entry = {
+		.tag     = tag,
+		.wakes   = wakes,
+		.holds   = holds,
+		.held_ms = held_ms,
+	};
+
+	g_array_append_val(vec, entry);
+}
+
+/** Sort wakeup accounting data to descending held time order
+ *
+ * @param a  wakeup_report_entry_t pointer (as void pointer)
+ * @param b  wakeup_report_entry_t pointer (as void pointer)
+ *
+ * @return negative if a was held longer than b, positive if shorter
+ */
+static gint wakeup_report_compare_cb(gconstpointer a, gconstpointer b)
+{
+	const wakeup_report_entry_t *lhs = a;
+	const wakeup_report_entry_t *rhs = b;
+
+	if( lhs->held_ms != rhs->held_ms )
+		return (lhs->held_ms < rhs->held_ms) ? 1 : -1;
+
+	return strcmp(lhs->tag, rhs->tag);
+}
+
+/** D-Bus callback for the get wakeup report method call
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean wakeup_report_get_dbus_cb(DBusMessage *const req)
+{
+	DBusMessage     *rsp = 0;
+	GArray          *vec = 0;
+	DBusMessageIter  body, array, entry;
+
+	mce_log(LL_DEVEL, "wakeup report request from %s",
+		mce_dbus_get_message_sender_ident(req));
+
+	vec = g_array_new(FALSE, FALSE, sizeof(wakeup_report_entry_t));
+	mce_wakelock_account_foreach(wakeup_report_collect_cb, vec);
+	g_array_sort(vec, wakeup_report_compare_cb);
+
+	rsp = dbus_new_method_reply(req);
+	dbus_message_iter_init_append(rsp, &body);
+
+	if( !dbus_message_iter_open_container(&body, DBUS_TYPE_ARRAY,
+					      DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+					      DBUS_TYPE_STRING_AS_STRING
+					      DBUS_TYPE_UINT32_AS_STRING
+					      DBUS_TYPE_UINT32_AS_STRING
+					      DBUS_TYPE_INT64_AS_STRING
+					      DBUS_STRUCT_END_CHAR_AS_STRING,
+					      &array) )
+		goto EXIT;
+
+	for( guint i = 0; i < vec->len; ++i ) {
+		const wakeup_report_entry_t *item =
+			&g_array_index(vec, wakeup_report_entry_t, i);
+
+		if( !dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT,
+						      0, &entry) )
+			goto ABANDON_ARRAY;
+
+		if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING,
+						    &item->tag) ||
+		    !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+						    &item->wakes) ||
+		    !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+						    &item->holds) ||
+		    !dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT64,
+						    &item->held_ms) )
+			goto ABANDON_ENTRY;
+
+		if( !dbus_message_iter_close_container(&array, &entry) )
+			goto ABANDON_ARRAY;
+	}
+
+	if( !dbus_message_iter_close_container(&body, &array) )
+		goto EXIT;
+
+	dbus_send_message(rsp), rsp = 0;
+
+	goto EXIT;
+
+ABANDON_ENTRY:
+	dbus_message_iter_abandon_container(&array, &entry);
+
+ABANDON_ARRAY:
+	dbus_message_iter_abandon_container(&body, &array);
+
+EXIT:
+	if( vec )
+		g_array_free(vec, TRUE);
+
+	if( rsp )
+		dbus_message_unref(rsp);
+
+	return TRUE;
+}
+
+/** D-Bus callback for the get datapipe graph method call
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean datapipe_graph_get_dbus_cb(DBusMessage *const req)
+{
+	DBusMessage *rsp    = 0;
+	DBusError    err    = DBUS_ERROR_INIT;
+	const char  *format = 0;
+	gchar       *graph  = 0;
+
+	mce_log(LL_DEVEL, "datapipe graph request from %s",
+		mce_dbus_get_message_sender_ident(req));
+
+	if( !dbus_message_get_args(req, &err,
+				   DBUS_TYPE_STRING, &format,
+				   DBUS_TYPE_INVALID) ) {
+		rsp = dbus_new_error(req, err.name, "%s", err.message);
+		goto EXIT;
+	}
+
+	if( !(graph = mce_datapipe_graph_export(format)) ) {
+		rsp = dbus_new_error(req, DBUS_ERROR_INVALID_ARGS,
+				     "unsupported format: %s", format);
+		goto EXIT;
+	}
+
+	rsp = dbus_new_method_reply(req);
+
+	if( !dbus_message_append_args(rsp,
+				      DBUS_TYPE_STRING, &graph,
+				      DBUS_TYPE_INVALID) ) {
+		mce_log(LL_ERR, "Failed to append arguments");
+		dbus_message_unref(rsp), rsp = 0;
+	}
+
+EXIT:
+	if( rsp && !dbus_message_get_no_reply(req) )
+		dbus_send_message(rsp), rsp = 0;
+
+	if( rsp )
+		dbus_message_unref(rsp);
+
+	g_free(graph);
+	dbus_error_free(&err);
+
+	return TRUE;
+}
+
+/** D-Bus callback for: get mce verbosity method call
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean verbosity_get_dbus_cb(DBusMessage *const req)
+{
+	DBusMessage *rsp = 0;
+
+	mce_log(LL_DEVEL, "verbosity get from %s",
+		mce_dbus_get_message_sender_ident(req));
+
+	dbus_int32_t verbosity = mce_log_get_verbosity();
+
+	rsp = dbus_new_method_reply(req);
+
+	if( !dbus_message_append_args(rsp,
+				      DBUS_TYPE_INT32, &verbosity,
+				      DBUS_TYPE_INVALID) ) {
+		mce_log(LL_ERR, "Failed to append arguments");
+		goto EXIT;
+	}
+
+	dbus_send_message(rsp), rsp = 0;
+
+EXIT:
+	if( rsp )
+		dbus_message_unref(rsp);
+
+	return TRUE;
+}
+
+/** D-Bus callback for: set mce verbosity method call
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean verbosity_set_dbus_cb(DBusMessage *const req)
+{
+	dbus_bool_t  ack = false;
+	DBusError    err = DBUS_ERROR_INIT;
+
+	mce_log(LL_DEVEL, "verbosity set from %s",
+		mce_dbus_get_message_sender_ident(req));
+
+	dbus_int32_t verbosity = LL_WARN;
+
+	if( !dbus_message_get_args(req, &err,
+				   DBUS_TYPE_INT32, &verbosity,
+				   DBUS_TYPE_INVALID) ) {
+		mce_log(LL_ERR, "%s: %s", err.name, err.message);
+		goto EXIT;
+	}
+
+	mce_log_set_verbosity(verbosity);
+	ack = true;
+
+EXIT:
+	if( !dbus_message_get_no_reply(req) ) {
+		DBusMessage *rsp = dbus_new_method_reply(req);
+		if( !dbus_message_append_args(rsp,
+					      DBUS_TYPE_BOOLEAN, &ack,
+					      DBUS_TYPE_INVALID) ) {
+			mce_log(LL_ERR, "Failed to append arguments");
+			dbus_message_unref(rsp), rsp = 0;
+		}
+		else {
+			dbus_send_message(rsp), rsp = 0;
+		}
+	}
+
+	dbus_error_free(&err);
+
+	return TRUE;
+}
+
+/* ========================================================================= *
+ * CONFIG_VALUES
+ * ========================================================================= */
+
+/** Helper for appending gconf string list to dbus message
+ *
+ * @param conf GConfValue of string list type
+ * @param pcount number of items in the returned array is stored here
+ * @return array of string pointers that can be easily added to DBusMessage
+ */
+static const char **string_array_from_gconf_value(GConfValue *conf, int *pcount)
+{
+	const char **array = 0;
+	int    count = 0;
+
+	GSList *list, *item;
+
+	if( conf->type != GCONF_VALUE_LIST )
+		goto EXIT;
+
+	if( gconf_value_get_list_type(conf) != GCONF_VALUE_STRING )
+		goto EXIT;
+
+	list = gconf_value_get_list(conf);
+
+	for( item = list; item; item = item->next )
+		++count;
+
+	array = g_malloc_n(count, sizeof *array);
+	count = 0;
+
+	for( item = list; item; item = item->next )
+		array[count++] = gconf_value_get_string(item->data);
+
+EXIT:
+	return *pcount = count, array;
+}
+
+/** Helper for appending gconf int list to dbus message
+ *
+ * @param conf GConfValue of int list type
+ * @param pcount number of items in the returned array is stored here
+ * @return array of integers that can be easily added to DBusMessage
+ */
+static dbus_int32_t *int_array_from_gconf_value(GConfValue *conf, int *pcount)
+{
+	dbus_int32_t *array = 0;
+	int           count = 0;
+
+	GSList *list, *item;
+
+	if( conf->type != GCONF_VALUE_LIST )
+		goto EXIT;
 
 	if( gconf_value_get_list_type(conf) != GCONF_VALUE_INT )
 		goto EXIT;
@@ -3380,6 +4361,72 @@ EXIT:
 	return status;
 }
 
+/** Reply template for config get all -method call */
+static DBusMessage *config_get_all_cache = 0;
+
+/** Config client generation config_get_all_cache was built at */
+static unsigned config_get_all_cache_generation = 0;
+
+/** Random identifier for config generation numbers of this mce instance */
+static dbus_uint32_t config_changes_epoch = 0;
+
+/** Get reply to config get all -method call
+ *
+ * Serializing all config values is relatively costly, so the reply
+ * body is cached and reused until config values change. Every reply
+ * is a copy of the cached message, with only the addressing header
+ * fields adjusted to match the request.
+ *
+ * @param req  method call message
+ * @param cli  config client
+ *
+ * @return reply message, or NULL on failure
+ */
+static DBusMessage *config_get_all_cached_reply(DBusMessage *const req,
+						GConfClient *cli)
+{
+	DBusMessage *rsp = 0;
+
+	if( config_get_all_cache &&
+	    config_get_all_cache_generation != cli->generation ) {
+		mce_log(LL_DEBUG, "config changed; invalidating cached reply");
+		config_get_all_cache_flush();
+	}
+
+	if( !config_get_all_cache ) {
+		DBusMessageIter body;
+
+		config_get_all_cache = dbus_new_method_reply(req);
+		config_get_all_cache_generation = cli->generation;
+
+		dbus_message_iter_init_append(config_get_all_cache, &body);
+
+		if( !append_gconf_entries_to_dbus_iterator(&body, cli->entries) ) {
+			config_get_all_cache_flush();
+			goto EXIT;
+		}
+	}
+
+	if( !(rsp = dbus_message_copy(config_get_all_cache)) )
+		goto EXIT;
+
+	if( !dbus_message_set_reply_serial(rsp, dbus_message_get_serial(req)) ||
+	    !dbus_message_set_destination(rsp, dbus_message_get_sender(req)) )
+		dbus_message_unref(rsp), rsp = 0;
+
+EXIT:
+	return rsp;
+}
+
+/** Release cached config get all -method call reply
+ */
+static void config_get_all_cache_flush(void)
+{
+	if( config_get_all_cache )
+		dbus_message_unref(config_get_all_cache),
+			config_get_all_cache = 0;
+}
+
 /** D-Bus callback for the config get all -method call
  *
  * @param msg The D-Bus message to reply to
@@ -3396,14 +4443,90 @@ static gboolean config_get_all_dbus_cb(DBusMessage *const req)
 	if( !(cli = gconf_client_get_default()) )
 		goto EXIT;
 
-	if( !(rsp = dbus_new_method_reply(req)) )
+	rsp = config_get_all_cached_reply(req, cli);
+
+EXIT:
+
+	if( !dbus_message_get_no_reply(req) ) {
+		if( !rsp )
+			rsp = dbus_message_new_error(req, "com.nokia.mce.GConf.Error",
+						     "unknown");
+		if( rsp )
+			dbus_send_message(rsp), rsp = 0;
+	}
+
+	if( rsp )
+		dbus_message_unref(rsp);
+
+	return TRUE;
+}
+
+/** D-Bus callback for the config changes query -method call
+ *
+ * Returns values that have changed since the given generation, which
+ * allows clients to keep a local copy of mce settings up to date
+ * without fetching everything after each change notification.
+ *
+ * If the epoch does not match, i.e. the client has not queried this
+ * mce instance before, or the generation is not known, all values
+ * are returned.
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean config_get_changes_dbus_cb(DBusMessage *const req)
+{
+	GConfClient   *cli     = 0;
+	DBusMessage   *rsp     = 0;
+	GSList        *changed = 0;
+	dbus_uint32_t  epoch   = 0;
+	dbus_uint32_t  since   = 0;
+	DBusError      err     = DBUS_ERROR_INIT;
+
+	mce_log(LL_DEBUG, "Received configuration changes query request");
+
+	if( !dbus_message_get_args(req, &err,
+				   DBUS_TYPE_UINT32, &epoch,
+				   DBUS_TYPE_UINT32, &since,
+				   DBUS_TYPE_INVALID) ) {
+		mce_log(LL_WARN, "%s: %s", err.name, err.message);
+		rsp = dbus_message_new_error(req, err.name, err.message);
+		goto EXIT;
+	}
+
+	if( !(cli = gconf_client_get_default()) )
 		goto EXIT;
 
+	if( !config_changes_epoch )
+		config_changes_epoch = g_random_int() | 1;
+
+	bool everything = (epoch != config_changes_epoch ||
+			   since > cli->generation);
+
+	for( GSList *item = cli->entries; item; item = item->next ) {
+		GConfEntry *entry = item->data;
+
+		if( everything || entry->generation > since )
+			changed = g_slist_prepend(changed, entry);
+	}
+	changed = g_slist_reverse(changed);
+
+	mce_log(LL_DEBUG, "generation %u -> %u: %u values",
+		since, cli->generation, g_slist_length(changed));
+
+	rsp = dbus_new_method_reply(req);
+
+	dbus_uint32_t   generation = cli->generation;
 	DBusMessageIter body;
 
 	dbus_message_iter_init_append(rsp, &body);
 
-	if( !append_gconf_entries_to_dbus_iterator(&body, cli->entries) ) {
+	if( !dbus_message_iter_append_basic(&body, DBUS_TYPE_UINT32,
+					    &config_changes_epoch) ||
+	    !dbus_message_iter_append_basic(&body, DBUS_TYPE_UINT32,
+					    &generation) ||
+	    !append_gconf_entries_to_dbus_iterator(&body, changed) ) {
 		dbus_message_unref(rsp), rsp = 0;
 	}
 
@@ -3420,6 +4543,9 @@ EXIT:
 	if( rsp )
 		dbus_message_unref(rsp);
 
+	g_slist_free(changed);
+	dbus_error_free(&err);
+
 	return TRUE;
 }
 
@@ -3454,6 +4580,45 @@ void mce_dbus_send_config_notification(GConfEntry *entry)
 
 	append_gconf_value_to_dbus_message(sig, val);
 
+	dbus_send_signal_coalesced(sig, key, 0), sig = 0;
+
+EXIT:
+
+	if( sig ) dbus_message_unref(sig);
+
+	return;
+}
+
+/** Send configuration changed notifications for a batch of settings
+ *
+ * One signal carrying all the changed values is sent for clients that
+ * know about batches. The per-setting signals can not be left out:
+ * existing clients track individual settings via config_change_ind
+ * only, and would otherwise miss changes made via batch methods. They
+ * go through the coalescing emitter keyed by setting name, so each
+ * setting is broadcast at most once per main loop iteration.
+ *
+ * @param entries GSList of changed GConfEntry objects
+ */
+void mce_dbus_send_config_batch_notification(GSList *entries)
+{
+	DBusMessage    *sig = 0;
+	DBusMessageIter body;
+
+	for( GSList *item = entries; item; item = item->next )
+		mce_dbus_send_config_notification(item->data);
+
+	mce_log(LL_DEBUG, "%u settings changed", g_slist_length(entries));
+
+	sig = dbus_new_signal(MCE_SIGNAL_PATH,
+			      MCE_SIGNAL_IF,
+			      MCE_CONFIG_BATCH_CHANGE_SIG);
+
+	dbus_message_iter_init_append(sig, &body);
+
+	if( !append_gconf_entries_to_dbus_iterator(&body, entries) )
+		goto EXIT;
+
 	dbus_send_message(sig), sig = 0;
 
 EXIT:
@@ -3635,22 +4800,222 @@ static gboolean config_reset_dbus_cb(DBusMessage *const msg)
 		g_clear_error(&err);
 	}
 
-EXIT:
-	if( dbus_message_get_no_reply(msg) )
-		goto NOREPLY;
+EXIT:
+	if( dbus_message_get_no_reply(msg) )
+		goto NOREPLY;
+
+	if( !(reply = dbus_new_method_reply(msg)) )
+		goto NOREPLY;
+
+	dbus_message_append_args(reply,
+				 DBUS_TYPE_INT32, &count,
+				 DBUS_TYPE_INVALID);
+
+	dbus_send_message(reply), reply = 0;
+
+NOREPLY:
+	dbus_error_free(&error);
+	return TRUE;
+}
+
+/** Map D-Bus value type to config value type
+ *
+ * @param type D-Bus type
+ *
+ * @return config value type, or GCONF_VALUE_INVALID
+ */
+static GConfValueType config_type_from_dbus_type(int type)
+{
+	switch( type ) {
+	case DBUS_TYPE_BOOLEAN: return GCONF_VALUE_BOOL;
+	case DBUS_TYPE_INT32:   return GCONF_VALUE_INT;
+	case DBUS_TYPE_DOUBLE:  return GCONF_VALUE_FLOAT;
+	case DBUS_TYPE_STRING:  return GCONF_VALUE_STRING;
+	case DBUS_TYPE_ARRAY:   return GCONF_VALUE_LIST;
+	default: break;
+	}
+	return GCONF_VALUE_INVALID;
+}
+
+/** Check that D-Bus value could be assigned to a setting
+ *
+ * @param client config client
+ * @param key    setting key
+ * @param iter   D-Bus message iterator at value
+ *
+ * @return NULL if value is acceptable, or error message
+ */
+static const char *config_check_value_from_iter(GConfClient *client,
+						const char *key,
+						DBusMessageIter *iter)
+{
+	const char     *invalid = 0;
+	GConfValue     *conf    = 0;
+	GError         *err     = 0;
+	int             type    = dbus_message_iter_get_arg_type(iter);
+	GConfValueType  vtype   = config_type_from_dbus_type(type);
+
+	if( !(conf = gconf_client_get(client, key, &err)) ) {
+		invalid = "unknown key";
+		goto EXIT;
+	}
+
+	if( vtype == GCONF_VALUE_INVALID ) {
+		invalid = "unexpected value type";
+		goto EXIT;
+	}
+
+	if( conf->type != vtype ) {
+		invalid = "value type mismatch";
+		goto EXIT;
+	}
+
+	if( vtype == GCONF_VALUE_LIST ) {
+		type = dbus_message_iter_get_element_type(iter);
+		vtype = config_type_from_dbus_type(type);
+
+		if( vtype == GCONF_VALUE_INVALID || vtype == GCONF_VALUE_LIST ) {
+			invalid = "unexpected value array type";
+			goto EXIT;
+		}
+
+		if( gconf_value_get_list_type(conf) != vtype ) {
+			invalid = "value array type mismatch";
+			goto EXIT;
+		}
+	}
+
+EXIT:
+	if( conf )
+		gconf_value_free(conf);
+
+	g_clear_error(&err);
+
+	return invalid;
+}
+
+/** Assign D-Bus value to a setting
+ *
+ * @param client config client
+ * @param key    setting key
+ * @param iter   D-Bus message iterator at value
+ * @param err    where to store config errors
+ *
+ * @return NULL if value type was acceptable, or error message
+ */
+static const char *config_set_value_from_iter(GConfClient *client,
+					      const char *key,
+					      DBusMessageIter *iter,
+					      GError **err)
+{
+	const char *invalid = 0;
+	GSList     *list    = 0;
+
+	switch( dbus_message_iter_get_arg_type(iter) ) {
+	case DBUS_TYPE_BOOLEAN:
+		{
+			dbus_bool_t arg = 0;
+			dbus_message_iter_get_basic(iter, &arg);
+			gconf_client_set_bool(client, key, arg, err);
+		}
+		break;
+	case DBUS_TYPE_INT32:
+		{
+			dbus_int32_t arg = 0;
+			dbus_message_iter_get_basic(iter, &arg);
+			gconf_client_set_int(client, key, arg, err);
+		}
+		break;
+	case DBUS_TYPE_DOUBLE:
+		{
+			double arg = 0;
+			dbus_message_iter_get_basic(iter, &arg);
+			gconf_client_set_float(client, key, arg, err);
+		}
+		break;
+	case DBUS_TYPE_STRING:
+		{
+			const char *arg = 0;
+			dbus_message_iter_get_basic(iter, &arg);
+			gconf_client_set_string(client, key, arg, err);
+		}
+		break;
+
+	case DBUS_TYPE_ARRAY:
+		switch( dbus_message_iter_get_element_type(iter) ) {
+		case DBUS_TYPE_BOOLEAN:
+			list = value_list_from_bool_array(iter);
+			gconf_client_set_list(client, key, GCONF_VALUE_BOOL, list, err);
+			break;
+		case DBUS_TYPE_INT32:
+			list = value_list_from_int_array(iter);
+			gconf_client_set_list(client, key, GCONF_VALUE_INT, list, err);
+			break;
+		case DBUS_TYPE_DOUBLE:
+			list = value_list_from_float_array(iter);
+			gconf_client_set_list(client, key, GCONF_VALUE_FLOAT, list, err);
+			break;
+		case DBUS_TYPE_STRING:
+			list = value_list_from_string_array(iter);
+			gconf_client_set_list(client, key, GCONF_VALUE_STRING, list, err);
+			break;
+		default:
+			invalid = "unexpected value array type";
+			break;
+		}
+		break;
+
+	default:
+		invalid = "unexpected value type";
+		break;
+	}
+
+	value_list_free(list);
 
-	if( !(reply = dbus_new_method_reply(msg)) )
-		goto NOREPLY;
+	return invalid;
+}
 
-	dbus_message_append_args(reply,
-				 DBUS_TYPE_INT32, &count,
-				 DBUS_TYPE_INVALID);
+/** Restore previously saved value of a setting
+ *
+ * @param client config client
+ * @param key    setting key
+ * @param value  value obtained via gconf_client_get()
+ */
+static void config_restore_value(GConfClient *client, const char *key,
+				 const GConfValue *value)
+{
+	GError *err = 0;
 
-	dbus_send_message(reply), reply = 0;
+	switch( value->type ) {
+	case GCONF_VALUE_BOOL:
+		gconf_client_set_bool(client, key,
+				      gconf_value_get_bool(value), &err);
+		break;
+	case GCONF_VALUE_INT:
+		gconf_client_set_int(client, key,
+				     gconf_value_get_int(value), &err);
+		break;
+	case GCONF_VALUE_FLOAT:
+		gconf_client_set_float(client, key,
+				       gconf_value_get_float(value), &err);
+		break;
+	case GCONF_VALUE_STRING:
+		gconf_client_set_string(client, key,
+					gconf_value_get_string(value), &err);
+		break;
+	case GCONF_VALUE_LIST:
+		gconf_client_set_list(client, key,
+				      gconf_value_get_list_type(value),
+				      gconf_value_get_list(value), &err);
+		break;
+	default:
+		break;
+	}
 
-NOREPLY:
-	dbus_error_free(&error);
-	return TRUE;
+	if( err ) {
+		mce_log(LL_ERR, "%s: failed to restore: %s", key, err->message);
+		g_clear_error(&err);
+	}
 }
 
 /**
@@ -3667,7 +5032,6 @@ static gboolean config_set_dbus_cb(DBusMessage *const msg)
 	const char *key = NULL;
 	GError *err = NULL;
 	GConfClient *client = 0;
-	GSList *list = 0;
 
 	DBusError error = DBUS_ERROR_INIT;
 	DBusMessageIter body, iter;
@@ -3711,65 +5075,10 @@ static gboolean config_set_dbus_cb(DBusMessage *const msg)
 		goto EXIT;
 	}
 
-	switch( dbus_message_iter_get_arg_type(&iter) ) {
-	case DBUS_TYPE_BOOLEAN:
-		{
-			dbus_bool_t arg = 0;
-			dbus_message_iter_get_basic(&iter, &arg);
-			gconf_client_set_bool(client, key, arg, &err);
-		}
-		break;
-	case DBUS_TYPE_INT32:
-		{
-			dbus_int32_t arg = 0;
-			dbus_message_iter_get_basic(&iter, &arg);
-			gconf_client_set_int(client, key, arg, &err);
-		}
-		break;
-	case DBUS_TYPE_DOUBLE:
-		{
-			double arg = 0;
-			dbus_message_iter_get_basic(&iter, &arg);
-			gconf_client_set_float(client, key, arg, &err);
-		}
-		break;
-	case DBUS_TYPE_STRING:
-		{
-			const char *arg = 0;
-			dbus_message_iter_get_basic(&iter, &arg);
-			gconf_client_set_string(client, key, arg, &err);
-		}
-		break;
-
-	case DBUS_TYPE_ARRAY:
-		switch( dbus_message_iter_get_element_type(&iter) ) {
-		case DBUS_TYPE_BOOLEAN:
-			list = value_list_from_bool_array(&iter);
-			gconf_client_set_list(client, key, GCONF_VALUE_BOOL, list, &err);
-			break;
-		case DBUS_TYPE_INT32:
-			list = value_list_from_int_array(&iter);
-			gconf_client_set_list(client, key, GCONF_VALUE_INT, list, &err);
-			break;
-		case DBUS_TYPE_DOUBLE:
-			list = value_list_from_float_array(&iter);
-			gconf_client_set_list(client, key, GCONF_VALUE_FLOAT, list, &err);
-			break;
-		case DBUS_TYPE_STRING:
-			list = value_list_from_string_array(&iter);
-			gconf_client_set_list(client, key, GCONF_VALUE_STRING, list, &err);
-			break;
-		default:
-			reply = dbus_message_new_error(msg, DBUS_ERROR_INVALID_ARGS,
-						       "unexpected value array type");
-			goto EXIT;
-
-		}
-		break;
-
-	default:
+	const char *invalid = config_set_value_from_iter(client, key, &iter, &err);
+	if( invalid ) {
 		reply = dbus_message_new_error(msg, DBUS_ERROR_INVALID_ARGS,
-					       "unexpected value type");
+					       invalid);
 		goto EXIT;
 	}
 
@@ -3800,8 +5109,6 @@ static gboolean config_set_dbus_cb(DBusMessage *const msg)
 	}
 
 EXIT:
-	value_list_free(list);
-
 	/* Send a reply if we have one */
 	if( reply ) {
 		if( dbus_message_get_no_reply(msg) ) {
@@ -3820,6 +5127,242 @@ EXIT:
 	return status;
 }
 
+/** D-Bus callback for the config set batch -method call
+ *
+ * All key/value pairs are validated before any of them are applied,
+ * so that either all or none of the settings get changed. If applying
+ * a value still fails, already applied values are restored and an
+ * error reply is sent. Values are saved to disk once, and D-Bus change
+ * notifications are sent only after all values have been updated.
+ *
+ * @param msg The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean config_set_batch_dbus_cb(DBusMessage *const msg)
+{
+	DBusMessage *reply  = 0;
+	GConfClient *client = 0;
+	GError      *err    = 0;
+	GHashTable  *saved  = 0;
+	const char  *key    = 0;
+	const char  *why    = 0;
+	int          count  = 0;
+
+	DBusMessageIter body, array, dict, iter;
+
+	mce_log(LL_DEBUG, "Received configuration batch change request");
+
+	if( !(client = gconf_client_get_default()) )
+		goto EXIT;
+
+	dbus_message_iter_init(msg, &body);
+
+	if( dbus_message_iter_get_arg_type(&body) != DBUS_TYPE_ARRAY ||
+	    dbus_message_iter_get_element_type(&body) != DBUS_TYPE_DICT_ENTRY ) {
+		reply = dbus_message_new_error(msg, DBUS_ERROR_INVALID_ARGS,
+					       "expected a{sv}");
+		goto EXIT;
+	}
+
+	/* Validate all values before touching anything */
+	dbus_message_iter_recurse(&body, &array);
+	while( dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_DICT_ENTRY ) {
+		dbus_message_iter_recurse(&array, &dict);
+		dbus_message_iter_next(&array);
+
+		if( dbus_message_iter_get_arg_type(&dict) != DBUS_TYPE_STRING ) {
+			why = "expected string key";
+			goto INVALID;
+		}
+		dbus_message_iter_get_basic(&dict, &key);
+		dbus_message_iter_next(&dict);
+
+		if( dbus_message_iter_get_arg_type(&dict) != DBUS_TYPE_VARIANT ) {
+			why = "expected variant value";
+			goto INVALID;
+		}
+		dbus_message_iter_recurse(&dict, &iter);
+
+		if( (why = config_check_value_from_iter(client, key, &iter)) )
+			goto INVALID;
+
+		++count;
+	}
+
+	/* Apply values and broadcast the changes as one batch. Old values
+	 * are saved so that everything can be rolled back on failure. */
+	saved = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+				      (GDestroyNotify)gconf_value_free);
+
+	gconf_client_batch_begin(client);
+
+	dbus_message_iter_recurse(&body, &array);
+	while( dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_DICT_ENTRY ) {
+		dbus_message_iter_recurse(&array, &dict);
+		dbus_message_iter_next(&array);
+
+		dbus_message_iter_get_basic(&dict, &key);
+		dbus_message_iter_next(&dict);
+		dbus_message_iter_recurse(&dict, &iter);
+
+		if( !g_hash_table_contains(saved, key) ) {
+			GConfValue *prev = gconf_client_get(client, key, 0);
+			if( prev )
+				g_hash_table_insert(saved, g_strdup(key), prev);
+		}
+
+		config_set_value_from_iter(client, key, &iter, &err);
+		if( err )
+			break;
+	}
+
+	if( err ) {
+		mce_log(LL_ERR, "%s: %s; rolling back", key, err->message);
+
+		GHashTableIter iter_saved;
+		gpointer       saved_key, saved_val;
+
+		g_hash_table_iter_init(&iter_saved, saved);
+		while( g_hash_table_iter_next(&iter_saved, &saved_key,
+					      &saved_val) )
+			config_restore_value(client, saved_key, saved_val);
+
+		gconf_client_batch_end(client);
+
+		char *txt = g_strdup_printf("%s: %s", key, err->message);
+		reply = dbus_message_new_error(msg, "com.nokia.mce.GConf.Error",
+					       txt);
+		g_free(txt);
+		goto EXIT;
+	}
+
+	gconf_client_suggest_sync(client, &err);
+	if( err ) {
+		mce_log(LL_ERR, "gconf_client_suggest_sync: %s", err->message);
+		g_clear_error(&err);
+	}
+
+	gconf_client_batch_end(client);
+
+	mce_log(LL_DEBUG, "applied %d settings", count);
+
+	reply = dbus_new_method_reply(msg);
+	{
+		dbus_bool_t arg = TRUE;
+		dbus_message_append_args(reply,
+					 DBUS_TYPE_BOOLEAN, &arg,
+					 DBUS_TYPE_INVALID);
+	}
+	goto EXIT;
+
+INVALID:
+	{
+		char *txt = g_strdup_printf("%s: %s", key ?: "?", why);
+		reply = dbus_message_new_error(msg, DBUS_ERROR_INVALID_ARGS, txt);
+		g_free(txt);
+	}
+
+EXIT:
+	if( !dbus_message_get_no_reply(msg) ) {
+		if( !reply )
+			reply = dbus_message_new_error(msg, "com.nokia.mce.GConf.Error",
+						       "unknown");
+		if( reply )
+			dbus_send_message(reply), reply = 0;
+	}
+
+	if( reply )
+		dbus_message_unref(reply);
+
+	if( saved )
+		g_hash_table_unref(saved);
+
+	g_clear_error(&err);
+
+	return TRUE;
+}
+
+/** D-Bus callback for the config get batch -method call
+ *
+ * @param req The D-Bus message to reply to
+ *
+ * @return TRUE
+ */
+static gboolean config_get_batch_dbus_cb(DBusMessage *const req)
+{
+	GConfClient  *cli     = 0;
+	DBusMessage  *rsp     = 0;
+	GSList       *entries = 0;
+	char        **keys    = 0;
+	int           count   = 0;
+	DBusError     err     = DBUS_ERROR_INIT;
+
+	mce_log(LL_DEBUG, "Received configuration batch query request");
+
+	if( !dbus_message_get_args(req, &err,
+				   DBUS_TYPE_ARRAY, DBUS_TYPE_STRING,
+				   &keys, &count,
+				   DBUS_TYPE_INVALID) ) {
+		mce_log(LL_WARN, "%s: %s", err.name, err.message);
+		rsp = dbus_message_new_error(req, err.name, err.message);
+		goto EXIT;
+	}
+
+	if( !(cli = gconf_client_get_default()) )
+		goto EXIT;
+
+	for( int i = 0; i < count; ++i ) {
+		GConfEntry *entry = 0;
+
+		for( GSList *item = cli->entries; item; item = item->next ) {
+			if( !strcmp(gconf_entry_get_key(item->data), keys[i]) ) {
+				entry = item->data;
+				break;
+			}
+		}
+
+		if( !entry ) {
+			char *txt = g_strdup_printf("%s: unknown key", keys[i]);
+			rsp = dbus_message_new_error(req, DBUS_ERROR_INVALID_ARGS,
+						     txt);
+			g_free(txt);
+			goto EXIT;
+		}
+
+		entries = g_slist_prepend(entries, entry);
+	}
+	entries = g_slist_reverse(entries);
+
+	rsp = dbus_new_method_reply(req);
+
+	DBusMessageIter body;
+
+	dbus_message_iter_init_append(rsp, &body);
+
+	if( !append_gconf_entries_to_dbus_iterator(&body, entries) )
+		dbus_message_unref(rsp), rsp = 0;
+
+EXIT:
+
+	if( !dbus_message_get_no_reply(req) ) {
+		if( !rsp )
+			rsp = dbus_message_new_error(req, "com.nokia.mce.GConf.Error",
+						     "unknown");
+		if( rsp )
+			dbus_send_message(rsp), rsp = 0;
+	}
+
+	if( rsp )
+		dbus_message_unref(rsp);
+
+	g_slist_free(entries);
+	dbus_free_string_array(keys);
+	dbus_error_free(&err);
+
+	return TRUE;
+}
+
 /* ========================================================================= *
  * MESSAGE_DISPATCH
  * ========================================================================= */
@@ -4001,8 +5544,6 @@ static DBusHandlerResult msg_handler(DBusConnection *const connection,
 {
 	(void)user_data;
 
-	mce_wakelock_obtain("dbus_recv", -1);
-
 	guint status = DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 	int   type   = dbus_message_get_type(msg);
 
@@ -4015,6 +5556,28 @@ static DBusHandlerResult msg_handler(DBusConnection *const connection,
 	if( sender )
 		peerinfo = mce_dbus_add_peerinfo(sender);
 
+	/* Account wakeups to client command line when known, so that
+	 * client restarts do not churn the accounting table. Fall back
+	 * to the private bus name of the sender while the owner details
+	 * are still being resolved or could not be resolved at all. */
+	if( mce_wakelock_account_is_enabled() ) {
+		const char *client = 0;
+		char        tag[128];
+
+		if( peerinfo )
+			client = peerinfo_get_owner_cmd(peerinfo);
+
+		snprintf(tag, sizeof tag, "dbus:%s:%s",
+			 client ?: sender ?: "unknown",
+			 member ?: "unknown");
+		mce_wakelock_obtain_tagged("dbus_recv", tag, -1);
+	}
+	else {
+		mce_wakelock_obtain("dbus_recv", -1);
+	}
+
+	int lagmon = mce_lagmon_enter(MCE_LAGMON_KIND_DBUS, member);
+
 	for( GSList *now = dbus_handlers; now; now = now->next ) {
 
 		handler_struct_t *handler = now->data;
@@ -4108,6 +5671,7 @@ static DBusHandlerResult msg_handler(DBusConnection *const connection,
 	mce_dbus_squeeze_slist(&dbus_handlers);
 
 EXIT:
+	mce_lagmon_leave(lagmon);
 
 	mce_wakelock_release("dbus_recv");
 
@@ -5160,6 +6724,20 @@ static mce_dbus_handler_t mce_dbus_handlers[] =
 			"    <arg name=\"key_name\" type=\"s\"/>\n"
 			"    <arg name=\"key_value\" type=\"v\"/>\n"
 	},
+	{
+		.interface = MCE_SIGNAL_IF,
+		.name      = MCE_CONFIG_BATCH_CHANGE_SIG,
+		.type      = DBUS_MESSAGE_TYPE_SIGNAL,
+		.args      =
+			"    <arg name=\"values\" type=\"a{sv}\"/>\n"
+	},
+	{
+		.interface = MCE_SIGNAL_IF,
+		.name      = MCE_PROPERTIES_CHANGED_SIG,
+		.type      = DBUS_MESSAGE_TYPE_SIGNAL,
+		.args      =
+			"    <arg name=\"properties\" type=\"a{sv}\"/>\n"
+	},
 	/* method calls */
 	{
 		.interface = MCE_REQUEST_IF,
@@ -5187,6 +6765,19 @@ static mce_dbus_handler_t mce_dbus_handlers[] =
 			"    <arg direction=\"out\" name=\"values\" type=\"a{sv}\"/>\n"
 			"    <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out0\" value=\"QVariantMap\"/>\n"
 	},
+	{
+		.interface = MCE_REQUEST_IF,
+		.name      = MCE_CONFIG_GET_CHANGES,
+		.type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+		.callback  = config_get_changes_dbus_cb,
+		.args      =
+			"    <arg direction=\"in\" name=\"epoch\" type=\"u\"/>\n"
+			"    <arg direction=\"in\" name=\"generation\" type=\"u\"/>\n"
+			"    <arg direction=\"out\" name=\"epoch\" type=\"u\"/>\n"
+			"    <arg direction=\"out\" name=\"generation\" type=\"u\"/>\n"
+			"    <arg direction=\"out\" name=\"values\" type=\"a{sv}\"/>\n"
+			"    <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out2\" value=\"QVariantMap\"/>\n"
+	},
 	{
 		.interface = MCE_REQUEST_IF,
 		.name      = MCE_CONFIG_SET,
@@ -5197,6 +6788,26 @@ static mce_dbus_handler_t mce_dbus_handlers[] =
 			"    <arg direction=\"in\" name=\"key_value\" type=\"v\"/>\n"
 			"    <arg direction=\"out\" name=\"success\" type=\"b\"/>\n"
 	},
+	{
+		.interface = MCE_REQUEST_IF,
+		.name      = MCE_CONFIG_SET_BATCH,
+		.type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+		.callback  = config_set_batch_dbus_cb,
+		.args      =
+			"    <arg direction=\"in\" name=\"values\" type=\"a{sv}\"/>\n"
+			"    <annotation name=\"org.qtproject.QtDBus.QtTypeName.In0\" value=\"QVariantMap\"/>\n"
+			"    <arg direction=\"out\" name=\"success\" type=\"b\"/>\n"
+	},
+	{
+		.interface = MCE_REQUEST_IF,
+		.name      = MCE_CONFIG_GET_BATCH,
+		.type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+		.callback  = config_get_batch_dbus_cb,
+		.args      =
+			"    <arg direction=\"in\" name=\"keys\" type=\"as\"/>\n"
+			"    <arg direction=\"out\" name=\"values\" type=\"a{sv}\"/>\n"
+			"    <annotation name=\"org.qtproject.QtDBus.QtTypeName.Out0\" value=\"QVariantMap\"/>\n"
+	},
 	{
 		.interface = MCE_REQUEST_IF,
 		.name      = MCE_CONFIG_RESET,
@@ -5215,6 +6826,23 @@ static mce_dbus_handler_t mce_dbus_handlers[] =
 			"    <arg direction=\"out\" name=\"uptime_ms\" type=\"x\"/>\n"
 			"    <arg direction=\"out\" name=\"suspend_ms\" type=\"x\"/>\n"
 	},
+	{
+		.interface = MCE_REQUEST_IF,
+		.name      = MCE_WAKEUP_REPORT_GET,
+		.type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+		.callback  = wakeup_report_get_dbus_cb,
+		.args      =
+			"    <arg direction=\"out\" name=\"wakeup_sources\" type=\"a(suux)\"/>\n"
+	},
+	{
+		.interface = MCE_REQUEST_IF,
+		.name      = MCE_DATAPIPE_GRAPH_GET,
+		.type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+		.callback  = datapipe_graph_get_dbus_cb,
+		.args      =
+			"    <arg direction=\"in\" name=\"format\" type=\"s\"/>\n"
+			"    <arg direction=\"out\" name=\"graph\" type=\"s\"/>\n"
+	},
 	{
 		.interface = MCE_REQUEST_IF,
 		.name      = MCE_VERBOSITY_GET,
@@ -5442,6 +7070,13 @@ void mce_dbus_exit(void)
 		dbus_handlers = 0;
 	}
 
+	/* Send pending signals before disconnecting */
+	dbusprop_quit();
+	sigslot_quit();
+
+	/* Release cached replies */
+	config_get_all_cache_flush();
+
 	/* Disconnect from D-Bus */
 	if (dbus_connection != NULL) {
 		mce_log(LL_DEBUG, "closing dbus connection");
@@ -82,6 +82,177 @@
 #  define MCE_BATTERY_LEVEL_REQ                   "req_battery_level"
 # endif // ENABLE_BATTERY_SIMULATION
 
+/** Query heartbeat timer wakeup statistics
+ *
+ * Available to all applications; meant for debugging wakeup related
+ * power consumption issues.
+ *
+ * @since mce 1.117.4
+ *
+ * @return dictionary of timer name to struct of uint32 values:
+ * - number of dispatches after resume from suspend, where the iphb
+ *   wakeup was programmed for the timer, i.e. it caused the wakeup
+ * - number of other dispatches, i.e. while awake or coalesced with
+ *   wakeup caused by something else
+ * - number of dispatches within  0 ...    9 ms from trigger time
+ * - number of dispatches within 10 ...   99 ms from trigger time
+ * - number of dispatches within 100 ...  999 ms from trigger time
+ * - number of dispatches within   1 ...    9 s from trigger time
+ * - number of dispatches 10 seconds or more after trigger time
+ */
+# define MCE_TIMER_STATS_GET                      "get_timer_stats"
+
+/** Query config values changed since given generation
+ *
+ * Available to all applications. Meant for clients that keep a copy
+ * of mce settings: the first query is made with zero epoch and
+ * generation, and subsequent ones with the values returned by the
+ * previous reply. Only values changed in between are then returned.
+ * If mce has been restarted, the epoch will not match and all values
+ * are returned.
+ *
+ * @since mce 1.117.4
+ *
+ * @param uint32: epoch from previous reply, or zero
+ * @param uint32: generation from previous reply, or zero
+ *
+ * @return uint32: current epoch
+ * @return uint32: current generation
+ * @return dictionary of config key to variant value
+ */
+# define MCE_CONFIG_GET_CHANGES                   "get_config_changes"
+
+/** Query cpu keepalive client statistics
+ *
+ * Available to all applications; meant for finding clients that
+ * keep the device from suspending.
+ *
+ * @since mce 1.117.4
+ *
+ * @return array of structs, one per tracked client:
+ * - string: dbus name of the client
+ * - string: client process identification
+ * - uint32: number of active sessions
+ * - uint32: number of sessions started
+ * - uint32: number of session renewals
+ * - uint64: total session duration [ms]
+ * - uint64: time since client was first seen [ms]
+ */
+# define MCE_CPU_KEEPALIVE_STATS_GET              "get_cpu_keepalive_stats"
+
+/** Set multiple config values in one transaction
+ *
+ * All values are validated before any of them are applied; if any
+ * key is unknown or value has wrong type, nothing is changed and an
+ * error reply is sent. Values are saved once and change signals are
+ * sent after all values have been updated.
+ *
+ * @since mce 1.117.4
+ *
+ * @param dictionary of config key to variant value
+ *
+ * @return boolean true on success, or error reply
+ */
+# define MCE_CONFIG_SET_BATCH                     "set_config_batch"
+
+/** Get multiple config values in one query
+ *
+ * @since mce 1.117.4
+ *
+ * @param array of config keys
+ *
+ * @return dictionary of config key to variant value, or error reply
+ *         if any of the keys is unknown
+ */
+# define MCE_CONFIG_GET_BATCH                     "get_config_batch"
+
+/** Signal sent after a batch of config values has been changed
+ *
+ * Sent in addition to the per-value #MCE_CONFIG_CHANGE_SIG signals.
+ *
+ * @since mce 1.117.4
+ *
+ * @param dictionary of changed config key to variant value
+ */
+# define MCE_CONFIG_BATCH_CHANGE_SIG              "config_batch_change_ind"
+
+/** Signal sent after a batch of published property values has changed
+ *
+ * Sent in addition to the per-property change signals, for example
+ * #MCE_INACTIVITY_SIG and #MCE_TOUCH_INPUT_POLICY_SIG.
+ *
+ * @since mce 1.117.4
+ *
+ * @param dictionary of changed property, i.e. change signal name,
+ *        to variant value
+ */
+# define MCE_PROPERTIES_CHANGED_SIG               "properties_changed_ind"
+
+/** Query main loop stall statistics
+ *
+ * Available to all applications; meant for finding out what keeps
+ * mce main loop busy for extended periods of time.
+ *
+ * @since mce 1.117.4
+ *
+ * @return struct of uint32 values describing latency histogram for
+ *         a high priority probe timer:
+ * - number of dispatches within  0 ...    9 ms from trigger time
+ * - number of dispatches within 10 ...   99 ms from trigger time
+ * - number of dispatches within 100 ...  999 ms from trigger time
+ * - number of dispatches within   1 ...    9 s from trigger time
+ * - number of dispatches 10 seconds or more after trigger time
+ *
+ * @return array of structs describing stall offenders, worst first:
+ * - string: dispatch kind and name, e.g. "dbus:req_display_state_on"
+ * - uint32: number of stalls
+ * - uint32: longest stall [ms]
+ * - uint32: total stall time [ms]
+ */
+# define MCE_MAINLOOP_STATS_GET                   "get_mainloop_stats"
+
+/** Query wakeup source accounting data
+ *
+ * Available to all applications; meant for finding out which mce
+ * subsystems keep the device from suspending, or resume it.
+ *
+ * The first hold that starts after a resume from suspend has been
+ * detected is counted as a wakeup. Accounting is enabled via the
+ * WakeupAccounting setting in the [Wakelock] config group; while it
+ * is disabled, the report is empty.
+ *
+ * @since mce 1.117.4
+ *
+ * @return array of structs describing wakeup sources, longest held first:
+ * - string: subsystem and object, e.g. "iomon:/dev/input/event0",
+ *           "hbtimer:inactivity" or "dbus:/usr/bin/app:req_tklock_mode_change"
+ * - uint32: number of wakeups
+ * - uint32: number of wakelock holds
+ * - int64:  cumulative wakelock hold time [ms]
+ */
+# define MCE_WAKEUP_REPORT_GET                    "get_wakeup_report"
+
+/** Query live datapipe dependency graph
+ *
+ * Available to all applications; meant for finding out pointless
+ * datapipe fan-out and re-execution chains.
+ *
+ * The graph is built from datapipe bindings registered by modules
+ * and from observed datapipe executions. Edges carry execution counts
+ * and cumulative execution times. Dependency cycles between datapipes
+ * are listed separately.
+ *
+ * Executions are tracked only when TrackGraph is enabled in the
+ * [Datapipe] config group; otherwise only the bindings are reported.
+ *
+ * @since mce 1.117.4
+ *
+ * @param format string: "dot" for graphviz, or "json"
+ *
+ * @return string: graph description in requested format
+ */
+# define MCE_DATAPIPE_GRAPH_GET                   "get_datapipe_graph"
+
 /* ========================================================================= *
  * DSME DBUS SERVICE
  * ========================================================================= */
@@ -228,6 +399,11 @@ DBusMessage *dbus_new_method_call(const gchar *const service,
 DBusMessage *dbus_new_method_reply(DBusMessage *const message);
 
 gboolean dbus_send_message(DBusMessage *const msg);
+gboolean dbus_send_signal_coalesced(DBusMessage *const msg, const char *tag,
+                                    int min_interval);
+
+gboolean mce_dbus_property_publish(const char *name, int type, const void *value);
+gboolean mce_dbus_property_reply(DBusMessage *const req, const char *name);
 
 gboolean dbus_send(const gchar *const service, const gchar *const path,
                    const gchar *const interface, const gchar *const name,
@@ -254,6 +430,7 @@ gboolean dbus_send_ex2(const char *service,
                        int first_arg_type, ...);
 
 void mce_dbus_send_config_notification(GConfEntry *entry);
+void mce_dbus_send_config_batch_notification(GSList *entries);
 
 const char *mce_dbus_type_repr(int type);
 char *mce_dbus_message_repr(DBusMessage *const msg);
@@ -29,6 +29,11 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-lib.h"
+#include "mce-conf.h"
+#include "mce-dbus.h"
+#include "mce-lagmon.h"
+#include "mce-timerheap.h"
+#include "mce-wakelock.h"
 
 #ifdef ENABLE_WAKELOCKS
 # include "libwakelock.h"
@@ -44,6 +49,8 @@
 
 #include <iphbd/libiphb.h>
 
+#include <mce/dbus-names.h>
+
 /* ========================================================================= *
  * Types and functions
  * ========================================================================= */
@@ -72,6 +79,12 @@ struct mce_hbtimer_t
 
     /** User data to pass to hbt_notify() */
     void       *hbt_user_data;
+
+    /** Wakeup class */
+    mce_hbtimer_class_t hbt_class;
+
+    /** Position in trigger time ordered timer heap */
+    mce_timerheap_node_t hbt_node;
 };
 
 mce_hbtimer_t * mce_hbtimer_create         (const char *name, int period, GSourceFunc notify, void *user_data);
@@ -80,6 +93,8 @@ void            mce_hbtimer_delete         (mce_hbtimer_t *self);
 bool            mce_hbtimer_is_active      (const mce_hbtimer_t *self);
 const char     *mce_hbtimer_get_name       (const mce_hbtimer_t *self);
 void            mce_hbtimer_set_period     (mce_hbtimer_t *self, int period);
+void            mce_hbtimer_set_class      (mce_hbtimer_t *self, mce_hbtimer_class_t cls);
+static mce_timerheap_t *mce_hbtimer_heap   (const mce_hbtimer_t *self);
 void            mce_hbtimer_start          (mce_hbtimer_t *self);
 void            mce_hbtimer_stop           (mce_hbtimer_t *self);
 
@@ -99,15 +114,66 @@ static guint    mht_add_iowatch            (int fd, bool close_on_unref, GIOCond
  * QUEUE_MANAGEMENT
  * ------------------------------------------------------------------------- */
 
-/** List of registered timers */
-static GSList *mht_queue_timer_list = 0;
+/** Set of registered timers */
+static GHashTable *mht_queue_timer_lut = 0;
+
+/** Started timers, ordered by trigger time, one heap per wakeup class */
+static mce_timerheap_t *mht_queue_timer_heap[MCE_HBTIMER_CLASS_COUNT];
+
+/** How much timer triggering can be delayed for wakeup coalescing [ms] */
+static gint mht_queue_wakeup_slack = MCE_DEFAULT_HBTIMER_SLACK;
+
+/** How much deferrable timer triggering can be delayed [ms] */
+static gint mht_queue_defer_max = MCE_DEFAULT_HBTIMER_DEFER_MAX;
 
+/** Timer whose trigger time was used for the latest iphb wakeup */
+static const mce_hbtimer_t *mht_queue_armed_timer = 0;
+
+/** CLOCK_BOOTTIME - CLOCK_MONOTONIC at the latest dispatch [ms] */
+static int64_t mht_queue_suspend_skew = 0;
+
+static gint     mht_queue_compare_trigger  (gconstpointer a, gconstpointer b);
 void            mht_queue_dispatch_timers  (void);
 static void     mht_queue_schedule_wakeups (void);
-static void     mht_queue_garbage_collect  (void);
 static void     mht_queue_add_timer        (mce_hbtimer_t *self);
 static void     mht_queue_remove_timer     (mce_hbtimer_t *self);
 static bool     mht_queue_has_timer        (const mce_hbtimer_t *self);
+static bool     mht_queue_detect_resume    (void);
+
+/* ------------------------------------------------------------------------- *
+ * WAKEUP_STATS
+ * ------------------------------------------------------------------------- */
+
+/** Number of dispatch delay histogram buckets */
+#define MHT_STATS_DELAY_BUCKETS 5
+
+/** Wakeup statistics for timers with the same name */
+typedef struct
+{
+    /** Dispatches after resume from suspend caused by this timer */
+    guint32 mhs_wakeups;
+
+    /** Other dispatches, i.e. while awake or after a wakeup
+     *  caused by something else */
+    guint32 mhs_coalesced;
+
+    /** Dispatch delay histogram: <10ms, <100ms, <1s, <10s, >=10s */
+    guint32 mhs_delay[MHT_STATS_DELAY_BUCKETS];
+} mht_stats_t;
+
+/** Timer name -> mht_stats_t lookup table */
+static GHashTable *mht_stats_lut = 0;
+
+static void     mht_stats_update           (const mce_hbtimer_t *timer, bool wakeup, int64_t delay);
+static void     mht_stats_quit             (void);
+
+/* ------------------------------------------------------------------------- *
+ * DBUS_HANDLERS
+ * ------------------------------------------------------------------------- */
+
+static gboolean mht_dbus_timer_stats_get_cb(DBusMessage *const req);
+static void     mht_dbus_init              (void);
+static void     mht_dbus_quit              (void);
 
 /* ------------------------------------------------------------------------- *
  * GLIB_WAKEUPS
@@ -132,11 +198,14 @@ static void     mht_glib_set_wakeup        (int64_t trigger, int64_t now);
 /** Cached timestamp of last requested iphb wakeup */
 static int64_t  mht_iphb_wakeup_tick = NO_TICK;
 
+/** Cached upper bound of last requested iphb wakeup range [s] */
+static int      mht_iphb_wakeup_hi = 0;
+
 /** Source id for iphb wakeup input watch */
 static guint   mht_iphb_wakeup_watch_id = 0;
 
 static gboolean mht_iphb_wakeup_cb         (GIOChannel *chn, GIOCondition cnd, gpointer data);
-static void     mht_iphb_set_wakeup        (int64_t trigger, int64_t now);
+static void     mht_iphb_set_wakeup        (int64_t trigger, int64_t limit, int64_t now);
 
 /* ------------------------------------------------------------------------- *
  * IPHB_CONNECTION
@@ -251,6 +320,9 @@ mce_hbtimer_create(const char  *name,
     self->hbt_user_data = user_data;
     self->hbt_trigger   = NO_TICK;
     self->hbt_in_notify = false;
+    self->hbt_class     = MCE_HBTIMER_CLASS_WAKEUP;
+
+    mce_timerheap_node_init(&self->hbt_node, self);
 
     mht_queue_add_timer(self);
 
@@ -324,6 +396,51 @@ mce_hbtimer_set_period(mce_hbtimer_t *self, int period)
         self->hbt_period = period;
 }
 
+/** Set heatbeat timer wakeup class
+ *
+ * @param self   heartbeat timer object, or NULL
+ * @param cls    wakeup class
+ */
+void
+mce_hbtimer_set_class(mce_hbtimer_t *self, mce_hbtimer_class_t cls)
+{
+    if( !self )
+        goto EXIT;
+
+    if( cls < 0 || cls >= MCE_HBTIMER_CLASS_COUNT )
+        goto EXIT;
+
+    if( self->hbt_class == cls )
+        goto EXIT;
+
+    /* Move started timer to the heap of the new class */
+    bool queued = mce_timerheap_node_is_queued(&self->hbt_node);
+
+    mce_timerheap_remove(mce_hbtimer_heap(self), &self->hbt_node);
+    self->hbt_class = cls;
+
+    if( queued ) {
+        mce_timerheap_insert(mce_hbtimer_heap(self), &self->hbt_node,
+                             self->hbt_trigger);
+        mht_queue_schedule_wakeups();
+    }
+
+EXIT:
+    return;
+}
+
+/** Get timer heap matching heatbeat timer wakeup class
+ *
+ * @param self   heartbeat timer object
+ *
+ * @return timer heap
+ */
+static mce_timerheap_t *
+mce_hbtimer_heap(const mce_hbtimer_t *self)
+{
+    return mht_queue_timer_heap[self->hbt_class];
+}
+
 /** Call heatbeat timer notification functiom
  *
  * @param self   heartbeat timer object, or NULL
@@ -337,13 +454,18 @@ mce_hbtimer_notify(mce_hbtimer_t *self)
     if( self->hbt_in_notify )
         goto EXIT;
 
-    if( !self->hbt_notify )
+    if( !self->hbt_notify ) {
+        self->hbt_trigger = NO_TICK;
         goto EXIT;
+    }
 
     self->hbt_in_notify = true;
     self->hbt_trigger   = NO_TICK;
 
-    bool again = self->hbt_notify(self->hbt_user_data);
+    int  lagmon = mce_lagmon_enter(MCE_LAGMON_KIND_TIMER,
+                                   mce_hbtimer_get_name(self));
+    bool again  = self->hbt_notify(self->hbt_user_data);
+    mce_lagmon_leave(lagmon);
 
     /* Check that notify callback did not delete the timer */
     if( !mht_queue_has_timer(self) )
@@ -370,10 +492,18 @@ mce_hbtimer_set_trigger(mce_hbtimer_t *self, int64_t trigger)
     if( !self )
         goto EXIT;
 
-    if( self->hbt_trigger == trigger )
+    /* Note: Timers being dispatched are not in the heap */
+    if( self->hbt_trigger == trigger &&
+        (trigger == NO_TICK || mce_timerheap_node_is_queued(&self->hbt_node)) )
         goto EXIT;
 
     self->hbt_trigger = trigger;
+
+    if( trigger == NO_TICK )
+        mce_timerheap_remove(mce_hbtimer_heap(self), &self->hbt_node);
+    else
+        mce_timerheap_insert(mce_hbtimer_heap(self), &self->hbt_node, trigger);
+
     mht_queue_schedule_wakeups();
 
 EXIT:
@@ -422,33 +552,6 @@ EXIT:
  * QUEUE_MANAGEMENT
  * ========================================================================= */
 
-/** Clean up unused timer list slots
- *
- * When timers are deleted, the associated node in mht_queue_timer_list
- * is left in place with data pointer set to zero.
- *
- * This function can be used to remove such stale entries in suitable
- * point outside the dispatch iteration loop.
- */
-static void
-mht_queue_garbage_collect(void)
-{
-    GSList **tail = &mht_queue_timer_list;
-
-    GSList *item;
-
-    while( (item = *tail) ) {
-        if( item->data ) {
-            tail = &item->next;
-        }
-        else {
-            *tail = item->next;
-            item->next = 0;
-            g_slist_free(item);
-        }
-    }
-}
-
 /** Predicate for: heartbeat timer is registered
  *
  * @param self   heartbeat timer object, or NULL
@@ -460,10 +563,10 @@ mht_queue_has_timer(const mce_hbtimer_t *self)
 {
     bool has_timer = false;
 
-    if( !self )
+    if( !self || !mht_queue_timer_lut )
         goto EXIT;
 
-    has_timer = g_slist_find(mht_queue_timer_list, self) != 0;
+    has_timer = g_hash_table_contains(mht_queue_timer_lut, self);
 
 EXIT:
     return has_timer;
@@ -479,13 +582,16 @@ mht_queue_add_timer(mce_hbtimer_t *self)
     if( !self )
         goto EXIT;
 
-    /* Try to find recyclable vacated timer slot */
-    GSList *item = g_slist_find(mht_queue_timer_list, 0);
+    /* Timers can be created before mce_hbtimer_init() */
+    if( !mht_queue_timer_lut )
+        mht_queue_timer_lut = g_hash_table_new(g_direct_hash, g_direct_equal);
 
-    if( item )
-        item->data = self;
-    else
-        mht_queue_timer_list = g_slist_prepend(mht_queue_timer_list, self);
+    for( int cls = 0; cls < MCE_HBTIMER_CLASS_COUNT; ++cls ) {
+        if( !mht_queue_timer_heap[cls] )
+            mht_queue_timer_heap[cls] = mce_timerheap_create();
+    }
+
+    g_hash_table_add(mht_queue_timer_lut, self);
 
 EXIT:
     return;
@@ -501,17 +607,23 @@ mht_queue_remove_timer(mce_hbtimer_t *self)
     if( !self )
         goto EXIT;
 
-    GSList *item = g_slist_find(mht_queue_timer_list, self);
+    mce_timerheap_remove(mce_hbtimer_heap(self), &self->hbt_node);
+
+    if( mht_queue_armed_timer == self )
+        mht_queue_armed_timer = 0;
 
-    /* Vacate the slot by clearing the data link */
-    if( item )
-        item->data = 0;
+    if( mht_queue_timer_lut )
+        g_hash_table_remove(mht_queue_timer_lut, self);
 
 EXIT:
     return;
 }
 
-/** Scan registered heartbeat timers and schdule nearest wakeup
+/** Schedule wakeup for the nearest heartbeat timer trigger
+ *
+ * Wakeup class timers can be delayed by configurable slack, precise
+ * timers are not delayed, and deferrable timers do not contribute
+ * to iphb wakeups at all.
  */
 static void
 mht_queue_schedule_wakeups(void)
@@ -519,40 +631,85 @@ mht_queue_schedule_wakeups(void)
     if( !mce_hbtimer_initialized )
         goto EXIT;
 
-    int64_t trigger = NO_TICK;
-    bool    compact = false;
+    int64_t wakeup =
+        mce_timerheap_next_wakeup(mht_queue_timer_heap[MCE_HBTIMER_CLASS_WAKEUP],
+                                  mht_queue_wakeup_slack);
+    int64_t precise =
+        mce_timerheap_next_deadline(mht_queue_timer_heap[MCE_HBTIMER_CLASS_PRECISE]);
+    int64_t deferred =
+        mce_timerheap_next_wakeup(mht_queue_timer_heap[MCE_HBTIMER_CLASS_DEFERRABLE],
+                                  mht_queue_defer_max);
 
-    for( GSList *item = mht_queue_timer_list; item; item = item->next ) {
-        mce_hbtimer_t *timer = item->data;
-
-        if( !timer )
-            compact = true;
-        else if( trigger > timer->hbt_trigger )
-            trigger = timer->hbt_trigger;
-    }
+    int64_t now = mce_lib_get_boot_tick();
 
-    if( compact )
-        mht_queue_garbage_collect();
+    /* Device must wake up for wakeup and precise timers */
+    int64_t trigger = MIN(wakeup, precise);
 
-    int64_t now = mce_lib_get_boot_tick();
+    /* Remember which timer the wakeup is programmed for */
+    mce_timerheap_node_t *armed =
+        mce_timerheap_peek(mht_queue_timer_heap[precise <= wakeup ?
+                                                MCE_HBTIMER_CLASS_PRECISE :
+                                                MCE_HBTIMER_CLASS_WAKEUP]);
+    mht_queue_armed_timer = armed ? armed->thn_owner : 0;
 
     if( trigger < now )
         trigger = now;
+    if( precise < now )
+        precise = now;
+
+    /* Deferrable timers are bounded only while not suspended */
+    int64_t local = MIN(trigger, deferred);
+    if( local < now )
+        local = now;
 
-    mht_glib_set_wakeup(trigger, now);
-    mht_iphb_set_wakeup(trigger, now);
+    mht_glib_set_wakeup(local, now);
+    mht_iphb_set_wakeup(trigger, precise, now);
 
 EXIT:
     return;
 }
 
-/** Scan registered heartbeat timers and notify triggered ones
+/** Heartbeat timer trigger time comparison for sorting
+ */
+static gint
+mht_queue_compare_trigger(gconstpointer a, gconstpointer b)
+{
+    const mce_hbtimer_t *ta = *(mce_hbtimer_t * const *)a;
+    const mce_hbtimer_t *tb = *(mce_hbtimer_t * const *)b;
+
+    return (ta->hbt_trigger > tb->hbt_trigger) -
+        (ta->hbt_trigger < tb->hbt_trigger);
+}
+
+/** Check if the device has been suspended since the previous check
+ *
+ * Uses the same CLOCK_BOOTTIME vs CLOCK_MONOTONIC skew heuristic as
+ * the resume detection in mce-io.c, but evaluated locally so that the
+ * result does not depend on which wakeup source gets dispatched first.
+ *
+ * @return true if suspend/resume cycle is detected, false otherwise
+ */
+static bool
+mht_queue_detect_resume(void)
+{
+    int64_t skew = mce_lib_get_boot_tick() - mce_lib_get_mono_tick();
+    bool    resumed = (skew - mht_queue_suspend_skew) >= 100;
+
+    if( resumed || skew < mht_queue_suspend_skew )
+        mht_queue_suspend_skew = skew;
+
+    return resumed;
+}
+
+/** Notify triggered heartbeat timers
  */
 void
 mht_queue_dispatch_timers(void)
 {
     static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
+    GPtrArray *due = 0;
+
     if( !mce_hbtimer_initialized )
         goto EXIT;
 
@@ -570,28 +727,84 @@ mht_queue_dispatch_timers(void)
 
     int64_t now = mce_lib_get_boot_tick();
 
-    for( GSList *item = mht_queue_timer_list; item; item = item->next ) {
-        mce_hbtimer_t *timer = item->data;
+    /* Wakeup is attributed only when resuming from suspend, and
+     * only to the timer the iphb wakeup was programmed for */
+    const mce_hbtimer_t *waker = 0;
+    if( mht_queue_detect_resume() )
+        waker = mht_queue_armed_timer;
+
+    /* Detach all triggered timers from the heap before making
+     * any callbacks, so that timers restarted from notify
+     * callbacks do not get dispatched again in this round */
+    due = g_ptr_array_new();
+
+    for( int cls = 0; cls < MCE_HBTIMER_CLASS_COUNT; ++cls ) {
+        mce_timerheap_t *heap = mht_queue_timer_heap[cls];
+
+        for( ;; ) {
+            mce_timerheap_node_t *node = mce_timerheap_peek(heap);
 
-        if( !timer )
+            if( !node || node->thn_deadline > now )
+                break;
+
+            mce_timerheap_pop(heap);
+            g_ptr_array_add(due, node->thn_owner);
+        }
+    }
+
+    /* Notify in trigger time order */
+    g_ptr_array_sort(due, mht_queue_compare_trigger);
+
+    /* Waker must be among the due timers */
+    if( waker ) {
+        guint i = 0;
+        while( i < due->len && g_ptr_array_index(due, i) != waker )
+            ++i;
+        if( i == due->len )
+            waker = 0;
+    }
+
+    if( due->len > 0 && mce_wakelock_account_is_enabled() ) {
+        const mce_hbtimer_t *owner = waker ?: g_ptr_array_index(due, 0);
+        gchar *tag = g_strdup_printf("hbtimer:%s",
+                                     mce_hbtimer_get_name(owner));
+        mce_wakelock_account_begin("mce_hbtimer_dispatch", tag);
+        g_free(tag);
+    }
+
+    for( guint i = 0; i < due->len; ++i ) {
+        mce_hbtimer_t *timer = g_ptr_array_index(due, i);
+
+        /* Deleted by previously notified timer? */
+        if( !mht_queue_has_timer(timer) )
             continue;
 
-        if( timer->hbt_trigger == NO_TICK )
+        /* Stopped or restarted by previously notified timer? */
+        if( timer->hbt_trigger == NO_TICK ||
+            mce_timerheap_node_is_queued(&timer->hbt_node) )
             continue;
 
         mce_log(LL_DEBUG, "%s T%+"PRId64" ms",
                 mce_hbtimer_get_name(timer),
                 now - timer->hbt_trigger);
 
-        if( now < timer->hbt_trigger )
-            continue;
+        mht_stats_update(timer, timer == waker, now - timer->hbt_trigger);
 
         mce_hbtimer_notify(timer);
+
+        /* Keep timers that were not notified in the heap */
+        if( mht_queue_has_timer(timer) &&
+            timer->hbt_trigger != NO_TICK &&
+            !mce_timerheap_node_is_queued(&timer->hbt_node) )
+            mce_timerheap_insert(mce_hbtimer_heap(timer), &timer->hbt_node,
+                                 timer->hbt_trigger);
     }
 
     /* Check the next timer to trigger */
     mht_queue_schedule_wakeups();
 
+    mce_wakelock_account_end("mce_hbtimer_dispatch");
+
 #ifdef ENABLE_WAKELOCKS
     wakelock_unlock("mce_hbtimer_dispatch");
 #endif
@@ -599,9 +812,204 @@ mht_queue_dispatch_timers(void)
     pthread_mutex_unlock(&mutex);
 
 EXIT:
+    if( due )
+        g_ptr_array_free(due, TRUE);
+
     return;
 }
 
+/* ========================================================================= *
+ * WAKEUP_STATS
+ * ========================================================================= */
+
+/** Update wakeup statistics for a dispatched timer
+ *
+ * @param timer  heartbeat timer object
+ * @param wakeup true if the timer caused the wakeup, false otherwise
+ * @param delay  dispatch time - trigger time [ms]
+ */
+static void
+mht_stats_update(const mce_hbtimer_t *timer, bool wakeup, int64_t delay)
+{
+    const char *name = mce_hbtimer_get_name(timer);
+
+    if( !mht_stats_lut )
+        mht_stats_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                              g_free, g_free);
+
+    mht_stats_t *stats = g_hash_table_lookup(mht_stats_lut, name);
+    if( !stats ) {
+        stats = g_new0(mht_stats_t, 1);
+        g_hash_table_insert(mht_stats_lut, g_strdup(name), stats);
+    }
+
+    if( wakeup )
+        stats->mhs_wakeups += 1;
+    else
+        stats->mhs_coalesced += 1;
+
+    int bucket = 0;
+    for( int64_t limit = 10; bucket < MHT_STATS_DELAY_BUCKETS - 1; limit *= 10 ) {
+        if( delay < limit )
+            break;
+        ++bucket;
+    }
+    stats->mhs_delay[bucket] += 1;
+}
+
+/** Release wakeup statistics
+ */
+static void
+mht_stats_quit(void)
+{
+    if( mht_stats_lut )
+        g_hash_table_unref(mht_stats_lut), mht_stats_lut = 0;
+}
+
+/* ========================================================================= *
+ * DBUS_HANDLERS
+ * ========================================================================= */
+
+/** D-Bus callback for the get timer statistics method call
+ *
+ * @param req The D-Bus method call message to be replied
+ *
+ * @return TRUE
+ */
+static gboolean
+mht_dbus_timer_stats_get_cb(DBusMessage *const req)
+{
+    DBusMessage      *rsp = 0;
+    DBusMessageIter  body;
+    DBusMessageIter  array;
+    DBusMessageIter  dict;
+    DBusMessageIter  entry;
+    GHashTableIter   iter;
+    gpointer         key;
+    gpointer         val;
+
+    mce_log(LL_DEVEL, "timer statistics req from %s",
+            mce_dbus_get_message_sender_ident(req));
+
+    if( dbus_message_get_no_reply(req) )
+        goto EXIT;
+
+    rsp = dbus_new_method_reply(req);
+
+    dbus_message_iter_init_append(rsp, &body);
+
+    if( !dbus_message_iter_open_container(&body, DBUS_TYPE_ARRAY,
+                                          DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                                          DBUS_TYPE_STRING_AS_STRING
+                                          DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_STRUCT_END_CHAR_AS_STRING
+                                          DBUS_DICT_ENTRY_END_CHAR_AS_STRING,
+                                          &array) )
+        goto EXIT;
+
+    if( mht_stats_lut )
+        g_hash_table_iter_init(&iter, mht_stats_lut);
+
+    while( mht_stats_lut && g_hash_table_iter_next(&iter, &key, &val) ) {
+        const mht_stats_t *stats = val;
+        const char        *name  = key;
+
+        if( !dbus_message_iter_open_container(&array, DBUS_TYPE_DICT_ENTRY,
+                                              0, &dict) )
+            goto ABANDON_ARRAY;
+
+        if( !dbus_message_iter_append_basic(&dict, DBUS_TYPE_STRING, &name) )
+            goto ABANDON_DICT;
+
+        if( !dbus_message_iter_open_container(&dict, DBUS_TYPE_STRUCT,
+                                              0, &entry) )
+            goto ABANDON_DICT;
+
+        if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+                                            &stats->mhs_wakeups) )
+            goto ABANDON_ENTRY;
+
+        if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+                                            &stats->mhs_coalesced) )
+            goto ABANDON_ENTRY;
+
+        for( int i = 0; i < MHT_STATS_DELAY_BUCKETS; ++i ) {
+            if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+                                                &stats->mhs_delay[i]) )
+                goto ABANDON_ENTRY;
+        }
+
+        if( !dbus_message_iter_close_container(&dict, &entry) )
+            goto ABANDON_DICT;
+
+        if( !dbus_message_iter_close_container(&array, &dict) )
+            goto ABANDON_ARRAY;
+    }
+
+    if( !dbus_message_iter_close_container(&body, &array) )
+        goto EXIT;
+
+    dbus_send_message(rsp), rsp = 0;
+
+    goto EXIT;
+
+ABANDON_ENTRY:
+    dbus_message_iter_abandon_container(&dict, &entry);
+
+ABANDON_DICT:
+    dbus_message_iter_abandon_container(&array, &dict);
+
+ABANDON_ARRAY:
+    dbus_message_iter_abandon_container(&body, &array);
+
+EXIT:
+    if( rsp )
+        dbus_message_unref(rsp);
+
+    return TRUE;
+}
+
+/** Array of dbus message handlers */
+static mce_dbus_handler_t mht_dbus_handlers[] =
+{
+    /* method calls */
+    {
+        .interface = MCE_REQUEST_IF,
+        .name      = MCE_TIMER_STATS_GET,
+        .type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+        .callback  = mht_dbus_timer_stats_get_cb,
+        .args      =
+            "    <arg direction=\"out\" name=\"timer_stats\" type=\"a{s(uuuuuuu)}\"/>\n"
+    },
+    /* sentinel */
+    {
+        .interface = 0
+    }
+};
+
+/** Add dbus handlers
+ */
+static void
+mht_dbus_init(void)
+{
+    mce_dbus_handler_register_array(mht_dbus_handlers);
+}
+
+/** Remove dbus handlers
+ */
+static void
+mht_dbus_quit(void)
+{
+    mce_dbus_handler_unregister_array(mht_dbus_handlers);
+}
+
 /* ========================================================================= *
  * GLIB_WAKEUPS
  * ========================================================================= */
@@ -741,10 +1149,11 @@ cleanup_nak:
 /** Reprogram iphb timeout for dispatching heartbeat timers
  *
  * @param trigger when to trigger
+ * @param limit   latest acceptable wakeup time, or NO_TICK
  * @param now     current time
  */
 static void
-mht_iphb_set_wakeup(int64_t trigger, int64_t now)
+mht_iphb_set_wakeup(int64_t trigger, int64_t limit, int64_t now)
 {
     /* Assume: iphb timer should be stopped */
     int lo = 0;
@@ -758,6 +1167,13 @@ mht_iphb_set_wakeup(int64_t trigger, int64_t now)
         lo = (int)delay;
         hi = lo + MHT_IPHB_WAKEUP_MAX_DELAY_S;
 
+        /* Precise timers narrow down the wakeup range */
+        if( limit != NO_TICK ) {
+            int64_t bound = (limit - now + 999) / 1000;
+            if( hi > bound )
+                hi = (int)MAX(bound, delay);
+        }
+
         /* Calculate the next full BOOTTIME second after low bound
          * of iphb wakeup. This is used for avoiding constant iphb
          * ipc when wakeups get re-evaluated.
@@ -776,8 +1192,9 @@ mht_iphb_set_wakeup(int64_t trigger, int64_t now)
         tick -= tick % 1000;
     }
 
-    if( mht_iphb_wakeup_tick != tick ) {
+    if( mht_iphb_wakeup_tick != tick || mht_iphb_wakeup_hi != hi ) {
         mht_iphb_wakeup_tick = tick;
+        mht_iphb_wakeup_hi   = hi;
 
         if( mht_connection_handle )
             iphb_wait2(mht_connection_handle, lo, hi, 0, 1);
@@ -943,7 +1360,7 @@ mht_connection_close(void)
         mce_log(LL_DEBUG, "iphb disconnected");
 
         /* reset last programmed wakeup */
-        mht_iphb_set_wakeup(NO_TICK, NO_TICK);
+        mht_iphb_set_wakeup(NO_TICK, NO_TICK, NO_TICK);
     }
 }
 
@@ -1053,9 +1470,25 @@ static void mht_datapipe_quit(void)
 void
 mce_hbtimer_init(void)
 {
+    /* Get wakeup coalescing configuration */
+    mht_queue_wakeup_slack = mce_conf_get_int(MCE_CONF_TIMER_GROUP,
+                                              MCE_CONF_HBTIMER_SLACK,
+                                              MCE_DEFAULT_HBTIMER_SLACK);
+    if( mht_queue_wakeup_slack < 0 )
+        mht_queue_wakeup_slack = 0;
+
+    mht_queue_defer_max = mce_conf_get_int(MCE_CONF_TIMER_GROUP,
+                                           MCE_CONF_HBTIMER_DEFER_MAX,
+                                           MCE_DEFAULT_HBTIMER_DEFER_MAX);
+    if( mht_queue_defer_max < 0 )
+        mht_queue_defer_max = 0;
+
     /* Connect to datapipes */
     mht_datapipe_init();
 
+    /* Expose wakeup statistics */
+    mht_dbus_init();
+
     /* Mark as initialized */
     mce_hbtimer_initialized = true;
 
@@ -1073,10 +1506,23 @@ mce_hbtimer_quit(void)
     /* Disconnect from datapipes */
     mht_datapipe_quit();
 
+    /* Remove dbus handlers */
+    mht_dbus_quit();
+    mht_stats_quit();
+
     /* Remove wakeups */
     mht_glib_set_wakeup(NO_TICK, NO_TICK);
-    mht_iphb_set_wakeup(NO_TICK, NO_TICK);
+    mht_iphb_set_wakeup(NO_TICK, NO_TICK, NO_TICK);
 
     /* close iphb connection */
     mht_connection_close();
+
+    /* Release timer queues; left-behind timers are detached
+     * and can still be deleted later on */
+    for( int cls = 0; cls < MCE_HBTIMER_CLASS_COUNT; ++cls )
+        mce_timerheap_delete(mht_queue_timer_heap[cls]),
+            mht_queue_timer_heap[cls] = 0;
+
+    if( mht_queue_timer_lut )
+        g_hash_table_unref(mht_queue_timer_lut), mht_queue_timer_lut = 0;
 }
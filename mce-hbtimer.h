@@ -34,14 +34,44 @@
 extern "C" {
 # endif
 
+/** Configuration group for timer settings */
+# define MCE_CONF_TIMER_GROUP           "Timers"
+
+/** How much heartbeat timer wakeups can be delayed for coalescing [ms] */
+# define MCE_CONF_HBTIMER_SLACK         "HeartbeatTimerSlack"
+# define MCE_DEFAULT_HBTIMER_SLACK      0
+
+/** How much deferrable heartbeat timers can be delayed [ms] */
+# define MCE_CONF_HBTIMER_DEFER_MAX     "DeferrableTimerMaxDelay"
+# define MCE_DEFAULT_HBTIMER_DEFER_MAX  12000
+
 typedef struct mce_hbtimer_t mce_hbtimer_t;
 
+/** Heartbeat timer wakeup classes */
+typedef enum
+{
+    /** Wakes up the device, possibly up to a heartbeat period late
+     *  when suspended; timers with nearby deadlines can be coalesced */
+    MCE_HBTIMER_CLASS_WAKEUP,
+
+    /** Wakes up the device as close to trigger time as possible */
+    MCE_HBTIMER_CLASS_PRECISE,
+
+    /** Does not wake up the device on its own, but is dispatched
+     *  along with the next wakeup caused by something else, or
+     *  after a bounded delay when the device is not suspended */
+    MCE_HBTIMER_CLASS_DEFERRABLE,
+
+    MCE_HBTIMER_CLASS_COUNT
+} mce_hbtimer_class_t;
+
 mce_hbtimer_t * mce_hbtimer_create      (const char *name, int period, GSourceFunc notify, void *user_data);
 void            mce_hbtimer_delete      (mce_hbtimer_t *self);
 
 bool            mce_hbtimer_is_active   (const mce_hbtimer_t *self);
 const char     *mce_hbtimer_get_name    (const mce_hbtimer_t *self);
 void            mce_hbtimer_set_period  (mce_hbtimer_t *self, int period);
+void            mce_hbtimer_set_class   (mce_hbtimer_t *self, mce_hbtimer_class_t cls);
 
 void            mce_hbtimer_start       (mce_hbtimer_t *self);
 void            mce_hbtimer_stop        (mce_hbtimer_t *self);
@@ -26,8 +26,8 @@
  * elements these functions turn in to "NOP and return failure".
  *
  * In addition to the above this module also:
- * - moves sensor input data via pipe from worker thread context to the
- *   thread that is running the glib mainloop.
+ * - moves sensor input data via eventfd signaled mailbox from worker
+ *   thread context to the thread that is running the glib mainloop.
  * - proxies diagnostic output from hybris-plugin to mce_log()
  * ========================================================================= */
 
@@ -45,6 +45,8 @@
 #include <errno.h>
 #include <dlfcn.h>
 
+#include <sys/eventfd.h>
+
 /* ========================================================================= *
  * On some devices using in theory supported hybris functionality can lead
  * to problems. As a solution mce side configuration files can be used to
@@ -72,34 +74,54 @@ static void mce_hybris_ps_set_hook(mce_hybris_ps_fn cb);
 static void mce_hybris_als_set_hook(mce_hybris_als_fn cb);
 
 /* ------------------------------------------------------------------------- *
- * Feeding sensor data via pipe to glib mainloop goes roughly as follows
+ * Feeding sensor data via mailbox to glib mainloop goes roughly as follows
  *
  * --- mce-libhybris-plugin worker thread --
  * 1) uses blocking poll_dev->poll() function to read sensor data
- * 2) uses a set of callbacks to write the data to a pipe
+ * 2) uses a set of callbacks to store the data to per-sensor mailbox
+ *    slots, only the latest sample of each sensor is retained
+ * 3) eventfd is signaled when the first slot becomes pending
  * --- mce-libhybris-module --
- * 3) iowatch reads the data from pipe
- * 4) and passes the data to mce via another set of callbacks
+ * 4) iowatch resets the eventfd and collects pending slots
+ * 5) and passes the data to mce via another set of callbacks
  * --- mce sensor handling code --
- * 5) can act on the data in the context that runs gmainloop
+ * 6) can act on the data in the context that runs gmainloop
+ *
+ * Thus a burst of sensor samples arriving before the mainloop gets
+ * to run costs one eventfd write and one mainloop wakeup.
  * ------------------------------------------------------------------------- */
 
-/** Sensor enumeration for mux @ worker thread -> pipe -> demux @ mainloop */
+/** Sensor enumeration for mux @ worker thread -> mailbox -> demux @ mainloop */
 enum
 {
   EVEPIPE_ALS,
   EVEPIPE_PS,
+  EVEPIPE_COUNT
 };
 
-/** Sensor data passed over pipe */
+/** Latest sensor data, written by worker thread, read by mainloop
+ *
+ * Consistency is guaranteed via sequence counter that is odd while
+ * the worker thread is updating the slot. Readers retry if the
+ * counter was odd or changed during read.
+ */
+typedef struct
+{
+  volatile gint  seq;   // update sequence counter
+  int64_t        time;  // time stamp from android side
+  float          value; // sensor data from android side
+} evepipe_slot_t;
+
+/** Mailbox statistics */
 typedef struct
 {
-  int64_t time;  // time stamp from android side
-  int32_t type;  // EVEPIPE_ALS or EVEPIPE_PS
-  float   value; // sensor data from android side
-} evepipe_t;
+  volatile gint posted;      // samples written by worker thread
+  volatile gint overwritten; // samples replaced before mainloop saw them
+  volatile gint dropped;     // samples that could not be delivered
+  volatile gint wakeups;     // eventfd signals sent
+} evepipe_stats_t;
 
-/** Initialize once flag for sensor data pipe */
+/** Initialize once flag for sensor data mailbox */
 static bool evepipe_done = false;
 
 /** Callback for handling proximity data */
@@ -108,13 +130,71 @@ static mce_hybris_ps_fn  evepipe_ps_cb  = 0;
 /** Callback for handling ambient light data */
 static mce_hybris_als_fn evepipe_als_cb = 0;
 
-/** The sensor data pipe */
-static int               evepipe_fd[2]  = { -1, -1 };
+/** Mailbox slots, indexed by sensor type */
+static evepipe_slot_t    evepipe_slot[EVEPIPE_COUNT];
 
-/** I/O watch id for the sensor data pipe */
+/** Bitmask of slots holding samples not yet seen by mainloop */
+static volatile guint    evepipe_pending = 0;
+
+/** Mailbox statistics */
+static evepipe_stats_t   evepipe_stats;
+
+/** Eventfd for waking up the mainloop */
+static int               evepipe_fd     = -1;
+
+/** I/O watch id for the eventfd */
 static guint             evepipe_id     = 0;
 
-/** I/O watch callback for handling pipe input
+/** Log mailbox statistics if there has been losses since last time
+ */
+static void evepipe_log_stats(void)
+{
+  static gint overwritten = 0;
+  static gint dropped     = 0;
+
+  gint o = g_atomic_int_get(&evepipe_stats.overwritten);
+  gint d = g_atomic_int_get(&evepipe_stats.dropped);
+
+  if( o == overwritten && d == dropped )
+    goto EXIT;
+
+  overwritten = o;
+  dropped     = d;
+
+  mce_log(LL_DEBUG, "sensor mailbox: posted=%d overwritten=%d "
+          "dropped=%d wakeups=%d",
+          g_atomic_int_get(&evepipe_stats.posted), o, d,
+          g_atomic_int_get(&evepipe_stats.wakeups));
+
+EXIT:
+  return;
+}
+
+/** Read latest sample from mailbox slot
+ *
+ * @param type      EVEPIPE_ALS or EVEPIPE_PS
+ * @param timestamp where to store time stamp
+ * @param data      where to store sensor data
+ */
+static void evepipe_read_slot(int type, int64_t *timestamp, float *data)
+{
+  evepipe_slot_t *slot = &evepipe_slot[type];
+
+  for( ;; ) {
+    gint seq = g_atomic_int_get(&slot->seq);
+
+    if( seq & 1 )
+      continue;
+
+    *timestamp = slot->time;
+    *data      = slot->value;
+
+    if( g_atomic_int_get(&slot->seq) == seq )
+      break;
+  }
+}
+
+/** I/O watch callback for handling mailbox notifications
  *
  * @param channel    (not used)
  * @param condition  (not used)
@@ -131,43 +211,52 @@ static gboolean evepipe_recv_cb(GIOChannel *channel,
 
   gboolean keep_going = TRUE;
 
-  evepipe_t eve[64];
+  uint64_t cnt = 0;
 
   if( condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL) )
   {
     keep_going = FALSE;
   }
 
-  int rc = read(evepipe_fd[0], eve, sizeof eve);
-
-  if( rc < 0 ) {
+  /* Reset the eventfd before collecting pending slots, so
+   * that samples posted after this get signaled again */
+  if( read(evepipe_fd, &cnt, sizeof cnt) < 0 ) {
     switch( errno ) {
     case EINTR:
     case EAGAIN:
       break;
 
     default:
-      mce_log(LL_ERR, "failed to read sensor events: %m");
+      mce_log(LL_ERR, "failed to read sensor eventfd: %m");
       keep_going = FALSE;
-      break;
+      goto cleanup;
     }
-    goto cleanup;
   }
 
-  rc /= sizeof *eve;
+  guint pending = g_atomic_int_and(&evepipe_pending, 0);
+
+  for( int type = 0; type < EVEPIPE_COUNT; ++type ) {
+    if( !(pending & (1u << type)) )
+      continue;
+
+    int64_t time  = 0;
+    float   value = 0;
 
-  for( int i = 0; i < rc; ++i ) {
-    switch( eve[i].type ) {
+    evepipe_read_slot(type, &time, &value);
+
+    switch( type ) {
     case EVEPIPE_PS:
-      if( evepipe_ps_cb ) {
-        evepipe_ps_cb(eve[i].time, eve[i].value);
-      }
+      if( evepipe_ps_cb )
+        evepipe_ps_cb(time, value);
+      else
+        g_atomic_int_inc(&evepipe_stats.dropped);
       break;
 
     case EVEPIPE_ALS:
-      if( evepipe_als_cb ) {
-        evepipe_als_cb(eve[i].time, eve[i].value);
-      }
+      if( evepipe_als_cb )
+        evepipe_als_cb(time, value);
+      else
+        g_atomic_int_inc(&evepipe_stats.dropped);
       break;
 
     default:
@@ -175,17 +264,21 @@ static gboolean evepipe_recv_cb(GIOChannel *channel,
     }
   }
 
+  evepipe_log_stats();
+
 cleanup:
 
   if( !keep_going )  {
-    mce_log(LL_CRIT, "disabling sensor event pipe iowatch");
+    mce_log(LL_CRIT, "disabling sensor event mailbox iowatch");
     evepipe_id = 0;
   }
 
   return keep_going;
 }
 
-/** Write sensor data to the pipe
+/** Store sensor data to the mailbox
+ *
+ * Called from worker thread context.
  *
  * @param timestamp nanoseconds
  * @param type      EVEPIPE_ALS or EVEPIPE_PS
@@ -193,24 +286,43 @@ cleanup:
  */
 static void evepipe_send(int64_t timestamp, int32_t type, float data)
 {
-  evepipe_t eve =
-  {
-    .time  = timestamp,
-    .type  = type,
-    .value = data,
-  };
-
-  int rc = TEMP_FAILURE_RETRY(write(evepipe_fd[1], &eve, sizeof eve));
-
-  if( rc != sizeof eve ) {
-    // TODO: since this happens from separate thread, we might want
-    //       to do something bit more clever in case the sensor data
-    //       overflows the pipe ...
-    mce_abort();
+  evepipe_slot_t *slot = &evepipe_slot[type];
+  guint           mask = 1u << type;
+
+  g_atomic_int_inc(&evepipe_stats.posted);
+
+  /* Update slot content */
+  g_atomic_int_inc(&slot->seq);
+  slot->time  = timestamp;
+  slot->value = data;
+  g_atomic_int_inc(&slot->seq);
+
+  /* Mark slot pending; signal only on empty -> non-empty transition */
+  guint prev = g_atomic_int_or(&evepipe_pending, mask);
+
+  if( prev & mask ) {
+    g_atomic_int_inc(&evepipe_stats.overwritten);
+  }
+  else if( !prev ) {
+    uint64_t cnt = 1;
+    int rc = TEMP_FAILURE_RETRY(write(evepipe_fd, &cnt, sizeof cnt));
+
+    if( rc == sizeof cnt ) {
+      g_atomic_int_inc(&evepipe_stats.wakeups);
+    }
+    else {
+      /* No wakeup is coming -> release everything that is pending,
+       * including slots marked by other threads meanwhile. Otherwise
+       * the next send would not see empty -> non-empty transition
+       * and the mailbox would stall permanently. */
+      guint lost = g_atomic_int_and(&evepipe_pending, 0u);
+      for( ; lost; lost &= lost - 1 )
+        g_atomic_int_inc(&evepipe_stats.dropped);
+    }
   }
 }
 
-/** Write PS data to the sensor data pipe
+/** Write PS data to the sensor data mailbox
  *
  * @param timestamp nanoseconds
  * @param distance  centimeters
@@ -220,7 +332,7 @@ static void evepipe_send_ps(int64_t timestamp, float distance)
   evepipe_send(timestamp, EVEPIPE_PS, distance);
 }
 
-/** Write ALS data to the sensor data pipe
+/** Write ALS data to the sensor data mailbox
  * @param timestamp nanoseconds
  * @param ligt      lux
  */
@@ -229,7 +341,7 @@ static void evepipe_send_als(int64_t timestamp, float light)
   evepipe_send(timestamp, EVEPIPE_ALS, light);
 }
 
-/** Close sensor data pipe
+/** Close sensor data mailbox
  *
  * @param reset_done true if we wish to return to uninitialized
  *                   state, or false to preserve "already tried
@@ -240,14 +352,19 @@ static void evepipe_quit(bool reset_done)
   /* remove io watch */
   if( evepipe_id ) g_source_remove(evepipe_id), evepipe_id = 0;
 
-  /* close pipe file descriptors */
-  if( evepipe_fd[1] != -1 ) close(evepipe_fd[1]), evepipe_fd[1] = -1;
-  if( evepipe_fd[0] != -1 ) close(evepipe_fd[0]), evepipe_fd[0] = -1;
+  /* close eventfd */
+  if( evepipe_fd != -1 ) close(evepipe_fd), evepipe_fd = -1;
 
-  if( reset_done ) evepipe_done = false;
+  if( reset_done ) {
+    mce_log(LL_DEBUG, "sensor mailbox: posted=%d overwritten=%d "
+            "dropped=%d wakeups=%d",
+            evepipe_stats.posted, evepipe_stats.overwritten,
+            evepipe_stats.dropped, evepipe_stats.wakeups);
+    evepipe_done = false;
+  }
 }
 
-/** Initialize sensor data pipe
+/** Initialize sensor data mailbox
  *
  * @return true on success, or false in case of errors
  */
@@ -261,11 +378,12 @@ static bool evepipe_init(void)
 
   evepipe_done = true;
 
-  if( pipe(evepipe_fd) == -1 ) {
+  if( (evepipe_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1 ) {
+    mce_log(LL_ERR, "failed to create sensor eventfd: %m");
     goto EXIT;
   }
 
-  if( !(chn = g_io_channel_unix_new(evepipe_fd[0])) ) {
+  if( !(chn = g_io_channel_unix_new(evepipe_fd)) ) {
     goto EXIT;
   }
 
@@ -29,6 +29,7 @@
 #include "mce.h"
 #include "mce-log.h"
 #include "mce-lib.h"
+#include "mce-lagmon.h"
 #include "mce-wakelock.h"
 
 #ifdef ENABLE_WAKELOCKS
@@ -627,6 +628,12 @@ static gboolean mce_io_mon_read_chunks(GIOChannel *source,
 	wakelock_lock("mce_input_handler", -1);
 #endif
 
+	if( iomon && mce_wakelock_account_is_enabled() ) {
+		gchar *tag = g_strdup_printf("iomon:%s", iomon->path);
+		mce_wakelock_account_begin("mce_input_handler", tag);
+		g_free(tag);
+	}
+
 	/* We get input from evdev nodes at resume, handle that 1st */
 	io_detect_resume();
 
@@ -721,6 +728,8 @@ EXIT:
 	g_clear_error(&error);
 	g_free(buffer);
 
+	mce_wakelock_account_end("mce_input_handler");
+
 #ifdef ENABLE_WAKELOCKS
 	/* Release the lock after we're done with processing it */
 	wakelock_unlock("mce_input_handler");
@@ -834,6 +843,9 @@ static gboolean mce_io_mon_input_cb(GIOChannel *source,
 
 	// input processing
 	if( condition & G_IO_IN ) {
+		int lagmon = mce_lagmon_enter(MCE_LAGMON_KIND_IOMON,
+					      iomon->path);
+
 		switch (iomon->type) {
 		case IOMON_STRING:
 			if( !mce_io_mon_read_string(source, condition, data) ) {
@@ -853,6 +865,8 @@ static gboolean mce_io_mon_input_cb(GIOChannel *source,
 			keep_going = FALSE;
 			break;
 		}
+
+		mce_lagmon_leave(lagmon);
 	}
 
 EXIT:
@@ -0,0 +1,629 @@
+/**
+ * @file mce-lagmon.c
+ *
+ * Mode Control Entity - Main loop stall detection
+ *
+ * <p>
+ *
+ * Copyright (c) 2026 Jolla Mobile Ltd
+ *
+ * <p>
+ *
+ * @author Simo Piiroinen <simo.piiroinen@jollamobile.com>
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mce-lagmon.h"
+
+#include "mce.h"
+#include "mce-log.h"
+#include "mce-lib.h"
+#include "mce-conf.h"
+#include "mce-dbus.h"
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include <mce/dbus-names.h>
+
+/* ========================================================================= *
+ * Types and functions
+ * ========================================================================= */
+
+/** Maximum depth of tracked dispatch scope nesting */
+#define MLM_SCOPE_MAX       8
+
+/** Maximum length of dispatch scope name */
+#define MLM_SCOPE_NAME_MAX  64
+
+/** Maximum number of distinct offenders to keep track of */
+#define MLM_OFFENDER_MAX    256
+
+/** Number of latency histogram buckets */
+#define MLM_STATS_BUCKETS   5
+
+/* ------------------------------------------------------------------------- *
+ * DISPATCH_SCOPE
+ * ------------------------------------------------------------------------- */
+
+/** Book keeping for code executing from main loop */
+typedef struct
+{
+    /** Kind of dispatch, one of MCE_LAGMON_KIND_xxx */
+    const char *mls_kind;
+
+    /** Name of D-Bus method, datapipe, iomon path or timer */
+    char        mls_name[MLM_SCOPE_NAME_MAX];
+
+    /** Monotonic time when scope was entered [ms] */
+    int64_t     mls_started;
+
+    /** Flag for: stall already attributed to a nested scope */
+    bool        mls_claimed;
+} mlm_scope_t;
+
+int                mce_lagmon_enter      (const char *kind, const char *name);
+void               mce_lagmon_leave      (int scope);
+
+/* ------------------------------------------------------------------------- *
+ * OFFENDER_STATS
+ * ------------------------------------------------------------------------- */
+
+/** Statistics for dispatch scopes that have stalled main loop */
+typedef struct
+{
+    /** Dispatch kind and name, used as hash table key too */
+    gchar   *mlo_name;
+
+    /** Number of stalls */
+    guint    mlo_count;
+
+    /** Longest stall [ms] */
+    guint    mlo_max_ms;
+
+    /** Sum of stall durations [ms] */
+    guint    mlo_total_ms;
+} mlm_offender_t;
+
+static mlm_offender_t *mlm_offender_create   (const char *name);
+static void            mlm_offender_delete   (mlm_offender_t *self);
+static void            mlm_offender_delete_cb(gpointer self);
+static gint            mlm_offender_compare  (gconstpointer a, gconstpointer b);
+
+static void            mlm_stats_add_stall   (const char *kind, const char *name, int64_t ms);
+static void            mlm_stats_add_latency (int64_t ms);
+static void            mlm_stats_init        (void);
+static void            mlm_stats_quit        (void);
+
+/* ------------------------------------------------------------------------- *
+ * LATENCY_PROBE
+ * ------------------------------------------------------------------------- */
+
+static gboolean        mlm_probe_cb          (gpointer aptr);
+static void            mlm_probe_start       (void);
+static void            mlm_probe_stop        (void);
+
+/* ------------------------------------------------------------------------- *
+ * DBUS_HANDLERS
+ * ------------------------------------------------------------------------- */
+
+static gboolean        mlm_dbus_stats_get_cb (DBusMessage *const req);
+static void            mlm_dbus_init         (void);
+static void            mlm_dbus_quit         (void);
+
+/* ------------------------------------------------------------------------- *
+ * MODULE_INIT
+ * ------------------------------------------------------------------------- */
+
+void                   mce_lagmon_init       (void);
+void                   mce_lagmon_quit       (void);
+
+/* ========================================================================= *
+ * DISPATCH_SCOPE
+ * ========================================================================= */
+
+/** Dispatch time that is considered a stall [ms], or 0 if disabled */
+static gint        mlm_stall_limit = 0;
+
+/** Stack of currently active dispatch scopes */
+static mlm_scope_t mlm_scope_stack[MLM_SCOPE_MAX];
+
+/** Number of currently active dispatch scopes */
+static int         mlm_scope_depth = 0;
+
+/** Monotonic time of the latest stall attributed to a scope [ms] */
+static int64_t     mlm_scope_last_stall = 0;
+
+/** Mark start of main loop dispatch that can be attributed to a stall
+ *
+ * Scopes can be nested - stalls are attributed to the innermost
+ * scope that exceeds the stall threshold.
+ *
+ * @param kind   dispatch kind, one of MCE_LAGMON_KIND_xxx
+ * @param name   name of D-Bus method, datapipe, iomon path or timer
+ *
+ * When stall tracking is disabled via configuration, this is a no-op
+ * and the returned token makes mce_lagmon_leave() a no-op too.
+ *
+ * @return scope token to pass to mce_lagmon_leave(),
+ *         or -1 if monitoring is not enabled
+ */
+int
+mce_lagmon_enter(const char *kind, const char *name)
+{
+    if( mlm_stall_limit <= 0 )
+        return -1;
+
+    int scope = mlm_scope_depth++;
+
+    if( scope < MLM_SCOPE_MAX ) {
+        mlm_scope_t *self = mlm_scope_stack + scope;
+
+        self->mls_kind    = kind;
+        self->mls_started = mce_lib_get_mono_tick();
+        self->mls_claimed = false;
+        g_strlcpy(self->mls_name, name ?: "unknown", sizeof self->mls_name);
+    }
+
+    return scope;
+}
+
+/** Mark end of main loop dispatch
+ *
+ * @param scope  scope token returned by mce_lagmon_enter()
+ */
+void
+mce_lagmon_leave(int scope)
+{
+    if( scope < 0 || scope >= mlm_scope_depth )
+        goto EXIT;
+
+    /* Unbalanced inner scopes are implicitly closed too */
+    mlm_scope_depth = scope;
+
+    if( scope >= MLM_SCOPE_MAX )
+        goto EXIT;
+
+    mlm_scope_t *self   = mlm_scope_stack + scope;
+    mlm_scope_t *parent = scope > 0 ? self - 1 : 0;
+
+    if( self->mls_claimed ) {
+        if( parent )
+            parent->mls_claimed = true;
+        goto EXIT;
+    }
+
+    int64_t now = mce_lib_get_mono_tick();
+    int64_t ms  = now - self->mls_started;
+
+    if( ms < mlm_stall_limit )
+        goto EXIT;
+
+    mlm_stats_add_stall(self->mls_kind, self->mls_name, ms);
+    mlm_scope_last_stall = now;
+
+    if( parent )
+        parent->mls_claimed = true;
+
+EXIT:
+    return;
+}
+
+/* ========================================================================= *
+ * OFFENDER_STATS
+ * ========================================================================= */
+
+/** Lookup table for offender statistics */
+static GHashTable *mlm_stats_offenders = 0;
+
+/** Histogram of probe dispatch latencies, bucketed like timer stats */
+static guint       mlm_stats_latency[MLM_STATS_BUCKETS];
+
+/** Create offender statistics object
+ *
+ * @param name  dispatch kind and name
+ *
+ * @return offender statistics object
+ */
+static mlm_offender_t *
+mlm_offender_create(const char *name)
+{
+    mlm_offender_t *self = g_slice_new0(mlm_offender_t);
+
+    self->mlo_name     = g_strdup(name);
+    self->mlo_count    = 0;
+    self->mlo_max_ms   = 0;
+    self->mlo_total_ms = 0;
+
+    return self;
+}
+
+/** Delete offender statistics object
+ *
+ * @param self  offender statistics object, or NULL
+ */
+static void
+mlm_offender_delete(mlm_offender_t *self)
+{
+    if( !self )
+        goto EXIT;
+
+    g_free(self->mlo_name);
+    g_slice_free(mlm_offender_t, self);
+
+EXIT:
+    return;
+}
+
+/** Type agnostic callback for deleting offender statistics object
+ *
+ * @param self  offender statistics object, or NULL
+ */
+static void
+mlm_offender_delete_cb(gpointer self)
+{
+    mlm_offender_delete(self);
+}
+
+/** Sort offenders in descending total stall time order
+ */
+static gint
+mlm_offender_compare(gconstpointer a, gconstpointer b)
+{
+    const mlm_offender_t *o1 = *(const mlm_offender_t * const *)a;
+    const mlm_offender_t *o2 = *(const mlm_offender_t * const *)b;
+
+    if( o1->mlo_total_ms != o2->mlo_total_ms )
+        return o1->mlo_total_ms < o2->mlo_total_ms ? 1 : -1;
+
+    return g_strcmp0(o1->mlo_name, o2->mlo_name);
+}
+
+/** Record main loop stall
+ *
+ * @param kind  dispatch kind
+ * @param name  dispatch name
+ * @param ms    duration of the stall
+ */
+static void
+mlm_stats_add_stall(const char *kind, const char *name, int64_t ms)
+{
+    if( !mlm_stats_offenders )
+        goto EXIT;
+
+    gchar *key = g_strdup_printf("%s:%s", kind ?: "unknown", name);
+
+    mce_log(LL_WARN, "main loop stalled for %" PRId64 " ms by %s", ms, key);
+
+    mlm_offender_t *offender = g_hash_table_lookup(mlm_stats_offenders, key);
+
+    if( !offender ) {
+        if( g_hash_table_size(mlm_stats_offenders) >= MLM_OFFENDER_MAX ) {
+            mce_log(LL_DEBUG, "offender table full; %s not tracked", key);
+            g_free(key);
+            goto EXIT;
+        }
+        offender = mlm_offender_create(key);
+        g_hash_table_replace(mlm_stats_offenders, offender->mlo_name,
+                             offender);
+    }
+
+    g_free(key);
+
+    offender->mlo_count    += 1;
+    offender->mlo_total_ms += (guint)ms;
+    if( offender->mlo_max_ms < ms )
+        offender->mlo_max_ms = (guint)ms;
+
+EXIT:
+    return;
+}
+
+/** Record probe dispatch latency
+ *
+ * @param ms  time from expected to actual probe dispatch
+ */
+static void
+mlm_stats_add_latency(int64_t ms)
+{
+    int bucket = 0;
+
+    for( int64_t limit = 10; bucket < MLM_STATS_BUCKETS - 1; limit *= 10 ) {
+        if( ms < limit )
+            break;
+        ++bucket;
+    }
+
+    mlm_stats_latency[bucket] += 1;
+}
+
+/** Initialize stall statistics
+ */
+static void
+mlm_stats_init(void)
+{
+    if( !mlm_stats_offenders )
+        mlm_stats_offenders = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                    0, mlm_offender_delete_cb);
+}
+
+/** Release stall statistics
+ */
+static void
+mlm_stats_quit(void)
+{
+    if( mlm_stats_offenders )
+        g_hash_table_unref(mlm_stats_offenders), mlm_stats_offenders = 0;
+}
+
+/* ========================================================================= *
+ * LATENCY_PROBE
+ * ========================================================================= */
+
+/** Probe interval [ms], or 0 if disabled */
+static gint    mlm_probe_interval = 0;
+
+/** Timer id for latency probe */
+static guint   mlm_probe_id = 0;
+
+/** Monotonic time when the probe is expected to be dispatched [ms] */
+static int64_t mlm_probe_expected = 0;
+
+/** High priority timer callback for measuring main loop latency
+ *
+ * Since the probe has higher priority than any other source mce
+ * uses, any lateness is caused by whatever was being dispatched
+ * when the probe became due.
+ *
+ * @param aptr (not used)
+ *
+ * @return TRUE to keep timer repeating, or FALSE to stop it
+ */
+static gboolean
+mlm_probe_cb(gpointer aptr)
+{
+    (void)aptr;
+
+    if( !mlm_probe_id )
+        return FALSE;
+
+    int64_t now = mce_lib_get_mono_tick();
+    int64_t lag = MAX(now - mlm_probe_expected, 0);
+
+    mlm_stats_add_latency(lag);
+
+    /* Stalls caused by uninstrumented sources are not
+     * attributed to any dispatch scope */
+    if( mlm_stall_limit > 0 && lag >= mlm_stall_limit &&
+        mlm_scope_last_stall < mlm_probe_expected )
+        mlm_stats_add_stall("unknown", "unattributed", lag);
+
+    mlm_probe_expected = now + mlm_probe_interval;
+
+    return TRUE;
+}
+
+/** Start latency probe timer
+ */
+static void
+mlm_probe_start(void)
+{
+    if( mlm_probe_id || mlm_probe_interval <= 0 )
+        goto EXIT;
+
+    mlm_probe_expected = mce_lib_get_mono_tick() + mlm_probe_interval;
+    mlm_probe_id = g_timeout_add_full(G_PRIORITY_HIGH, mlm_probe_interval,
+                                      mlm_probe_cb, 0, 0);
+
+EXIT:
+    return;
+}
+
+/** Stop latency probe timer
+ */
+static void
+mlm_probe_stop(void)
+{
+    if( mlm_probe_id )
+        g_source_remove(mlm_probe_id), mlm_probe_id = 0;
+}
+
+/* ========================================================================= *
+ * DBUS_HANDLERS
+ * ========================================================================= */
+
+/** D-Bus callback for the get main loop statistics method call
+ *
+ * @param req The D-Bus method call message to be replied
+ *
+ * @return TRUE
+ */
+static gboolean
+mlm_dbus_stats_get_cb(DBusMessage *const req)
+{
+    DBusMessage      *rsp = 0;
+    GPtrArray        *vec = 0;
+    DBusMessageIter  body;
+    DBusMessageIter  hist;
+    DBusMessageIter  array;
+    DBusMessageIter  entry;
+
+    mce_log(LL_DEVEL, "main loop statistics req from %s",
+            mce_dbus_get_message_sender_ident(req));
+
+    if( dbus_message_get_no_reply(req) )
+        goto EXIT;
+
+    rsp = dbus_new_method_reply(req);
+
+    dbus_message_iter_init_append(rsp, &body);
+
+    /* Latency histogram */
+    if( !dbus_message_iter_open_container(&body, DBUS_TYPE_STRUCT,
+                                          0, &hist) )
+        goto EXIT;
+
+    for( int i = 0; i < MLM_STATS_BUCKETS; ++i ) {
+        if( !dbus_message_iter_append_basic(&hist, DBUS_TYPE_UINT32,
+                                            &mlm_stats_latency[i]) ) {
+            dbus_message_iter_abandon_container(&body, &hist);
+            goto EXIT;
+        }
+    }
+
+    if( !dbus_message_iter_close_container(&body, &hist) )
+        goto EXIT;
+
+    /* Offenders, worst first */
+    vec = g_ptr_array_new();
+
+    if( mlm_stats_offenders ) {
+        GHashTableIter iter;
+        gpointer       val;
+
+        g_hash_table_iter_init(&iter, mlm_stats_offenders);
+        while( g_hash_table_iter_next(&iter, 0, &val) )
+            g_ptr_array_add(vec, val);
+    }
+
+    g_ptr_array_sort(vec, mlm_offender_compare);
+
+    if( !dbus_message_iter_open_container(&body, DBUS_TYPE_ARRAY,
+                                          DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+                                          DBUS_TYPE_STRING_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_TYPE_UINT32_AS_STRING
+                                          DBUS_STRUCT_END_CHAR_AS_STRING,
+                                          &array) )
+        goto EXIT;
+
+    for( guint i = 0; i < vec->len; ++i ) {
+        const mlm_offender_t *offender = g_ptr_array_index(vec, i);
+
+        if( !dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT,
+                                              0, &entry) )
+            goto ABANDON_ARRAY;
+
+        if( !dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING,
+                                            &offender->mlo_name) ||
+            !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+                                            &offender->mlo_count) ||
+            !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+                                            &offender->mlo_max_ms) ||
+            !dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+                                            &offender->mlo_total_ms) )
+            goto ABANDON_ENTRY;
+
+        if( !dbus_message_iter_close_container(&array, &entry) )
+            goto ABANDON_ARRAY;
+    }
+
+    if( !dbus_message_iter_close_container(&body, &array) )
+        goto EXIT;
+
+    dbus_send_message(rsp), rsp = 0;
+
+    goto EXIT;
+
+ABANDON_ENTRY:
+    dbus_message_iter_abandon_container(&array, &entry);
+
+ABANDON_ARRAY:
+    dbus_message_iter_abandon_container(&body, &array);
+
+EXIT:
+    if( vec )
+        g_ptr_array_free(vec, TRUE);
+
+    if( rsp )
+        dbus_message_unref(rsp);
+
+    return TRUE;
+}
+
+/** Array of dbus message handlers */
+static mce_dbus_handler_t mlm_dbus_handlers[] =
+{
+    /* method calls */
+    {
+        .interface = MCE_REQUEST_IF,
+        .name      = MCE_MAINLOOP_STATS_GET,
+        .type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+        .callback  = mlm_dbus_stats_get_cb,
+        .args      =
+            "    <arg direction=\"out\" name=\"latency_histogram\" type=\"(uuuuu)\"/>\n"
+            "    <arg direction=\"out\" name=\"offenders\" type=\"a(suuu)\"/>\n"
+    },
+    /* sentinel */
+    {
+        .interface = 0
+    }
+};
+
+/** Add dbus handlers
+ */
+static void
+mlm_dbus_init(void)
+{
+    mce_dbus_handler_register_array(mlm_dbus_handlers);
+}
+
+/** Remove dbus handlers
+ */
+static void
+mlm_dbus_quit(void)
+{
+    mce_dbus_handler_unregister_array(mlm_dbus_handlers);
+}
+
+/* ========================================================================= *
+ * MODULE_INIT
+ * ========================================================================= */
+
+/** Start main loop stall detection
+ */
+void
+mce_lagmon_init(void)
+{
+    mlm_stall_limit = mce_conf_get_int(MCE_CONF_LAGMON_GROUP,
+                                       MCE_CONF_LAGMON_STALL_LIMIT,
+                                       MCE_DEFAULT_LAGMON_STALL_LIMIT);
+
+    mlm_probe_interval = mce_conf_get_int(MCE_CONF_LAGMON_GROUP,
+                                          MCE_CONF_LAGMON_PROBE_INTERVAL,
+                                          MCE_DEFAULT_LAGMON_PROBE_INTERVAL);
+
+    mce_log(LL_DEBUG, "stall threshold %d ms, probe interval %d ms",
+            mlm_stall_limit, mlm_probe_interval);
+
+    mlm_stats_init();
+    mlm_probe_start();
+    mlm_dbus_init();
+}
+
+/** Stop main loop stall detection
+ */
+void
+mce_lagmon_quit(void)
+{
+    mlm_dbus_quit();
+    mlm_probe_stop();
+
+    /* Disable scope tracking before releasing statistics */
+    mlm_stall_limit = 0;
+    mlm_scope_depth = 0;
+
+    mlm_stats_quit();
+}
@@ -0,0 +1,69 @@
+/**
+ * @file mce-lagmon.h
+ *
+ * Mode Control Entity - Main loop stall detection
+ *
+ * <p>
+ *
+ * Copyright (c) 2026 Jolla Mobile Ltd
+ *
+ * <p>
+ *
+ * @author Simo Piiroinen <simo.piiroinen@jollamobile.com>
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCE_LAGMON_H_
+# define MCE_LAGMON_H_
+
+# include <glib.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/** Configuration group for main loop monitoring */
+# define MCE_CONF_LAGMON_GROUP          "MainLoop"
+
+/** Interval for probing main loop dispatch latency [ms], 0 = disabled */
+# define MCE_CONF_LAGMON_PROBE_INTERVAL "LagProbeInterval"
+# define MCE_DEFAULT_LAGMON_PROBE_INTERVAL 5000
+
+/** Dispatch time / latency that is considered a stall [ms], 0 = disabled */
+# define MCE_CONF_LAGMON_STALL_LIMIT    "StallThreshold"
+# define MCE_DEFAULT_LAGMON_STALL_LIMIT 100
+
+/** Dispatch scope kind: D-Bus message handling */
+# define MCE_LAGMON_KIND_DBUS           "dbus"
+
+/** Dispatch scope kind: datapipe execution */
+# define MCE_LAGMON_KIND_DATAPIPE       "datapipe"
+
+/** Dispatch scope kind: io monitor input */
+# define MCE_LAGMON_KIND_IOMON          "iomon"
+
+/** Dispatch scope kind: timer callback */
+# define MCE_LAGMON_KIND_TIMER          "timer"
+
+int  mce_lagmon_enter(const char *kind, const char *name);
+void mce_lagmon_leave(int scope);
+
+void mce_lagmon_init (void);
+void mce_lagmon_quit (void);
+
+# ifdef __cplusplus
+};
+# endif
+
+#endif /* MCE_LAGMON_H_ */
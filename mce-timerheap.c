@@ -0,0 +1,373 @@
+/**
+ * @file mce-timerheap.c
+ *
+ * Mode Control Entity - Binary min-heap for ordering timer deadlines
+ *
+ * <p>
+ *
+ * Copyright (c) 2026 Jolla Mobile Ltd
+ *
+ * <p>
+ *
+ * @author Simo Piiroinen <simo.piiroinen@jollamobile.com>
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mce-timerheap.h"
+
+#include <stdlib.h>
+
+/* ========================================================================= *
+ * Types and functions
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * HEAP_NODE
+ * ------------------------------------------------------------------------- */
+
+void                  mce_timerheap_node_init     (mce_timerheap_node_t *node, void *owner);
+bool                  mce_timerheap_node_is_queued(const mce_timerheap_node_t *node);
+static bool           mce_timerheap_node_before   (const mce_timerheap_node_t *a, const mce_timerheap_node_t *b);
+
+/* ------------------------------------------------------------------------- *
+ * HEAP_OBJECT
+ * ------------------------------------------------------------------------- */
+
+/** Min-heap of timer deadlines
+ *
+ * Nodes are kept in implicit binary tree stored in an array, with
+ * the earliest deadline at index zero. Each node caches its own
+ * array position so that arbitrary nodes can be removed and
+ * rescheduled in O(log n) time.
+ */
+struct mce_timerheap_t
+{
+    /** Array of queued nodes */
+    mce_timerheap_node_t **th_node;
+
+    /** Number of queued nodes */
+    guint                  th_count;
+
+    /** Allocated size of th_node array */
+    guint                  th_alloc;
+
+    /** Sequence number for the next insert */
+    uint64_t               th_sequence;
+};
+
+mce_timerheap_t      *mce_timerheap_create        (void);
+void                  mce_timerheap_delete        (mce_timerheap_t *self);
+
+static void           mce_timerheap_place         (mce_timerheap_t *self, guint slot, mce_timerheap_node_t *node);
+static void           mce_timerheap_sift_up       (mce_timerheap_t *self, guint slot);
+static void           mce_timerheap_sift_down     (mce_timerheap_t *self, guint slot);
+
+guint                 mce_timerheap_count         (const mce_timerheap_t *self);
+void                  mce_timerheap_insert        (mce_timerheap_t *self, mce_timerheap_node_t *node, int64_t deadline);
+void                  mce_timerheap_remove        (mce_timerheap_t *self, mce_timerheap_node_t *node);
+mce_timerheap_node_t *mce_timerheap_peek          (const mce_timerheap_t *self);
+mce_timerheap_node_t *mce_timerheap_pop           (mce_timerheap_t *self);
+int64_t               mce_timerheap_next_deadline (const mce_timerheap_t *self);
+int64_t               mce_timerheap_next_wakeup   (const mce_timerheap_t *self, int slack);
+
+/* ========================================================================= *
+ * HEAP_NODE
+ * ========================================================================= */
+
+/** Initialize heap node embedded in a timer object
+ *
+ * @param node   heap node
+ * @param owner  timer object the node is embedded in
+ */
+void
+mce_timerheap_node_init(mce_timerheap_node_t *node, void *owner)
+{
+    node->thn_deadline = MCE_TIMERHEAP_NO_DEADLINE;
+    node->thn_sequence = 0;
+    node->thn_slot     = 0;
+    node->thn_owner    = owner;
+}
+
+/** Predicate for: heap node is queued
+ *
+ * @param node   heap node, or NULL
+ *
+ * @return true if node is in a heap, false otherwise
+ */
+bool
+mce_timerheap_node_is_queued(const mce_timerheap_node_t *node)
+{
+    return node && node->thn_slot != 0;
+}
+
+/** Heap ordering predicate
+ *
+ * @return true if node a should trigger before node b, false otherwise
+ */
+static bool
+mce_timerheap_node_before(const mce_timerheap_node_t *a,
+                          const mce_timerheap_node_t *b)
+{
+    if( a->thn_deadline != b->thn_deadline )
+        return a->thn_deadline < b->thn_deadline;
+    return a->thn_sequence < b->thn_sequence;
+}
+
+/* ========================================================================= *
+ * HEAP_OBJECT
+ * ========================================================================= */
+
+/** Create timer heap
+ *
+ * @return timer heap object
+ */
+mce_timerheap_t *
+mce_timerheap_create(void)
+{
+    mce_timerheap_t *self = calloc(1, sizeof *self);
+
+    self->th_node     = 0;
+    self->th_count    = 0;
+    self->th_alloc    = 0;
+    self->th_sequence = 0;
+
+    return self;
+}
+
+/** Delete timer heap
+ *
+ * Nodes that are still queued are detached from the heap.
+ *
+ * @param self timer heap object, or NULL
+ */
+void
+mce_timerheap_delete(mce_timerheap_t *self)
+{
+    if( !self )
+        goto EXIT;
+
+    for( guint i = 0; i < self->th_count; ++i )
+        self->th_node[i]->thn_slot = 0;
+
+    free(self->th_node);
+    free(self);
+
+EXIT:
+    return;
+}
+
+/** Store node to given array position
+ */
+static void
+mce_timerheap_place(mce_timerheap_t *self, guint slot,
+                    mce_timerheap_node_t *node)
+{
+    self->th_node[slot] = node;
+    node->thn_slot = slot + 1;
+}
+
+/** Move node towards heap root until heap property holds
+ */
+static void
+mce_timerheap_sift_up(mce_timerheap_t *self, guint slot)
+{
+    mce_timerheap_node_t *node = self->th_node[slot];
+
+    while( slot > 0 ) {
+        guint parent = (slot - 1) / 2;
+
+        if( !mce_timerheap_node_before(node, self->th_node[parent]) )
+            break;
+
+        mce_timerheap_place(self, slot, self->th_node[parent]);
+        slot = parent;
+    }
+
+    mce_timerheap_place(self, slot, node);
+}
+
+/** Move node towards heap leaves until heap property holds
+ */
+static void
+mce_timerheap_sift_down(mce_timerheap_t *self, guint slot)
+{
+    mce_timerheap_node_t *node = self->th_node[slot];
+
+    for( ;; ) {
+        guint child = slot * 2 + 1;
+
+        if( child >= self->th_count )
+            break;
+
+        if( child + 1 < self->th_count &&
+            mce_timerheap_node_before(self->th_node[child + 1],
+                                      self->th_node[child]) )
+            ++child;
+
+        if( !mce_timerheap_node_before(self->th_node[child], node) )
+            break;
+
+        mce_timerheap_place(self, slot, self->th_node[child]);
+        slot = child;
+    }
+
+    mce_timerheap_place(self, slot, node);
+}
+
+/** Get number of queued nodes
+ *
+ * @param self timer heap object, or NULL
+ *
+ * @return number of nodes in the heap
+ */
+guint
+mce_timerheap_count(const mce_timerheap_t *self)
+{
+    return self ? self->th_count : 0;
+}
+
+/** Queue node with given deadline
+ *
+ * If the node is already queued, it is rescheduled.
+ *
+ * @param self     timer heap object
+ * @param node     heap node
+ * @param deadline trigger time
+ */
+void
+mce_timerheap_insert(mce_timerheap_t *self, mce_timerheap_node_t *node,
+                     int64_t deadline)
+{
+    if( !self || !node )
+        goto EXIT;
+
+    if( mce_timerheap_node_is_queued(node) )
+        mce_timerheap_remove(self, node);
+
+    if( self->th_count == self->th_alloc ) {
+        guint alloc = self->th_alloc ? self->th_alloc * 2 : 16;
+        mce_timerheap_node_t **array =
+            realloc(self->th_node, alloc * sizeof *array);
+        if( !array )
+            abort();
+        self->th_node  = array;
+        self->th_alloc = alloc;
+    }
+
+    node->thn_deadline = deadline;
+    node->thn_sequence = self->th_sequence++;
+
+    guint slot = self->th_count++;
+    mce_timerheap_place(self, slot, node);
+    mce_timerheap_sift_up(self, slot);
+
+EXIT:
+    return;
+}
+
+/** Remove node from heap
+ *
+ * @param self     timer heap object
+ * @param node     heap node, nodes that are not queued are ignored
+ */
+void
+mce_timerheap_remove(mce_timerheap_t *self, mce_timerheap_node_t *node)
+{
+    if( !self || !mce_timerheap_node_is_queued(node) )
+        goto EXIT;
+
+    guint slot = node->thn_slot - 1;
+    guint last = --self->th_count;
+
+    node->thn_slot = 0;
+
+    if( slot == last )
+        goto EXIT;
+
+    /* Move the last node to the vacated slot and
+     * restore heap property in whatever direction
+     * is needed */
+    mce_timerheap_place(self, slot, self->th_node[last]);
+
+    if( slot > 0 &&
+        mce_timerheap_node_before(self->th_node[slot],
+                                  self->th_node[(slot - 1) / 2]) )
+        mce_timerheap_sift_up(self, slot);
+    else
+        mce_timerheap_sift_down(self, slot);
+
+EXIT:
+    return;
+}
+
+/** Get node with the earliest deadline
+ *
+ * @param self     timer heap object, or NULL
+ *
+ * @return heap node, or NULL if heap is empty
+ */
+mce_timerheap_node_t *
+mce_timerheap_peek(const mce_timerheap_t *self)
+{
+    return (self && self->th_count) ? self->th_node[0] : 0;
+}
+
+/** Remove and return node with the earliest deadline
+ *
+ * @param self     timer heap object, or NULL
+ *
+ * @return heap node, or NULL if heap is empty
+ */
+mce_timerheap_node_t *
+mce_timerheap_pop(mce_timerheap_t *self)
+{
+    mce_timerheap_node_t *node = mce_timerheap_peek(self);
+    mce_timerheap_remove(self, node);
+    return node;
+}
+
+/** Get the earliest deadline
+ *
+ * @param self     timer heap object, or NULL
+ *
+ * @return trigger time, or MCE_TIMERHEAP_NO_DEADLINE if heap is empty
+ */
+int64_t
+mce_timerheap_next_deadline(const mce_timerheap_t *self)
+{
+    const mce_timerheap_node_t *node = mce_timerheap_peek(self);
+    return node ? node->thn_deadline : MCE_TIMERHEAP_NO_DEADLINE;
+}
+
+/** Get wakeup time that services the earliest deadline
+ *
+ * Allowing the wakeup to be delayed by up to slack milliseconds
+ * means all deadlines that fall within the slack window can be
+ * dispatched from the same wakeup.
+ *
+ * @param self     timer heap object, or NULL
+ * @param slack    allowed wakeup delay [ms]
+ *
+ * @return wakeup time, or MCE_TIMERHEAP_NO_DEADLINE if heap is empty
+ */
+int64_t
+mce_timerheap_next_wakeup(const mce_timerheap_t *self, int slack)
+{
+    int64_t wakeup = mce_timerheap_next_deadline(self);
+
+    if( wakeup != MCE_TIMERHEAP_NO_DEADLINE && slack > 0 )
+        wakeup += slack;
+
+    return wakeup;
+}
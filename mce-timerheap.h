@@ -0,0 +1,77 @@
+/**
+ * @file mce-timerheap.h
+ *
+ * Mode Control Entity - Binary min-heap for ordering timer deadlines
+ *
+ * <p>
+ *
+ * Copyright (c) 2026 Jolla Mobile Ltd
+ *
+ * <p>
+ *
+ * @author Simo Piiroinen <simo.piiroinen@jollamobile.com>
+ *
+ * mce is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * mce is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mce.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MCE_TIMERHEAP_H_
+# define MCE_TIMERHEAP_H_
+
+# include <stdbool.h>
+# include <stdint.h>
+# include <glib.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/** Deadline value used for empty heap */
+# define MCE_TIMERHEAP_NO_DEADLINE INT64_MAX
+
+typedef struct mce_timerheap_t mce_timerheap_t;
+
+/** Heap node, to be embedded in timer objects */
+typedef struct
+{
+    /** Trigger time, milliseconds in clock base chosen by heap user */
+    int64_t   thn_deadline;
+
+    /** Insertion order, used for keeping equal deadlines in FIFO order */
+    uint64_t  thn_sequence;
+
+    /** Position in heap array + 1, or zero when not queued */
+    guint     thn_slot;
+
+    /** Timer object the node is embedded in */
+    void     *thn_owner;
+} mce_timerheap_node_t;
+
+void                  mce_timerheap_node_init     (mce_timerheap_node_t *node, void *owner);
+bool                  mce_timerheap_node_is_queued(const mce_timerheap_node_t *node);
+
+mce_timerheap_t      *mce_timerheap_create        (void);
+void                  mce_timerheap_delete        (mce_timerheap_t *self);
+
+guint                 mce_timerheap_count         (const mce_timerheap_t *self);
+void                  mce_timerheap_insert        (mce_timerheap_t *self, mce_timerheap_node_t *node, int64_t deadline);
+void                  mce_timerheap_remove        (mce_timerheap_t *self, mce_timerheap_node_t *node);
+mce_timerheap_node_t *mce_timerheap_peek          (const mce_timerheap_t *self);
+mce_timerheap_node_t *mce_timerheap_pop           (mce_timerheap_t *self);
+int64_t               mce_timerheap_next_deadline (const mce_timerheap_t *self);
+int64_t               mce_timerheap_next_wakeup   (const mce_timerheap_t *self, int slack);
+
+# ifdef __cplusplus
+};
+# endif
+
+#endif /* MCE_TIMERHEAP_H_ */
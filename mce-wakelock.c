@@ -21,11 +21,13 @@
 
 #include "mce-wakelock.h"
 #include "mce-log.h"
+#include "mce-lib.h"
 
 #include <stdbool.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <string.h>
 
 #include <glib.h>
 
@@ -82,6 +84,74 @@ static mwl_wakelock_t *mwl_wakelock_create      (const char *name);
 static void            mwl_wakelock_delete      (mwl_wakelock_t *self);
 static void            mwl_wakelock_delete_cb   (void *self);
 
+/* ------------------------------------------------------------------------- *
+ * WAKEUP_ACCOUNTING
+ * ------------------------------------------------------------------------- */
+
+/** Maximum number of distinct tags to keep track of */
+#define MWL_ACCOUNT_MAX 256
+
+/** Tag used for accounting once MWL_ACCOUNT_MAX has been reached */
+static const char mwl_account_overflow_tag[] = "other";
+
+/** Wakeup accounting data for one originating subsystem and object */
+typedef struct mwl_account_t
+{
+    /** Originating subsystem and object, used as hash table key too */
+    gchar   *wa_tag;
+
+    /** Number of holds that were the first after resume from suspend */
+    guint    wa_wakes;
+
+    /** Number of holds */
+    guint    wa_holds;
+
+    /** Cumulative time held [ms] */
+    int64_t  wa_held_ms;
+} mwl_account_t;
+
+/** Active wakelock hold */
+typedef struct mwl_hold_t
+{
+    /** Tag the hold is accounted to */
+    gchar   *wh_tag;
+
+    /** Boot time tick when the hold was started */
+    int64_t  wh_started;
+} mwl_hold_t;
+
+/** Lookup table for accounting data */
+static GHashTable *mwl_account_lut = 0; // [tag] -> mwl_account_t *
+
+/** Lookup table for active holds */
+static GHashTable *mwl_hold_lut = 0; // [name] -> mwl_hold_t *
+
+/** Flag for: wakeup accounting is enabled */
+static bool mwl_account_enabled = false;
+
+/** CLOCK_BOOTTIME - CLOCK_MONOTONIC at the previous hold [ms] */
+static int64_t mwl_account_suspend_skew = 0;
+
+static mwl_account_t  *mwl_account_create       (const char *tag);
+static void            mwl_account_delete       (mwl_account_t *self);
+static void            mwl_account_delete_cb    (void *self);
+static mwl_account_t  *mwl_account_lookup       (const char *tag);
+
+static bool            mwl_account_detect_resume(void);
+
+static mwl_hold_t     *mwl_hold_create          (const char *tag);
+static void            mwl_hold_delete          (mwl_hold_t *self);
+static void            mwl_hold_delete_cb       (void *self);
+
+void                   mce_wakelock_account_set_enabled(bool enabled);
+bool                   mce_wakelock_account_is_enabled(void);
+void                   mce_wakelock_account_begin  (const char *name, const char *tag);
+void                   mce_wakelock_account_end    (const char *name);
+void                   mce_wakelock_account_foreach(mce_wakelock_account_cb cb, void *aptr);
+
+static void            mwl_account_init         (void);
+static void            mwl_account_quit         (void);
+
 /* ------------------------------------------------------------------------- *
  * MODULE_API
  * ------------------------------------------------------------------------- */
@@ -97,6 +167,7 @@ static void            mce_wakelock_rem_entry    (const char *name);
 static bool            mce_wakelock_have_entries (void);
 
 void                   mce_wakelock_obtain       (const char *name, int duration_ms);
+void                   mce_wakelock_obtain_tagged(const char *name, const char *tag, int duration_ms);
 void                   mce_wakelock_release      (const char *name);
 
 void                   mce_wakelock_init         (void);
@@ -318,6 +389,319 @@ mwl_wakelock_delete_cb(void *aptr)
     mwl_wakelock_delete(aptr);
 }
 
+/* ========================================================================= *
+ * WAKEUP_ACCOUNTING
+ * ========================================================================= */
+
+/** Create accounting object
+ *
+ * @param tag  originating subsystem and object
+ *
+ * @return accounting object pointer
+ */
+static mwl_account_t *
+mwl_account_create(const char *tag)
+{
+    mwl_account_t *self = g_malloc0(sizeof *self);
+
+    self->wa_tag     = g_strdup(tag);
+    self->wa_wakes   = 0;
+    self->wa_holds   = 0;
+    self->wa_held_ms = 0;
+
+    return self;
+}
+
+/** Delete accounting object
+ *
+ * @param self accounting object pointer, or NULL
+ */
+static void
+mwl_account_delete(mwl_account_t *self)
+{
+    if( !self )
+        goto EXIT;
+
+    g_free(self->wa_tag);
+    g_free(self);
+
+EXIT:
+    return;
+}
+
+/** GDestroyNotify compatible delete callback
+ *
+ * @param aptr accounting object pointer (as void pointer), or NULL
+ */
+static void
+mwl_account_delete_cb(void *aptr)
+{
+    mwl_account_delete(aptr);
+}
+
+/** Lookup or create accounting object by tag
+ *
+ * Once the table is full, new tags are accounted as "other".
+ *
+ * @param tag  originating subsystem and object
+ *
+ * @return object pointer, or NULL on errors
+ */
+static mwl_account_t *
+mwl_account_lookup(const char *tag)
+{
+    mwl_account_t *self = 0;
+
+    if( !mwl_account_lut )
+        goto EXIT;
+
+    if( (self = g_hash_table_lookup(mwl_account_lut, tag)) )
+        goto EXIT;
+
+    if( g_hash_table_size(mwl_account_lut) >= MWL_ACCOUNT_MAX ) {
+        tag = mwl_account_overflow_tag;
+        if( (self = g_hash_table_lookup(mwl_account_lut, tag)) )
+            goto EXIT;
+    }
+
+    self = mwl_account_create(tag);
+    g_hash_table_replace(mwl_account_lut, self->wa_tag, self);
+
+EXIT:
+    return self;
+}
+
+/** Check if the device has been suspended since the previous check
+ *
+ * Uses the same CLOCK_BOOTTIME vs CLOCK_MONOTONIC skew heuristic as
+ * the resume detection in mce-io.c.
+ *
+ * @return true if suspend/resume cycle is detected, false otherwise
+ */
+static bool
+mwl_account_detect_resume(void)
+{
+    int64_t skew    = mce_lib_get_boot_tick() - mce_lib_get_mono_tick();
+    bool    resumed = (skew - mwl_account_suspend_skew) >= 100;
+
+    if( resumed || skew < mwl_account_suspend_skew )
+        mwl_account_suspend_skew = skew;
+
+    return resumed;
+}
+
+/** Create hold object
+ *
+ * @param tag  originating subsystem and object
+ *
+ * @return hold object pointer
+ */
+static mwl_hold_t *
+mwl_hold_create(const char *tag)
+{
+    mwl_hold_t *self = g_malloc0(sizeof *self);
+
+    self->wh_tag     = g_strdup(tag);
+    self->wh_started = mce_lib_get_boot_tick();
+
+    return self;
+}
+
+/** Delete hold object
+ *
+ * @param self hold object pointer, or NULL
+ */
+static void
+mwl_hold_delete(mwl_hold_t *self)
+{
+    if( !self )
+        goto EXIT;
+
+    g_free(self->wh_tag);
+    g_free(self);
+
+EXIT:
+    return;
+}
+
+/** GDestroyNotify compatible delete callback
+ *
+ * @param aptr hold object pointer (as void pointer), or NULL
+ */
+static void
+mwl_hold_delete_cb(void *aptr)
+{
+    mwl_hold_delete(aptr);
+}
+
+/** Enable/disable wakeup accounting
+ *
+ * Accounting is disabled by default. Callers should check
+ * mce_wakelock_account_is_enabled() before constructing tags.
+ *
+ * @param enabled  true to enable accounting, false to disable
+ */
+void
+mce_wakelock_account_set_enabled(bool enabled)
+{
+    if( mwl_account_enabled == enabled )
+        goto EXIT;
+
+    mwl_account_enabled = enabled;
+
+    if( mwl_account_enabled ) {
+        /* Do not count suspends that happened before enabling */
+        mwl_account_detect_resume();
+    }
+    else if( mwl_hold_lut ) {
+        g_hash_table_remove_all(mwl_hold_lut);
+    }
+
+    mce_log(LL_DEBUG, "wakeup accounting %s",
+            mwl_account_enabled ? "enabled" : "disabled");
+
+EXIT:
+    return;
+}
+
+/** Predicate for: wakeup accounting is enabled
+ *
+ * @return true if accounting is enabled, false otherwise
+ */
+bool
+mce_wakelock_account_is_enabled(void)
+{
+    return mwl_account_enabled;
+}
+
+/** Start accounting wakelock hold
+ *
+ * The first hold that starts after a resume from suspend has been
+ * detected is counted as a wakeup caused by the given tag. Holds
+ * taken while the device is awake - whether or not other wakelocks,
+ * including ones taken via libwakelock, are held - are not.
+ *
+ * @param name  name of the wakelock
+ * @param tag   originating subsystem and object, e.g. "iomon:/dev/input/event0"
+ */
+void
+mce_wakelock_account_begin(const char *name, const char *tag)
+{
+    if( !mwl_account_enabled || !mwl_hold_lut || !name )
+        goto EXIT;
+
+    bool wakeup = mwl_account_detect_resume();
+
+    /* Re-obtaining held wakelock does not start a new hold */
+    if( g_hash_table_lookup(mwl_hold_lut, name) )
+        goto EXIT;
+
+    mwl_hold_t *hold = mwl_hold_create(tag ?: name);
+    g_hash_table_replace(mwl_hold_lut, g_strdup(name), hold);
+
+    mwl_account_t *account = mwl_account_lookup(hold->wh_tag);
+    if( !account )
+        goto EXIT;
+
+    account->wa_holds += 1;
+    if( wakeup )
+        account->wa_wakes += 1;
+
+EXIT:
+    return;
+}
+
+/** Stop accounting wakelock hold
+ *
+ * @param name  name of the wakelock
+ */
+void
+mce_wakelock_account_end(const char *name)
+{
+    mwl_hold_t *hold = 0;
+
+    if( !mwl_account_enabled || !mwl_hold_lut || !name )
+        goto EXIT;
+
+    if( !(hold = g_hash_table_lookup(mwl_hold_lut, name)) )
+        goto EXIT;
+
+    mwl_account_t *account = mwl_account_lookup(hold->wh_tag);
+    if( account )
+        account->wa_held_ms += mce_lib_get_boot_tick() - hold->wh_started;
+
+    g_hash_table_remove(mwl_hold_lut, name);
+
+EXIT:
+    return;
+}
+
+/** Iterate over wakeup accounting data
+ *
+ * Time accumulated by holds that are still active is included.
+ *
+ * @param cb    callback to call for each accounted tag
+ * @param aptr  user data to pass to the callback
+ */
+void
+mce_wakelock_account_foreach(mce_wakelock_account_cb cb, void *aptr)
+{
+    GHashTableIter iter;
+    gpointer       val;
+
+    if( !mwl_account_lut || !cb )
+        goto EXIT;
+
+    int64_t now = mce_lib_get_boot_tick();
+
+    g_hash_table_iter_init(&iter, mwl_account_lut);
+    while( g_hash_table_iter_next(&iter, 0, &val) ) {
+        const mwl_account_t *account = val;
+        int64_t              held_ms = account->wa_held_ms;
+
+        GHashTableIter hiter;
+        gpointer       hval;
+
+        g_hash_table_iter_init(&hiter, mwl_hold_lut);
+        while( g_hash_table_iter_next(&hiter, 0, &hval) ) {
+            const mwl_hold_t *hold = hval;
+            if( !strcmp(hold->wh_tag, account->wa_tag) )
+                held_ms += now - hold->wh_started;
+        }
+
+        cb(account->wa_tag, account->wa_wakes, account->wa_holds,
+           held_ms, aptr);
+    }
+
+EXIT:
+    return;
+}
+
+/** Initialize wakeup accounting
+ */
+static void
+mwl_account_init(void)
+{
+    if( !mwl_account_lut )
+        mwl_account_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                0, mwl_account_delete_cb);
+    if( !mwl_hold_lut )
+        mwl_hold_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                             g_free, mwl_hold_delete_cb);
+}
+
+/** Release wakeup accounting data
+ */
+static void
+mwl_account_quit(void)
+{
+    if( mwl_hold_lut )
+        g_hash_table_unref(mwl_hold_lut), mwl_hold_lut = 0;
+
+    if( mwl_account_lut )
+        g_hash_table_unref(mwl_account_lut), mwl_account_lut = 0;
+}
+
 /* ========================================================================= *
  * MODULE_API
  * ========================================================================= */
@@ -381,15 +765,30 @@ EXIT:
 }
 
 /** Obtain virtual wakelock
+ *
+ * The hold is accounted to the wakelock name.
  *
  * @param name  Name of the virtual wakelock
  */
 void
 mce_wakelock_obtain(const char *name, int duration_ms)
+{
+    mce_wakelock_obtain_tagged(name, name, duration_ms);
+}
+
+/** Obtain virtual wakelock and account the hold to given tag
+ *
+ * @param name  Name of the virtual wakelock
+ * @param tag   Originating subsystem and object
+ */
+void
+mce_wakelock_obtain_tagged(const char *name, const char *tag, int duration_ms)
 {
     if( !mce_wakelock_ready )
         goto EXIT;
 
+    mce_wakelock_account_begin(name, tag);
+
     /* Add entry & start release timer */
     mwl_wakelock_start_timer(mce_wakelock_add_entry(name),
                              duration_ms);
@@ -411,6 +810,9 @@ mce_wakelock_release(const char *name)
     if( !mce_wakelock_ready )
         goto EXIT;
 
+    /* Stop accounting before name gets invalidated by removal */
+    mce_wakelock_account_end(name);
+
     /* Remove entry */
     mce_wakelock_rem_entry(name);
 
@@ -426,6 +828,9 @@ EXIT:
 void
 mce_wakelock_init(void)
 {
+    /* Accounting is used also for locks taken via libwakelock */
+    mwl_account_init();
+
     /* Leave disabled if sysfs control files do not exist */
     if( !mwl_rawlock_supported() )
         goto EXIT;
@@ -464,6 +869,8 @@ mce_wakelock_quit(void)
     /* If there were active internal wakelocks,
      * remove the real kernel wakelock too */
     mwl_rawlock_set(false);
+
+    mwl_account_quit();
 }
 
 /** Async signal safe wakelock cleanup
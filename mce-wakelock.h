@@ -21,15 +21,44 @@
 #ifndef MCE_WAKELOCK_H_
 # define MCE_WAKELOCK_H_
 
+# include <stdint.h>
+# include <stdbool.h>
+
 # ifdef __cplusplus
 extern "C" {
 # elif 0
 } /* fool JED indentation ... */
 # endif
 
+/** Configuration group for wakelock settings */
+# define MCE_CONF_WAKELOCK_GROUP                "Wakelock"
+
+/** Whether wakelock holds are accounted to originating subsystems */
+# define MCE_CONF_WAKELOCK_ACCOUNTING           "WakeupAccounting"
+# define MCE_DEFAULT_WAKELOCK_ACCOUNTING        false
+
+/** Callback for iterating wakeup accounting data
+ *
+ * @param tag      originating subsystem and object
+ * @param wakes    number of holds that were the first after a resume
+ * @param holds    number of holds
+ * @param held_ms  cumulative time held [ms]
+ * @param aptr     user data
+ */
+typedef void (*mce_wakelock_account_cb)(const char *tag, unsigned wakes,
+                                        unsigned holds, int64_t held_ms,
+                                        void *aptr);
+
 void                   mce_wakelock_obtain      (const char *name, int duration_ms);
+void                   mce_wakelock_obtain_tagged(const char *name, const char *tag, int duration_ms);
 void                   mce_wakelock_release     (const char *name);
 
+void                   mce_wakelock_account_set_enabled(bool enabled);
+bool                   mce_wakelock_account_is_enabled(void);
+void                   mce_wakelock_account_begin  (const char *name, const char *tag);
+void                   mce_wakelock_account_end    (const char *name);
+void                   mce_wakelock_account_foreach(mce_wakelock_account_cb cb, void *aptr);
+
 void                   mce_wakelock_init        (void);
 void                   mce_wakelock_quit        (void);
 void                   mce_wakelock_abort       (void);
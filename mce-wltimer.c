@@ -25,9 +25,13 @@
  */
 
 #include "mce-wltimer.h"
+#include "mce-hbtimer.h"
 
 #include "mce-log.h"
+#include "mce-conf.h"
+#include "mce-lagmon.h"
 #include "mce-wakelock.h"
+#include "mce-timerheap.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -49,8 +53,8 @@ struct mce_wltimer_t
     /** Timer delay in milliseconds */
     int         wlt_period;
 
-    /** Underlying glib timeout id */
-    guint       wlt_timer_id;
+    /** Timer has been started */
+    bool        wlt_active;
 
     /** Timer callback function */
     GSourceFunc wlt_notify;
@@ -66,6 +70,9 @@ struct mce_wltimer_t
 
     /** Timer stop while in notify */
     bool        wlt_stopped;
+
+    /** Position in trigger time ordered timer heap */
+    mce_timerheap_node_t wlt_node;
 };
 
 mce_wltimer_t * mce_wltimer_create         (const char *name, int period, GSourceFunc notify, void *user_data);
@@ -79,22 +86,35 @@ void            mce_wltimer_set_period     (mce_wltimer_t *self, int period);
 void            mce_wltimer_start          (mce_wltimer_t *self);
 void            mce_wltimer_stop           (mce_wltimer_t *self);
 
-static gboolean mce_wltimer_gate_cb        (gpointer aptr);
+static bool     mce_wltimer_notify         (mce_wltimer_t *self);
 
 /* ------------------------------------------------------------------------- *
  * QUEUE_MANAGEMENT
  * ------------------------------------------------------------------------- */
 
-/** Idle callback id for delayed garbage collect */
-static guint mwt_queue_compact_id = 0;
+/** Monotonic tick value used to signify "not-set" */
+#define NO_TICK INT64_MAX
+
+/** Set of registered timers */
+static GHashTable *mwt_queue_timer_lut = 0;
+
+/** Started timers, ordered by trigger time */
+static mce_timerheap_t *mwt_queue_timer_heap = 0;
+
+/** Glib source id for dispatching triggered timers */
+static guint    mwt_queue_wakeup_id = 0;
 
-/** List of registered timers */
-static GSList *mwt_queue_timer_list = 0;
+/** Time of the currently scheduled dispatch */
+static int64_t  mwt_queue_wakeup_tick = NO_TICK;
 
-static void     mwt_queue_compact          (void);
-static gboolean mwt_queue_compact_cb       (gpointer aptr);
-static void     mwt_queue_schedule_compact (void);
-static void     mwt_queue_cancel_compact   (void);
+/** How much timer triggering can be delayed for wakeup coalescing [ms] */
+static gint     mwt_queue_wakeup_slack = MCE_DEFAULT_WLTIMER_SLACK;
+
+static int64_t  mwt_queue_get_tick         (void);
+static gboolean mwt_queue_wakeup_cb        (gpointer aptr);
+static void     mwt_queue_schedule_wakeup  (void);
+static void     mwt_queue_cancel_wakeup    (void);
+static void     mwt_queue_dispatch_timers  (void);
 
 static void     mwt_queue_add_timer        (mce_wltimer_t *self);
 static void     mwt_queue_remove_timer     (mce_wltimer_t *self);
@@ -133,13 +153,15 @@ mce_wltimer_create(const char  *name,
 
     self->wlt_name      = name ? strdup(name) : 0;
     self->wlt_period    = period;
-    self->wlt_timer_id  = 0;
+    self->wlt_active    = false;
     self->wlt_notify    = notify;
     self->wlt_user_data = user_data;
     self->wlt_triggered = false;
     self->wlt_started   = false;
     self->wlt_stopped   = false;
 
+    mce_timerheap_node_init(&self->wlt_node, self);
+
     mwt_queue_add_timer(self);
 
     return self;
@@ -159,11 +181,11 @@ mce_wltimer_delete(mce_wltimer_t *self)
         mce_log(LL_DEBUG, "%s: timer delete while in notify",
                 mce_wltimer_get_name(self));
 
-    /* Clear the behaviour modifying flags so that the timer id
+    /* Clear the behaviour modifying flags so that the timer
      * and wakelock does get released at mce_wltimer_stop().
      *
      * Note that mwt_queue_remove_timer() invalidates
-     * timer object so that mce_wltimer_gate_cb() knows
+     * timer object so that mce_wltimer_notify() knows
      * not to touch it anymore when user callback returns.
      */
     self->wlt_triggered = false;
@@ -195,7 +217,7 @@ mce_wltimer_eval_wakelock(const mce_wltimer_t *self)
     if( !self->wlt_name)
         goto EXIT;
 
-    if( self->wlt_timer_id )
+    if( self->wlt_active )
         mce_wakelock_obtain(self->wlt_name, -1);
     else
         mce_wakelock_release(self->wlt_name);
@@ -214,7 +236,7 @@ bool
 mce_wltimer_is_active(const mce_wltimer_t *self)
 {
     bool active = false;
-    if( self && self->wlt_timer_id ) {
+    if( self && self->wlt_active ) {
         active = !(self->wlt_triggered && self->wlt_stopped);
     }
     return active;
@@ -252,16 +274,16 @@ mce_wltimer_set_period(mce_wltimer_t *self, int period)
 
 /** Call wakelock timer notification functiom
  *
- * @param aptr   wakelock timer object (as void pointer)
+ * @param self   wakelock timer object
+ *
+ * @return true if timer object still exists, false if it was deleted
  */
-static gboolean
-mce_wltimer_gate_cb(gpointer aptr)
+static bool
+mce_wltimer_notify(mce_wltimer_t *self)
 {
-    gboolean repeat = FALSE;
-
-    mce_wltimer_t *self = aptr;
+    bool repeat = false;
 
-    if( !self->wlt_timer_id )
+    if( !self->wlt_active )
         goto EXIT;
 
     mce_log(LL_DEBUG, "trigger %s %d", mce_wltimer_get_name(self),
@@ -270,7 +292,10 @@ mce_wltimer_gate_cb(gpointer aptr)
     if( self->wlt_notify ) {
         self->wlt_triggered = true;
 
-        bool res = self->wlt_notify(self->wlt_user_data);
+        int  lagmon = mce_lagmon_enter(MCE_LAGMON_KIND_TIMER,
+                                       mce_wltimer_get_name(self));
+        bool res    = self->wlt_notify(self->wlt_user_data);
+        mce_lagmon_leave(lagmon);
 
         if( !mwt_queue_has_timer(self) ) {
             /* The notify callback managed to delete the timer
@@ -301,12 +326,15 @@ mce_wltimer_gate_cb(gpointer aptr)
 EXIT:
 
     if( self ) {
-        if( !repeat &&  self->wlt_timer_id )
-            self->wlt_timer_id = 0;
+        if( repeat )
+            mce_timerheap_insert(mwt_queue_timer_heap, &self->wlt_node,
+                                 mwt_queue_get_tick() + self->wlt_period);
+        else
+            self->wlt_active = false;
         mce_wltimer_eval_wakelock(self);
     }
 
-    return repeat;
+    return self != 0;
 }
 
 /** Start wakelock timer
@@ -334,21 +362,16 @@ mce_wltimer_start(mce_wltimer_t *self)
     if( self->wlt_period < 0 )
         goto EXIT;
 
-    if( self->wlt_timer_id )
+    if( self->wlt_active )
         goto EXIT;
 
     mce_log(LL_DEBUG, "start %s %d", mce_wltimer_get_name(self),
             self->wlt_period);
 
-    if( self->wlt_period > 0 ) {
-        self->wlt_timer_id = g_timeout_add(self->wlt_period,
-                                           mce_wltimer_gate_cb,
-                                           self);
-    }
-    else {
-        self->wlt_timer_id = g_idle_add(mce_wltimer_gate_cb,
-                                        self);
-    }
+    self->wlt_active = true;
+    mce_timerheap_insert(mwt_queue_timer_heap, &self->wlt_node,
+                         mwt_queue_get_tick() + self->wlt_period);
+    mwt_queue_schedule_wakeup();
 
 EXIT:
     mce_wltimer_eval_wakelock(self);
@@ -374,13 +397,14 @@ mce_wltimer_stop(mce_wltimer_t *self)
         goto EXIT;
     }
 
-    if( !self->wlt_timer_id )
+    if( !self->wlt_active )
         goto EXIT;
 
     mce_log(LL_DEBUG, "stop %s", mce_wltimer_get_name(self));
 
-    g_source_remove(self->wlt_timer_id),
-        self->wlt_timer_id = 0;
+    self->wlt_active = false;
+    mce_timerheap_remove(mwt_queue_timer_heap, &self->wlt_node);
+    mwt_queue_schedule_wakeup();
 
 EXIT:
     mce_wltimer_eval_wakelock(self);
@@ -392,82 +416,123 @@ EXIT:
  * QUEUE_MANAGEMENT
  * ========================================================================= */
 
-/** Clean up unused timer list slots
+/** Get current time in the clock base used by the timer heap
  *
- * When timers are deleted, the associated node in mwt_queue_timer_list
- * is left in place with data pointer set to zero.
- *
- * This function can be used to remove such stale entries in suitable
- * point outside the dispatch iteration loop.
+ * @return CLOCK_MONOTONIC time [ms], same as what glib timeouts use
  */
-static void
-mwt_queue_compact(void)
+static int64_t
+mwt_queue_get_tick(void)
 {
-    mwt_queue_cancel_compact();
-
-    GSList **tail = &mwt_queue_timer_list;
-
-    GSList *item;
-
-    while( (item = *tail) ) {
-        if( item->data ) {
-            tail = &item->next;
-        }
-        else {
-            *tail = item->next;
-            item->next = 0;
-            g_slist_free(item);
-        }
-    }
+    return g_get_monotonic_time() / 1000;
 }
 
-/** Idle callback function for delayed garbage collect
+/** Glib callback for dispatching triggered timers
  *
  * @param aptr user data pointer (unused)
  *
  * @return FALSE, to stop repeats
  */
 static gboolean
-mwt_queue_compact_cb(gpointer aptr)
+mwt_queue_wakeup_cb(gpointer aptr)
 {
     (void)aptr;
 
-    if( !mwt_queue_compact_id )
+    if( !mwt_queue_wakeup_id )
         goto EXIT;
 
-    mwt_queue_compact_id = 0;
+    mwt_queue_wakeup_id   = 0;
+    mwt_queue_wakeup_tick = NO_TICK;
 
-    mwt_queue_compact();
+    mwt_queue_dispatch_timers();
 
 EXIT:
     return FALSE;
 }
 
-/** Schedule delayed garbage collection
+/** Schedule dispatching of the nearest timer trigger
+ *
+ * Timers that are already due are dispatched from idle
+ * callback, like zero period timers used to be.
  */
-static void mwt_queue_schedule_compact(void)
+static void
+mwt_queue_schedule_wakeup(void)
 {
-    if( mwt_queue_compact_id )
+    int64_t tick = mce_timerheap_next_wakeup(mwt_queue_timer_heap,
+                                             mwt_queue_wakeup_slack);
+
+    if( mwt_queue_wakeup_id && mwt_queue_wakeup_tick == tick )
         goto EXIT;
 
-    mwt_queue_compact_id = g_idle_add(mwt_queue_compact_cb, 0);
+    mwt_queue_cancel_wakeup();
+
+    if( tick == NO_TICK )
+        goto EXIT;
+
+    int64_t delay = tick - mwt_queue_get_tick();
+
+    if( delay > 0 )
+        mwt_queue_wakeup_id = g_timeout_add((guint)delay,
+                                            mwt_queue_wakeup_cb, 0);
+    else
+        mwt_queue_wakeup_id = g_idle_add(mwt_queue_wakeup_cb, 0);
+
+    mwt_queue_wakeup_tick = tick;
 
 EXIT:
     return;
 }
 
-/** Cancel delayed garbage collection
+/** Cancel scheduled timer dispatching
  */
-static void mwt_queue_cancel_compact(void)
+static void
+mwt_queue_cancel_wakeup(void)
 {
-    if( !mwt_queue_compact_id )
-        goto EXIT;
+    if( mwt_queue_wakeup_id ) {
+        g_source_remove(mwt_queue_wakeup_id),
+            mwt_queue_wakeup_id = 0;
+    }
+    mwt_queue_wakeup_tick = NO_TICK;
+}
 
-    g_source_remove(mwt_queue_compact_id),
-        mwt_queue_compact_id = 0;
+/** Notify triggered wakelock timers
+ */
+static void
+mwt_queue_dispatch_timers(void)
+{
+    int64_t    now = mwt_queue_get_tick();
+    GPtrArray *due = g_ptr_array_new();
 
-EXIT:
-    return;
+    /* Detach all triggered timers from the heap before making
+     * any callbacks, so that timers restarted from notify
+     * callbacks do not get dispatched again in this round */
+    for( ;; ) {
+        mce_timerheap_node_t *node = mce_timerheap_peek(mwt_queue_timer_heap);
+
+        if( !node || node->thn_deadline > now )
+            break;
+
+        mce_timerheap_pop(mwt_queue_timer_heap);
+        g_ptr_array_add(due, node->thn_owner);
+    }
+
+    for( guint i = 0; i < due->len; ++i ) {
+        mce_wltimer_t *timer = g_ptr_array_index(due, i);
+
+        /* Deleted by previously notified timer? */
+        if( !mwt_queue_has_timer(timer) )
+            continue;
+
+        /* Stopped or restarted by previously notified timer? */
+        if( !timer->wlt_active ||
+            mce_timerheap_node_is_queued(&timer->wlt_node) )
+            continue;
+
+        mce_wltimer_notify(timer);
+    }
+
+    g_ptr_array_free(due, TRUE);
+
+    mwt_queue_schedule_wakeup();
 }
 
 /** Predicate for: wakelock timer is registered
@@ -481,10 +546,10 @@ mwt_queue_has_timer(const mce_wltimer_t *self)
 {
     bool has_timer = false;
 
-    if( !self )
+    if( !self || !mwt_queue_timer_lut )
         goto EXIT;
 
-    has_timer = g_slist_find(mwt_queue_timer_list, self) != 0;
+    has_timer = g_hash_table_contains(mwt_queue_timer_lut, self);
 
 EXIT:
     return has_timer;
@@ -500,13 +565,13 @@ mwt_queue_add_timer(mce_wltimer_t *self)
     if( !self )
         goto EXIT;
 
-    /* Try to find recyclable vacated timer slot */
-    GSList *item = g_slist_find(mwt_queue_timer_list, 0);
+    if( !mwt_queue_timer_lut )
+        mwt_queue_timer_lut = g_hash_table_new(g_direct_hash, g_direct_equal);
 
-    if( item )
-        item->data = self;
-    else
-        mwt_queue_timer_list = g_slist_prepend(mwt_queue_timer_list, self);
+    if( !mwt_queue_timer_heap )
+        mwt_queue_timer_heap = mce_timerheap_create();
+
+    g_hash_table_add(mwt_queue_timer_lut, self);
 
 EXIT:
     return;
@@ -522,14 +587,10 @@ mwt_queue_remove_timer(mce_wltimer_t *self)
     if( !self )
         goto EXIT;
 
-    GSList *item = g_slist_find(mwt_queue_timer_list, self);
+    mce_timerheap_remove(mwt_queue_timer_heap, &self->wlt_node);
 
-    /* Vacate the slot by clearing the data link */
-    if( item )
-        item->data = 0;
-
-    /* Schedule removal of the link it self */
-    mwt_queue_schedule_compact();
+    if( mwt_queue_timer_lut )
+        g_hash_table_remove(mwt_queue_timer_lut, self);
 
 EXIT:
     return;
@@ -542,7 +603,12 @@ EXIT:
 void
 mce_wltimer_init(void)
 {
-    /* nop */
+    /* Get wakeup coalescing configuration */
+    mwt_queue_wakeup_slack = mce_conf_get_int(MCE_CONF_TIMER_GROUP,
+                                              MCE_CONF_WLTIMER_SLACK,
+                                              MCE_DEFAULT_WLTIMER_SLACK);
+    if( mwt_queue_wakeup_slack < 0 )
+        mwt_queue_wakeup_slack = 0;
 }
 
 void
@@ -553,11 +619,16 @@ mce_wltimer_quit(void)
     /* Deny starting of timers */
     mce_wltimer_ready = false;
 
+    if( !mwt_queue_timer_lut )
+        goto EXIT;
+
     /* Disable left-behind timer objects */
-    for( GSList *item = mwt_queue_timer_list; item; item = item->next ) {
-        mce_wltimer_t *timer = item->data;
-        if( !timer )
-            continue;
+    GHashTableIter iter;
+    gpointer       key;
+
+    g_hash_table_iter_init(&iter, mwt_queue_timer_lut);
+    while( g_hash_table_iter_next(&iter, &key, 0) ) {
+        mce_wltimer_t *timer = key;
 
         /* Note: What we have here is effectively a resource leak
          *       somewhere else. But all that can be done is to make
@@ -569,10 +640,13 @@ mce_wltimer_quit(void)
                mce_wltimer_get_name(timer));
 
         mce_wltimer_stop(timer);
-        item->data = 0;
+        g_hash_table_iter_remove(&iter);
     }
 
-    /* Flush timer list */
-    mwt_queue_compact();
+    g_hash_table_unref(mwt_queue_timer_lut), mwt_queue_timer_lut = 0;
+
+EXIT:
+    mwt_queue_cancel_wakeup();
 
+    mce_timerheap_delete(mwt_queue_timer_heap), mwt_queue_timer_heap = 0;
 }
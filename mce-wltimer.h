@@ -34,6 +34,13 @@
 extern "C" {
 # endif
 
+/** How much wakelock timer wakeups can be delayed for coalescing [ms]
+ *
+ * Lives in the same #MCE_CONF_TIMER_GROUP as heartbeat timer settings.
+ */
+# define MCE_CONF_WLTIMER_SLACK         "WakelockTimerSlack"
+# define MCE_DEFAULT_WLTIMER_SLACK      0
+
 typedef struct mce_wltimer_t mce_wltimer_t;
 
 mce_wltimer_t * mce_wltimer_create      (const char *name, int period, GSourceFunc notify, void *user_data);
@@ -31,6 +31,7 @@
 #include "mce-fbdev.h"
 #include "mce-hbtimer.h"
 #include "mce-wltimer.h"
+#include "mce-lagmon.h"
 #include "mce-setting.h"
 #include "mce-dbus.h"
 #include "mce-dsme.h"
@@ -1041,6 +1042,16 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+#ifdef ENABLE_WAKELOCKS
+	/* Enable wakeup accounting if configured
+	 * pre-requisite: mce_conf_init()
+	 */
+	mce_wakelock_account_set_enabled(
+		mce_conf_get_bool(MCE_CONF_WAKELOCK_GROUP,
+				  MCE_CONF_WAKELOCK_ACCOUNTING,
+				  MCE_DEFAULT_WAKELOCK_ACCOUNTING));
+#endif
+
 	/* Open fbdev as early as possible */
 	mce_fbdev_init();
 
@@ -1073,6 +1084,12 @@ int main(int argc, char **argv)
 	/* Allow registering of suspend blocking timers */
 	mce_wltimer_init();
 
+	/* Start main loop stall detection
+	 * pre-requisite: mce_conf_init()
+	 * pre-requisite: mce_dbus_init()
+	 */
+	mce_lagmon_init();
+
 	/* Initialise mode management
 	 * pre-requisite: mce_setting_init()
 	 * pre-requisite: mce_dbus_init()
@@ -1167,6 +1184,7 @@ EXIT:
 	mce_powerkey_exit();
 	mce_dsme_exit();
 	mce_mode_exit();
+	mce_lagmon_quit();
 	mce_wltimer_quit();
 	mce_hbtimer_quit();
 
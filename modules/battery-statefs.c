@@ -66,13 +66,15 @@
 /** Delay between re-open attempts while statefs entries are missing; [ms] */
 #define START_DELAY  (5 * 1000)
 
-/** Delay from 1st property change to forced property re-read; [ms]
+/** Delay from detected epoll miss to forced property re-read; [ms]
  *
  * HACK: Depending on kernel & fuse versions there are varying problems
  *       with epoll wakeups. It is possible that we get woken up, but
  *       do not receive events identifying the input file with changed
  *       content. To overcome this we schedule forced re-read of all
- *       battery properties if we get any kind of wakeup from epoll fd.
+ *       battery properties if an epoll wakeup does not lead to any
+ *       of the reported input files having changed content, or if
+ *       reading them fails.
  */
 #define REREAD_DELAY 250
 
@@ -203,6 +205,12 @@ struct tracker_t
 
     /** For use with debugging with pipes instead of real statefs */
     bool        seekable;
+
+    /** Raw file content from the previous successful read */
+    char        content[64];
+
+    /** Whether content holds valid data */
+    bool        content_valid;
 };
 
 static const char *tracker_propdir(void);
@@ -215,7 +223,7 @@ static bool tracker_start       (tracker_t *self, bool *warned);
 static bool tracker_read_data   (tracker_t *self, char *data, size_t size);
 static bool tracker_parse_int   (tracker_t *self, const char *data);
 static bool tracker_parse_bool  (tracker_t *self, const char *data);
-static bool tracker_update      (tracker_t *self);
+static bool tracker_update      (tracker_t *self, bool *changed);
 
 /* ------------------------------------------------------------------------- *
  * SFSCTL  --  controls for statefs tracking
@@ -911,15 +919,15 @@ tracker_read_data(tracker_t *self, char *data, size_t size)
     if( self->fd == -1 )
         goto cleanup;
 
-    /* Read the state data */
-    if( (rc = read(self->fd, data, size-1)) == -1 ) {
-        mce_log(LL_WARN, "%s: read: %m", self->path);
-        goto cleanup;
-    }
+    /* Read the state data from the start of the file; positional
+     * read avoids separate rewind round trip to statefs */
+    if( self->seekable )
+        rc = pread(self->fd, data, size-1, 0);
+    else
+        rc = read(self->fd, data, size-1);
 
-    /* Rewind to the start of the file */
-    if( self->seekable && lseek(self->fd, 0, SEEK_SET) == -1 ) {
-        mce_log(LL_WARN, "%s: rewind: %m", self->path);
+    if( rc == -1 ) {
+        mce_log(LL_WARN, "%s: read: %m", self->path);
         goto cleanup;
     }
 
@@ -1027,31 +1035,42 @@ cleanup:
 
 /** Update value from statefs content and schedule state machine update
  *
- * @param self statefs input file tracking object
+ * Content identical to what was read previously is not parsed again.
  *
- * @return true if io was successfull, but the value did not change;
- *         false otherwise
+ * @param self    statefs input file tracking object
+ * @param changed where to store content changed flag, or NULL
+ *
+ * @return true if io was successfull, false otherwise
  */
 static bool
-tracker_update(tracker_t *self)
+tracker_update(tracker_t *self, bool *changed)
 {
-    bool dummy = false; // assume: io failed or value changed
+    bool ack = false;
 
-    char data[64];
+    char data[sizeof self->content];
 
     if( !tracker_read_data(self, data, sizeof data) ) {
         tracker_close(self);
         goto cleanup;
     }
 
+    ack = true;
+
+    if( self->content_valid && !strcmp(self->content, data) )
+        goto cleanup;
+
+    strcpy(self->content, data);
+    self->content_valid = true;
+
+    if( changed )
+        *changed = true;
+
     if( self->update_cb(self, data) )
         mcebat_update_schedule();
-    else
-        dummy = true; // io succeesfull, but value did not change
 
 cleanup:
 
-    return dummy;
+    return ack;
 }
 
 /** Open statefs file
@@ -1116,6 +1135,8 @@ tracker_close(tracker_t *self)
         inputset_remove(self->fd);
         close(self->fd), self->fd = -1;
     }
+
+    self->content_valid = false;
 }
 
 /** Initialize tracker_t dynamic data
@@ -1126,6 +1147,7 @@ static void
 tracker_init(tracker_t *self)
 {
     self->path = g_strdup_printf("%s/%s", tracker_propdir(), self->name);
+    self->content_valid = false;
 }
 
 /** Release dynamic resources associated with tracker_t
@@ -1158,7 +1180,7 @@ tracker_start(tracker_t *self, bool *warned)
     if( !tracker_open(self, warned) )
         goto cleanup_failure;
 
-    tracker_update(self);
+    tracker_update(self, 0);
 
     if( !inputset_insert(self->fd, self) ) {
         tracker_close(self);
@@ -1322,20 +1344,32 @@ sfsctl_watch_cb(struct epoll_event *eve, int cnt)
 {
     bool keep_going   = true;
     bool statefs_lost = false;
+    bool changed      = false;
+    bool failed       = false;
 
     mce_log(LL_DEBUG, "process %d statefs changes", cnt);
 
+    /* Read only the files that epoll reported */
     for( int i = 0; i < cnt; ++i ) {
         tracker_t *prop = eve[i].data.ptr;
 
         if( eve[i].events & ~EPOLLIN )
             tracker_close(prop), statefs_lost = true;
-        else
-            tracker_update(prop);
+        else if( !tracker_update(prop, &changed) )
+            failed = true;
     }
 
-    /* HACK: Force all props to be reread before datapipe updates */
-    sfsctl_schedule_reread();
+    /* HACK: If none of the reported files had changed content, the
+     *       wakeup was most likely caused by a file epoll failed to
+     *       identify. And after io errors the state is unknown. In
+     *       either case force all props to be reread before datapipe
+     *       updates.
+     */
+    if( !changed || failed ) {
+        mce_log(LL_DEBUG, "%s; forcing reread",
+                failed ? "read error" : "epoll miss");
+        sfsctl_schedule_reread();
+    }
 
     if( statefs_lost ) {
         /* ASSUME: Loss of inputs == statefs restart */
@@ -1369,7 +1403,7 @@ sfsctl_reread_cb(gpointer aptr)
     mce_log(LL_DEBUG, "forced update of all states files");
 
     for( tracker_t *prop = sfsctl_props; prop->name; ++prop )
-        tracker_update(prop);
+        tracker_update(prop, 0);
 
 cleanup:
     return FALSE;
@@ -33,6 +33,10 @@
 
 #include <libudev.h>
 
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
 #include <gmodule.h>
 
 /* ========================================================================= *
@@ -91,6 +95,9 @@
 #define MCE_CONF_BATTERY_UDEV_REFRESH_ON_HEARTBEAT     "RefreshOnHeartbeat"
 #define DEFAULT_BATTERY_UDEV_REFRESH_ON_HEARTBEAT      true
 
+/** Setting for sysfs attributes to poll on system heartbeat */
+#define MCE_CONF_BATTERY_UDEV_HEARTBEAT_ATTRIBUTES     "HeartbeatAttributes"
+
 /** Delay between udev notifications and battery state evaluation
  *
  * The purpose is to increase chances of getting battery and
@@ -173,6 +180,7 @@ typedef struct
 typedef struct udevtracker_t  udevtracker_t;
 typedef struct udevdevice_t   udevdevice_t;
 typedef struct udevproperty_t udevproperty_t;
+typedef struct udevattr_t     udevattr_t;
 
 /** Bookkeeping data for udev power supply device tracking
  */
@@ -201,9 +209,18 @@ struct udevdevice_t
     /** Device sysname */
     gchar      *udd_name;
 
+    /** Device syspath */
+    gchar      *udd_path;
+
     /** Properties associated with the device */
     GHashTable *udd_props; // [key_name] -> udevproperty_t *
 
+    /** Sysfs attributes polled on heartbeat */
+    GSList     *udd_attrs; // -> udevattr_t *
+
+    /** Flag for: Pollable sysfs attributes have been probed */
+    bool        udd_attrs_probed;
+
     /** Flag for: Device has reached battery full state */
     bool        udd_full;
 
@@ -228,6 +245,22 @@ struct udevproperty_t
     bool          udp_used;
 };
 
+/** Bookkeeping data for a sysfs attribute polled via kept-open fd
+ *
+ * Some kernels do not send udev change notifications when values
+ * such as battery capacity change. Rather than re-enumerating all
+ * properties of all devices, such attributes are re-read directly
+ * from sysfs using pread() on file descriptors that are kept open.
+ */
+struct udevattr_t
+{
+    /** Name of the udev property the attribute maps to */
+    gchar *uda_key;
+
+    /** File descriptor for reading attribute value, or -1 */
+    int    uda_fd;
+};
+
 /* ========================================================================= *
  * Prototypes
  * ========================================================================= */
@@ -272,6 +305,18 @@ static const char      *udevproperty_key        (const udevproperty_t *self);
 static const char      *udevproperty_get        (const udevproperty_t *self);
 static bool             udevproperty_set        (udevproperty_t *self, const char *val);
 
+/* ------------------------------------------------------------------------- *
+ * UDEVATTR
+ * ------------------------------------------------------------------------- */
+
+static void             udevattr_init_names     (void);
+static void             udevattr_quit_names     (void);
+static udevattr_t      *udevattr_create         (const char *path, const char *attr);
+static void             udevattr_delete         (udevattr_t *self);
+static void             udevattr_delete_cb      (void *self);
+static const char      *udevattr_key            (const udevattr_t *self);
+static bool             udevattr_read           (udevattr_t *self, char *buff, size_t size);
+
 /* ------------------------------------------------------------------------- *
  * UDEVDEVICE
  * ------------------------------------------------------------------------- */
@@ -283,7 +328,7 @@ static void             udevdevice_quit_chargertype    (void);
 static void             udevdevice_init_blacklist      (void);
 static void             udevdevice_quit_blacklist      (void);
 static bool             udevdevice_is_blacklisted      (const char *name);
-static udevdevice_t    *udevdevice_create              (const char *name);
+static udevdevice_t    *udevdevice_create              (const char *path, const char *name);
 static void             udevdevice_delete              (udevdevice_t *self);
 static void             udevdevice_delete_cb           (void *self);
 static const char      *udevdevice_name                (const udevdevice_t *self);
@@ -293,6 +338,9 @@ static bool             udevdevice_set_prop            (udevdevice_t *self, cons
 static const char      *udevdevice_get_str_prop        (udevdevice_t *self, const char *key, const char *def);
 static int              udevdevice_get_int_prop        (udevdevice_t *self, const char *key, int def);
 static bool             udevdevice_refresh             (udevdevice_t *self, struct udev_device *dev);
+static void             udevdevice_probe_attrs         (udevdevice_t *self);
+static void             udevdevice_close_attrs         (udevdevice_t *self);
+static bool             udevdevice_poll_attrs          (udevdevice_t *self, bool *rethink);
 static bool             udevdevice_is_battery          (udevdevice_t *self);
 static bool             udevdevice_is_charger          (udevdevice_t *self);
 static void             udevdevice_evaluate_charger    (udevdevice_t *self, mcebat_t *mcebat);
@@ -327,6 +375,7 @@ static bool           udevtracker_start           (udevtracker_t *self);
 static void           udevtracker_stop            (udevtracker_t *self);
 static gboolean       udevtracker_event_cb        (GIOChannel *chn, GIOCondition cnd, gpointer aptr);
 static void           udevtracker_refresh_all     (udevtracker_t *self);
+static void           udevtracker_poll_all        (udevtracker_t *self);
 static gboolean       udevtracker_refresh_cb      (gpointer aptr);
 static void           udevtracker_schedule_refresh(void);
 static void           udevtracker_cancel_refresh  (void);
@@ -420,6 +469,9 @@ static GHashTable      *udevdevice_blacklist_lut = 0;
 /** Lookup table for determining charger types */
 static GHashTable      *udevdevice_chargertype_lut = 0;
 
+/** Names of sysfs attributes to poll on heartbeat */
+static gchar          **udevattr_names           = 0;
+
 /** How to treat unknown properties; default to ignoring them */
 static property_type_t  udevproperty_type_def    = PROPERTY_TYPE_IGNORE;
 
@@ -1151,6 +1203,144 @@ udevproperty_set(udevproperty_t *self, const char *val)
     return rethink;
 }
 
+/* ========================================================================= *
+ * UDEVATTR
+ * ========================================================================= */
+
+/** Initialize list of sysfs attributes to poll on heartbeat
+ */
+static void
+udevattr_init_names(void)
+{
+    static const char grp[] = MCE_CONF_BATTERY_UDEV_SETTINGS_GROUP;
+    static const char key[] = MCE_CONF_BATTERY_UDEV_HEARTBEAT_ATTRIBUTES;
+
+    if( udevattr_names )
+        goto EXIT;
+
+    if( mce_conf_has_key(grp, key) )
+        udevattr_names = mce_conf_get_string_list(grp, key, 0);
+
+    if( !udevattr_names ) {
+        /* Battery capacity is the most common value that
+         * changes without kernel sending udev notifications.
+         */
+        udevattr_names = g_malloc0(2 * sizeof *udevattr_names);
+        udevattr_names[0] = g_strdup("capacity");
+    }
+
+EXIT:
+    return;
+}
+
+/** Release list of sysfs attributes to poll on heartbeat
+ */
+static void
+udevattr_quit_names(void)
+{
+    g_strfreev(udevattr_names), udevattr_names = 0;
+}
+
+/** Create sysfs attribute polling object
+ *
+ * @param path  device syspath
+ * @param attr  sysfs attribute name, e.g. "capacity"
+ *
+ * @return attribute object, or NULL if attribute could not be opened
+ */
+static udevattr_t *
+udevattr_create(const char *path, const char *attr)
+{
+    udevattr_t *self = 0;
+    gchar      *file = g_strdup_printf("%s/%s", path, attr);
+    gchar      *name = g_ascii_strup(attr, -1);
+    int         fd   = open(file, O_RDONLY | O_CLOEXEC);
+
+    if( fd == -1 ) {
+        if( errno != ENOENT )
+            mce_log(LL_WARN, "%s: open: %m", file);
+        goto EXIT;
+    }
+
+    self = g_malloc0(sizeof *self);
+    self->uda_key = g_strconcat("POWER_SUPPLY_", name, NULL);
+    self->uda_fd  = fd, fd = -1;
+
+    mce_log(LL_DEBUG, "%s: polled as %s", file, self->uda_key);
+
+EXIT:
+    if( fd != -1 )
+        close(fd);
+    g_free(name);
+    g_free(file);
+
+    return self;
+}
+
+/** Delete sysfs attribute polling object
+ *
+ * @param self  attribute object, or NULL
+ */
+static void
+udevattr_delete(udevattr_t *self)
+{
+    if( self != 0 ) {
+        if( self->uda_fd != -1 )
+            close(self->uda_fd);
+        g_free(self->uda_key);
+        g_free(self);
+    }
+}
+
+/** Type agnostic callback for deleting attribute objects
+ *
+ * @param self  attribute object, or NULL
+ */
+static void
+udevattr_delete_cb(void *self)
+{
+    udevattr_delete(self);
+}
+
+/** Get name of the udev property attribute maps to
+ *
+ * @param self  attribute object
+ *
+ * @return property name
+ */
+static const char *
+udevattr_key(const udevattr_t *self)
+{
+    return self->uda_key;
+}
+
+/** Read current attribute value
+ *
+ * @param self  attribute object
+ * @param buff  buffer for storing nul terminated value
+ * @param size  size of the buffer
+ *
+ * @return true if value was read, false otherwise
+ */
+static bool
+udevattr_read(udevattr_t *self, char *buff, size_t size)
+{
+    bool    ack = false;
+    ssize_t rc  = pread(self->uda_fd, buff, size - 1, 0);
+
+    if( rc == -1 ) {
+        mce_log(LL_WARN, "%s: read: %m", udevattr_key(self));
+        goto EXIT;
+    }
+
+    buff[rc] = 0;
+    g_strstrip(buff);
+    ack = true;
+
+EXIT:
+    return ack;
+}
+
 /* ========================================================================= *
  * UDEVDEVICE
  * ========================================================================= */
@@ -1405,22 +1595,26 @@ udevdevice_is_blacklisted(const char *name)
 
 /** Create device object
  *
+ * @param path device syspath
  * @param name device sysname
  *
  * @return device object
  */
 static udevdevice_t *
-udevdevice_create(const char *name)
+udevdevice_create(const char *path, const char *name)
 {
     udevdevice_t *self = g_malloc0(sizeof *self);
 
     self->udd_name  = g_strdup(name);
+    self->udd_path  = g_strdup(path);
     self->udd_props = g_hash_table_new_full(g_str_hash,
                                             g_str_equal,
                                             g_free,
                                             udevproperty_delete_cb);
-    self->udd_full     = false;
-    self->udd_charging = false;
+    self->udd_attrs        = 0;
+    self->udd_attrs_probed = false;
+    self->udd_full         = false;
+    self->udd_charging     = false;
 
     return self;
 }
@@ -1433,7 +1627,9 @@ static void
 udevdevice_delete(udevdevice_t *self)
 {
     if( self != 0 ) {
+        udevdevice_close_attrs(self);
         g_hash_table_unref(self->udd_props);
+        g_free(self->udd_path);
         g_free(self->udd_name);
         g_free(self);
     }
@@ -1586,6 +1782,89 @@ udevdevice_refresh(udevdevice_t *self, struct udev_device *dev)
     return rethink;
 }
 
+/** Open sysfs attributes that need to be polled
+ *
+ * Only attributes that map to properties the device
+ * already has are considered.
+ *
+ * @param self  device object
+ */
+static void
+udevdevice_probe_attrs(udevdevice_t *self)
+{
+    if( self->udd_attrs_probed || !udevattr_names )
+        goto EXIT;
+
+    self->udd_attrs_probed = true;
+
+    for( size_t i = 0; udevattr_names[i]; ++i ) {
+        udevattr_t *attr = udevattr_create(self->udd_path, udevattr_names[i]);
+        if( !attr )
+            continue;
+
+        if( !udevdevice_get_prop(self, udevattr_key(attr)) )
+            udevattr_delete(attr);
+        else
+            self->udd_attrs = g_slist_prepend(self->udd_attrs, attr);
+    }
+
+EXIT:
+    return;
+}
+
+/** Close polled sysfs attributes
+ *
+ * @param self  device object
+ */
+static void
+udevdevice_close_attrs(udevdevice_t *self)
+{
+    g_slist_free_full(self->udd_attrs, udevattr_delete_cb),
+        self->udd_attrs = 0;
+    self->udd_attrs_probed = false;
+}
+
+/** Update device object properties from polled sysfs attributes
+ *
+ * @param self     device object
+ * @param rethink  set to true if battery state should be re-evaluated
+ *
+ * @return true on success, or false if full refresh is needed
+ */
+static bool
+udevdevice_poll_attrs(udevdevice_t *self, bool *rethink)
+{
+    bool ack = false;
+
+    udevdevice_probe_attrs(self);
+
+    /* Devices without polled attributes, e.g. chargers, are
+     * tracked via uevents only - skip the libudev refresh */
+    if( !self->udd_attrs ) {
+        ack = true;
+        goto EXIT;
+    }
+
+    for( GSList *iter = self->udd_attrs; iter; iter = iter->next ) {
+        udevattr_t *attr = iter->data;
+        char        buff[64];
+
+        if( !udevattr_read(attr, buff, sizeof buff) ) {
+            /* Reopen on the next round */
+            udevdevice_close_attrs(self);
+            goto EXIT;
+        }
+
+        if( udevdevice_set_prop(self, udevattr_key(attr), buff) )
+            *rethink = true;
+    }
+
+    ack = true;
+
+EXIT:
+    return ack;
+}
+
 /** Predicate for: power_supply device is a battery
  *
  * @param self  device object
@@ -2082,7 +2361,7 @@ udevtracker_add_dev(udevtracker_t *self, const char *path, const char *name)
     udevdevice_t *dev = g_hash_table_lookup(self->udt_devices, path);
 
     if( !dev ) {
-        dev = udevdevice_create(name);
+        dev = udevdevice_create(path, name);
         g_hash_table_replace(self->udt_devices, g_strdup(path), dev);
     }
     return dev;
@@ -2312,6 +2591,47 @@ udevtracker_refresh_all(udevtracker_t *self)
     g_list_free_full(syspaths, g_free);
 }
 
+/** Update polled sysfs attributes of all tracked devices
+ *
+ * Unlike udevtracker_refresh_all(), this does not involve
+ * libudev at all - just a few pread() calls on kept-open file
+ * descriptors. Devices where reading fails are refreshed via
+ * libudev, devices without polled attributes are skipped.
+ *
+ * @param self  tracker object
+ */
+static void
+udevtracker_poll_all(udevtracker_t *self)
+{
+    bool            rethink  = false;
+    GSList         *failed   = 0;
+    GHashTableIter  iter;
+    gpointer        key, val;
+
+    g_hash_table_iter_init(&iter, self->udt_devices);
+    while( g_hash_table_iter_next(&iter, &key, &val) ) {
+        udevdevice_t *dev = val;
+        if( !udevdevice_poll_attrs(dev, &rethink) )
+            failed = g_slist_prepend(failed, g_strdup(key));
+    }
+
+    if( rethink )
+        udevtracker_schedule_rethink(self);
+
+    for( GSList *item = failed; item; item = item->next ) {
+        const gchar *syspath = item->data;
+        mce_log(LL_DEBUG, "%s: full refresh", syspath);
+        struct udev_device *dev =
+            udev_device_new_from_syspath(self->udt_udev_handle, syspath);
+        if( dev ) {
+            udevtracker_update_device(self, dev);
+            udev_device_unref(dev);
+        }
+    }
+
+    g_slist_free_full(failed, g_free);
+}
+
 static guint udevtracker_refresh_id = 0;
 static gboolean udevtracker_refresh_cb(gpointer aptr)
 {
@@ -2361,12 +2681,12 @@ static void mcebat_datapipe_heartbeat_event_cb(gconstpointer data)
 {
     (void)data;
 
-    mce_log(LL_DEBUG, "ENTER - refresh on heartbeat");
+    mce_log(LL_DEBUG, "ENTER - poll on heartbeat");
 
     if( mcebat_refresh_on_heartbeat && udevtracker_object )
-        udevtracker_refresh_all(udevtracker_object);
+        udevtracker_poll_all(udevtracker_object);
 
-    mce_log(LL_DEBUG, "LEAVE - refresh on heartbeat");
+    mce_log(LL_DEBUG, "LEAVE - poll on heartbeat");
 }
 
 /** Array of datapipe handlers */
@@ -2455,6 +2775,7 @@ G_MODULE_EXPORT const gchar *g_module_check_init(GModule *module)
 
     mcebat_init_settings();
     udevextcon_init();
+    udevattr_init_names();
     udevdevice_init_blacklist();
     udevdevice_init_chargertype();
     udevproperty_init_types();
@@ -2492,6 +2813,7 @@ G_MODULE_EXPORT void g_module_unload(GModule *module)
     udevdevice_quit_chargertype();
     udevdevice_quit_blacklist();
     udevextcon_quit();
+    udevattr_quit_names();
     udevtracker_cancel_refresh();
 
     mce_log(LL_DEBUG, "%s: unloaded", MODULE_NAME);
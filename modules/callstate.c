@@ -100,6 +100,8 @@ static void call_state_rethink_schedule(void);
 static bool call_state_rethink_forced(void);
 
 static void xofono_get_vcalls(const char *modem);
+static void xofono_get_modems(void);
+static void xofono_resync_vcalls(const char *vcall);
 
 /* ========================================================================= *
  * OFONO CALL STATE HELPERS
@@ -215,68 +217,112 @@ typedef struct
     call_type_t  type;
 } ofono_vcall_t;
 
-static void clients_merge_state_cb(gpointer key, gpointer val, gpointer aptr);
-static void clients_merge_state   (ofono_vcall_t *combined);
 static void clients_set_state     (const char *dbus_name, const ofono_vcall_t *vcall);
 static void clients_get_state     (const char *dbus_name, ofono_vcall_t *vcall);
 static void clients_init          (void);
 static void clients_quit          (void);
 
-/** Mark incoming vcall as ignored
+/* ========================================================================= *
+ * CALL STATE TALLY
+ * ========================================================================= */
+
+/** Number of tracked objects contributing to combined call state
  *
- * @param self      oFono voice call object
+ * Every change to voice call, modem or simulated call state data is
+ * applied as a delta: the old state is removed from the tally and the
+ * new state added. The combined call state can then be evaluated in
+ * constant time, without enumerating all tracked objects.
+ */
+typedef struct
+{
+    /** Number of ringing calls */
+    int ringing;
+
+    /** Number of active calls */
+    int active;
+
+    /** Number of emergency calls + modems in emergency state */
+    int emergency;
+} call_state_tally_t;
+
+/** Tally of voice calls, modems and simulated calls */
+static call_state_tally_t call_state_tally = { 0, 0, 0 };
+
+/** Add / remove voice call data to / from call state tally
+ *
+ * @param vcall  oFono voice call object, or simulated call state
+ * @param delta  +1 to add, -1 to remove
  */
 static void
-ofono_vcall_ignore_incoming_call(ofono_vcall_t *self)
+call_state_tally_vcall(const ofono_vcall_t *vcall, int delta)
 {
-    if( self->state == CALL_STATE_RINGING ) {
-        mce_log(LL_DEBUG, "ignoring incoming vcall: %s",
-                self->name ?: "unnamed");
-        self->state = CALL_STATE_IGNORED;
+    switch( vcall->state ) {
+    case CALL_STATE_RINGING:
+        call_state_tally.ringing += delta;
+        break;
+
+    case CALL_STATE_ACTIVE:
+        call_state_tally.active += delta;
+        break;
+
+    default:
+        break;
     }
+
+    if( vcall->type == CALL_TYPE_EMERGENCY )
+        call_state_tally.emergency += delta;
 }
 
-/** Merge emergency data to oFono voice call object
+/** Add / remove modem emergency state to / from call state tally
  *
- * @param self      oFono voice call object
- * @param emergency emergency state to merge
+ * @param emergency  modem emergency property value
+ * @param delta      +1 to add, -1 to remove
  */
 static void
-ofono_vcall_merge_emergency(ofono_vcall_t *self, bool emergency)
+call_state_tally_emergency(bool emergency, int delta)
 {
     if( emergency )
-        self->type = CALL_TYPE_EMERGENCY;
+        call_state_tally.emergency += delta;
 }
 
-/** Merge state data from oFono voice call object to another
+/** Evaluate combined call state from tally
  *
- * @param self      oFono voice call object
- * @param emergency emergency state to merge
+ * When evaluating combined call state, we must give "ringing" state
+ * priority over "active" so that display and suspend policy works in
+ * expected manner. If any call is emergency, we have emergency call.
+ *
+ * @param combined  call state data to fill in
  */
 static void
-ofono_vcall_merge_vcall(ofono_vcall_t *self, const ofono_vcall_t *that)
+call_state_tally_eval(ofono_vcall_t *combined)
 {
-    /* When evaluating combined call state, we must
-     * give "ringing" state priority over "active"
-     * so that display and suspend policy works in
-     * expected manner. */
-    switch( that->state ) {
-    case CALL_STATE_ACTIVE:
-        if( self->state != CALL_STATE_RINGING )
-            self->state = CALL_STATE_ACTIVE;
-        break;
+    if( call_state_tally.ringing > 0 )
+        combined->state = CALL_STATE_RINGING;
+    else if( call_state_tally.active > 0 )
+        combined->state = CALL_STATE_ACTIVE;
+    else
+        combined->state = CALL_STATE_NONE;
 
-    case CALL_STATE_RINGING:
-        self->state = CALL_STATE_RINGING;
-        break;
+    if( call_state_tally.emergency > 0 )
+        combined->type = CALL_TYPE_EMERGENCY;
+    else
+        combined->type = CALL_TYPE_NORMAL;
+}
 
-    default:
-        break;
+/** Mark incoming vcall as ignored
+ *
+ * @param self      oFono voice call object
+ */
+static void
+ofono_vcall_ignore_incoming_call(ofono_vcall_t *self)
+{
+    if( self->state == CALL_STATE_RINGING ) {
+        mce_log(LL_DEBUG, "ignoring incoming vcall: %s",
+                self->name ?: "unnamed");
+        call_state_tally_vcall(self, -1);
+        self->state = CALL_STATE_IGNORED;
+        call_state_tally_vcall(self, +1);
     }
-
-    /* if any call is emergency, we have emergency call */
-    if( that->type == CALL_TYPE_EMERGENCY )
-        self->type = CALL_TYPE_EMERGENCY;
 }
 
 /** Create oFono voice call object
@@ -308,6 +354,7 @@ ofono_vcall_delete(ofono_vcall_t *self)
 {
     if( self ) {
         mce_log(LL_DEBUG, "vcall=%s", self->name);
+        call_state_tally_vcall(self, -1);
         g_free(self->name);
         free(self);
     }
@@ -343,7 +390,9 @@ ofono_vcall_update_1(ofono_vcall_t *self, DBusMessageIter *iter)
         bool emergency = false;
         if( !mce_dbus_iter_get_bool(&var, &emergency) )
             goto EXIT;
+        call_state_tally_vcall(self, -1);
         self->type = ofono_calltype_to_mce(emergency);
+        call_state_tally_vcall(self, +1);
 
         mce_log(LL_DEBUG, "* %s = ofono:%s -> mce:%s", key,
                 emergency ? "true" : "false",
@@ -353,7 +402,9 @@ ofono_vcall_update_1(ofono_vcall_t *self, DBusMessageIter *iter)
         const char *str = 0;
         if( !mce_dbus_iter_get_string(&var, &str) )
             goto EXIT;
+        call_state_tally_vcall(self, -1);
         self->state = ofono_callstate_to_mce(str);
+        call_state_tally_vcall(self, +1);
         mce_log(LL_DEBUG, "* %s = ofono:%s -> mce:%s", key,str,
                 call_state_repr(self->state));
     }
@@ -459,6 +510,43 @@ EXIT:
     return;
 }
 
+/** Voice calls reported by oFono for one modem */
+typedef struct
+{
+    /** D-Bus object path of the modem */
+    const char *modem;
+
+    /** Set of voice call object paths */
+    GHashTable *seen;
+} vcalls_resync_t;
+
+/** Remove voice call objects not seen during modem resync
+ *
+ * @param key   D-Bus object path of the voice call (as void pointer)
+ * @param val   oFono voice call object (as void pointer)
+ * @param aptr  vcalls_resync_t data (as void pointer)
+ *
+ * @return TRUE if the voice call should be removed, FALSE otherwise
+ */
+static gboolean
+vcalls_rem_stale_cb(gpointer key, gpointer val, gpointer aptr)
+{
+    const char      *name   = key;
+    ofono_vcall_t   *vcall  = val;
+    vcalls_resync_t *resync = aptr;
+    size_t           len    = strlen(resync->modem);
+
+    /* Calls belonging to other modems are left alone */
+    if( strncmp(name, resync->modem, len) || name[len] != '/' )
+        return FALSE;
+
+    if( g_hash_table_contains(resync->seen, name) )
+        return FALSE;
+
+    mce_log(LL_WARN, "stale vcall=%s removed", vcall->name);
+    return TRUE;
+}
+
 /** Remove all tracked voice call objects
  *
  * @param name D-Bus object path
@@ -510,6 +598,9 @@ typedef struct
     /** Flag for: async dbus query to get vcalls for this modem is made */
     bool vcalls_probed;
 
+    /** Flag for: async dbus query to get vcalls is waiting for reply */
+    bool vcalls_pending;
+
 } ofono_modem_t;
 
 /** Create oFono modem tracking object
@@ -527,8 +618,9 @@ ofono_modem_create(const char *path)
     self->probed    = false;
     self->emergency = false;
 
-    self->vcalls_iface  = false;
-    self->vcalls_probed = false;
+    self->vcalls_iface   = false;
+    self->vcalls_probed  = false;
+    self->vcalls_pending = false;
 
     mce_log(LL_DEBUG, "modem=%s", self->name);
     return self;
@@ -543,6 +635,7 @@ ofono_modem_delete(ofono_modem_t *self)
 {
     if( self ) {
         mce_log(LL_DEBUG, "modem=%s", self->name);
+        call_state_tally_emergency(self->emergency, -1);
         g_free(self->name);
         free(self);
     }
@@ -576,8 +669,12 @@ ofono_modem_update_1(ofono_modem_t *self, DBusMessageIter *iter)
         goto EXIT;
 
     if( !strcmp(key, "Emergency") ) {
-        if( !mce_dbus_iter_get_bool(&var, &self->emergency) )
+        bool emergency = false;
+        if( !mce_dbus_iter_get_bool(&var, &emergency) )
             goto EXIT;
+        call_state_tally_emergency(self->emergency, -1);
+        self->emergency = emergency;
+        call_state_tally_emergency(self->emergency, +1);
         mce_log(LL_DEBUG, "* %s = %s", key,
                 self->emergency ? "true" : "false");
     }
@@ -667,7 +764,8 @@ ofono_modem_get_vcalls(ofono_modem_t *self)
         goto EXIT;
 
     /* Mark as done */
-    self->vcalls_probed = true;
+    self->vcalls_probed  = true;
+    self->vcalls_pending = true;
 
     /* Start async D-Bus query */
     xofono_get_vcalls(self->name);
@@ -775,18 +873,25 @@ modems_quit(void)
  * ========================================================================= */
 
 /** Handle reply to voice calls query
+ *
+ * The reply is authoritative for the modem: calls that are tracked,
+ * but not included in the reply are removed.
  *
  * @param pc   pending call object
- * @param aptr (not used)
+ * @param aptr D-Bus object path of the modem (as void pointer)
  */
 static void
 xofono_get_vcalls_cb(DBusPendingCall *pc, void *aptr)
 {
-    (void) aptr;
+    const char  *modem = aptr;
+    DBusMessage *rsp   = 0;
+    DBusError    err   = DBUS_ERROR_INIT;
+    int          cnt   = 0;
+    GHashTable  *seen  = 0;
 
-    DBusMessage *rsp = 0;
-    DBusError    err = DBUS_ERROR_INIT;
-    int          cnt = 0;
+    ofono_modem_t *self = modems_get_modem(modem);
+    if( self )
+        self->vcalls_pending = false;
 
     if( !(rsp = dbus_pending_call_steal_reply(pc)) ) {
         mce_log(LL_ERR, "%s: no reply",
@@ -806,6 +911,8 @@ xofono_get_vcalls_cb(DBusPendingCall *pc, void *aptr)
     if( !mce_dbus_iter_get_array(&body, &arr1) )
         goto EXIT;
 
+    seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, 0);
+
     while( !mce_dbus_iter_at_end(&arr1) ) {
         const char *name = 0;
 
@@ -818,12 +925,20 @@ xofono_get_vcalls_cb(DBusPendingCall *pc, void *aptr)
         if( !vcall )
             continue;
         ofono_vcall_update_N(vcall, &mod);
+        g_hash_table_add(seen, g_strdup(name));
         ++cnt;
     }
-    call_state_rethink_schedule();
+
+    if( vcalls_lut ) {
+        vcalls_resync_t resync = { .modem = modem, .seen = seen };
+        g_hash_table_foreach_remove(vcalls_lut, vcalls_rem_stale_cb, &resync);
+    }
+
+    call_state_rethink_forced();
 
 EXIT:
     mce_log(LL_DEBUG, "added %d calls", cnt);
+    if( seen ) g_hash_table_unref(seen);
     if( rsp ) dbus_message_unref(rsp);
     dbus_error_free(&err);
     return;
@@ -843,10 +958,47 @@ xofono_get_vcalls(const char *modem)
                  OFONO_VCALLMANAGER_INTERFACE,
                  OFONO_VCALLMANAGER_REQ_GET_CALLS,
                  xofono_get_vcalls_cb,
-                 0,0,0,
+                 g_strdup(modem), g_free, 0,
                  DBUS_TYPE_INVALID);
 }
 
+/** Resynchronize voice calls after missing a state change
+ *
+ * Voice calls are tracked via CallAdded, CallRemoved and
+ * PropertyChanged signals. Should a signal for unknown voice
+ * call arrive, some signals have been missed and the voice
+ * calls of the modem are enumerated again.
+ *
+ * If enumeration is already in progress, the reply will reflect
+ * the state after the signal and no new query is made.
+ *
+ * @param vcall D-Bus object path of the voice call
+ */
+static void
+xofono_resync_vcalls(const char *vcall)
+{
+    gchar         *name  = g_path_get_dirname(vcall);
+    ofono_modem_t *modem = modems_get_modem(name);
+
+    if( modem && modem->vcalls_pending ) {
+        mce_log(LL_DEBUG, "untracked vcall=%s; modem=%s resync pending",
+                vcall, name);
+    }
+    else if( modem ) {
+        mce_log(LL_WARN, "untracked vcall=%s; resyncing modem=%s",
+                vcall, name);
+        modem->vcalls_probed = false;
+        ofono_modem_get_vcalls(modem);
+    }
+    else {
+        /* Modem is not known either, resync everything */
+        mce_log(LL_WARN, "untracked vcall=%s; resyncing modems", vcall);
+        xofono_get_modems();
+    }
+
+    g_free(name);
+}
+
 /** Handle voice call changed signal
  *
  * Update voice call lookup table with the content
@@ -866,11 +1018,15 @@ xofono_vcall_changed_cb(DBusMessage *const msg)
         goto EXIT;
 
     ofono_vcall_t *vcall = vcalls_get_call(name);
-    if( !vcall )
+    if( !vcall ) {
+        xofono_resync_vcalls(name);
         goto EXIT;
+    }
 
     ofono_vcall_update_1(vcall, &body);
-    call_state_rethink_schedule();
+
+    /* Evaluation is O(1) -> no need to delay incoming call handling */
+    call_state_rethink_forced();
 
 EXIT:
     return TRUE;
@@ -899,7 +1055,7 @@ xofono_vcall_added_cb(DBusMessage *const msg)
     if( vcall )
         ofono_vcall_update_N(vcall, &body);
 
-    call_state_rethink_schedule();
+    call_state_rethink_forced();
 
 EXIT:
     return TRUE;
@@ -925,7 +1081,7 @@ xofono_vcall_removed_cb(DBusMessage *const msg)
         goto EXIT;
 
     vcalls_rem_call(name);
-    call_state_rethink_schedule();
+    call_state_rethink_forced();
 
 EXIT:
     return TRUE;
@@ -1028,6 +1184,10 @@ xofono_modem_changed_cb(DBusMessage *const msg)
         ofono_modem_update_1(modem, &body);
         ofono_modem_get_vcalls(modem);
     }
+    else {
+        mce_log(LL_WARN, "untracked modem=%s; resyncing", name);
+        xofono_get_modems();
+    }
     call_state_rethink_schedule();
 
 EXIT:
@@ -1257,39 +1417,6 @@ EXIT:
     return;
 }
 
-/** Enumeration callback for evaluating combined dbus client state
- *
- * @param key   D-Bus name of the client (as void pointer)
- * @param val   ofono_vcall_t data of the client (as void pointer)
- * @param aptr  ofono_vcall_t data to update (as void pointer)
- */
-static void
-clients_merge_state_cb(gpointer key, gpointer val, gpointer aptr)
-{
-    (void)key;
-
-    ofono_vcall_t *combined  = aptr;
-    ofono_vcall_t *simulated = val;
-
-    ofono_vcall_merge_vcall(combined, simulated);
-}
-
-/** Update overall call state by inspecting all active dbus client states
- *
- * @param combined  ofono_vcall_t data to update
- */
-static void
-clients_merge_state(ofono_vcall_t *combined)
-{
-    if( !clients_state_lut )
-        goto EXIT;
-
-    g_hash_table_foreach(clients_state_lut, clients_merge_state_cb, combined);
-
-EXIT:
-    return;
-}
-
 /** Set state of one dbus client
  *
  * @ dbus_name  D-Bus name of the client
@@ -1309,10 +1436,14 @@ clients_set_state(const char *dbus_name, const ofono_vcall_t *vcall)
     ofono_vcall_t *cached = g_hash_table_lookup(clients_state_lut, dbus_name);
     if( !cached ) {
         cached = g_malloc0(sizeof *cached);
+        cached->state = CALL_STATE_NONE;
+        cached->type  = CALL_TYPE_NORMAL;
         g_hash_table_replace(clients_state_lut, g_strdup(dbus_name), cached);
     }
 
+    call_state_tally_vcall(cached, -1);
     *cached = *vcall;
+    call_state_tally_vcall(cached, +1);
 
 EXIT:
     return;
@@ -1336,13 +1467,25 @@ clients_get_state(const char *dbus_name, ofono_vcall_t *vcall)
     *vcall = cached ? *cached : clients_vcall_def;
 }
 
+/** Delete callback for dbus client state data
+ *
+ * @param self  ofono_vcall_t data of the client (as void pointer)
+ */
+static void
+clients_state_delete_cb(gpointer self)
+{
+    call_state_tally_vcall(self, -1);
+    g_free(self);
+}
+
 /** Initialize dbus client tracking */
 static void clients_init(void)
 {
     if( !clients_state_lut ) {
         clients_state_lut = g_hash_table_new_full(g_str_hash,
                                                   g_str_equal,
-                                                  g_free, g_free);
+                                                  g_free,
+                                                  clients_state_delete_cb);
     }
 }
 
@@ -1421,7 +1564,9 @@ send_call_state(DBusMessage *const method_call,
         }
 
         /* Send the message if it is signal or wanted method reply */
-        if( !method_call || !dbus_message_get_no_reply(method_call) )
+        if( !method_call )
+                status = dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
+        else if( !dbus_message_get_no_reply(method_call) )
                 status = dbus_send_message(msg), msg = 0;
 
 EXIT:
@@ -1614,30 +1759,6 @@ call_state_ignore_incoming_calls(void)
        g_hash_table_foreach(vcalls_lut, call_state_ignore_incoming_calls_cb, 0);
 }
 
-/** Callback for merging voice call stats
- */
-static void
-call_state_merge_vcall_cb(gpointer key, gpointer value, gpointer aptr)
-{
-    (void)key; //const char *name  = key;
-    ofono_vcall_t *vcall = value;
-    ofono_vcall_t *stats = aptr;
-
-    ofono_vcall_merge_vcall(stats, vcall);
-}
-
-/** Callback for merging merging modem emergency data to voice call state
- */
-static void
-call_state_merge_modem_cb(gpointer key, gpointer value, gpointer aptr)
-{
-    (void)key; //const char *name  = key;
-    ofono_modem_t *modem = value;
-    ofono_vcall_t *stats = aptr;
-
-    ofono_vcall_merge_emergency(stats, modem->emergency);
-}
-
 /** Evaluate mce call state
  *
  * Emit signals and update data pipes as needed
@@ -1661,16 +1782,9 @@ call_state_rethink_now(void)
         .type  = CALL_TYPE_NORMAL,
     };
 
-    /* consider simulated call state */
-    clients_merge_state(&combined);
-
-    /* consider ofono modem emergency properties */
-    if( modems_lut )
-       g_hash_table_foreach(modems_lut, call_state_merge_modem_cb, &combined);
-
-    /* consider ofono voice call properties */
-    if( vcalls_lut )
-       g_hash_table_foreach(vcalls_lut, call_state_merge_vcall_cb, &combined);
+    /* simulated call states, ofono modem emergency properties
+     * and ofono voice call properties are kept in tally */
+    call_state_tally_eval(&combined);
 
     /* skip broadcast if no change */
     if( !memcmp(&previous, &combined, sizeof combined) )
@@ -23,6 +23,7 @@
 #include "../mce-log.h"
 #include "../mce-lib.h"
 #include "../mce-dbus.h"
+#include "../mce-timerheap.h"
 
 #ifdef ENABLE_WAKELOCKS
 # include "../libwakelock.h"
@@ -151,8 +152,14 @@ struct cka_session_t
 
   /** Has the session been finished */
   bool          ses_finished;
+
+  /** Position in session expiry heap */
+  mce_timerheap_node_t ses_heapnode;
 };
 
+/** Session timeouts ordered so that the earliest is at the top */
+static mce_timerheap_t *cka_session_heap = 0;
+
 static cka_session_t *cka_session_create   (cka_client_t *client, const char *session);
 static void           cka_session_renew    (cka_session_t *self, tick_t timeout);
 static void           cka_session_finish   (cka_session_t *self, tick_t now);
@@ -172,11 +179,20 @@ struct cka_client_t
   /** NameOwnerChanged signal match used for tracking death of client */
   char       *cli_match_rule;
 
-  /** Upper bound for reneval of cpu keepalive for this client */
-  tick_t      cli_timeout;
-
   /** One client can have several keepalive objects */
   GHashTable *cli_sessions; // [string] -> cka_session_t *
+
+  /** When the client was first seen */
+  tick_t      cli_created;
+
+  /** Number of sessions started */
+  unsigned    cli_sessions_total;
+
+  /** Number of session timeout renewals */
+  unsigned    cli_renewals;
+
+  /** Total duration of finished sessions [ms] */
+  tick_t      cli_held_ms;
 };
 
 /** Format string for constructing name owner lost match rules */
@@ -192,11 +208,11 @@ static const char cka_client_match_fmt[] =
 
 static cka_session_t *cka_client_get_session   (cka_client_t *self, const char *session_id);
 static cka_session_t *cka_client_add_session   (cka_client_t *self, const char *session_id);
-static void           cka_client_scan_timeout  (cka_client_t *self);
 static void           cka_client_remove_timeout(cka_client_t *self, const char *session_id);
 static void           cka_client_update_timeout(cka_client_t *self, const char *session_id, tick_t when);
 static cka_client_t  *cka_client_create        (const char *dbus_name);
 static const char    *cka_client_identify      (cka_client_t *self);
+static tick_t         cka_client_held_time     (cka_client_t *self, tick_t now);
 
 static void           cka_client_delete        (cka_client_t *self);
 static void           cka_client_delete_cb     (void *self);
@@ -253,6 +269,7 @@ static gboolean           cka_dbus_handle_period_cb  (DBusMessage *const msg);
 static gboolean           cka_dbus_handle_start_cb   (DBusMessage *const msg);
 static gboolean           cka_dbus_handle_stop_cb    (DBusMessage *const msg);
 static gboolean           cka_dbus_handle_wakeup_cb  (DBusMessage *const msg);
+static gboolean           cka_dbus_handle_stats_cb   (DBusMessage *const msg);
 
 static DBusHandlerResult  cka_dbus_filter_message_cb (DBusConnection *con, DBusMessage *msg, void *user_data);
 
@@ -463,6 +480,10 @@ cka_session_create(cka_client_t *client, const char *session_id)
   self->ses_flagged  = false;
   self->ses_finished = false;
 
+  mce_timerheap_node_init(&self->ses_heapnode, self);
+
+  client->cli_sessions_total += 1;
+
   mce_log(LL_DEVEL, "session created; id=%u/%s %s",
           self->ses_unique, self->ses_session,
           cka_client_identify(self->ses_client));
@@ -482,6 +503,11 @@ cka_session_renew(cka_session_t *self, tick_t timeout)
   self->ses_timeout  = timeout;
   self->ses_renewed += 1;
 
+  self->ses_client->cli_renewals += 1;
+
+  /* Reschedule within expiry heap - O(log n) */
+  mce_timerheap_insert(cka_session_heap, &self->ses_heapnode, timeout);
+
   tick_t now = cka_tick_get_current();
   tick_t dur = now - self->ses_started;
 
@@ -527,6 +553,10 @@ cka_session_finish(cka_session_t *self, tick_t now)
   }
 
   self->ses_finished = true;
+
+  self->ses_client->cli_held_ms += dur;
+
+  mce_timerheap_remove(cka_session_heap, &self->ses_heapnode);
 }
 
 /** Delete bookkeeping information for a keepalive session
@@ -546,6 +576,8 @@ cka_session_delete(cka_session_t *self)
           self->ses_unique, self->ses_session,
           cka_client_identify(self->ses_client));
 
+  mce_timerheap_remove(cka_session_heap, &self->ses_heapnode);
+
   g_free(self->ses_session);
   g_free(self);
 
@@ -608,48 +640,6 @@ cka_client_add_session(cka_client_t *self, const char *session_id)
   return session;
 }
 
-/** Update client timeout to be maximum of context timeouts
- *
- * @param self pointer to cka_client_t structure
- */
-static
-void
-cka_client_scan_timeout(cka_client_t *self)
-{
-  tick_t now  = cka_tick_get_current();
-
-  self->cli_timeout = 0;
-
-  /* Expire sessions / update client timeout */
-  GHashTableIter iter;
-  gpointer       val;
-
-  g_hash_table_iter_init(&iter, self->cli_sessions);
-  while( g_hash_table_iter_next(&iter, 0, &val) )
-  {
-    cka_session_t *session = val;
-
-    if( session->ses_timeout <= now )
-    {
-      /* Expire session */
-      cka_session_finish(session, now);
-      g_hash_table_iter_remove(&iter);
-    }
-    else if( self->cli_timeout < session->ses_timeout )
-    {
-      /* Update client timeout */
-      self->cli_timeout = session->ses_timeout;
-    }
-  }
-
-  if( self->cli_timeout > now )
-  {
-    mce_log(LL_DEBUG, "client T%+"PRId64"; %s",
-            now - self->cli_timeout,
-            cka_client_identify(self));
-  }
-}
-
 /** Clear client cpu-keepalive timeout
  *
  * @param self        pointer to cka_client_t structure
@@ -701,6 +691,38 @@ cka_client_identify(cka_client_t *self)
   return mce_dbus_get_name_owner_ident(self->cli_dbus_name);
 }
 
+/** Get total time client has held cpu keepalive sessions
+ *
+ * Overlapping sessions are counted separately.
+ *
+ * @param self  pointer to cka_client_t structure
+ * @param now   current time
+ *
+ * @return duration of finished and active sessions [ms]
+ */
+static
+tick_t
+cka_client_held_time(cka_client_t *self, tick_t now)
+{
+  tick_t held = self->cli_held_ms;
+
+  GHashTableIter iter;
+  gpointer       val;
+
+  g_hash_table_iter_init(&iter, self->cli_sessions);
+  while( g_hash_table_iter_next(&iter, 0, &val) )
+  {
+    cka_session_t *session = val;
+
+    if( !session->ses_finished )
+    {
+      held += now - session->ses_started;
+    }
+  }
+
+  return held;
+}
+
 /** Create bookkeeping information for a dbus client
  *
  * Note: Will also add signal matching rule so that we get notified
@@ -719,11 +741,14 @@ cka_client_create(const char *dbus_name)
   self->cli_dbus_name  = g_strdup(dbus_name);
   self->cli_match_rule = g_strdup_printf(cka_client_match_fmt,
                                          self->cli_dbus_name);
-  self->cli_timeout    = 0;
-
   self->cli_sessions   = g_hash_table_new_full(g_str_hash, g_str_equal,
                                                g_free, cka_session_delete_cb);
 
+  self->cli_created        = cka_tick_get_current();
+  self->cli_sessions_total = 0;
+  self->cli_renewals       = 0;
+  self->cli_held_ms        = 0;
+
   mce_log(LL_DEBUG, "client created; %s", cka_client_identify(self));
 
   /* NULL error -> match will be added asynchronously */
@@ -887,8 +912,10 @@ cka_state_reset(void)
 
 /** Re-evaluate the end of cpu-keepalive period
  *
- * Calculates maximum of wakeup period and per client renew periods
- * and uses it to reprogram the end of cpu-keepalive period
+ * Expires sessions from the top of the session timeout heap and
+ * reprograms the timer for the next session timeout, or the
+ * end of rtc wakeup period, whichever comes first. Keepalive is
+ * active as long as there are unexpired sessions or rtc wakeup.
  */
 static
 void
@@ -896,23 +923,26 @@ cka_state_rethink(void)
 {
   tick_t now = cka_tick_get_current();
 
-  /* Find furthest away client renew timeout */
-  tick_t maxtime = cka_clients_wakeup_timeout;
-
-  GHashTableIter iter;
-  gpointer       val;
+  /* Expire sessions that have timed out - O(log n) each */
+  mce_timerheap_node_t *node;
 
-  g_hash_table_iter_init(&iter, cka_clients_lut);
-  while( g_hash_table_iter_next(&iter, 0, &val) )
+  while( (node = mce_timerheap_peek(cka_session_heap)) &&
+         node->thn_deadline <= now )
   {
-    cka_client_t *client = val;
+    cka_session_t *session = node->thn_owner;
+    cka_client_t  *client  = session->ses_client;
+
+    cka_session_finish(session, now);
+    g_hash_table_remove(client->cli_sessions, session->ses_session);
+  }
 
-    cka_client_scan_timeout(client);
+  /* The next session timeout is at the top of the heap */
+  tick_t nexttime = mce_timerheap_next_deadline(cka_session_heap);
 
-    if( maxtime < client->cli_timeout )
-    {
-      maxtime = client->cli_timeout;
-    }
+  if( now < cka_clients_wakeup_timeout &&
+      cka_clients_wakeup_timeout < nexttime )
+  {
+    nexttime = cka_clients_wakeup_timeout;
   }
 
   /* Remove existing timer */
@@ -924,18 +954,19 @@ cka_state_rethink(void)
   /* If needed, program timer */
   static tick_t oldtime = 0;
 
-  if( now < maxtime )
+  if( nexttime != MCE_TIMERHEAP_NO_DEADLINE )
   {
-    if( maxtime != oldtime )
+    if( nexttime != oldtime )
     {
-      mce_log(LL_DEBUG, "cpu-keepalive timeout at T%+"PRId64"",
-              now - maxtime);
+      mce_log(LL_DEBUG, "cpu-keepalive timeout at T%+"PRId64"; "
+              "%u sessions", now - nexttime,
+              mce_timerheap_count(cka_session_heap));
     }
-    cka_state_timer_id = g_timeout_add(maxtime - now,
+    cka_state_timer_id = g_timeout_add(nexttime - now,
                              cka_state_timer_cb, 0);
   }
 
-  oldtime = maxtime;
+  oldtime = nexttime;
 
   cka_state_set(cka_state_timer_id != 0);
 }
@@ -1201,6 +1232,11 @@ cka_clients_handle_wakeup(const gchar *dbus_name)
  */
 static void cka_clients_init(void)
 {
+  if( !cka_session_heap )
+  {
+    cka_session_heap = mce_timerheap_create();
+  }
+
   if( !cka_clients_lut )
   {
     cka_clients_lut = g_hash_table_new_full(g_str_hash, g_str_equal,
@@ -1216,6 +1252,8 @@ static void cka_clients_quit(void)
   {
     g_hash_table_unref(cka_clients_lut), cka_clients_lut = 0;
   }
+
+  mce_timerheap_delete(cka_session_heap), cka_session_heap = 0;
 }
 
 /* ========================================================================= *
@@ -1407,6 +1445,106 @@ EXIT:
   return success;
 }
 
+/** D-Bus callback for the MCE_CPU_KEEPALIVE_STATS_GET method call
+ *
+ * @param msg  The D-Bus message
+ *
+ * @return TRUE
+ */
+static
+gboolean
+cka_dbus_handle_stats_cb(DBusMessage *const msg)
+{
+  DBusMessage    *rsp = 0;
+  tick_t          now = cka_tick_get_current();
+  DBusMessageIter body, array, item;
+
+  mce_log(LL_DEBUG, "got keepalive stats query from %s",
+          mce_dbus_get_name_owner_ident(dbus_message_get_sender(msg)));
+
+  if( dbus_message_get_no_reply(msg) )
+  {
+    goto EXIT;
+  }
+
+  rsp = dbus_new_method_reply(msg);
+
+  dbus_message_iter_init_append(rsp, &body);
+
+  if( !dbus_message_iter_open_container(&body, DBUS_TYPE_ARRAY,
+                                        DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+                                        DBUS_TYPE_STRING_AS_STRING
+                                        DBUS_TYPE_STRING_AS_STRING
+                                        DBUS_TYPE_UINT32_AS_STRING
+                                        DBUS_TYPE_UINT32_AS_STRING
+                                        DBUS_TYPE_UINT32_AS_STRING
+                                        DBUS_TYPE_UINT64_AS_STRING
+                                        DBUS_TYPE_UINT64_AS_STRING
+                                        DBUS_STRUCT_END_CHAR_AS_STRING,
+                                        &array) )
+  {
+    goto FAILED;
+  }
+
+  GHashTableIter iter;
+  gpointer       val;
+
+  g_hash_table_iter_init(&iter, cka_clients_lut);
+  while( g_hash_table_iter_next(&iter, 0, &val) )
+  {
+    cka_client_t  *client = val;
+    const char    *name   = client->cli_dbus_name;
+    const char    *ident  = cka_client_identify(client);
+    dbus_uint32_t  active = g_hash_table_size(client->cli_sessions);
+    dbus_uint32_t  total  = client->cli_sessions_total;
+    dbus_uint32_t  renew  = client->cli_renewals;
+    dbus_uint64_t  held   = cka_client_held_time(client, now);
+    dbus_uint64_t  age    = now - client->cli_created;
+
+    if( !dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT,
+                                          0, &item) )
+    {
+      goto FAILED_ARRAY;
+    }
+
+    if( !dbus_message_iter_append_basic(&item, DBUS_TYPE_STRING, &name)   ||
+        !dbus_message_iter_append_basic(&item, DBUS_TYPE_STRING, &ident)  ||
+        !dbus_message_iter_append_basic(&item, DBUS_TYPE_UINT32, &active) ||
+        !dbus_message_iter_append_basic(&item, DBUS_TYPE_UINT32, &total)  ||
+        !dbus_message_iter_append_basic(&item, DBUS_TYPE_UINT32, &renew)  ||
+        !dbus_message_iter_append_basic(&item, DBUS_TYPE_UINT64, &held)   ||
+        !dbus_message_iter_append_basic(&item, DBUS_TYPE_UINT64, &age) )
+    {
+      dbus_message_iter_abandon_container(&array, &item);
+      goto FAILED_ARRAY;
+    }
+
+    if( !dbus_message_iter_close_container(&array, &item) )
+    {
+      goto FAILED_ARRAY;
+    }
+  }
+
+  if( !dbus_message_iter_close_container(&body, &array) )
+  {
+    goto FAILED;
+  }
+
+  /* dbus_send_message() unrefs the message */
+  dbus_send_message(rsp), rsp = 0;
+  goto EXIT;
+
+FAILED_ARRAY:
+  dbus_message_iter_abandon_container(&body, &array);
+
+FAILED:
+  mce_log(LL_ERR, "failed to construct keepalive stats reply");
+  dbus_message_unref(rsp), rsp = 0;
+
+EXIT:
+  return TRUE;
+}
+
 /** D-Bus message filter for handling NameOwnerChanged signals
  *
  * @param con        dbus connection
@@ -1516,6 +1654,14 @@ static mce_dbus_handler_t cka_dbus_handlers[] =
     .args       =
       "    <arg direction=\"out\" name=\"success\" type=\"b\"/>\n"
   },
+  {
+    .interface = MCE_REQUEST_IF,
+    .name      = MCE_CPU_KEEPALIVE_STATS_GET,
+    .type      = DBUS_MESSAGE_TYPE_METHOD_CALL,
+    .callback  = cka_dbus_handle_stats_cb,
+    .args      =
+      "    <arg direction=\"out\" name=\"clients\" type=\"a(ssuuutt)\"/>\n"
+  },
   /* sentinel */
   {
     .interface = 0
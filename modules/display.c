@@ -10184,6 +10184,10 @@ static void mdy_dbus_invalidate_display_status(void)
 /**
  * Send a display status reply or signal
  *
+ * The broadcast value is published as D-Bus property, and queries
+ * are replied from the cached value. Forced re-broadcasts of an
+ * unchanged value are sent as plain signals.
+ *
  * @param method_call A DBusMessage to reply to;
  *                    pass NULL to send a display status signal instead
  * @return TRUE on success, FALSE on failure
@@ -10241,12 +10245,25 @@ static gboolean mdy_dbus_send_display_status(DBusMessage *const method_call)
 
     const char *curr = prev ?: MCE_DISPLAY_OFF_STRING;
 
-    /* Signal broadcast, or method call reply */
     if( !method_call ) {
         mce_log(LL_NOTICE, "Sending display status signal: %s", curr);
+
+        /* Changed values are broadcast via property publishing */
+        if( mce_dbus_property_publish(MCE_DISPLAY_SIG,
+                                      DBUS_TYPE_STRING, &curr) ) {
+            status = TRUE;
+            goto EXIT;
+        }
+
         msg = dbus_new_signal(MCE_SIGNAL_PATH, MCE_SIGNAL_IF,
                               MCE_DISPLAY_SIG);
     }
+    else if( prev ) {
+        /* Reply with the published value */
+        mce_log(LL_DEBUG, "Sending display status reply: %s", curr);
+        status = mce_dbus_property_reply(method_call, MCE_DISPLAY_SIG);
+        goto EXIT;
+    }
     else {
         mce_log(LL_DEBUG, "Sending display status reply: %s", curr);
         msg = dbus_new_method_reply(method_call);
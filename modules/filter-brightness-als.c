@@ -1479,6 +1479,10 @@ fba_datapipe_quit(void)
 /**
  * Send the current profile id
  *
+ * The value is published as D-Bus property, and queries are replied
+ * from the cached value. Forced re-broadcasts of an unchanged value
+ * are sent as plain signals.
+ *
  * @param method_call A DBusMessage to reply to
  */
 static void
@@ -1490,12 +1494,21 @@ fba_dbus_send_current_color_profile(DBusMessage *method_call)
     if( !fba_color_profile_exists(val) )
         val = COLOR_PROFILE_ID_HARDCODED;
 
-    if( method_call )
-        msg = dbus_new_method_reply(method_call);
-    else
-        msg = dbus_new_signal(MCE_SIGNAL_PATH,
-                              MCE_SIGNAL_IF,
-                              MCE_COLOR_PROFILE_SIG);
+    /* Changed values are broadcast via property publishing */
+    bool changed = mce_dbus_property_publish(MCE_COLOR_PROFILE_SIG,
+                                             DBUS_TYPE_STRING, &val);
+
+    if( method_call ) {
+        mce_dbus_property_reply(method_call, MCE_COLOR_PROFILE_SIG);
+        goto EXIT;
+    }
+
+    if( changed )
+        goto EXIT;
+
+    msg = dbus_new_signal(MCE_SIGNAL_PATH,
+                          MCE_SIGNAL_IF,
+                          MCE_COLOR_PROFILE_SIG);
     if( !msg )
         goto EXIT;
 
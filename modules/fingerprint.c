@@ -1609,13 +1609,9 @@ EXIT:
 static void
 fingerprint_datapipe_keypress_event_cb(gconstpointer const data)
 {
-    const struct input_event * const *evp;
     const struct input_event *ev;
 
-    if( !(evp = data) )
-        goto EXIT;
-
-    if( !(ev = *evp) )
+    if( !(ev = data) )
         goto EXIT;
 
     /* For example in Sony Xperia X fingerprint scanner is located
@@ -2662,8 +2658,7 @@ fpwakeup_trigger(void)
         datapipe_exec_full(&user_activity_event_pipe, &ev);
 
         /* Forward to powerkey.c for configurable action handling */
-        const struct input_event *evp = &ev;
-        datapipe_exec_full(&keypress_event_pipe, &evp);
+        datapipe_exec_full(&keypress_event_pipe, &ev);
     }
 }
 
@@ -147,7 +147,7 @@ static gboolean mia_dbus_activity_action_owner_cb  (DBusMessage *const sig);
 static gboolean mia_dbus_add_activity_action_cb    (DBusMessage *const msg);
 static gboolean mia_dbus_remove_activity_action_cb (DBusMessage *const msg);
 
-static gboolean mia_dbus_send_inactivity_state     (DBusMessage *const method_call);
+static void     mia_dbus_publish_inactivity_state  (void);
 static gboolean mia_dbus_get_inactivity_state      (DBusMessage *const req);
 
 static void     mia_dbus_init(void);
@@ -444,7 +444,7 @@ static void mia_datapipe_device_inactive_cb(gconstpointer data)
                 mia_inactivity_repr(prev),
                 mia_inactivity_repr(device_inactive));
 
-        mia_dbus_send_inactivity_state(NULL);
+        mia_dbus_publish_inactivity_state();
 
         /* React to activity */
         if( !device_inactive )
@@ -744,7 +744,7 @@ static void mia_datapipe_check_initial_state(void)
      * if the artificial activity gets suppressed. */
 
     mce_log(LL_DEBUG, "forced broadcast");
-    mia_dbus_send_inactivity_state(0);
+    mia_dbus_publish_inactivity_state();
 
 EXIT:
     return;
@@ -1022,64 +1022,30 @@ EXIT:
     return TRUE;
 }
 
-/** Send an inactivity status reply or signal
+/** Publish inactivity status
  *
- * @param method_call A DBusMessage to reply to;
- *                    pass NULL to send an inactivity status signal instead
- * @return TRUE
+ * The value is cached for replying to state queries, and
+ * a signal is broadcast if it differs from the last one sent.
  */
-static gboolean mia_dbus_send_inactivity_state(DBusMessage *const method_call)
+static void mia_dbus_publish_inactivity_state(void)
 {
-    /* Make sure initial state is broadcast; -1 does not match TRUE/FALSE */
-    static int last_sent = -1;
-
-    DBusMessage *msg = NULL;
+    dbus_bool_t value = device_inactive ? TRUE : FALSE;
 
-    if( method_call ) {
-        /* Send reply to state query */
-        msg = dbus_new_method_reply(method_call);
-    }
-    else if( last_sent == device_inactive ) {
-        /* Do not repeat broadcasts */
+    if( !mce_dbus_property_publish(MCE_INACTIVITY_SIG,
+                                   DBUS_TYPE_BOOLEAN, &value) )
         goto EXIT;
-    }
-    else {
-        /* Broadcast state change */
 
-#ifdef ENABLE_WAKELOCKS
-        /* Block suspend for a while to give other processes
-         * a chance to get and process the signal. */
-        mia_keepalive_start();
-#endif
-
-        msg = dbus_new_signal(MCE_SIGNAL_PATH, MCE_SIGNAL_IF,
-                              MCE_INACTIVITY_SIG);
-    }
-
-    mce_log(method_call ? LL_DEBUG : LL_DEVEL,
-            "Sending inactivity %s: %s",
-            method_call ? "reply" : "signal",
+    mce_log(LL_DEVEL, "Sending inactivity signal: %s",
             mia_inactivity_repr(device_inactive));
 
-    /* Append the inactivity status */
-    if( !dbus_message_append_args(msg,
-                                  DBUS_TYPE_BOOLEAN, &device_inactive,
-                                  DBUS_TYPE_INVALID) ) {
-        mce_log(LL_ERR, "Failed to append argument to D-Bus message");
-        goto EXIT;
-    }
-
-    /* Send the message */
-    dbus_send_message(msg), msg = 0;
-
-    if( !method_call )
-        last_sent = device_inactive;
+#ifdef ENABLE_WAKELOCKS
+    /* Block suspend for a while to give other processes
+     * a chance to get and process the signal. */
+    mia_keepalive_start();
+#endif
 
 EXIT:
-    if( msg )
-        dbus_message_unref(msg);
-
-    return TRUE;
+    return;
 }
 
 /** D-Bus callback for the get inactivity status method call
@@ -1093,10 +1059,8 @@ static gboolean mia_dbus_get_inactivity_state(DBusMessage *const req)
         mce_log(LL_DEVEL, "Received inactivity status get request from %s",
                mce_dbus_get_message_sender_ident(req));
 
-        /* Try to send a reply that contains the current inactivity status */
-        mia_dbus_send_inactivity_state(req);
-
-        return TRUE;
+        /* Reply with the published inactivity status */
+        return mce_dbus_property_reply(req, MCE_INACTIVITY_SIG);
 }
 
 /** Array of dbus message handlers */
@@ -1150,6 +1114,9 @@ static mce_dbus_handler_t mia_dbus_handlers[] =
 static void mia_dbus_init(void)
 {
     mce_dbus_handler_register_array(mia_dbus_handlers);
+
+    /* Have a value available for state queries */
+    mia_dbus_publish_inactivity_state();
 }
 
 /** Remove dbus handlers
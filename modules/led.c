@@ -86,10 +86,18 @@ G_MODULE_EXPORT module_info_struct module_info = {
 
 /** The pattern queue */
 static GQueue *pattern_stack = NULL;
+/** Pattern name -> pattern_struct lookup table */
+static GHashTable *pattern_lut = NULL;
+/** Pattern stack position -> pattern_struct lookup array */
+static GPtrArray *pattern_index = NULL;
+/** Number of 64 bit words in pattern bitmasks */
+static guint pattern_mask_words = 0;
+/** Bitmask of active patterns, indexed by pattern stack position */
+static guint64 *pattern_active_mask = NULL;
+/** Bitmask of active and enabled patterns */
+static guint64 *pattern_candidate_mask = NULL;
 /** The pattern combination rule queue */
 static GQueue *combination_rule_list = NULL;
-/** The pattern combination rule queue */
-static GQueue *combination_rule_xref_list = NULL;
 /** The D-Bus controlled LED switch */
 static gboolean led_enabled = FALSE;
 
@@ -143,6 +151,21 @@ typedef enum {
  */
 #define CHANNEL_SIZE		32 * 2
 
+/** Software animation keyframe */
+typedef struct {
+	gint time;			/**< Offset from cycle start in ms */
+	guint rgb;			/**< RGB24 color at this keyframe */
+	gboolean smooth;		/**< Ease in/out towards this keyframe */
+} led_keyframe_t;
+
+/** Software animation compiled from keyframe configuration */
+typedef struct {
+	led_keyframe_t *frames;		/**< Keyframes in time order */
+	guint count;			/**< Number of keyframes */
+	gint period;			/**< Cycle length in ms */
+	guint peak;			/**< Brightest keyframe color */
+} led_animation_t;
+
 /** Structure holding LED patterns */
 typedef struct {
 	gchar *name;			/**< Pattern name */
@@ -166,14 +189,23 @@ typedef struct {
 	guint setting_id;		/**< Callback ID for GConf entry */
 	guint rgb_color;                /**< RGB24 data for libhybris use */
 	gboolean undecided;		/**< Flag for policy=6 lock in */
+	guint stack_pos;		/**< Position in pattern stack */
+	GPtrArray *rules;		/**< Rules using this as pre-requisite */
+	led_animation_t *animation;	/**< Software animation, or NULL */
 } pattern_struct;
 
-/** Pattern combination rule struct; this is also used for cross-referencing */
+/** Pattern combination rule struct */
 typedef struct {
 	/** Name of the combined pattern */
 	gchar *rulename;
 	/** List of pre-requisite patterns */
 	GQueue *pre_requisites;
+	/** The combined pattern, or NULL if it does not exist */
+	pattern_struct *pattern;
+	/** Bitmask of pre-requisite pattern stack positions */
+	guint64 *mask;
+	/** Flag for: all pre-requisite patterns exist */
+	gboolean resolved;
 } combination_rule_struct;
 
 /** Pointer to the top pattern */
@@ -322,7 +354,6 @@ static guint maximum_led_brightness = MAXIMUM_LYSTI_MONOCHROME_LED_CURRENT;
 /* Function prototypes */
 static void              disable_reno                   (void);
 static led_type_t        get_led_type                   (void);
-static gint              queue_find                     (gconstpointer data, gconstpointer userdata);
 static gint              queue_prio_compare             (gconstpointer entry1, gconstpointer entry2, gpointer userdata);
 static void              lysti_set_brightness           (gint brightness);
 static void              njoy_set_brightness            (gint brightness);
@@ -336,6 +367,13 @@ static void              disable_led                    (void);
 static pattern_struct   *led_pattern_create             (void);
 static void              led_pattern_delete             (pattern_struct *self);
 static void              led_pattern_set_active         (pattern_struct *self, gboolean active);
+static void              led_pattern_update_masks       (const pattern_struct *self);
+static bool              led_pattern_is_visible         (const pattern_struct *self);
+static guint64          *led_mask_create                (void);
+static void              led_mask_assign                (guint64 *mask, guint bit, gboolean set);
+static gboolean          led_mask_covers                (const guint64 *mask, const guint64 *subset);
+static void              led_pattern_index_init         (void);
+static void              led_pattern_index_quit         (void);
 static bool              led_pattern_should_breathe     (const pattern_struct *self);
 static bool              led_pattern_can_breathe        (const pattern_struct *self);
 static gboolean          led_pattern_timeout_cb         (gpointer data);
@@ -344,13 +382,24 @@ static void              njoy_program_led               (const pattern_struct *c
 static void              mono_program_led               (const pattern_struct *const pattern);
 static void              hybris_program_led             (const pattern_struct *const pattern);
 static void              program_led                    (const pattern_struct *const pattern);
+static guint             led_rgb_intensity              (guint rgb);
+static led_animation_t  *led_animation_create           (const gchar *name);
+static void              led_animation_delete           (led_animation_t *self);
+static guint             led_animation_eval             (const led_animation_t *self, gint t, gint *hold);
+static void              led_animator_output            (guint rgb);
+static gboolean          led_animator_frame_cb          (gpointer data);
+static bool              led_animator_program           (const pattern_struct *pattern);
+static void              led_animator_stop              (void);
+static void              led_animator_rethink           (void);
+static void              led_animator_init              (void);
+static void              led_animator_quit              (void);
 static void              allow_sw_breathing             (bool enable);
 static void              led_set_active_pattern         (pattern_struct *pattern);
 static gboolean          display_off_p                  (display_state_t state);
 static void              led_update_active_pattern      (void);
 static pattern_struct   *find_pattern_struct            (const gchar *const name);
-static void              update_combination_rule        (gpointer name, gpointer data);
-static void              update_combination_rules       (const gchar *const name);
+static void              update_combination_rule        (combination_rule_struct *cr);
+static void              update_combination_rules       (const pattern_struct *psp);
 static void              led_activate_pattern           (const gchar *const name);
 static void              led_deactivate_pattern         (const gchar *const name);
 static void              led_enable                     (void);
@@ -374,6 +423,7 @@ static gboolean          led_deactivate_pattern_dbus_cb (DBusMessage *const msg)
 static gboolean          led_enable_dbus_cb             (DBusMessage *const msg);
 static gboolean          led_disable_dbus_cb            (DBusMessage *const msg);
 static gboolean          init_combination_rules         (void);
+static void              resolve_combination_rules      (void);
 static gboolean          init_lysti_patterns            (void);
 static gboolean          init_njoy_patterns             (void);
 static gboolean          init_mono_patterns             (void);
@@ -618,31 +668,6 @@ EXIT:
 	return led_type;
 }
 
-/**
- * Custom find function to get a particular entry in the pattern stack
- *
- * @param data The pattern_struct entry
- * @param userdata The pattern name
- * @return Less than, equal to, or greater than zero depending
- *         whether the name of the pattern struct pointed to by data
- *         is less than, equal to, or greater than entry2
- */
-static gint queue_find(gconstpointer data, gconstpointer userdata) G_GNUC_PURE;
-static gint queue_find(gconstpointer data, gconstpointer userdata)
-{
-	pattern_struct *psp;
-
-	if (data == NULL || userdata == NULL)
-		return -1;
-
-	psp = (pattern_struct *)data;
-
-	if (psp->name == NULL)
-		return -1;
-
-	return strcmp(psp->name, (gchar *)userdata);
-}
-
 /**
  * Custom compare function used for priority insertions
  *
@@ -912,6 +937,8 @@ static void hybris_disable_led(void)
  */
 static void disable_led(void)
 {
+	led_animator_stop();
+
 	switch (get_led_type()) {
 	case LED_TYPE_LYSTI_RGB:
 	case LED_TYPE_LYSTI_MONO:
@@ -952,6 +979,9 @@ static pattern_struct *led_pattern_create(void)
 	self->name       = 0;
 	self->timeout_id = 0;
 	self->setting_id = 0;
+	self->stack_pos  = 0;
+	self->rules      = 0;
+	self->animation  = 0;
 
 EXIT:
 	return self;
@@ -970,6 +1000,11 @@ static void led_pattern_delete(pattern_struct *self)
 	mce_setting_notifier_remove(self->setting_id);
 	free(self->name);
 
+	if( self->rules )
+		g_ptr_array_free(self->rules, TRUE);
+
+	led_animation_delete(self->animation);
+
 	g_slice_free(pattern_struct, self);
 
 EXIT:
@@ -999,6 +1034,7 @@ static void led_pattern_set_active(pattern_struct *self, gboolean active)
 		goto EXIT;
 
 	self->active = active;
+	led_pattern_update_masks(self);
 
 	if( !self->enabled )
 		goto EXIT;
@@ -1033,6 +1069,111 @@ EXIT:
 	return;
 }
 
+/** Sync pattern active and enabled state to pattern bitmasks
+ *
+ * @param self    pattern object
+ */
+static void led_pattern_update_masks(const pattern_struct *self)
+{
+	/* Nothing to do until patterns have been indexed */
+	if( !self || !pattern_active_mask )
+		goto EXIT;
+
+	led_mask_assign(pattern_active_mask, self->stack_pos,
+			self->active);
+	led_mask_assign(pattern_candidate_mask, self->stack_pos,
+			self->active && self->enabled);
+
+EXIT:
+	return;
+}
+
+/** Allocate pattern bitmask
+ *
+ * @return bitmask with all bits cleared
+ */
+static guint64 *led_mask_create(void)
+{
+	return g_new0(guint64, pattern_mask_words ? pattern_mask_words : 1);
+}
+
+/** Set or clear a bit in pattern bitmask
+ *
+ * @param mask    pattern bitmask
+ * @param bit     pattern stack position
+ * @param set     TRUE to set the bit, FALSE to clear it
+ */
+static void led_mask_assign(guint64 *mask, guint bit, gboolean set)
+{
+	guint64 val = G_GUINT64_CONSTANT(1) << (bit % 64);
+
+	if( set )
+		mask[bit / 64] |= val;
+	else
+		mask[bit / 64] &= ~val;
+}
+
+/** Check if all bits set in subset are also set in mask
+ *
+ * @param mask    pattern bitmask
+ * @param subset  pattern bitmask
+ *
+ * @return TRUE if subset is covered by mask, FALSE otherwise
+ */
+static gboolean led_mask_covers(const guint64 *mask, const guint64 *subset)
+{
+	for( guint i = 0; i < pattern_mask_words; ++i ) {
+		if( (mask[i] & subset[i]) != subset[i] )
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/** Index patterns by name and by pattern stack position
+ *
+ * Must be called after the pattern stack has been populated.
+ */
+static void led_pattern_index_init(void)
+{
+	pattern_lut = g_hash_table_new(g_str_hash, g_str_equal);
+	pattern_index = g_ptr_array_new();
+
+	for( GList *iter = pattern_stack->head; iter; iter = iter->next ) {
+		pattern_struct *psp = iter->data;
+
+		psp->stack_pos = pattern_index->len;
+		g_ptr_array_add(pattern_index, psp);
+
+		/* In case of duplicates, the one with higher priority wins */
+		if( psp->name && !g_hash_table_lookup(pattern_lut, psp->name) )
+			g_hash_table_insert(pattern_lut, psp->name, psp);
+	}
+
+	pattern_mask_words = (pattern_index->len + 63) / 64;
+	pattern_active_mask = led_mask_create();
+	pattern_candidate_mask = led_mask_create();
+
+	for( guint i = 0; i < pattern_index->len; ++i )
+		led_pattern_update_masks(g_ptr_array_index(pattern_index, i));
+
+	resolve_combination_rules();
+}
+
+/** Release pattern lookup tables and bitmasks
+ */
+static void led_pattern_index_quit(void)
+{
+	if( pattern_lut )
+		g_hash_table_unref(pattern_lut), pattern_lut = NULL;
+
+	if( pattern_index )
+		g_ptr_array_free(pattern_index, TRUE), pattern_index = NULL;
+
+	g_free(pattern_active_mask), pattern_active_mask = NULL;
+	g_free(pattern_candidate_mask), pattern_candidate_mask = NULL;
+	pattern_mask_words = 0;
+}
+
 /** Check if a led pattern should always utilize sw breathing
  *
  * @param self led pattern object
@@ -1308,6 +1449,10 @@ static void hybris_program_led(const pattern_struct *const pattern)
  */
 static void program_led(const pattern_struct *const pattern)
 {
+	/* Patterns with software animation are driven by timers */
+	if( led_animator_program(pattern) )
+		return;
+
 	switch (get_led_type()) {
 	case LED_TYPE_LYSTI_RGB:
 	case LED_TYPE_LYSTI_MONO:
@@ -1334,6 +1479,356 @@ static void program_led(const pattern_struct *const pattern)
 	}
 }
 
+/* ========================================================================= *
+ * SW_ANIMATION
+ * ========================================================================= */
+
+/** Timer for advancing software animation
+ *
+ * Heartbeat timer, so that animation frames while the display is off
+ * are coalesced with other heartbeat timer wakeups.
+ */
+static mce_hbtimer_t *led_animator_timer = NULL;
+
+/** Pattern currently driven by software animation */
+static const pattern_struct *led_animator_pattern = NULL;
+
+/** Boot time tick when current animation was started */
+static int64_t led_animator_start_tick = 0;
+
+/** Last color written to led, or -1 if unknown */
+static gint led_animator_rgb = -1;
+
+/** Minimum delay between animation frames [ms] */
+static gint led_animator_frame_interval = MCE_DEFAULT_LED_ANIMATION_FRAME_INTERVAL;
+
+/** Get intensity of RGB24 color
+ *
+ * @param rgb  RGB24 color
+ *
+ * @return value of the strongest channel, in 0 ... 255 range
+ */
+static guint led_rgb_intensity(guint rgb)
+{
+	guint r = (rgb >> 16) & 0xff;
+	guint g = (rgb >>  8) & 0xff;
+	guint b = (rgb >>  0) & 0xff;
+
+	return MAX(MAX(r, g), b);
+}
+
+/** Compile software animation from configuration
+ *
+ * The configuration value is a list of TIME:RRGGBB keyframes, with
+ * TIME in milliseconds from the start of the cycle. Colors between
+ * keyframes are interpolated linearly, or with ease in/out curve if
+ * the keyframe has a '~' suffix. The cycle length is the time of the
+ * last keyframe, after which the animation wraps to the first one.
+ *
+ * @param name  pattern name
+ *
+ * @return animation object, or NULL if not configured
+ */
+static led_animation_t *led_animation_create(const gchar *name)
+{
+	led_animation_t *self = NULL;
+	gchar **v = NULL;
+	gsize length = 0;
+
+	if( !mce_conf_has_key(MCE_CONF_LED_ANIMATION_GROUP, name) )
+		goto EXIT;
+
+	v = mce_conf_get_string_list(MCE_CONF_LED_ANIMATION_GROUP,
+				     name, &length);
+	if( !v || length < 2 ) {
+		mce_log(LL_ERR, "LED animation '%s' is invalid", name);
+		goto EXIT;
+	}
+
+	self = g_slice_new0(led_animation_t);
+	self->frames = g_new0(led_keyframe_t, length);
+	self->count  = 0;
+	self->period = 0;
+	self->peak   = 0;
+
+	for( gsize i = 0; i < length; ++i ) {
+		led_keyframe_t *kf = &self->frames[self->count];
+		char *end = v[i];
+
+		kf->time = strtol(end, &end, 0);
+		if( *end++ != ':' )
+			goto INVALID;
+
+		kf->rgb = strtoul(end, &end, 16) & 0xffffff;
+		kf->smooth = (*end == '~');
+		if( kf->smooth )
+			++end;
+		if( *end )
+			goto INVALID;
+
+		if( kf->time < self->period )
+			goto INVALID;
+
+		self->period = kf->time;
+		self->count += 1;
+
+		if( led_rgb_intensity(kf->rgb) >= led_rgb_intensity(self->peak) )
+			self->peak = kf->rgb;
+	}
+
+	if( self->period <= 0 )
+		goto INVALID;
+
+	mce_log(LL_DEBUG, "LED animation '%s': %u keyframes, %d ms cycle",
+		name, self->count, self->period);
+
+	goto EXIT;
+
+INVALID:
+	mce_log(LL_ERR, "LED animation '%s': invalid keyframe '%s'",
+		name, v[MIN(self->count, length - 1)]);
+	led_animation_delete(self), self = NULL;
+
+EXIT:
+	g_strfreev(v);
+
+	return self;
+}
+
+/** Release software animation
+ *
+ * @param self  animation object, or NULL
+ */
+static void led_animation_delete(led_animation_t *self)
+{
+	if( !self )
+		goto EXIT;
+
+	g_free(self->frames);
+	g_slice_free(led_animation_t, self);
+
+EXIT:
+	return;
+}
+
+/** Evaluate software animation color at given time
+ *
+ * @param self  animation object
+ * @param t     time from animation start [ms]
+ * @param hold  where to store time until color needs reevaluation [ms]
+ *
+ * @return RGB24 color
+ */
+static guint led_animation_eval(const led_animation_t *self, gint t,
+				gint *hold)
+{
+	t %= self->period;
+
+	/* Locate keyframes surrounding t; time before the first
+	 * keyframe and after the last one wraps around the cycle */
+	guint i = 0;
+	while( i < self->count && self->frames[i].time <= t )
+		++i;
+
+	const led_keyframe_t *prev = &self->frames[(i + self->count - 1) % self->count];
+	const led_keyframe_t *next = &self->frames[i % self->count];
+
+	gint t0 = (i == 0) ? 0 : prev->time;
+	gint t1 = (i == self->count) ? self->period : next->time;
+
+	*hold = t1 - t;
+
+	/* Flat segments need no updates until the segment ends */
+	if( prev->rgb == next->rgb || t1 <= t0 )
+		return prev->rgb;
+
+	*hold = MIN(*hold, led_animator_frame_interval);
+
+	/* Interpolation weight in 0 ... 1024 range */
+	gint w = (t - t0) * 1024 / (t1 - t0);
+	if( next->smooth )
+		w = w * w / 1024 * (3 * 1024 - 2 * w) / 1024;
+
+	guint rgb = 0;
+	for( int shift = 0; shift < 24; shift += 8 ) {
+		gint a = (prev->rgb >> shift) & 0xff;
+		gint b = (next->rgb >> shift) & 0xff;
+		rgb |= (guint)(a + (b - a) * w / 1024) << shift;
+	}
+
+	return rgb;
+}
+
+/** Write animation color to led, skipping writes that change nothing
+ *
+ * @param rgb  RGB24 color
+ */
+static void led_animator_output(guint rgb)
+{
+	if( led_animator_rgb == (gint)rgb )
+		goto EXIT;
+
+	led_animator_rgb = (gint)rgb;
+
+	switch (get_led_type()) {
+	case LED_TYPE_DIRECT_MONO:
+		mono_set_brightness(led_rgb_intensity(rgb) *
+				    led_animator_pattern->brightness / 255);
+		break;
+
+#ifdef ENABLE_HYBRIS
+	case LED_TYPE_HYBRIS:
+		mce_hybris_indicator_set_pattern((rgb >> 16) & 0xff,
+						 (rgb >>  8) & 0xff,
+						 (rgb >>  0) & 0xff,
+						 0, 0);
+		break;
+#endif
+
+	default:
+		break;
+	}
+
+EXIT:
+	return;
+}
+
+/** Timer callback for advancing software animation
+ *
+ * @param data  (unused)
+ *
+ * @return TRUE to schedule the next frame, FALSE to stop
+ */
+static gboolean led_animator_frame_cb(gpointer data)
+{
+	(void)data;
+
+	gboolean again = FALSE;
+	gint     hold  = 0;
+
+	if( !led_animator_pattern )
+		goto EXIT;
+
+	const led_animation_t *animation = led_animator_pattern->animation;
+
+	/* Hold the peak color while the display is on */
+	if( !display_off_p(display_state_curr) ) {
+		led_animator_output(animation->peak);
+		goto EXIT;
+	}
+
+	int64_t t = mce_lib_get_boot_tick() - led_animator_start_tick;
+
+	led_animator_output(led_animation_eval(animation,
+					       (gint)(t % animation->period),
+					       &hold));
+
+	mce_hbtimer_set_period(led_animator_timer, MAX(hold, 1));
+	again = TRUE;
+
+EXIT:
+	return again;
+}
+
+/** Start software animation if the pattern has one
+ *
+ * @param pattern  led pattern to program
+ *
+ * @return true if the pattern is handled by animator, false otherwise
+ */
+static bool led_animator_program(const pattern_struct *pattern)
+{
+	led_animator_stop();
+
+	if( !pattern || !pattern->animation || !led_animator_timer )
+		goto EXIT;
+
+	led_animator_pattern = pattern;
+	led_animator_start_tick = mce_lib_get_boot_tick();
+
+	if( get_led_type() == LED_TYPE_DIRECT_MONO )
+		mce_write_string_to_file(MCE_LED_TRIGGER_PATH,
+					 MCE_LED_TRIGGER_NONE);
+
+	led_animator_rethink();
+
+EXIT:
+	return led_animator_pattern != NULL;
+}
+
+/** Stop software animation
+ */
+static void led_animator_stop(void)
+{
+	mce_hbtimer_stop(led_animator_timer);
+	led_animator_pattern = NULL;
+	led_animator_rgb = -1;
+}
+
+/** Reevaluate software animation after display state change
+ *
+ * Animation runs only while the display is off. Otherwise the
+ * led shows the static peak color and the timer is stopped.
+ */
+static void led_animator_rethink(void)
+{
+	if( !led_animator_pattern )
+		goto EXIT;
+
+	mce_hbtimer_stop(led_animator_timer);
+
+	if( led_animator_frame_cb(NULL) )
+		mce_hbtimer_start(led_animator_timer);
+
+EXIT:
+	return;
+}
+
+/** Compile software animations for the configured led patterns
+ *
+ * Only led types without hw pattern engine are animated.
+ */
+static void led_animator_init(void)
+{
+	switch (get_led_type()) {
+	case LED_TYPE_DIRECT_MONO:
+#ifdef ENABLE_HYBRIS
+	case LED_TYPE_HYBRIS:
+#endif
+		break;
+
+	default:
+		goto EXIT;
+	}
+
+	led_animator_frame_interval =
+		mce_conf_get_int(MCE_CONF_LED_GROUP,
+				 MCE_CONF_LED_ANIMATION_FRAME_INTERVAL,
+				 MCE_DEFAULT_LED_ANIMATION_FRAME_INTERVAL);
+	if( led_animator_frame_interval < 10 )
+		led_animator_frame_interval = 10;
+
+	led_animator_timer = mce_hbtimer_create("led-animation",
+						led_animator_frame_interval,
+						led_animator_frame_cb, 0);
+
+	for( GList *iter = pattern_stack->head; iter; iter = iter->next ) {
+		pattern_struct *psp = iter->data;
+		psp->animation = led_animation_create(psp->name);
+	}
+
+EXIT:
+	return;
+}
+
+/** Release software animation resources
+ */
+static void led_animator_quit(void)
+{
+	led_animator_stop();
+	mce_hbtimer_delete(led_animator_timer), led_animator_timer = NULL;
+}
+
 /** Enable/disable led breathing via software
  *
  * @param pattern A pointer to a pattern_struct with the new pattern
@@ -1426,92 +1921,97 @@ static gboolean display_off_p(display_state_t state)
 	return is_off;
 }
 
-/**
- * Recalculate active pattern and update the pattern timer
+/** Check if active and enabled pattern can be shown in current state
+ *
+ * @param self    pattern object
+ *
+ * @return true if pattern can be shown, false otherwise
  */
-static void led_update_active_pattern(void)
+static bool led_pattern_is_visible(const pattern_struct *self)
 {
-	pattern_struct *new_active_pattern = 0;
-
-	if( !pattern_stack )
-		goto EXIT;
-
-	for( GList *iter = pattern_stack->head; ; iter = iter->next ) {
-		if( !iter ) {
-			new_active_pattern = 0;
-			break;
-		}
-
-		new_active_pattern = iter->data;
-
 #if 0 /* While this can be useful when actively debugging led
        * activation logic, it creates so much noise that using
        * debug verbosity becomes impossible - do not compile in
        * by default. */
-		mce_log(LL_DEBUG,
-			"pattern: %s, active: %d, enabled: %d",
-			new_active_pattern->name,
-			new_active_pattern->active,
-			new_active_pattern->enabled);
+	mce_log(LL_DEBUG,
+		"pattern: %s, active: %d, enabled: %d",
+		self->name,
+		self->active,
+		self->enabled);
 #endif
 
-		/* If the pattern is deactivated, ignore */
-		if (new_active_pattern->active == FALSE)
-			continue;
-
-		/* If the pattern is disabled through GConf, ignore */
-		if (new_active_pattern->enabled == FALSE)
-			continue;
+	/* If the LED is disabled,
+	 * only patterns with visibility 5 are shown
+	 */
+	if ((led_enabled == FALSE) &&
+	    (self->policy != 5))
+		return false;
+
+	/* Always show pattern with visibility 3 or 5 */
+	if ((self->policy == 3) ||
+	    (self->policy == 5))
+		return true;
+
+	/* Show pattern with visibility 7 if display is dimmed */
+	if( self->policy == 7 )
+		return display_state_curr == MCE_DISPLAY_DIM;
+
+	/* Acting dead behaviour */
+	if (system_state == MCE_SYSTEM_STATE_ACTDEAD) {
+		/* If we're in acting dead,
+		 * show patterns with visibility 4
+		 */
+		if (self->policy == 4)
+			return true;
 
-		/* If the LED is disabled,
-		 * only patterns with visibility 5 are shown
+		/* If we're in acting dead
+		 * and the display is off, show pattern
 		 */
-		if ((led_enabled == FALSE) &&
-		    (new_active_pattern->policy != 5))
-			continue;
+		if (display_off_p(display_state_curr) &&
+		    (self->policy == 2))
+			return true;
 
-		/* Always show pattern with visibility 3 or 5 */
-		if ((new_active_pattern->policy == 3) ||
-		    (new_active_pattern->policy == 5))
-			break;
+		/* If the display is on and visibility is 2,
+		 * or if visibility is 1/0, ignore pattern
+		 */
+		return false;
+	}
 
-		/* Show pattern with visibility 7 if display is dimmed */
-		if( new_active_pattern->policy == 7 ) {
-			if( display_state_curr == MCE_DISPLAY_DIM )
-				break;
-			continue;
-		}
+	/* If the display is off or in low power mode,
+	 * we can use any active pattern
+	 */
+	if( display_off_p(display_state_curr) )
+		return true;
 
-		/* Acting dead behaviour */
-		if (system_state == MCE_SYSTEM_STATE_ACTDEAD) {
-			/* If we're in acting dead,
-			 * show patterns with visibility 4
-			 */
-			if (new_active_pattern->policy == 4)
-				break;
+	/* If the pattern should be shown with screen on, use it */
+	return self->policy == 1;
+}
 
-			/* If we're in acting dead
-			 * and the display is off, show pattern
-			 */
-			if (display_off_p(display_state_curr) &&
-			    (new_active_pattern->policy == 2))
-				break;
+/**
+ * Recalculate active pattern and update the pattern timer
+ *
+ * Only patterns that are both active and enabled are evaluated,
+ * in pattern stack i.e. priority order.
+ */
+static void led_update_active_pattern(void)
+{
+	pattern_struct *new_active_pattern = 0;
 
-			/* If the display is on and visibility is 2,
-			 * or if visibility is 1/0, ignore pattern
-			 */
-			continue;
-		}
+	if( !pattern_candidate_mask )
+		goto EXIT;
 
-		/* If the display is off or in low power mode,
-		 * we can use any active pattern
-		 */
-		if( display_off_p(display_state_curr) )
-			break;
+	for( guint i = 0; i < pattern_mask_words; ++i ) {
+		for( guint64 bits = pattern_candidate_mask[i]; bits;
+		     bits &= bits - 1 ) {
+			guint pos = i * 64 + __builtin_ctzll(bits);
+			pattern_struct *psp = g_ptr_array_index(pattern_index,
+								 pos);
 
-		/* If the pattern should be shown with screen on, use it */
-		if (new_active_pattern->policy == 1)
-			break;
+			if( led_pattern_is_visible(psp) ) {
+				new_active_pattern = psp;
+				goto EXIT;
+			}
+		}
 	}
 
 EXIT:
@@ -1528,15 +2028,11 @@ EXIT:
 static pattern_struct *find_pattern_struct(const gchar *const name)
 {
 	pattern_struct *psp = NULL;
-	GList *glp;
 
-	if (name == NULL)
+	if (name == NULL || pattern_lut == NULL)
 		goto EXIT;
 
-	if ((glp = g_queue_find_custom(pattern_stack,
-				       name, queue_find)) != NULL) {
-		psp = (pattern_struct *)glp->data;
-	}
+	psp = g_hash_table_lookup(pattern_lut, name);
 
 EXIT:
 	return psp;
@@ -1545,42 +2041,22 @@ EXIT:
 /**
  * Update combination rule
  *
- * @param name The rule to process
- * @param data Unused
+ * @param cr The rule to process
  */
-static void update_combination_rule(gpointer name, gpointer data)
+static void update_combination_rule(combination_rule_struct *cr)
 {
-	combination_rule_struct *cr;
-	gboolean enabled = TRUE;
-	pattern_struct *psp;
-	GList *glp;
-	gchar *tmp;
-	gint i;
+	gboolean enabled = FALSE;
 
-	(void)data;
-
-	if ((glp = g_queue_find_custom(combination_rule_list,
-				       name, queue_find)) == NULL)
+	if (cr->pattern == NULL)
 		goto EXIT;
 
-	cr = glp->data;
-
-	/* If all patterns in the pre_requisite list are enabled,
-	 * then enable this pattern, else disable it
+	/* If all patterns in the pre_requisite list are active,
+	 * then activate this pattern, else deactivate it
 	 */
-	for (i = 0; (tmp = g_queue_peek_nth(cr->pre_requisites, i)) != NULL; i++) {
-		/* We've got a pattern name; check if that pattern is active */
-		if (((psp = find_pattern_struct(tmp)) == NULL) ||
-		    (psp->active == FALSE)) {
-			enabled = FALSE;
-			break;
-		}
-	}
+	if (cr->resolved)
+		enabled = led_mask_covers(pattern_active_mask, cr->mask);
 
-	if ((psp = find_pattern_struct(name)) == NULL)
-		goto EXIT;
-
-	led_pattern_set_active(psp, enabled);
+	led_pattern_set_active(cr->pattern, enabled);
 
 EXIT:
 	return;
@@ -1589,26 +2065,22 @@ EXIT:
 /**
  * Update activate patterns based on combination rules
  *
- * @param name THe name of the pattern that changed state
+ * @param psp The pattern that changed state
  */
-static void update_combination_rules(const gchar *const name)
+static void update_combination_rules(const pattern_struct *psp)
 {
-	GList *glp;
-
-	if (name == NULL) {
+	if (psp == NULL) {
 		mce_log(LL_CRIT,
-			"called with name == NULL");
+			"called with psp == NULL");
 		goto EXIT;
 	}
 
-	if ((glp = g_queue_find_custom(combination_rule_xref_list, name,
-				       queue_find)) != NULL) {
-		combination_rule_struct *xrf = glp->data;
+	if (psp->rules == NULL)
+		goto EXIT;
 
-		/* Update all combination rules that this pattern influences */
-		g_queue_foreach(xrf->pre_requisites,
-				update_combination_rule, NULL);
-	}
+	/* Update all combination rules that this pattern influences */
+	for (guint i = 0; i < psp->rules->len; i++)
+		update_combination_rule(g_ptr_array_index(psp->rules, i));
 
 EXIT:
 	return;
@@ -1633,7 +2105,7 @@ static void led_activate_pattern(const gchar *const name)
 		if( !psp->active && psp->policy == 6 )
 			psp->undecided = TRUE;
 		led_pattern_set_active(psp, TRUE);
-		update_combination_rules(name);
+		update_combination_rules(psp);
 		led_update_active_pattern();
 	} else {
 		mce_log(LL_DEBUG,
@@ -1656,7 +2128,7 @@ static void led_deactivate_pattern(const gchar *const name)
 
 	if ((psp = find_pattern_struct(name)) != NULL) {
 		led_pattern_set_active(psp, FALSE);
-		update_combination_rules(name);
+		update_combination_rules(psp);
 		led_update_active_pattern();
 	} else {
 		mce_log(LL_DEBUG,
@@ -1768,7 +2240,7 @@ static void type6_revert_cb(void *data, void *aptr)
 
 	if( psp->undecided && psp->active && psp->policy == 6 ) {
 		led_pattern_set_active(psp, FALSE);
-		update_combination_rules(psp->name);
+		update_combination_rules(psp);
 		mce_log(LL_DEBUG, "LED pattern %s: reverted", psp->name);
 	}
 	psp->undecided = FALSE;
@@ -1787,7 +2259,7 @@ static void type6_deactivate_cb(void *data, void *aptr)
 
 	if( psp->active && psp->policy == 6 ) {
 		led_pattern_set_active(psp, FALSE);
-		update_combination_rules(psp->name);
+		update_combination_rules(psp);
 		mce_log(LL_DEBUG, "LED pattern %s: deactivated", psp->name);
 	}
 	psp->undecided = FALSE;
@@ -1861,6 +2333,7 @@ static void display_state_curr_trigger(gconstpointer data)
 	}
 
 	led_update_active_pattern();
+	led_animator_rethink();
 
 EXIT:
 	return;
@@ -1992,6 +2465,7 @@ static void led_setting_cb(GConfClient *const gcc, const guint id,
 				       &id, setting_id_find)) != NULL) {
 		psp = (pattern_struct *)glp->data;
 		psp->enabled = gconf_value_get_bool(gcv);
+		led_pattern_update_masks(psp);
 		led_update_active_pattern();
 	} else {
 		mce_log(LL_WARN, "Spurious GConf value received; confused!");
@@ -2231,34 +2705,18 @@ static gboolean init_combination_rules(void)
 
 			cr->rulename = strdup(tmp[0]);
 			cr->pre_requisites = g_queue_new();
+			cr->pattern = NULL;
+			cr->mask = NULL;
+			cr->resolved = FALSE;
 
 			for (j = 1; j < length; j++) {
 				gchar *str = strdup(tmp[j]);
-				GList *glp;
-				combination_rule_struct *xrf = NULL;
 
 				g_queue_push_head(cr->pre_requisites, str);
-
-				glp = g_queue_find_custom(combination_rule_xref_list, str, queue_find);
-
-				if ((glp == NULL) || (glp->data == NULL)) {
-					xrf = g_slice_new(combination_rule_struct);
-					xrf->rulename = str;
-					xrf->pre_requisites = g_queue_new();
-					g_queue_push_head(combination_rule_xref_list, xrf);
-				} else {
-					xrf = (combination_rule_struct *)glp->data;
-				}
-
-				/* If the cross reference isn't in the list
-				 * already, add it
-				 */
-				if (g_queue_find_custom(xrf->pre_requisites, cr->rulename, queue_find) == NULL) {
-					g_queue_push_head(xrf->pre_requisites,
-							  cr->rulename);
-				}
 			}
 
+			g_strfreev(tmp);
+
 			g_queue_push_head(combination_rule_list, cr);
 		}
 	}
@@ -2272,6 +2730,50 @@ EXIT:
 	return status;
 }
 
+/**
+ * Resolve combination rule pattern names into pattern bitmasks
+ *
+ * Also cross-references each pre-requisite pattern to the rules
+ * it influences.
+ */
+static void resolve_combination_rules(void)
+{
+	for (GList *iter = combination_rule_list->head; iter; iter = iter->next) {
+		combination_rule_struct *cr = iter->data;
+
+		cr->pattern = find_pattern_struct(cr->rulename);
+		cr->mask = led_mask_create();
+		cr->resolved = TRUE;
+
+		if (cr->pattern == NULL)
+			continue;
+
+		for (GList *item = cr->pre_requisites->head; item; item = item->next) {
+			pattern_struct *psp = find_pattern_struct(item->data);
+
+			if (psp == NULL) {
+				cr->resolved = FALSE;
+				continue;
+			}
+
+			led_mask_assign(cr->mask, psp->stack_pos, TRUE);
+
+			if (psp->rules == NULL)
+				psp->rules = g_ptr_array_new();
+
+			/* If the cross reference isn't in the list
+			 * already, add it
+			 */
+			guint i = 0;
+			while (i < psp->rules->len &&
+			       g_ptr_array_index(psp->rules, i) != cr)
+				i++;
+			if (i == psp->rules->len)
+				g_ptr_array_add(psp->rules, cr);
+		}
+	}
+}
+
 /**
  * Init patterns for Lysti controlled RGB or monochrome LED
  *
@@ -2874,6 +3376,12 @@ static gboolean init_patterns(void)
 		break;
 	}
 
+	/* Index patterns and resolve combination rules */
+	led_pattern_index_init();
+
+	/* Compile software animations */
+	led_animator_init();
+
 	/* Handle common pattern initialization */
 	for( GList *iter = pattern_stack->head; iter; iter = iter->next ) {
 		pattern_struct *psp = iter->data;
@@ -2932,6 +3440,10 @@ static void sw_breathing_rethink(void)
 		 * not breathe even if it were allowed */
 		if( !led_pattern_can_breathe(active_pattern) )
 			breathe = false;
+
+		/* Software animation replaces breathing */
+		if( active_pattern == led_animator_pattern )
+			breathe = false;
 	}
 
 	allow_sw_breathing(breathe);
@@ -3194,13 +3706,11 @@ const gchar *g_module_check_init(GModule *module)
 	/* Append triggers/filters to datapipes */
 	mce_led_datapipes_init();
 
-	/* Setup a pattern stack,
-	 * a combination rule stack and a cross-refernce for said stack
+	/* Setup a pattern stack and a combination rule stack
 	 * and initialise the patterns
 	 */
 	pattern_stack = g_queue_new();
 	combination_rule_list = g_queue_new();
-	combination_rule_xref_list = g_queue_new();
 
 	if (init_patterns() == FALSE)
 		goto EXIT;
@@ -3249,6 +3759,9 @@ void g_module_unload(GModule *module)
 	/* Remove breathing timers and wakelocks */
 	sw_breathing_quit();
 
+	/* Remove animation timer */
+	led_animator_quit();
+
 	/* Don't disable the LED on shutdown/reboot/acting dead */
 	if ((system_state != MCE_SYSTEM_STATE_ACTDEAD) &&
 	    (system_state != MCE_SYSTEM_STATE_SHUTDOWN) &&
@@ -3292,6 +3805,9 @@ void g_module_unload(GModule *module)
 	g_free(engine2_leds_path);
 	g_free(engine3_leds_path);
 
+	/* Free pattern lookup tables */
+	led_pattern_index_quit();
+
 	/* Free the pattern stack */
 	if (pattern_stack != NULL) {
 		pattern_struct *psp;
@@ -3318,6 +3834,8 @@ void g_module_unload(GModule *module)
 
 			g_queue_free(cr->pre_requisites);
 			cr->pre_requisites = NULL;
+			g_free(cr->mask);
+			free(cr->rulename);
 			g_slice_free(combination_rule_struct, cr);
 		}
 
@@ -3325,19 +3843,5 @@ void g_module_unload(GModule *module)
 		combination_rule_list = NULL;
 	}
 
-	/* Free the combination rule cross reference list */
-	if (combination_rule_xref_list != NULL) {
-		combination_rule_struct *xrf;
-
-		while ((xrf = g_queue_pop_head(combination_rule_xref_list)) != NULL) {
-			g_queue_free(xrf->pre_requisites);
-			xrf->pre_requisites = NULL;
-			g_slice_free(combination_rule_struct, xrf);
-		}
-
-		g_queue_free(combination_rule_xref_list);
-		combination_rule_xref_list = NULL;
-	}
-
 	return;
 }
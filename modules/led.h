@@ -80,6 +80,17 @@
  */
 #define MCE_CONF_LED_PATTERN_HYBRIS_GROUP	"LEDPatternHybris"
 
+/**
+ * Name of LED software animation configuration group
+ *
+ * Keys are pattern names, values are keyframe lists.
+ */
+#define MCE_CONF_LED_ANIMATION_GROUP		"LEDAnimation"
+
+/** Name of configuration key for software animation frame interval */
+#define MCE_CONF_LED_ANIMATION_FRAME_INTERVAL	"AnimationFrameInterval"
+#define MCE_DEFAULT_LED_ANIMATION_FRAME_INTERVAL 50	/* ms */
+
 /* ========================================================================= *
  * Settings
  * ========================================================================= */
@@ -51,4 +51,27 @@
 # define MCE_SETTING_MEMNOTIFY_CRITICAL_ACTIVE  MCE_SETTING_MEMNOTIFY_PATH"/critical/active"
 # define MCE_DEFAULT_MEMNOTIFY_CRITICAL_ACTIVE  0 // = disabled
 
+/* ========================================================================= *
+ * Configuration
+ * ========================================================================= */
+
+/** Configuration group for pressure stall based memory tracking */
+# define MCE_CONF_MEMPRESSURE_GROUP             "MemPressure"
+
+/** Cgroup v2 directory to track instead of system wide pressure */
+# define MCE_CONF_MEMPRESSURE_CGROUP_DIRECTORY  "CgroupDirectory"
+# define MCE_DEFAULT_MEMPRESSURE_CGROUP_DIRECTORY ""
+
+/** PSI trigger for warning level: "some|full <stall us> <window us>" */
+# define MCE_CONF_MEMPRESSURE_WARNING_TRIGGER   "WarningTrigger"
+# define MCE_DEFAULT_MEMPRESSURE_WARNING_TRIGGER "some 150000 1000000"
+
+/** PSI trigger for critical level: "some|full <stall us> <window us>" */
+# define MCE_CONF_MEMPRESSURE_CRITICAL_TRIGGER  "CriticalTrigger"
+# define MCE_DEFAULT_MEMPRESSURE_CRITICAL_TRIGGER "full 100000 1000000"
+
+/** How long level is held after the last pressure event [ms] */
+# define MCE_CONF_MEMPRESSURE_HOLD_TIME         "HoldTime"
+# define MCE_DEFAULT_MEMPRESSURE_HOLD_TIME      5000
+
 #endif /* MEMNOTIFY_H_ */
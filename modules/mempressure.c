@@ -23,11 +23,13 @@
 
 #include "../mce.h"
 #include "../mce-log.h"
+#include "../mce-conf.h"
 #include "../mce-setting.h"
 
 #include <sys/eventfd.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <inttypes.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -39,6 +41,15 @@
 #define CGROUP_DATA_PATH        CGROUP_MEMORY_DIRECTORY "/memory.usage_in_bytes"
 #define CGROUP_CTRL_PATH        CGROUP_MEMORY_DIRECTORY "/cgroup.event_control"
 
+/* Paths to pressure stall information (PSI) and cgroup v2 files */
+#define PSI_MEMORY_PATH         "/proc/pressure/memory"
+#define CGROUP2_PRESSURE_FILE   "memory.pressure"
+#define CGROUP2_EVENTS_FILE     "memory.events"
+
+/* Tracking window limits imposed by kernel on PSI triggers [us] */
+#define PSI_WINDOW_MIN_US       500000
+#define PSI_WINDOW_MAX_US       10000000
+
 /* RAM page size in bytes
  *
  * Configuration is defined in terms of (memnotify style) page counts.
@@ -60,6 +71,50 @@ typedef struct
     gint        mnl_used;
 } mempressure_limit_t;
 
+/** Counters parsed from cgroup v2 memory.events file */
+typedef struct
+{
+    /** Times usage went over memory.high */
+    uint64_t    mpe_high;
+
+    /** Times usage was about to go over memory.max */
+    uint64_t    mpe_max;
+
+    /** Times usage hit the limit and allocation failed */
+    uint64_t    mpe_oom;
+
+    /** Number of processes killed by oom killer */
+    uint64_t    mpe_oom_kill;
+} mempressure_psi_events_t;
+
+/** Pressure stall trigger state for one memnotify level */
+typedef struct
+{
+    /** Memory level the trigger maps to */
+    memnotify_level_t mpt_level;
+
+    /** Configuration key for trigger description */
+    const char       *mpt_key;
+
+    /** Default trigger description */
+    const char       *mpt_def;
+
+    /** Parsed trigger in kernel format, or empty if disabled */
+    char              mpt_spec[64];
+
+    /** Tracking window [ms] */
+    int               mpt_window_ms;
+
+    /** File descriptor with trigger installed */
+    int               mpt_fd;
+
+    /** I/O watch for mpt_fd */
+    guint             mpt_watch_id;
+
+    /** Timeout for dropping level after pressure subsides */
+    guint             mpt_hold_id;
+} mempressure_psi_trigger_t;
+
 /* ========================================================================= *
  * Prototypes
  * ========================================================================= */
@@ -87,9 +142,30 @@ static bool mempressure_limit_exceeded(const mempressure_limit_t *self, const me
  * ------------------------------------------------------------------------- */
 
 static memnotify_level_t mempressure_status_evaluate_level(void);
+static bool              mempressure_status_set_level     (memnotify_level_t level);
 static bool              mempressure_status_update_level  (void);
 static void              mempressure_status_show_triggers (void);
 
+/* ------------------------------------------------------------------------- *
+ * MEMPRESSURE_PSI
+ * ------------------------------------------------------------------------- */
+
+static void              mempressure_psi_config_paths    (void);
+static memnotify_level_t mempressure_psi_evaluate_level  (void);
+static bool              mempressure_psi_trigger_config  (mempressure_psi_trigger_t *self);
+static gboolean          mempressure_psi_trigger_hold_cb (gpointer aptr);
+static gboolean          mempressure_psi_trigger_event_cb(GIOChannel *chn, GIOCondition cnd, gpointer aptr);
+static void              mempressure_psi_trigger_quit    (mempressure_psi_trigger_t *self);
+static bool              mempressure_psi_trigger_init    (mempressure_psi_trigger_t *self);
+static bool              mempressure_psi_events_read     (mempressure_psi_events_t *events);
+static gboolean          mempressure_psi_events_hold_cb  (gpointer aptr);
+static gboolean          mempressure_psi_events_cb       (GIOChannel *chn, GIOCondition cnd, gpointer aptr);
+static void              mempressure_psi_events_quit     (void);
+static void              mempressure_psi_events_init     (void);
+static bool              mempressure_psi_is_available    (void);
+static void              mempressure_psi_quit            (void);
+static bool              mempressure_psi_init            (void);
+
 /* ------------------------------------------------------------------------- *
  * MEMPRESSURE_CGROUP
  * ------------------------------------------------------------------------- */
@@ -275,13 +351,13 @@ mempressure_status_evaluate_level(void)
     return res;
 }
 
-/** Re-evaluate memory use level and broadcast changes via datapipe
+/** Set memory use level and broadcast changes via datapipe
  */
 static bool
-mempressure_status_update_level(void)
+mempressure_status_set_level(memnotify_level_t level)
 {
     memnotify_level_t prev = mempressure_level;
-    mempressure_level = mempressure_status_evaluate_level();
+    mempressure_level = level;
 
     if( mempressure_level == prev )
         goto EXIT;
@@ -298,6 +374,14 @@ EXIT:
     return mempressure_level != MEMNOTIFY_LEVEL_UNKNOWN;
 }
 
+/** Re-evaluate memory use level and broadcast changes via datapipe
+ */
+static bool
+mempressure_status_update_level(void)
+{
+    return mempressure_status_set_level(mempressure_status_evaluate_level());
+}
+
 /** Log current memory level configuration for debugging purposes
  */
 static void
@@ -312,6 +396,538 @@ mempressure_status_show_triggers(void)
     }
 }
 
+/* ========================================================================= *
+ * MEMPRESSURE_PSI
+ * ========================================================================= */
+
+/** PSI triggers for warning and critical levels */
+static mempressure_psi_trigger_t mempressure_psi_trigger[] =
+{
+    {
+        .mpt_level     = MEMNOTIFY_LEVEL_WARNING,
+        .mpt_key       = MCE_CONF_MEMPRESSURE_WARNING_TRIGGER,
+        .mpt_def       = MCE_DEFAULT_MEMPRESSURE_WARNING_TRIGGER,
+        .mpt_fd        = -1,
+    },
+    {
+        .mpt_level     = MEMNOTIFY_LEVEL_CRITICAL,
+        .mpt_key       = MCE_CONF_MEMPRESSURE_CRITICAL_TRIGGER,
+        .mpt_def       = MCE_DEFAULT_MEMPRESSURE_CRITICAL_TRIGGER,
+        .mpt_fd        = -1,
+    },
+};
+
+/** Path to memory.pressure style file */
+static gchar *mempressure_psi_pressure_path = 0;
+
+/** Path to cgroup v2 memory.events file, or NULL */
+static gchar *mempressure_psi_events_path = 0;
+
+/** File descriptor for mempressure_psi_events_path */
+static int    mempressure_psi_events_fd = -1;
+
+/** I/O watch for mempressure_psi_events_fd */
+static guint  mempressure_psi_events_id = 0;
+
+/** Timeout for dropping level raised by memory.events changes */
+static guint  mempressure_psi_events_hold_id = 0;
+
+/** Level raised by memory.events changes */
+static memnotify_level_t mempressure_psi_events_level = MEMNOTIFY_LEVEL_NORMAL;
+
+/** Previously seen memory.events counters */
+static mempressure_psi_events_t mempressure_psi_events_prev;
+
+/** How long levels are held after the last event [ms] */
+static gint   mempressure_psi_hold_ms = MCE_DEFAULT_MEMPRESSURE_HOLD_TIME;
+
+/** Flag for: PSI backend is in use */
+static bool   mempressure_psi_active = false;
+
+/** Resolve pressure / events file paths from configuration
+ */
+static void
+mempressure_psi_config_paths(void)
+{
+    gchar *dir = mce_conf_get_string(MCE_CONF_MEMPRESSURE_GROUP,
+                                     MCE_CONF_MEMPRESSURE_CGROUP_DIRECTORY,
+                                     MCE_DEFAULT_MEMPRESSURE_CGROUP_DIRECTORY);
+
+    g_free(mempressure_psi_pressure_path),
+        mempressure_psi_pressure_path = 0;
+    g_free(mempressure_psi_events_path),
+        mempressure_psi_events_path = 0;
+
+    if( dir && *dir ) {
+        mempressure_psi_pressure_path =
+            g_build_filename(dir, CGROUP2_PRESSURE_FILE, NULL);
+        mempressure_psi_events_path =
+            g_build_filename(dir, CGROUP2_EVENTS_FILE, NULL);
+    }
+    else {
+        mempressure_psi_pressure_path = g_strdup(PSI_MEMORY_PATH);
+    }
+
+    g_free(dir);
+}
+
+/** Parse and validate trigger configuration
+ *
+ * @param self  trigger object
+ *
+ * @return true if trigger is enabled, false otherwise
+ */
+static bool
+mempressure_psi_trigger_config(mempressure_psi_trigger_t *self)
+{
+    bool      res    = false;
+    gchar    *spec   = mce_conf_get_string(MCE_CONF_MEMPRESSURE_GROUP,
+                                           self->mpt_key, self->mpt_def);
+    char      kind[8] = "";
+    unsigned  stall  = 0;
+    unsigned  window = 0;
+
+    *self->mpt_spec = 0;
+    self->mpt_window_ms = 0;
+
+    if( !spec || !*spec )
+        goto EXIT;
+
+    if( sscanf(spec, "%7s %u %u", kind, &stall, &window) != 3 ||
+        (strcmp(kind, "some") && strcmp(kind, "full")) ||
+        window < PSI_WINDOW_MIN_US || window > PSI_WINDOW_MAX_US ||
+        stall == 0 || stall > window ) {
+        mce_log(LL_ERR, "%s: invalid trigger '%s'", self->mpt_key, spec);
+        goto EXIT;
+    }
+
+    snprintf(self->mpt_spec, sizeof self->mpt_spec, "%s %u %u",
+             kind, stall, window);
+    self->mpt_window_ms = (int)(window / 1000);
+
+    /* Kernel signals at most once per window while stalls go on,
+     * so levels must be held over at least two windows */
+    if( mempressure_psi_hold_ms < 2 * self->mpt_window_ms )
+        mempressure_psi_hold_ms = 2 * self->mpt_window_ms;
+
+    res = true;
+
+EXIT:
+    g_free(spec);
+
+    return res;
+}
+
+/** Evaluate memory level from active triggers and events
+ */
+static memnotify_level_t
+mempressure_psi_evaluate_level(void)
+{
+    memnotify_level_t res = mempressure_psi_events_level;
+
+    for( size_t i = 0; i < G_N_ELEMENTS(mempressure_psi_trigger); ++i ) {
+        mempressure_psi_trigger_t *trg = mempressure_psi_trigger + i;
+        if( trg->mpt_hold_id && res < trg->mpt_level )
+            res = trg->mpt_level;
+    }
+
+    return res;
+}
+
+/** Timeout callback for dropping trigger level
+ */
+static gboolean
+mempressure_psi_trigger_hold_cb(gpointer aptr)
+{
+    mempressure_psi_trigger_t *self = aptr;
+
+    if( !self->mpt_hold_id )
+        goto EXIT;
+
+    self->mpt_hold_id = 0;
+
+    mce_log(LL_DEBUG, "%s pressure subsided",
+            memnotify_level_repr(self->mpt_level));
+
+    mempressure_status_set_level(mempressure_psi_evaluate_level());
+
+EXIT:
+    return G_SOURCE_REMOVE;
+}
+
+/** Input watch callback for PSI trigger events
+ */
+static gboolean
+mempressure_psi_trigger_event_cb(GIOChannel *chn, GIOCondition cnd,
+                                 gpointer aptr)
+{
+    (void)chn;
+
+    mempressure_psi_trigger_t *self = aptr;
+    gboolean                   ret  = G_SOURCE_REMOVE;
+
+    if( !self->mpt_watch_id )
+        goto EXIT;
+
+    if( cnd & ~G_IO_PRI ) {
+        mce_log(LL_ERR, "%s: unexpected trigger watch condition",
+                memnotify_level_repr(self->mpt_level));
+        goto EXIT;
+    }
+
+    mce_log(LL_DEBUG, "%s pressure event",
+            memnotify_level_repr(self->mpt_level));
+
+    if( self->mpt_hold_id )
+        g_source_remove(self->mpt_hold_id);
+    self->mpt_hold_id = g_timeout_add(mempressure_psi_hold_ms,
+                                      mempressure_psi_trigger_hold_cb, self);
+
+    mempressure_status_set_level(mempressure_psi_evaluate_level());
+
+    ret = G_SOURCE_CONTINUE;
+
+EXIT:
+    if( ret == G_SOURCE_REMOVE && self->mpt_watch_id ) {
+        self->mpt_watch_id = 0;
+        mce_log(LL_CRIT, "disabling %s trigger iowatch",
+                memnotify_level_repr(self->mpt_level));
+    }
+
+    return ret;
+}
+
+/** Remove PSI trigger
+ */
+static void
+mempressure_psi_trigger_quit(mempressure_psi_trigger_t *self)
+{
+    if( self->mpt_hold_id ) {
+        g_source_remove(self->mpt_hold_id),
+            self->mpt_hold_id = 0;
+    }
+
+    if( self->mpt_watch_id ) {
+        g_source_remove(self->mpt_watch_id),
+            self->mpt_watch_id = 0;
+    }
+
+    if( self->mpt_fd != -1 ) {
+        mce_log(LL_DEBUG, "close %s trigger",
+                memnotify_level_repr(self->mpt_level));
+        close(self->mpt_fd),
+            self->mpt_fd = -1;
+    }
+}
+
+/** Install PSI trigger
+ *
+ * Kernel allows only one trigger per open file, so each
+ * level uses a file descriptor of its own.
+ */
+static bool
+mempressure_psi_trigger_init(mempressure_psi_trigger_t *self)
+{
+    bool res = false;
+
+    mce_log(LL_DEBUG, "%s trigger: %s @ %s",
+            memnotify_level_repr(self->mpt_level),
+            self->mpt_spec, mempressure_psi_pressure_path);
+
+    self->mpt_fd = open(mempressure_psi_pressure_path,
+                        O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if( self->mpt_fd == -1 ) {
+        mce_log(LL_ERR, "%s: open: %m", mempressure_psi_pressure_path);
+        goto EXIT;
+    }
+
+    /* Trigger string must be written including the terminator */
+    if( write(self->mpt_fd, self->mpt_spec, strlen(self->mpt_spec) + 1) == -1 ) {
+        mce_log(LL_ERR, "%s: write: %m", mempressure_psi_pressure_path);
+        goto EXIT;
+    }
+
+    self->mpt_watch_id =
+        mempressure_iowatch_add(self->mpt_fd, false, G_IO_PRI,
+                                mempressure_psi_trigger_event_cb, self);
+    if( !self->mpt_watch_id ) {
+        mce_log(LL_ERR, "failed to add trigger iowatch");
+        goto EXIT;
+    }
+
+    res = true;
+
+EXIT:
+    if( !res )
+        mempressure_psi_trigger_quit(self);
+
+    return res;
+}
+
+/** Read and parse cgroup v2 memory.events counters
+ */
+static bool
+mempressure_psi_events_read(mempressure_psi_events_t *events)
+{
+    bool res = false;
+    char tmp[512];
+
+    memset(events, 0, sizeof *events);
+
+    if( lseek(mempressure_psi_events_fd, 0, SEEK_SET) == -1 ) {
+        mce_log(LL_ERR, "failed to rewind events file: %m");
+        goto EXIT;
+    }
+
+    int done = read(mempressure_psi_events_fd, tmp, sizeof tmp - 1);
+    if( done <= 0 ) {
+        mce_log(LL_ERR, "failed to read events file: %m");
+        goto EXIT;
+    }
+    tmp[done] = 0;
+
+    for( char *pos = tmp, *end; *pos; pos = end ) {
+        end = pos + strcspn(pos, "\n");
+        if( *end )
+            *end++ = 0;
+
+        char     key[32];
+        uint64_t val = 0;
+        if( sscanf(pos, "%31s %" SCNu64, key, &val) != 2 )
+            continue;
+
+        if( !strcmp(key, "high") )
+            events->mpe_high = val;
+        else if( !strcmp(key, "max") )
+            events->mpe_max = val;
+        else if( !strcmp(key, "oom") )
+            events->mpe_oom = val;
+        else if( !strcmp(key, "oom_kill") )
+            events->mpe_oom_kill = val;
+    }
+
+    res = true;
+
+EXIT:
+    return res;
+}
+
+/** Timeout callback for dropping level raised by memory.events
+ */
+static gboolean
+mempressure_psi_events_hold_cb(gpointer aptr)
+{
+    (void)aptr;
+
+    if( !mempressure_psi_events_hold_id )
+        goto EXIT;
+
+    mempressure_psi_events_hold_id = 0;
+    mempressure_psi_events_level = MEMNOTIFY_LEVEL_NORMAL;
+
+    mempressure_status_set_level(mempressure_psi_evaluate_level());
+
+EXIT:
+    return G_SOURCE_REMOVE;
+}
+
+/** Input watch callback for cgroup v2 memory.events changes
+ */
+static gboolean
+mempressure_psi_events_cb(GIOChannel *chn, GIOCondition cnd, gpointer aptr)
+{
+    (void)chn;
+    (void)aptr;
+
+    gboolean                 ret = G_SOURCE_REMOVE;
+    mempressure_psi_events_t now;
+
+    if( !mempressure_psi_events_id )
+        goto EXIT;
+
+    /* Kernfs signals file modification with POLLPRI | POLLERR */
+    if( cnd & (G_IO_HUP | G_IO_NVAL) ) {
+        mce_log(LL_ERR, "unexpected events watch condition");
+        goto EXIT;
+    }
+
+    if( !mempressure_psi_events_read(&now) )
+        goto EXIT;
+
+    memnotify_level_t level = MEMNOTIFY_LEVEL_NORMAL;
+
+    if( now.mpe_max      > mempressure_psi_events_prev.mpe_max ||
+        now.mpe_oom      > mempressure_psi_events_prev.mpe_oom ||
+        now.mpe_oom_kill > mempressure_psi_events_prev.mpe_oom_kill )
+        level = MEMNOTIFY_LEVEL_CRITICAL;
+    else if( now.mpe_high > mempressure_psi_events_prev.mpe_high )
+        level = MEMNOTIFY_LEVEL_WARNING;
+
+    mempressure_psi_events_prev = now;
+
+    if( level != MEMNOTIFY_LEVEL_NORMAL ) {
+        mce_log(LL_DEBUG, "memory.events: %s",
+                memnotify_level_repr(level));
+
+        if( mempressure_psi_events_level < level ||
+            !mempressure_psi_events_hold_id )
+            mempressure_psi_events_level = level;
+
+        if( mempressure_psi_events_hold_id )
+            g_source_remove(mempressure_psi_events_hold_id);
+        mempressure_psi_events_hold_id =
+            g_timeout_add(mempressure_psi_hold_ms,
+                          mempressure_psi_events_hold_cb, 0);
+
+        mempressure_status_set_level(mempressure_psi_evaluate_level());
+    }
+
+    ret = G_SOURCE_CONTINUE;
+
+EXIT:
+    if( ret == G_SOURCE_REMOVE && mempressure_psi_events_id ) {
+        mempressure_psi_events_id = 0;
+        mce_log(LL_CRIT, "disabling events iowatch");
+    }
+
+    return ret;
+}
+
+/** Stop tracking cgroup v2 memory.events
+ */
+static void
+mempressure_psi_events_quit(void)
+{
+    if( mempressure_psi_events_hold_id ) {
+        g_source_remove(mempressure_psi_events_hold_id),
+            mempressure_psi_events_hold_id = 0;
+    }
+
+    if( mempressure_psi_events_id ) {
+        g_source_remove(mempressure_psi_events_id),
+            mempressure_psi_events_id = 0;
+    }
+
+    if( mempressure_psi_events_fd != -1 ) {
+        mce_log(LL_DEBUG, "close %s", mempressure_psi_events_path);
+        close(mempressure_psi_events_fd),
+            mempressure_psi_events_fd = -1;
+    }
+
+    mempressure_psi_events_level = MEMNOTIFY_LEVEL_NORMAL;
+}
+
+/** Start tracking cgroup v2 memory.events
+ *
+ * This is supplementary to PSI triggers, failures are not fatal.
+ */
+static void
+mempressure_psi_events_init(void)
+{
+    if( !mempressure_psi_events_path )
+        goto EXIT;
+
+    mce_log(LL_DEBUG, "open %s", mempressure_psi_events_path);
+    mempressure_psi_events_fd = open(mempressure_psi_events_path,
+                                     O_RDONLY | O_CLOEXEC);
+    if( mempressure_psi_events_fd == -1 ) {
+        mce_log(LL_WARN, "%s: open: %m", mempressure_psi_events_path);
+        goto EXIT;
+    }
+
+    /* Initial read sets the baseline and arms change notification */
+    if( !mempressure_psi_events_read(&mempressure_psi_events_prev) )
+        goto EXIT;
+
+    mempressure_psi_events_id =
+        mempressure_iowatch_add(mempressure_psi_events_fd, false, G_IO_PRI,
+                                mempressure_psi_events_cb, 0);
+
+EXIT:
+    if( !mempressure_psi_events_id )
+        mempressure_psi_events_quit();
+
+    return;
+}
+
+/** Probe if pressure stall triggers can be used
+ */
+static bool
+mempressure_psi_is_available(void)
+{
+    mempressure_psi_config_paths();
+
+    return access(mempressure_psi_pressure_path, R_OK | W_OK) == 0;
+}
+
+/** Stop pressure stall tracking
+ */
+static void
+mempressure_psi_quit(void)
+{
+    for( size_t i = 0; i < G_N_ELEMENTS(mempressure_psi_trigger); ++i )
+        mempressure_psi_trigger_quit(mempressure_psi_trigger + i);
+
+    mempressure_psi_events_quit();
+
+    g_free(mempressure_psi_pressure_path),
+        mempressure_psi_pressure_path = 0;
+    g_free(mempressure_psi_events_path),
+        mempressure_psi_events_path = 0;
+
+    mempressure_psi_active = false;
+}
+
+/** Start pressure stall tracking
+ */
+static bool
+mempressure_psi_init(void)
+{
+    bool res     = false;
+    int  enabled = 0;
+
+    if( !mempressure_psi_pressure_path )
+        mempressure_psi_config_paths();
+
+    mempressure_psi_hold_ms =
+        mce_conf_get_int(MCE_CONF_MEMPRESSURE_GROUP,
+                         MCE_CONF_MEMPRESSURE_HOLD_TIME,
+                         MCE_DEFAULT_MEMPRESSURE_HOLD_TIME);
+
+    for( size_t i = 0; i < G_N_ELEMENTS(mempressure_psi_trigger); ++i ) {
+        mempressure_psi_trigger_t *trg = mempressure_psi_trigger + i;
+
+        if( !mempressure_psi_trigger_config(trg) )
+            continue;
+
+        if( !mempressure_psi_trigger_init(trg) )
+            goto EXIT;
+
+        ++enabled;
+    }
+
+    if( !enabled ) {
+        mce_log(LL_WARN, "no pressure stall triggers configured");
+        goto EXIT;
+    }
+
+    mempressure_psi_events_init();
+
+    mempressure_psi_active = true;
+
+    /* Triggers report only stalls -> start from normal level */
+    mempressure_status_set_level(mempressure_psi_evaluate_level());
+
+    res = true;
+
+EXIT:
+    // all or nothing
+    if( !res )
+        mempressure_psi_quit();
+
+    return res;
+}
+
 /* ========================================================================= *
  * MEMPRESSURE_CGROUP
  * ========================================================================= */
@@ -523,6 +1139,10 @@ EXIT:
 static void
 mempressure_cgroup_update_thresholds(void)
 {
+    /* Used-pages thresholds do not apply to pressure stall tracking */
+    if( mempressure_psi_active )
+        return;
+
     /* TODO: Is there some way to remove trigger thresholds?
      *
      * Meanwhile do a full reinitialization to get rid of old thresholds.
@@ -674,6 +1294,7 @@ static void mempressure_setting_quit(void)
 static void
 mempressure_plugin_quit(void)
 {
+    mempressure_psi_quit();
     mempressure_cgroup_quit();
     mempressure_setting_quit();
 }
@@ -685,7 +1306,10 @@ mempressure_plugin_init(void)
 
     mempressure_setting_init();
 
-    if( !mempressure_cgroup_init() )
+    /* Prefer pressure stall triggers, fall back to cgroup v1 */
+    if( mempressure_psi_is_available() && mempressure_psi_init() )
+        mce_log(LL_DEBUG, "using pressure stall triggers");
+    else if( !mempressure_cgroup_init() )
         goto EXIT;
 
     success = true;
@@ -720,9 +1344,10 @@ G_MODULE_EXPORT const gchar *g_module_check_init(GModule *module)
         goto EXIT;
     }
 
-    /* Check if required sysfs files are present */
-    if( !mempressure_cgroup_is_available() ) {
-        mce_log(LL_WARN, "mempressure cgroup interface not available");
+    /* Check if required procfs / sysfs files are present */
+    if( !mempressure_psi_is_available() &&
+        !mempressure_cgroup_is_available() ) {
+        mce_log(LL_WARN, "mempressure psi / cgroup interface not available");
         goto EXIT;
     }
 
@@ -25,8 +25,10 @@
  */
 
 #include "multitouch.h"
+#include "evdev.h"
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 
 /* ========================================================================= *
@@ -87,6 +89,9 @@ struct mt_touch_t
 
     /* Maximum number of fingers seen during the touch */
     size_t     mtt_max_fingers;
+
+    /* Maximum distance any finger moved from initial contact, squared */
+    int        mtt_max_travel2;
 };
 
 /** Maximum jitter allowed in double tap (pixel) coordinates */
@@ -98,8 +103,50 @@ struct mt_touch_t
 /** Minimum delay between double tap presses and releases [ms] */
 #define MT_TOUCH_DBLTAP_DELAY_MIN    1
 
-static bool        mt_touch_is_single_tap(const mt_touch_t *self);
-static bool        mt_touch_is_double_tap(const mt_touch_t *self, const mt_touch_t *prev);
+/** Default minimum duration of a long press [ms] */
+#define MT_TOUCH_LONGPRESS_DELAY_MIN 800
+
+/** Default width of screen edge area for swipes */
+#define MT_TOUCH_EDGE_SIZE           50
+
+/** Default minimum distance travelled by edge swipes */
+#define MT_TOUCH_SWIPE_DIST_MIN     200
+
+/** Default maximum duration of edge swipes [ms] */
+#define MT_TOUCH_SWIPE_DELAY_MAX    500
+
+static int64_t     mt_touch_duration     (const mt_touch_t *self);
+static bool        mt_touch_is_stationary(const mt_touch_t *self, const mt_config_t *config);
+static bool        mt_touch_is_single_tap(const mt_touch_t *self, const mt_config_t *config);
+static bool        mt_touch_is_double_tap(const mt_touch_t *self, const mt_touch_t *prev, const mt_config_t *config);
+
+/* ------------------------------------------------------------------------- *
+ * GESTURE_RECOGNIZER
+ * ------------------------------------------------------------------------- */
+
+/** Software gesture recognizer table entry
+ *
+ * All recognizers are evaluated in one pass when the last finger
+ * is lifted from screen, using only the state accumulated from
+ * SYN_REPORT frames during the touch.
+ */
+typedef struct
+{
+    /** Name of the gesture, for debugging purposes */
+    const char *mtr_name;
+
+    /** Offset of the enabling flag within mt_config_t */
+    size_t      mtr_enabled;
+
+    /** Detection function: returns gesture_t value or MT_GESTURE_NONE */
+    int       (*mtr_detect_cb)(const mt_state_t *self);
+} mt_recognizer_t;
+
+static int         mt_recognizer_doubletap    (const mt_state_t *self);
+static int         mt_recognizer_twofinger_tap(const mt_state_t *self);
+static int         mt_recognizer_longpress    (const mt_state_t *self);
+static int         mt_recognizer_edge_swipe   (const mt_state_t *self);
+static int         mt_recognizer_evaluate     (const mt_state_t *self);
 
 /* ------------------------------------------------------------------------- *
  * TOUCH_STATE
@@ -135,9 +182,21 @@ struct mt_state_t
     /** Currently tracked primary touch point */
     mt_point_t mts_point_tracked;
 
+    /** Touch point positions at initial contact, indexed by slot */
+    mt_point_t mts_point_beg_array[MT_STATE_POINTS_MAX];
+
     /** Stats for the last 3 taps, used for double tap detection */
     mt_touch_t mts_tap_arr[3];
 
+    /** Gesture recognition tuning */
+    const mt_config_t *mts_config;
+
+    /** Maximum x-coordinate value, or zero if not known */
+    int        mts_x_max;
+
+    /** Maximum y-coordinate value, or zero if not known */
+    int        mts_y_max;
+
     /** Device type / protocol specific input event handler function */
     void     (*mts_event_handler_cb)(mt_state_t *, const struct input_event *);
 
@@ -146,18 +205,67 @@ struct mt_state_t
 };
 
 static void        mt_state_reset          (mt_state_t *self);
-static bool        mt_state_update         (mt_state_t *self);
+static void        mt_state_update_travel  (mt_state_t *self);
+static int         mt_state_update         (mt_state_t *self);
 
 static void        mt_state_handle_event_a (mt_state_t *self, const struct input_event *ev);
 static void        mt_state_handle_event_b (mt_state_t *self, const struct input_event *ev);
 
 mt_state_t        *mt_state_create         (bool protocol_b);
 void               mt_state_delete         (mt_state_t *self);
+void               mt_state_set_config     (mt_state_t *self, const mt_config_t *config);
+void               mt_state_set_range      (mt_state_t *self, int x_max, int y_max);
 
-bool               mt_state_handle_event   (mt_state_t *self, const struct input_event *ev);
+int                mt_state_handle_event   (mt_state_t *self, const struct input_event *ev);
 
 bool               mt_state_touching       (const mt_state_t *self);
 
+/* ------------------------------------------------------------------------- *
+ * CONFIG
+ * ------------------------------------------------------------------------- */
+
+void               mt_config_set_defaults  (mt_config_t *config);
+
+/** Configuration used when nothing else has been set */
+static mt_config_t mt_config_builtin =
+{
+    .mtc_doubletap_enabled     = true,
+    .mtc_twofinger_tap_enabled = false,
+    .mtc_longpress_enabled     = false,
+    .mtc_edge_swipe_enabled    = false,
+    .mtc_tap_dist_max          = MT_TOUCH_DBLTAP_DIST_MAX,
+    .mtc_tap_delay_max         = MT_TOUCH_DBLTAP_DELAY_MAX,
+    .mtc_longpress_delay_min   = MT_TOUCH_LONGPRESS_DELAY_MIN,
+    .mtc_edge_size             = MT_TOUCH_EDGE_SIZE,
+    .mtc_swipe_dist_min        = MT_TOUCH_SWIPE_DIST_MIN,
+    .mtc_swipe_delay_max       = MT_TOUCH_SWIPE_DELAY_MAX,
+};
+
+/** Gesture recognizers, in order of precedence */
+static const mt_recognizer_t mt_recognizer_lut[] =
+{
+    {
+        .mtr_name      = "doubletap",
+        .mtr_enabled   = offsetof(mt_config_t, mtc_doubletap_enabled),
+        .mtr_detect_cb = mt_recognizer_doubletap,
+    },
+    {
+        .mtr_name      = "twofinger_tap",
+        .mtr_enabled   = offsetof(mt_config_t, mtc_twofinger_tap_enabled),
+        .mtr_detect_cb = mt_recognizer_twofinger_tap,
+    },
+    {
+        .mtr_name      = "longpress",
+        .mtr_enabled   = offsetof(mt_config_t, mtc_longpress_enabled),
+        .mtr_detect_cb = mt_recognizer_longpress,
+    },
+    {
+        .mtr_name      = "edge_swipe",
+        .mtr_enabled   = offsetof(mt_config_t, mtc_edge_swipe_enabled),
+        .mtr_detect_cb = mt_recognizer_edge_swipe,
+    },
+};
+
 /* ========================================================================= *
  * TOUCH_POINT
  * ========================================================================= */
@@ -192,13 +300,40 @@ static int mt_point_distance2(const mt_point_t *a, const mt_point_t *b)
  * TOUCH_VECTOR
  * ========================================================================= */
 
-/** Predicate for: Touch vector represents a single tap
+/** Get touch duration
  *
  * @param self Touch vector object
  *
+ * @return Time between first finger down and last finger up [ms]
+ */
+static int64_t mt_touch_duration(const mt_touch_t *self)
+{
+    return self->mtt_end_tick - self->mtt_beg_tick;
+}
+
+/** Predicate for: None of the fingers moved too much during touch
+ *
+ * @param self   Touch vector object
+ * @param config Gesture recognition tuning
+ *
+ * @return true if all fingers stayed close to initial contact points
+ */
+static bool mt_touch_is_stationary(const mt_touch_t *self, const mt_config_t *config)
+{
+    int d2 = mt_point_distance2(&self->mtt_beg_point, &self->mtt_end_point);
+    int m2 = config->mtc_tap_dist_max * config->mtc_tap_dist_max;
+
+    return d2 <= m2 && self->mtt_max_travel2 <= m2;
+}
+
+/** Predicate for: Touch vector represents a single tap
+ *
+ * @param self   Touch vector object
+ * @param config Gesture recognition tuning
+ *
  * @return true if touch vector is tap, false otherwise
  */
-static bool mt_touch_is_single_tap(const mt_touch_t *self)
+static bool mt_touch_is_single_tap(const mt_touch_t *self, const mt_config_t *config)
 {
     bool is_single_tap = false;
 
@@ -211,12 +346,12 @@ static bool mt_touch_is_single_tap(const mt_touch_t *self)
 
     /* Touch release must happen close to the point of initial contact */
     int d2 = mt_point_distance2(&self->mtt_beg_point, &self->mtt_end_point);
-    if( d2 > MT_TOUCH_DBLTAP_DIST_MAX * MT_TOUCH_DBLTAP_DIST_MAX )
+    if( d2 > config->mtc_tap_dist_max * config->mtc_tap_dist_max )
         goto EXIT;
 
     /* The touch duration must not be too short or too long */
-    int64_t t = self->mtt_end_tick - self->mtt_beg_tick;
-    if( t < MT_TOUCH_DBLTAP_DELAY_MIN || t > MT_TOUCH_DBLTAP_DELAY_MAX )
+    int64_t t = mt_touch_duration(self);
+    if( t < MT_TOUCH_DBLTAP_DELAY_MIN || t > config->mtc_tap_delay_max )
         goto EXIT;
 
     is_single_tap = true;
@@ -227,27 +362,30 @@ EXIT:
 
 /** Predicate for: Two touch vectors represent a double tap
  *
- * @param self Current touch vector object
- * @param prev Previous touch vector object
+ * @param self   Current touch vector object
+ * @param prev   Previous touch vector object
+ * @param config Gesture recognition tuning
  *
  * @return true if touch vector is double tap, false otherwise
  */
-static bool mt_touch_is_double_tap(const mt_touch_t *self, const mt_touch_t *prev)
+static bool mt_touch_is_double_tap(const mt_touch_t *self, const mt_touch_t *prev,
+                                   const mt_config_t *config)
 {
     bool is_double_tap = false;
 
     /* Both touch vectors must classify as single taps */
-    if( !mt_touch_is_single_tap(self) || !mt_touch_is_single_tap(prev) )
+    if( !mt_touch_is_single_tap(self, config) ||
+        !mt_touch_is_single_tap(prev, config) )
         goto EXIT;
 
     /* The second tap must start near to the end point of the 1st one */
     int d2 = mt_point_distance2(&self->mtt_beg_point, &prev->mtt_end_point);
-    if( d2 > MT_TOUCH_DBLTAP_DIST_MAX * MT_TOUCH_DBLTAP_DIST_MAX )
+    if( d2 > config->mtc_tap_dist_max * config->mtc_tap_dist_max )
         goto EXIT;
 
     /* The delay between the taps must be sufficiently small too */
     int64_t t = self->mtt_beg_tick - prev->mtt_end_tick;
-    if( t < MT_TOUCH_DBLTAP_DELAY_MIN || t > MT_TOUCH_DBLTAP_DELAY_MAX )
+    if( t < MT_TOUCH_DBLTAP_DELAY_MIN || t > config->mtc_tap_delay_max )
         goto EXIT;
 
     is_double_tap = true;
@@ -256,6 +394,155 @@ EXIT:
     return is_double_tap;
 }
 
+/* ========================================================================= *
+ * GESTURE_RECOGNIZER
+ * ========================================================================= */
+
+/** Detect double tap
+ *
+ * @param self  Multitouch state object
+ *
+ * @return GESTURE_DOUBLETAP, or MT_GESTURE_NONE
+ */
+static int mt_recognizer_doubletap(const mt_state_t *self)
+{
+    const mt_config_t *config  = self->mts_config;
+    int                gesture = MT_GESTURE_NONE;
+
+    /* Ignore the 2nd & 3rd taps of a triple tap */
+    if( mt_touch_is_double_tap(self->mts_tap_arr+0, self->mts_tap_arr+1, config) &&
+        !mt_touch_is_double_tap(self->mts_tap_arr+1, self->mts_tap_arr+2, config) )
+        gesture = GESTURE_DOUBLETAP;
+
+    return gesture;
+}
+
+/** Detect two finger tap
+ *
+ * @param self  Multitouch state object
+ *
+ * @return GESTURE_TWOFINGER_TAP, or MT_GESTURE_NONE
+ */
+static int mt_recognizer_twofinger_tap(const mt_state_t *self)
+{
+    const mt_config_t *config  = self->mts_config;
+    const mt_touch_t  *touch   = self->mts_tap_arr + 0;
+    int                gesture = MT_GESTURE_NONE;
+
+    if( touch->mtt_max_fingers != 2 )
+        goto EXIT;
+
+    if( !mt_touch_is_stationary(touch, config) )
+        goto EXIT;
+
+    int64_t t = mt_touch_duration(touch);
+    if( t < MT_TOUCH_DBLTAP_DELAY_MIN || t > config->mtc_tap_delay_max )
+        goto EXIT;
+
+    gesture = GESTURE_TWOFINGER_TAP;
+
+EXIT:
+    return gesture;
+}
+
+/** Detect long press
+ *
+ * @param self  Multitouch state object
+ *
+ * @return GESTURE_LONGPRESS, or MT_GESTURE_NONE
+ */
+static int mt_recognizer_longpress(const mt_state_t *self)
+{
+    const mt_config_t *config  = self->mts_config;
+    const mt_touch_t  *touch   = self->mts_tap_arr + 0;
+    int                gesture = MT_GESTURE_NONE;
+
+    if( touch->mtt_max_fingers != 1 )
+        goto EXIT;
+
+    if( !mt_touch_is_stationary(touch, config) )
+        goto EXIT;
+
+    if( mt_touch_duration(touch) < config->mtc_longpress_delay_min )
+        goto EXIT;
+
+    gesture = GESTURE_LONGPRESS;
+
+EXIT:
+    return gesture;
+}
+
+/** Detect swipe from screen edge
+ *
+ * @param self  Multitouch state object
+ *
+ * @return GESTURE_SWIPE_FROM_XXX, or MT_GESTURE_NONE
+ */
+static int mt_recognizer_edge_swipe(const mt_state_t *self)
+{
+    const mt_config_t *config  = self->mts_config;
+    const mt_touch_t  *touch   = self->mts_tap_arr + 0;
+    int                gesture = MT_GESTURE_NONE;
+
+    /* Edges can't be determined without knowing the panel size */
+    if( self->mts_x_max <= 0 || self->mts_y_max <= 0 )
+        goto EXIT;
+
+    if( touch->mtt_max_fingers != 1 )
+        goto EXIT;
+
+    if( mt_touch_duration(touch) > config->mtc_swipe_delay_max )
+        goto EXIT;
+
+    const mt_point_t *beg  = &touch->mtt_beg_point;
+    const mt_point_t *end  = &touch->mtt_end_point;
+    int               dx   = end->mtp_x - beg->mtp_x;
+    int               dy   = end->mtp_y - beg->mtp_y;
+    int               edge = config->mtc_edge_size;
+    int               dist = config->mtc_swipe_dist_min;
+
+    /* Movement must be mainly along one axis, away from the edge */
+    if( abs(dx) > abs(dy) ) {
+        if( beg->mtp_x <= edge && dx >= dist )
+            gesture = GESTURE_SWIPE_FROM_LEFT;
+        else if( beg->mtp_x >= self->mts_x_max - edge && -dx >= dist )
+            gesture = GESTURE_SWIPE_FROM_RIGHT;
+    }
+    else {
+        if( beg->mtp_y <= edge && dy >= dist )
+            gesture = GESTURE_SWIPE_FROM_TOP;
+        else if( beg->mtp_y >= self->mts_y_max - edge && -dy >= dist )
+            gesture = GESTURE_SWIPE_FROM_BOTTOM;
+    }
+
+EXIT:
+    return gesture;
+}
+
+/** Evaluate all enabled gesture recognizers
+ *
+ * @param self  Multitouch state object
+ *
+ * @return gesture_t value, or MT_GESTURE_NONE
+ */
+static int mt_recognizer_evaluate(const mt_state_t *self)
+{
+    const char *config  = (const char *)self->mts_config;
+    int         gesture = MT_GESTURE_NONE;
+
+    for( size_t i = 0; i < sizeof mt_recognizer_lut / sizeof *mt_recognizer_lut; ++i ) {
+        const mt_recognizer_t *recognizer = mt_recognizer_lut + i;
+
+        if( !*(const bool *)(config + recognizer->mtr_enabled) )
+            continue;
+
+        if( (gesture = recognizer->mtr_detect_cb(self)) != MT_GESTURE_NONE )
+            break;
+    }
+
+    return gesture;
+}
+
 /* ========================================================================= *
  * TOUCH_STATE
  * ========================================================================= */
@@ -275,16 +562,47 @@ mt_state_reset(mt_state_t *self)
     self->mts_point_slot = 0;
 }
 
+/** Update maximum distance travelled by fingers during touch
+ *
+ * @param self  Multitouch state object
+ */
+static void
+mt_state_update_travel(mt_state_t *self)
+{
+    mt_touch_t *touch = self->mts_tap_arr + 0;
+
+    for( size_t i = 0; i < MT_STATE_POINTS_MAX; ++i ) {
+        const mt_point_t *curr = self->mts_point_array + i;
+        mt_point_t       *beg  = self->mts_point_beg_array + i;
+
+        if( curr->mtp_id == MT_POINT_ID_INVAL ) {
+            mt_point_invalidate(beg);
+            continue;
+        }
+
+        /* Start tracking new contact point */
+        if( beg->mtp_id != curr->mtp_id ) {
+            *beg = *curr;
+            continue;
+        }
+
+        int d2 = mt_point_distance2(beg, curr);
+        if( touch->mtt_max_travel2 < d2 )
+            touch->mtt_max_travel2 = d2;
+    }
+}
+
 /** Update touch position tracking state
  *
  * @param self  Multitouch state object
  *
- * @return true if a double tap was just detected, false otherwise
+ * @return gesture_t value if a gesture was just detected,
+ *         or MT_GESTURE_NONE
  */
-static bool
+static int
 mt_state_update(mt_state_t *self)
 {
-    bool   dbltap_seen  = false;
+    int    gesture      = MT_GESTURE_NONE;
     size_t finger_count = 0;
 
     /* Count fingers on screen and update position of one finger touch */
@@ -302,6 +620,10 @@ mt_state_update(mt_state_t *self)
             self->mts_point_tracked = self->mts_mouse;
     }
 
+    /* Track finger movement during touch */
+    if( self->mts_point_count > 0 )
+        mt_state_update_travel(self);
+
     /* Skip the rest if the number of fingers on screen does not change */
     if( self->mts_point_count == finger_count )
         goto EXIT;
@@ -316,8 +638,11 @@ mt_state_update(mt_state_t *self)
                 sizeof self->mts_tap_arr - sizeof *self->mts_tap_arr);
 
         self->mts_tap_arr[0].mtt_max_fingers = finger_count;
+        self->mts_tap_arr[0].mtt_max_travel2 = 0;
         self->mts_tap_arr[0].mtt_beg_point = self->mts_point_tracked;
         self->mts_tap_arr[0].mtt_beg_tick  = tick;
+
+        mt_state_update_travel(self);
     }
 
     /* Maintain maximum number of fingers seen on screen */
@@ -329,18 +654,14 @@ mt_state_update(mt_state_t *self)
     self->mts_tap_arr[0].mtt_end_tick  = tick;
 
     /* When final finger is lifted, check if the history buffer content
-     * looks like a double tap */
-    if( finger_count == 0 ) {
-        if( mt_touch_is_double_tap(self->mts_tap_arr+0, self->mts_tap_arr+1) ) {
-            if( ! mt_touch_is_double_tap(self->mts_tap_arr+1, self->mts_tap_arr+2) )
-                dbltap_seen = true;
-        }
-    }
+     * looks like some gesture */
+    if( finger_count == 0 )
+        gesture = mt_recognizer_evaluate(self);
 
     self->mts_point_count = finger_count;
 
 EXIT:
-    return dbltap_seen;
+    return gesture;
 }
 
 /** Handle multitouch protocol A event stream
@@ -478,20 +799,23 @@ mt_state_handle_event_b(mt_state_t *self, const struct input_event *ev)
  *
  * @param self  Multitouch state object
  * @param ev    Input event
+ *
+ * @return gesture_t value if a gesture was just detected,
+ *         or MT_GESTURE_NONE
  */
-bool
+int
 mt_state_handle_event(mt_state_t *self, const struct input_event *ev)
 {
-    bool   dbltap = false;
+    int gesture = MT_GESTURE_NONE;
 
     self->mts_event_time = ev->time;
 
     self->mts_event_handler_cb(self, ev);
 
     if( ev->type == EV_SYN && ev->code == SYN_REPORT )
-        dbltap = mt_state_update(self);
+        gesture = mt_state_update(self);
 
-    return dbltap;
+    return gesture;
 }
 
 /** Check if there is at least one finger on screen at the momement
@@ -506,6 +830,36 @@ mt_state_touching (const mt_state_t *self)
     return self && self->mts_point_count > 0;
 }
 
+/** Set gesture recognition tuning
+ *
+ * The configuration object must remain valid until the
+ * multitouch state object is deleted or another configuration
+ * object is set.
+ *
+ * @param self    Multitouch state object
+ * @param config  Gesture recognition tuning, or NULL for defaults
+ */
+void
+mt_state_set_config(mt_state_t *self, const mt_config_t *config)
+{
+    self->mts_config = config ?: &mt_config_builtin;
+}
+
+/** Set touch panel coordinate range
+ *
+ * Needed for detecting swipes that start from screen edges.
+ *
+ * @param self   Multitouch state object
+ * @param x_max  Maximum x-coordinate value, or zero if not known
+ * @param y_max  Maximum y-coordinate value, or zero if not known
+ */
+void
+mt_state_set_range(mt_state_t *self, int x_max, int y_max)
+{
+    self->mts_x_max = x_max;
+    self->mts_y_max = y_max;
+}
+
 /** Release multitouch state object
  *
  * @param self  Multitouch state object, or NULL
@@ -544,6 +898,13 @@ mt_state_create(bool protocol_b)
 
     mt_point_invalidate(&self->mts_point_tracked);
 
+    for( size_t i = 0; i < MT_STATE_POINTS_MAX; ++i )
+        mt_point_invalidate(self->mts_point_beg_array + i);
+
+    self->mts_config = &mt_config_builtin;
+    self->mts_x_max  = 0;
+    self->mts_y_max  = 0;
+
     if( protocol_b )
         self->mts_event_handler_cb = mt_state_handle_event_b;
     else
@@ -552,3 +913,17 @@ mt_state_create(bool protocol_b)
 EXIT:
     return self;
 }
+
+/* ========================================================================= *
+ * CONFIG
+ * ========================================================================= */
+
+/** Initialize gesture recognition tuning to built-in defaults
+ *
+ * @param config  Gesture recognition tuning object
+ */
+void
+mt_config_set_defaults(mt_config_t *config)
+{
+    *config = mt_config_builtin;
+}
@@ -30,11 +30,56 @@
 # include <linux/input.h>
 # include <stdbool.h>
 
-typedef struct mt_state_t mt_state_t;
+typedef struct mt_state_t  mt_state_t;
+typedef struct mt_config_t mt_config_t;
+
+/** Value returned when no gesture was detected */
+# define MT_GESTURE_NONE -1
+
+/** Tuning for software gesture recognition
+ *
+ * Distances are in touch panel coordinate units, delays in ms.
+ */
+struct mt_config_t
+{
+    /** Whether double tap detection is enabled */
+    bool mtc_doubletap_enabled;
+
+    /** Whether two finger tap detection is enabled */
+    bool mtc_twofinger_tap_enabled;
+
+    /** Whether long press detection is enabled */
+    bool mtc_longpress_enabled;
+
+    /** Whether swipe from edge detection is enabled */
+    bool mtc_edge_swipe_enabled;
+
+    /** Maximum jitter allowed in tap coordinates */
+    int  mtc_tap_dist_max;
+
+    /** Maximum tap duration / delay between double tap taps */
+    int  mtc_tap_delay_max;
+
+    /** Minimum duration of a long press */
+    int  mtc_longpress_delay_min;
+
+    /** Width of screen edge area where swipes must start */
+    int  mtc_edge_size;
+
+    /** Minimum distance edge swipe must travel */
+    int  mtc_swipe_dist_min;
+
+    /** Maximum duration of an edge swipe */
+    int  mtc_swipe_delay_max;
+};
+
+void               mt_config_set_defaults(mt_config_t *config);
 
 mt_state_t        *mt_state_create       (bool protocol_b);
 void               mt_state_delete       (mt_state_t *self);
-bool               mt_state_handle_event (mt_state_t *self, const struct input_event *ev);
+void               mt_state_set_config   (mt_state_t *self, const mt_config_t *config);
+void               mt_state_set_range    (mt_state_t *self, int x_max, int y_max);
+int                mt_state_handle_event (mt_state_t *self, const struct input_event *ev);
 bool               mt_state_touching     (const mt_state_t *self);
 
 #endif /* MCE_MULTITOUCH_H_ */
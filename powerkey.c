@@ -3058,13 +3058,9 @@ pwrkey_datapipe_keypress_event_cb(gconstpointer const data)
     /* Time limit for accepting the next power key press */
     static int64_t press_limit = 0;
 
-    const struct input_event * const *evp;
     const struct input_event *ev;
 
-    if( !(evp = data) )
-        goto EXIT;
-
-    if( !(ev = *evp) )
+    if( !(ev = data) )
         goto EXIT;
 
     switch( ev->type ) {
@@ -0,0 +1,427 @@
+/* Datapipe micro benchmarks
+ *
+ * Measures datapipe_exec_full_real() throughput and latency with varying
+ * amounts of filters and triggers, cache modes, recursion detection and
+ * handler install / remove churn via mce_datapipe_init_bindings().
+ *
+ * Results are written as tab separated values - one header line and one
+ * line per measurement - so that runs made before and after changes to
+ * the datapipe core can be compared with standard text tools.
+ *
+ * Logging is stubbed out, i.e. the numbers reflect the cost of datapipe
+ * bookkeeping and callback dispatching only.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+/* Benchmarked module */
+#include "../../datapipe.c"
+
+/* ------------------------------------------------------------------------- *
+ * STUBS
+ * ------------------------------------------------------------------------- */
+
+int mce_log_p_(loglevel_t loglevel, const char *const file,
+	       const char *const function)
+{
+	(void)loglevel;
+	(void)file;
+	(void)function;
+
+	return false;
+}
+
+void mce_log_file(loglevel_t loglevel, const char *const file,
+		  const char *const function, const char *const fmt, ...)
+{
+	(void)loglevel;
+	(void)file;
+	(void)function;
+	(void)fmt;
+}
+
+void mce_log_unconditional(loglevel_t loglevel, const char *const file,
+			   const char *const function, const char *const fmt,
+			   ...)
+{
+	(void)loglevel;
+	(void)file;
+	(void)function;
+	(void)fmt;
+}
+
+int mce_lagmon_enter(const char *kind, const char *name)
+{
+	(void)kind;
+	(void)name;
+
+	return -1;
+}
+
+void mce_lagmon_leave(int scope)
+{
+	(void)scope;
+}
+
+gboolean mce_conf_get_bool(const gchar *group, const gchar *key,
+			   const gboolean defaultval)
+{
+	(void)group;
+	(void)key;
+
+	return defaultval;
+}
+
+/* ------------------------------------------------------------------------- *
+ * BENCHMARK DATAPIPES
+ * ------------------------------------------------------------------------- */
+
+static datapipe_t bench_nothing_pipe = DATAPIPE_INIT(bench_nothing, int, 0, 0,
+	DATAPIPE_FILTERING_ALLOWED, DATAPIPE_CACHE_NOTHING);
+static datapipe_t bench_indata_pipe = DATAPIPE_INIT(bench_indata, int, 0, 0,
+	DATAPIPE_FILTERING_ALLOWED, DATAPIPE_CACHE_INDATA);
+static datapipe_t bench_outdata_pipe = DATAPIPE_INIT(bench_outdata, int, 0, 0,
+	DATAPIPE_FILTERING_ALLOWED, DATAPIPE_CACHE_OUTDATA);
+static datapipe_t bench_default_pipe = DATAPIPE_INIT(bench_default, int, 0, 0,
+	DATAPIPE_FILTERING_ALLOWED, DATAPIPE_CACHE_DEFAULT);
+
+static datapipe_t *const bench_pipes[] = {
+	&bench_nothing_pipe,
+	&bench_indata_pipe,
+	&bench_outdata_pipe,
+	&bench_default_pipe,
+};
+
+/** Amounts of filters / triggers to benchmark with */
+static const int bench_counts[] = { 0, 1, 4, 16 };
+
+#define BENCH_NUMOF(arr) (sizeof (arr) / sizeof *(arr))
+
+/* ------------------------------------------------------------------------- *
+ * CALLBACKS
+ * ------------------------------------------------------------------------- */
+
+/** Sink for callback side effects, keeps compiler from eliding work */
+static volatile int bench_sink = 0;
+
+/** Datapipe being executed from bench_reenter_cb() */
+static datapipe_t *bench_reenter_pipe = 0;
+
+static gpointer bench_filter_cb(gpointer data)
+{
+	return GINT_TO_POINTER(GPOINTER_TO_INT(data) + 1);
+}
+
+static void bench_trigger_cb(gconstpointer data)
+{
+	bench_sink += GPOINTER_TO_INT(data);
+}
+
+static void bench_reenter_cb(gconstpointer data)
+{
+	static bool active = false;
+
+	if( active || !bench_reenter_pipe )
+		return;
+
+	/* Re-executing the pipe invalidates the token of the outer
+	 * execution -> it bails out at the next callback */
+	active = true;
+	datapipe_exec_full(bench_reenter_pipe, data);
+	active = false;
+}
+
+/* ------------------------------------------------------------------------- *
+ * UTILITIES
+ * ------------------------------------------------------------------------- */
+
+static int64_t bench_iterations = 1000000;
+static int     bench_samples	= 10000;
+static FILE   *bench_output	= 0;
+
+static inline int64_t bench_get_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int bench_compare_ns(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a;
+	int64_t y = *(const int64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static const char *bench_cache_repr(datapipe_cache_t cache)
+{
+	switch( cache ) {
+	case DATAPIPE_CACHE_NOTHING: return "nothing";
+	case DATAPIPE_CACHE_INDATA:  return "indata";
+	case DATAPIPE_CACHE_OUTDATA: return "outdata";
+	case DATAPIPE_CACHE_DEFAULT: return "default";
+	default: break;
+	}
+	return "unknown";
+}
+
+/** Run pending idle callbacks, e.g. datapipe garbage collection */
+static void bench_flush_idle(void)
+{
+	while( g_main_context_iteration(0, FALSE) )
+		;
+}
+
+/** Create bindings with given amount of filters and output triggers
+ *
+ * @param pipe      datapipe to bind to
+ * @param filters   number of filter callbacks
+ * @param triggers  number of output trigger callbacks
+ * @param reenter   add re-entering output trigger in front
+ */
+static datapipe_bindings_t *bench_bindings_create(datapipe_t *pipe,
+						  int filters, int triggers,
+						  bool reenter)
+{
+	int count = filters + triggers + (reenter ? 1 : 0);
+	datapipe_handler_t *handlers = g_new0(datapipe_handler_t, count + 1);
+	datapipe_bindings_t *bindings = g_new0(datapipe_bindings_t, 1);
+	int i = 0;
+
+	if( reenter ) {
+		handlers[i].datapipe = pipe;
+		handlers[i].output_cb = bench_reenter_cb;
+		++i;
+	}
+	for( int k = 0; k < filters; ++k, ++i ) {
+		handlers[i].datapipe = pipe;
+		handlers[i].filter_cb = bench_filter_cb;
+	}
+	for( int k = 0; k < triggers; ++k, ++i ) {
+		handlers[i].datapipe = pipe;
+		handlers[i].output_cb = bench_trigger_cb;
+	}
+
+	bindings->module = "bench";
+	bindings->handlers = handlers;
+	return bindings;
+}
+
+static void bench_bindings_delete(datapipe_bindings_t *bindings)
+{
+	if( bindings ) {
+		g_free(bindings->handlers);
+		g_free(bindings);
+	}
+}
+
+/** Emit one result line
+ *
+ * @param test     name of the benchmark
+ * @param pipe     datapipe used
+ * @param filters  number of filters
+ * @param triggers number of triggers
+ * @param total_ns time spent in the throughput loop
+ * @param lat      per operation latency samples, sorted, or NULL
+ */
+static void bench_report(const char *test, const datapipe_t *pipe,
+			 int filters, int triggers, int64_t total_ns,
+			 const int64_t *lat)
+{
+	int64_t p50 = lat ? lat[bench_samples / 2] : -1;
+	int64_t p99 = lat ? lat[bench_samples * 99 / 100] : -1;
+	int64_t max = lat ? lat[bench_samples - 1] : -1;
+
+	fprintf(bench_output,
+		"%s\t%s\t%d\t%d\t%lld\t%.2f\t%.0f\t%lld\t%lld\t%lld\n",
+		test, bench_cache_repr(pipe->dp_cache),
+		filters, triggers,
+		(long long)bench_iterations,
+		(double)total_ns / bench_iterations,
+		total_ns ? bench_iterations * 1e9 / total_ns : 0.0,
+		(long long)p50, (long long)p99, (long long)max);
+}
+
+/* ------------------------------------------------------------------------- *
+ * BENCHMARKS
+ * ------------------------------------------------------------------------- */
+
+/** Measure datapipe execution cost
+ *
+ * @param test     name of the benchmark
+ * @param pipe     datapipe to execute
+ * @param filters  number of filters to install
+ * @param triggers number of output triggers to install
+ * @param reenter  whether to exercise recursion detection
+ */
+static void bench_exec(const char *test, datapipe_t *pipe,
+		       int filters, int triggers, bool reenter)
+{
+	datapipe_bindings_t *bindings =
+		bench_bindings_create(pipe, filters, triggers, reenter);
+	int64_t *lat = g_new(int64_t, bench_samples);
+
+	mce_datapipe_init_bindings(bindings);
+	bench_flush_idle();
+	bench_reenter_pipe = reenter ? pipe : 0;
+
+	/* Warm up caches */
+	for( int i = 0; i < bench_samples; ++i )
+		datapipe_exec_full(pipe, GINT_TO_POINTER(i));
+
+	int64_t t0 = bench_get_ns();
+	for( int64_t i = 0; i < bench_iterations; ++i )
+		datapipe_exec_full(pipe, GINT_TO_POINTER(i));
+	int64_t t1 = bench_get_ns();
+
+	for( int i = 0; i < bench_samples; ++i ) {
+		int64_t t = bench_get_ns();
+		datapipe_exec_full(pipe, GINT_TO_POINTER(i));
+		lat[i] = bench_get_ns() - t;
+	}
+	qsort(lat, bench_samples, sizeof *lat, bench_compare_ns);
+
+	bench_report(test, pipe, filters, triggers, t1 - t0, lat);
+
+	bench_reenter_pipe = 0;
+	mce_datapipe_quit_bindings(bindings);
+	bench_flush_idle();
+	bench_bindings_delete(bindings);
+	g_free(lat);
+}
+
+/** Measure handler install + remove cost
+ *
+ * Includes the idle callbacks scheduled by the bindings code, i.e.
+ * initial value notifications and garbage collection of removed slots.
+ *
+ * @param pipe     datapipe to bind to
+ * @param filters  number of filters to install
+ * @param triggers number of output triggers to install
+ */
+static void bench_churn(datapipe_t *pipe, int filters, int triggers)
+{
+	datapipe_bindings_t *bindings =
+		bench_bindings_create(pipe, filters, triggers, false);
+
+	int64_t t0 = bench_get_ns();
+	for( int64_t i = 0; i < bench_iterations; ++i ) {
+		mce_datapipe_init_bindings(bindings);
+		mce_datapipe_quit_bindings(bindings);
+		bench_flush_idle();
+	}
+	int64_t t1 = bench_get_ns();
+
+	bench_report("churn", pipe, filters, triggers, t1 - t0, 0);
+
+	bench_bindings_delete(bindings);
+}
+
+/* ------------------------------------------------------------------------- *
+ * MAIN
+ * ------------------------------------------------------------------------- */
+
+static void usage(const char *progname)
+{
+	printf("USAGE\n"
+	       "  %s [options]\n"
+	       "\n"
+	       "OPTIONS\n"
+	       "  -h, --help              -- this help text\n"
+	       "  -n, --iterations=COUNT  -- operations per measurement\n"
+	       "  -s, --samples=COUNT     -- latency samples per measurement\n"
+	       "  -o, --output=FILE       -- write results to FILE\n"
+	       "\n"
+	       "OUTPUT COLUMNS\n"
+	       "  test cache filters triggers iterations ns/op ops/s"
+	       " p50_ns p99_ns max_ns\n"
+	       "\n",
+	       progname);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option optL[] = {
+		{ "help",	0, 0, 'h' },
+		{ "iterations", 1, 0, 'n' },
+		{ "samples",	1, 0, 's' },
+		{ "output",	1, 0, 'o' },
+		{ 0, 0, 0, 0 }
+	};
+
+	int result = EXIT_FAILURE;
+	const char *output = 0;
+
+	for( ;; ) {
+		int opt = getopt_long(argc, argv, "hn:s:o:", optL, 0);
+		if( opt < 0 )
+			break;
+
+		switch( opt ) {
+		case 'h':
+			usage(*argv);
+			exit(EXIT_SUCCESS);
+		case 'n':
+			bench_iterations = strtoll(optarg, 0, 0);
+			break;
+		case 's':
+			bench_samples = strtol(optarg, 0, 0);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			goto EXIT;
+		}
+	}
+
+	if( bench_iterations < 1 || bench_samples < 1 ) {
+		fprintf(stderr, "iteration and sample counts must be positive\n");
+		goto EXIT;
+	}
+
+	bench_output = stdout;
+	if( output && !(bench_output = fopen(output, "w")) ) {
+		fprintf(stderr, "%s: %m\n", output);
+		goto EXIT;
+	}
+
+	fprintf(bench_output, "test\tcache\tfilters\ttriggers\titerations"
+		"\tns_per_op\tops_per_s\tp50_ns\tp99_ns\tmax_ns\n");
+
+	/* Fan-out: cache modes x filter counts x trigger counts */
+	for( size_t p = 0; p < BENCH_NUMOF(bench_pipes); ++p ) {
+		for( size_t f = 0; f < BENCH_NUMOF(bench_counts); ++f ) {
+			for( size_t t = 0; t < BENCH_NUMOF(bench_counts); ++t ) {
+				bench_exec("exec", bench_pipes[p],
+					   bench_counts[f], bench_counts[t],
+					   false);
+			}
+		}
+	}
+
+	/* Recursion detection: re-entry aborts the outer execution */
+	for( size_t t = 0; t < BENCH_NUMOF(bench_counts); ++t ) {
+		bench_exec("reenter", &bench_default_pipe,
+			   0, bench_counts[t], true);
+	}
+
+	/* Handler install / remove churn */
+	for( size_t c = 0; c < BENCH_NUMOF(bench_counts); ++c ) {
+		bench_churn(&bench_default_pipe,
+			    bench_counts[c], bench_counts[c]);
+	}
+
+	result = EXIT_SUCCESS;
+
+EXIT:
+	if( bench_output && bench_output != stdout )
+		fclose(bench_output);
+
+	return result;
+}
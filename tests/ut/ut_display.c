@@ -65,6 +65,10 @@
 EXTERN_DUMMY_STUB (
 gboolean, mce_conf_has_group, (const gchar *group));
 
+EXTERN_DUMMY_STUB (
+gboolean, mce_conf_get_bool, (const gchar *group, const gchar *key,
+			      const gboolean defaultval));
+
 typedef struct stub__mce_conf_get_int_item
 {
 	const gchar *group;
@@ -916,6 +920,25 @@ void, filewatcher_delete, (filewatcher_t *self));
 EXTERN_DUMMY_STUB (
 void, filewatcher_force_trigger, (filewatcher_t *self));
 
+/*
+ * mce-lagmon.c stubs {{{1
+ */
+
+EXTERN_STUB (
+int, mce_lagmon_enter, (const char *kind, const char *name))
+{
+	(void)kind;
+	(void)name;
+
+	return -1;
+}
+
+EXTERN_STUB (
+void, mce_lagmon_leave, (int scope))
+{
+	(void)scope;
+}
+
 /*
  * }}}
  */
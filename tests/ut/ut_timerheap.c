@@ -0,0 +1,196 @@
+#include <check.h>
+#include <glib.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+/* Tested module */
+#include "../../mce-timerheap.c"
+
+/* ------------------------------------------------------------------------- *
+ * HELPERS
+ * ------------------------------------------------------------------------- */
+
+#define UT_NODE_COUNT 64
+
+static mce_timerheap_t      *ut_heap = NULL;
+static mce_timerheap_node_t  ut_node[UT_NODE_COUNT];
+
+static void ut_setup(void)
+{
+	ut_heap = mce_timerheap_create();
+	ck_assert(ut_heap != NULL);
+
+	for( int i = 0; i < UT_NODE_COUNT; ++i )
+		mce_timerheap_node_init(&ut_node[i], &ut_node[i]);
+}
+
+static void ut_teardown(void)
+{
+	mce_timerheap_delete(ut_heap), ut_heap = NULL;
+}
+
+/* Pop all nodes and check they come out in non-decreasing deadline order */
+static guint ut_drain_sorted(void)
+{
+	guint   count = 0;
+	int64_t prev  = INT64_MIN;
+	mce_timerheap_node_t *node;
+
+	while( (node = mce_timerheap_pop(ut_heap)) ) {
+		ck_assert(!mce_timerheap_node_is_queued(node));
+		ck_assert(node->thn_deadline >= prev);
+		prev = node->thn_deadline;
+		++count;
+	}
+
+	ck_assert_int_eq(mce_timerheap_count(ut_heap), 0);
+	return count;
+}
+
+/* ------------------------------------------------------------------------- *
+ * TESTS
+ * ------------------------------------------------------------------------- */
+
+START_TEST (ut_check_empty)
+{
+	ck_assert_int_eq(mce_timerheap_count(ut_heap), 0);
+	ck_assert(mce_timerheap_peek(ut_heap) == NULL);
+	ck_assert(mce_timerheap_pop(ut_heap) == NULL);
+	ck_assert(mce_timerheap_next_deadline(ut_heap) ==
+		  MCE_TIMERHEAP_NO_DEADLINE);
+	ck_assert(mce_timerheap_next_wakeup(ut_heap, 100) ==
+		  MCE_TIMERHEAP_NO_DEADLINE);
+
+	/* NULL heap is treated as empty */
+	ck_assert_int_eq(mce_timerheap_count(NULL), 0);
+	ck_assert(mce_timerheap_peek(NULL) == NULL);
+}
+END_TEST
+
+START_TEST (ut_check_insert_ordering)
+{
+	GRand *rnd = g_rand_new_with_seed(_i + 1);
+
+	for( int i = 0; i < UT_NODE_COUNT; ++i )
+		mce_timerheap_insert(ut_heap, &ut_node[i],
+				     g_rand_int_range(rnd, 0, 1000));
+
+	ck_assert_int_eq(mce_timerheap_count(ut_heap), UT_NODE_COUNT);
+	ck_assert_int_eq(ut_drain_sorted(), UT_NODE_COUNT);
+
+	g_rand_free(rnd);
+}
+END_TEST
+
+START_TEST (ut_check_equal_deadlines_fifo)
+{
+	for( int i = 0; i < UT_NODE_COUNT; ++i )
+		mce_timerheap_insert(ut_heap, &ut_node[i], 500);
+
+	for( int i = 0; i < UT_NODE_COUNT; ++i )
+		ck_assert(mce_timerheap_pop(ut_heap) == &ut_node[i]);
+}
+END_TEST
+
+START_TEST (ut_check_remove)
+{
+	GRand *rnd = g_rand_new_with_seed(_i + 1);
+
+	for( int i = 0; i < UT_NODE_COUNT; ++i )
+		mce_timerheap_insert(ut_heap, &ut_node[i],
+				     g_rand_int_range(rnd, 0, 1000));
+
+	/* Remove every third node, including root and leaves */
+	guint removed = 0;
+	for( int i = 0; i < UT_NODE_COUNT; i += 3 ) {
+		mce_timerheap_remove(ut_heap, &ut_node[i]);
+		ck_assert(!mce_timerheap_node_is_queued(&ut_node[i]));
+		++removed;
+	}
+
+	/* Removing unqueued node is a no-op */
+	mce_timerheap_remove(ut_heap, &ut_node[0]);
+
+	ck_assert_int_eq(mce_timerheap_count(ut_heap),
+			 UT_NODE_COUNT - removed);
+	ck_assert_int_eq(ut_drain_sorted(), UT_NODE_COUNT - removed);
+
+	g_rand_free(rnd);
+}
+END_TEST
+
+START_TEST (ut_check_reschedule)
+{
+	for( int i = 0; i < UT_NODE_COUNT; ++i )
+		mce_timerheap_insert(ut_heap, &ut_node[i], 100 + i);
+
+	/* Move the earliest node last and a late node first */
+	mce_timerheap_insert(ut_heap, &ut_node[0], 10000);
+	mce_timerheap_insert(ut_heap, &ut_node[UT_NODE_COUNT - 1], 0);
+
+	ck_assert_int_eq(mce_timerheap_count(ut_heap), UT_NODE_COUNT);
+	ck_assert(mce_timerheap_peek(ut_heap) == &ut_node[UT_NODE_COUNT - 1]);
+	ck_assert(mce_timerheap_next_deadline(ut_heap) == 0);
+
+	mce_timerheap_node_t *last = NULL, *node;
+	while( (node = mce_timerheap_pop(ut_heap)) )
+		last = node;
+	ck_assert(last == &ut_node[0]);
+}
+END_TEST
+
+START_TEST (ut_check_next_wakeup)
+{
+	mce_timerheap_insert(ut_heap, &ut_node[0], 2000);
+	mce_timerheap_insert(ut_heap, &ut_node[1], 1000);
+
+	ck_assert(mce_timerheap_next_deadline(ut_heap) == 1000);
+	ck_assert(mce_timerheap_next_wakeup(ut_heap, 0) == 1000);
+	ck_assert(mce_timerheap_next_wakeup(ut_heap, 250) == 1250);
+}
+END_TEST
+
+START_TEST (ut_check_delete_detaches)
+{
+	for( int i = 0; i < 4; ++i )
+		mce_timerheap_insert(ut_heap, &ut_node[i], i);
+
+	mce_timerheap_delete(ut_heap), ut_heap = NULL;
+
+	for( int i = 0; i < 4; ++i )
+		ck_assert(!mce_timerheap_node_is_queued(&ut_node[i]));
+}
+END_TEST
+
+static Suite *ut_timerheap_suite (void)
+{
+	Suite *s = suite_create ("ut_timerheap");
+
+	TCase *tc_core = tcase_create ("core");
+	tcase_add_checked_fixture (tc_core, ut_setup, ut_teardown);
+	tcase_add_test (tc_core, ut_check_empty);
+	tcase_add_loop_test (tc_core, ut_check_insert_ordering, 0, 8);
+	tcase_add_test (tc_core, ut_check_equal_deadlines_fifo);
+	tcase_add_loop_test (tc_core, ut_check_remove, 0, 8);
+	tcase_add_test (tc_core, ut_check_reschedule);
+	tcase_add_test (tc_core, ut_check_next_wakeup);
+	tcase_add_test (tc_core, ut_check_delete_detaches);
+	suite_add_tcase (s, tc_core);
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	int number_failed;
+	Suite *s = ut_timerheap_suite ();
+	SRunner *sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
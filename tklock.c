@@ -351,6 +351,9 @@ static gboolean tklock_dtcalib_cb(gpointer data);
 static void     tklock_dtcalib_start(void);
 static void     tklock_dtcalib_stop(void);
 
+static void     tklock_dtcalib_init(void);
+static void     tklock_dtcalib_quit(void);
+
 // DYNAMIC_SETTINGS
 
 static void     tklock_setting_sanitize_lid_open_actions(void);
@@ -1528,13 +1531,9 @@ static void tklock_datapipe_camera_button_state_cb(gconstpointer const data)
  */
 static void tklock_datapipe_keypress_event_cb(gconstpointer const data)
 {
-    const struct input_event *const*evp;
-    const struct input_event       *ev;
-
-    if( !(evp = data) )
-        goto EXIT;
+    const struct input_event *ev;
 
-    if( !(ev = *evp) )
+    if( !(ev = data) )
         goto EXIT;
 
     // ignore non-key events
@@ -3571,6 +3570,9 @@ tklock_autolock_init(void)
     tklock_autolock_timer = mce_hbtimer_create("autolock-timer",
                                                tklock_autolock_delay,
                                                tklock_autolock_cb, 0);
+
+    /* Locking must not be delayed by iphb wakeup range */
+    mce_hbtimer_set_class(tklock_autolock_timer, MCE_HBTIMER_CLASS_PRECISE);
 }
 
 static void
@@ -4894,8 +4896,12 @@ static const guint tklock_dtcalib_delays[] = { 2, 4, 8, 16, 30 };
 /** Double tap recalibration index */
 static guint tklock_dtcalib_index = 0;
 
-/** Double tap recalibration timeout identifier */
-static guint tklock_dtcalib_timeout_id = 0;
+/** Double tap recalibration timer
+ *
+ * Recalibration can wait until the device wakes up for some other
+ * reason, so a deferrable heartbeat timer is used.
+ */
+static mce_hbtimer_t *tklock_dtcalib_timer = 0;
 
 /** Kick the double tap recalibrating sysfs file unconditionally
  */
@@ -4925,10 +4931,7 @@ static gboolean tklock_dtcalib_cb(gpointer data)
 {
     (void)data;
 
-    if( !tklock_dtcalib_timeout_id )
-        goto EXIT;
-
-    tklock_dtcalib_timeout_id = 0;
+    gboolean again = FALSE;
 
     mce_log(LL_DEBUG, "double tap calibration @ timer");
     tklock_dtcalib_now();
@@ -4940,12 +4943,12 @@ static gboolean tklock_dtcalib_cb(gpointer data)
     }
 
     /* Otherwise use next delay */
-    tklock_dtcalib_timeout_id =
-        g_timeout_add_seconds(tklock_dtcalib_delays[tklock_dtcalib_index++],
-                              tklock_dtcalib_cb, NULL);
+    mce_hbtimer_set_period(tklock_dtcalib_timer,
+                           tklock_dtcalib_delays[tklock_dtcalib_index++] * 1000);
+    again = TRUE;
 
 EXIT:
-    return FALSE;
+    return again;
 }
 
 /** Cancel doubletap recalibration timeouts
@@ -4953,9 +4956,7 @@ EXIT:
 static void tklock_dtcalib_stop(void)
 {
     /* stop timer based kicking */
-    if( tklock_dtcalib_timeout_id )
-        g_source_remove(tklock_dtcalib_timeout_id),
-        tklock_dtcalib_timeout_id = 0;
+    mce_hbtimer_stop(tklock_dtcalib_timer);
 
     /* stop heartbeat based kicking */
     tklock_dtcalib_on_heartbeat = FALSE;
@@ -4972,14 +4973,32 @@ static void tklock_dtcalib_start(void)
 
     tklock_dtcalib_index = 0;
 
-    tklock_dtcalib_timeout_id =
-        g_timeout_add_seconds(tklock_dtcalib_delays[tklock_dtcalib_index++],
-                              tklock_dtcalib_cb, NULL);
+    mce_hbtimer_set_period(tklock_dtcalib_timer,
+                           tklock_dtcalib_delays[tklock_dtcalib_index++] * 1000);
+    mce_hbtimer_start(tklock_dtcalib_timer);
 
 EXIT:
     return;
 }
 
+/** Create doubletap recalibration timer
+ */
+static void tklock_dtcalib_init(void)
+{
+    tklock_dtcalib_timer = mce_hbtimer_create("dtcalib-timer",
+                                              tklock_dtcalib_delays[0] * 1000,
+                                              tklock_dtcalib_cb, 0);
+    mce_hbtimer_set_class(tklock_dtcalib_timer, MCE_HBTIMER_CLASS_DEFERRABLE);
+}
+
+/** Delete doubletap recalibration timer
+ */
+static void tklock_dtcalib_quit(void)
+{
+    mce_hbtimer_delete(tklock_dtcalib_timer),
+        tklock_dtcalib_timer = 0;
+}
+
 /* ========================================================================= *
  * DYNAMIC_SETTINGS
  * ========================================================================= */
@@ -6190,7 +6209,10 @@ tklock_dbus_send_display_blanking_policy(DBusMessage *const req)
                                   DBUS_TYPE_INVALID) )
         goto EXIT;
 
-    dbus_send_message(rsp), rsp = 0;
+    if( req )
+        dbus_send_message(rsp), rsp = 0;
+    else
+        dbus_send_signal_coalesced(rsp, 0, 0), rsp = 0;
 
 EXIT:
     if( rsp ) dbus_message_unref(rsp);
@@ -6424,8 +6446,11 @@ static gboolean tklock_dbus_send_tklock_mode(DBusMessage *const method_call)
         goto EXIT;
     }
 
-    /* Send the message */
-    status = dbus_send_message(msg), msg = 0;
+    /* Send the message; omit redundant signals */
+    if( method_call )
+        status = dbus_send_message(msg), msg = 0;
+    else
+        status = dbus_send_signal_coalesced(msg, 0, 0), msg = 0;
 
 EXIT:
     if( msg ) dbus_message_unref(msg);
@@ -7377,6 +7402,7 @@ gboolean mce_tklock_init(void)
     tklock_setting_init();
 
     tklock_autolock_init();
+    tklock_dtcalib_init();
 
     /* Set initial lid_sensor_is_working_pipe value
      * before installing datapipe handlers */
@@ -7422,6 +7448,7 @@ void mce_tklock_exit(void)
     tklock_ui_notify_cancel();
 
     tklock_autolock_quit();
+    tklock_dtcalib_quit();
 
     if( tklock_ui_sync_id ) {
         g_source_remove(tklock_ui_sync_id),
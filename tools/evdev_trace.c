@@ -25,25 +25,230 @@
 #include "fileusers.h"
 
 #include <linux/input.h>
+#include <linux/uinput.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <time.h>
 #include <poll.h>
 #include <glob.h>
 #include <getopt.h>
+#include <signal.h>
+#include <sys/ioctl.h>
 
 #include "../musl-compatibility.h"
 
+/* ========================================================================= *
+ * PROTOTYPES
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * REPLAY
+ * ------------------------------------------------------------------------- */
+
+static int64_t replay_get_tick(void);
+
 /** Flag for: emit event time stamps */
 static bool emit_event_time  = true;
 
 /** Flag for: emit time of day (of event read time) */
 static bool emit_time_of_day = false;
 
+/** Flag for: emit kernel timestamp to read time latency */
+static bool emit_latency = false;
+
+/** Latency statistics: number of events */
+static int64_t latency_count = 0;
+
+/** Latency statistics: sum of latencies [us] */
+static int64_t latency_total = 0;
+
+/** Latency statistics: smallest latency [us] */
+static int64_t latency_min = INT64_MAX;
+
+/** Latency statistics: largest latency [us] */
+static int64_t latency_max = 0;
+
+/** Flag for: termination signal received */
+static volatile sig_atomic_t trace_interrupted = 0;
+
+/** Handler for termination signals while collecting latency data
+ *
+ * @param sig  signal number (unused)
+ */
+static
+void
+trace_interrupt_handler(int sig)
+{
+  (void)sig;
+  trace_interrupted = 1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * CAPTURE FILE
+ *
+ * Binary file layout:
+ *   capture_header_t                      -- once
+ *   capture_device_t                      -- capture_header_t::devices times
+ *   capture_event_t                       -- until end of file
+ *
+ * Data is stored in host byte order, i.e. capture files are meant
+ * to be replayed on the same architecture they were recorded on.
+ * ------------------------------------------------------------------------- */
+
+/** Capture file identification string */
+#define CAPTURE_MAGIC "EVDTRC01"
+
+/** Maximum number of device records in a capture file */
+#define CAPTURE_MAX_DEVICES 256
+
+/** Number of bytes needed for event code bitmap of any type */
+#define CAPTURE_BITS_SIZE ((KEY_CNT + 7) / 8)
+
+/** Capture file header */
+typedef struct
+{
+  /** File identification, CAPTURE_MAGIC without terminator */
+  char     magic[8];
+
+  /** Number of device records that follow */
+  uint32_t devices;
+} capture_header_t;
+
+/** Capture file device record */
+typedef struct
+{
+  /** Device name as reported by EVIOCGNAME */
+  char                 name[UINPUT_MAX_NAME_SIZE];
+
+  /** Device identification as reported by EVIOCGID */
+  struct input_id      id;
+
+  /** Supported event codes, indexed by event type */
+  uint8_t              bits[EV_CNT][CAPTURE_BITS_SIZE];
+
+  /** Value ranges of supported EV_ABS codes */
+  struct input_absinfo absinfo[ABS_CNT];
+} capture_device_t;
+
+/** Capture file event record */
+typedef struct
+{
+  /** Microseconds since the previous event, saturated to UINT32_MAX */
+  uint32_t delay;
+
+  /** Event type */
+  uint16_t type;
+
+  /** Event code */
+  uint16_t code;
+
+  /** Event value */
+  int32_t  value;
+
+  /** Index of the device record the event originates from */
+  uint32_t device;
+} capture_event_t;
+
+/** Capture file being recorded, or NULL */
+static FILE    *capture_file = 0;
+
+/** Timestamp of the previously recorded event [us] */
+static int64_t  capture_prev = -1;
+
+/** Predicate for: event code is supported by captured device
+ *
+ * @param dev   device record
+ * @param type  event type
+ * @param code  event code
+ *
+ * @return true if code is supported, false otherwise
+ */
+static
+bool
+capture_device_has_code(const capture_device_t *dev, int type, int code)
+{
+  if( type < 0 || type >= EV_CNT || code < 0 || code >= KEY_CNT )
+  {
+    return false;
+  }
+  return (dev->bits[type][code / 8] >> (code % 8)) & 1;
+}
+
+/** Fill in capture file device record from an input device
+ *
+ * @param dev  device record to fill in
+ * @param fd   input device file descriptor
+ */
+static
+void
+capture_device_probe(capture_device_t *dev, int fd)
+{
+  memset(dev, 0, sizeof *dev);
+
+  if( ioctl(fd, EVIOCGNAME(sizeof dev->name - 1), dev->name) < 0 )
+  {
+    mce_log(LL_WARN, "EVIOCGNAME: %m");
+  }
+
+  if( ioctl(fd, EVIOCGID, &dev->id) < 0 )
+  {
+    mce_log(LL_WARN, "EVIOCGID: %m");
+  }
+
+  for( int type = 0; type < EV_CNT; ++type )
+  {
+    ioctl(fd, EVIOCGBIT(type, CAPTURE_BITS_SIZE), dev->bits[type]);
+  }
+
+  for( int code = 0; code < ABS_CNT; ++code )
+  {
+    if( capture_device_has_code(dev, EV_ABS, code) )
+    {
+      ioctl(fd, EVIOCGABS(code), &dev->absinfo[code]);
+    }
+  }
+}
+
+/** Append an event to capture file
+ *
+ * @param device  index of the source device
+ * @param e       input event
+ */
+static
+void
+capture_write_event(int device, const struct input_event *e)
+{
+  int64_t now = e->input_event_sec * 1000000LL + e->input_event_usec;
+
+  capture_event_t rec =
+  {
+    .delay  = 0,
+    .type   = e->type,
+    .code   = e->code,
+    .value  = e->value,
+    .device = device,
+  };
+
+  if( capture_prev >= 0 && now > capture_prev )
+  {
+    int64_t delay = now - capture_prev;
+    rec.delay = (delay > UINT32_MAX) ? UINT32_MAX : (uint32_t)delay;
+  }
+  capture_prev = now;
+
+  if( fwrite(&rec, sizeof rec, 1, capture_file) != 1 )
+  {
+    mce_log(LL_ERR, "capture write failed: %m");
+  }
+}
+
 /** Read and show input events
  *
  * @param fd   input device file descriptor to read from
@@ -53,10 +258,10 @@ static bool emit_time_of_day = false;
  */
 static
 int
-process_events(int fd, const char *title)
+process_events(int fd, int device, const char *title)
 {
   struct input_event eve[256];
-  char tod[64], toe[64];
+  char tod[64], toe[64], lat[32];
 
   errno = 0;
   int n = read(fd, eve, sizeof eve);
@@ -74,6 +279,9 @@ process_events(int fd, const char *title)
 
   n /= sizeof *eve;
 
+  /* Event timestamps are in CLOCK_MONOTONIC, see mainloop() */
+  int64_t read_tick = emit_latency ? replay_get_tick() : 0;
+
   *tod = 0;
   if( emit_time_of_day )
   {
@@ -100,6 +308,11 @@ process_events(int fd, const char *title)
   {
     struct input_event *e = &eve[i];
 
+    if( capture_file )
+    {
+      capture_write_event(device, e);
+    }
+
     *toe = 0;
     if( emit_event_time )
     {
@@ -108,14 +321,34 @@ process_events(int fd, const char *title)
                (long)e->input_event_usec / 1000);
     }
 
-    printf("%s: %s%s0x%02x/%s - 0x%03x/%s - %d\n",
+    *lat = 0;
+    if( emit_latency )
+    {
+      int64_t delay = read_tick - (e->input_event_sec * 1000000LL +
+                                   e->input_event_usec);
+      snprintf(lat, sizeof lat, " - %lldus", (long long)delay);
+
+      latency_count += 1;
+      latency_total += delay;
+      if( latency_min > delay ) latency_min = delay;
+      if( latency_max < delay ) latency_max = delay;
+    }
+
+    printf("%s: %s%s0x%02x/%s - 0x%03x/%s - %d%s\n",
            title, tod, toe,
            e->type,
            evdev_get_event_type_name(e->type),
            e->code,
            evdev_get_event_code_name(e->type, e->code),
-           e->value);
+           e->value, lat);
   }
+
+  /* Tracing is normally terminated via signal -> flush as we go */
+  if( capture_file )
+  {
+    fflush(capture_file);
+  }
+
   return 1;
 }
 
@@ -168,20 +401,76 @@ mainloop(char **path, int count, int identify, int trace)
     goto cleanup;
   }
 
-  while( closed < count )
+  if( emit_latency )
+  {
+    /* Stop on signal so that latency summary gets printed */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = trace_interrupt_handler;
+    sigaction(SIGINT, &sa, 0);
+    sigaction(SIGTERM, &sa, 0);
+
+    /* Have the kernel stamp events with the same clock
+     * that is used for taking read time stamps */
+    int clk = CLOCK_MONOTONIC;
+    for( int i = 0; i < count; ++i )
+    {
+      if( pfd[i].fd != -1 && ioctl(pfd[i].fd, EVIOCSCLOCKID, &clk) == -1 )
+      {
+        mce_log(LL_WARN, "%s: EVIOCSCLOCKID: %m", path[i]);
+      }
+    }
+  }
+
+  if( capture_file && count > CAPTURE_MAX_DEVICES )
+  {
+    mce_log(LL_ERR, "can't record more than %d devices",
+            CAPTURE_MAX_DEVICES);
+    goto cleanup;
+  }
+
+  if( capture_file )
+  {
+    capture_header_t hdr;
+    capture_device_t dev;
+
+    memcpy(hdr.magic, CAPTURE_MAGIC, sizeof hdr.magic);
+    hdr.devices = count;
+    fwrite(&hdr, sizeof hdr, 1, capture_file);
+
+    /* Closed devices get a placeholder record so that
+     * indices match the command line order */
+    for( int i = 0; i < count; ++i )
+    {
+      if( pfd[i].fd == -1 )
+      {
+        memset(&dev, 0, sizeof dev);
+      }
+      else
+      {
+        capture_device_probe(&dev, pfd[i].fd);
+      }
+      fwrite(&dev, sizeof dev, 1, capture_file);
+    }
+  }
+
+  while( closed < count && !trace_interrupted )
   {
     for( int i = 0; i < count; ++i )
     {
       pfd[i].events = (pfd[i].fd < 0) ? 0 : POLLIN;
     }
 
-    poll(pfd, count, -1);
+    if( poll(pfd, count, -1) == -1 )
+    {
+      continue;
+    }
 
     for( int i = 0; i < count; ++i )
     {
       if( pfd[i].revents )
       {
-        if( process_events(pfd[i].fd, path[i]) <= 0 )
+        if( process_events(pfd[i].fd, i, path[i]) <= 0 )
         {
           close(pfd[i].fd);
           pfd[i].fd = -1;
@@ -191,6 +480,15 @@ mainloop(char **path, int count, int identify, int trace)
     }
   }
 
+  if( emit_latency && latency_count > 0 )
+  {
+    printf("latency: events=%lld min=%lldus avg=%lldus max=%lldus\n",
+           (long long)latency_count,
+           (long long)latency_min,
+           (long long)(latency_total / latency_count),
+           (long long)latency_max);
+  }
+
 cleanup:
 
   for( int i = 0; i < count; ++i )
@@ -201,6 +499,323 @@ cleanup:
   free(pfd);
 }
 
+/* ------------------------------------------------------------------------- *
+ * REPLAY
+ * ------------------------------------------------------------------------- */
+
+/** Time to wait for mce to detect replay devices [s] */
+#define REPLAY_SETTLE_DELAY 2
+
+/** Replay speed multiplier; zero for as fast as possible */
+static double replay_speed = 1.0;
+
+/** Process whose cpu usage should be reported, or zero */
+static pid_t  replay_cpu_pid = 0;
+
+/** Get monotonic time stamp
+ *
+ * @return current time [us]
+ */
+static
+int64_t
+replay_get_tick(void)
+{
+  struct timespec ts = { 0, 0 };
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/** Get cpu time consumed by a process
+ *
+ * @param pid  process identifier
+ *
+ * @return user + system time [clock ticks], or -1 on failure
+ */
+static
+long long
+replay_get_cpu_ticks(pid_t pid)
+{
+  long long  res  = -1;
+  char       path[64];
+  char       data[1024];
+  FILE      *file = 0;
+
+  snprintf(path, sizeof path, "/proc/%d/stat", (int)pid);
+
+  if( !(file = fopen(path, "r")) )
+  {
+    goto cleanup;
+  }
+
+  if( !fgets(data, sizeof data, file) )
+  {
+    goto cleanup;
+  }
+
+  /* Skip "pid (comm)", then fields 3..13 to reach utime & stime */
+  char *pos = strrchr(data, ')');
+  unsigned long long utime = 0, stime = 0;
+  if( pos && sscanf(pos + 1,
+                    " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                    &utime, &stime) == 2 )
+  {
+    res = (long long)(utime + stime);
+  }
+
+cleanup:
+
+  if( file )
+  {
+    fclose(file);
+  }
+
+  return res;
+}
+
+/** Create uinput device mimicking a captured input device
+ *
+ * @param dev  device record
+ *
+ * @return uinput file descriptor, or -1 on failure
+ */
+static
+int
+replay_create_device(const capture_device_t *dev)
+{
+  static const struct
+  {
+    int           type;
+    int           count;
+    unsigned long request;
+  } lut[] =
+  {
+    { EV_KEY, KEY_CNT, UI_SET_KEYBIT },
+    { EV_REL, REL_CNT, UI_SET_RELBIT },
+    { EV_ABS, ABS_CNT, UI_SET_ABSBIT },
+    { EV_MSC, MSC_CNT, UI_SET_MSCBIT },
+    { EV_SW,  SW_CNT,  UI_SET_SWBIT  },
+    { EV_LED, LED_CNT, UI_SET_LEDBIT },
+    { EV_SND, SND_CNT, UI_SET_SNDBIT },
+  };
+
+  struct uinput_user_dev setup;
+
+  int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+  if( fd == -1 )
+  {
+    mce_log(LL_ERR, "/dev/uinput: %m");
+    goto failure;
+  }
+
+  memset(&setup, 0, sizeof setup);
+  strncpy(setup.name, dev->name, sizeof setup.name - 1);
+  setup.id = dev->id;
+
+  for( int type = 0; type < EV_CNT; ++type )
+  {
+    if( type != EV_SYN && capture_device_has_code(dev, 0, type) )
+    {
+      ioctl(fd, UI_SET_EVBIT, type);
+    }
+  }
+
+  for( size_t i = 0; i < sizeof lut / sizeof *lut; ++i )
+  {
+    for( int code = 0; code < lut[i].count; ++code )
+    {
+      if( capture_device_has_code(dev, lut[i].type, code) )
+      {
+        ioctl(fd, lut[i].request, code);
+      }
+    }
+  }
+
+  for( int code = 0; code < ABS_CNT; ++code )
+  {
+    setup.absmin[code]  = dev->absinfo[code].minimum;
+    setup.absmax[code]  = dev->absinfo[code].maximum;
+    setup.absfuzz[code] = dev->absinfo[code].fuzz;
+    setup.absflat[code] = dev->absinfo[code].flat;
+  }
+
+  if( write(fd, &setup, sizeof setup) != sizeof setup )
+  {
+    mce_log(LL_ERR, "uinput setup: %m");
+    goto failure;
+  }
+
+  if( ioctl(fd, UI_DEV_CREATE) < 0 )
+  {
+    mce_log(LL_ERR, "UI_DEV_CREATE: %m");
+    goto failure;
+  }
+
+  return fd;
+
+failure:
+
+  if( fd != -1 )
+  {
+    close(fd);
+  }
+
+  return -1;
+}
+
+/** Replay captured input events via uinput devices
+ *
+ * @param path  capture file path
+ *
+ * @return true on success, false on failure
+ */
+static
+bool
+replay_capture(const char *path)
+{
+  bool              ack      = false;
+  FILE             *file     = 0;
+  int              *uinput   = 0;
+  uint32_t          devices  = 0;
+  capture_header_t  hdr;
+  capture_device_t  dev;
+  capture_event_t   rec;
+
+  if( !(file = fopen(path, "r")) )
+  {
+    mce_log(LL_ERR, "%s: %m", path);
+    goto cleanup;
+  }
+
+  if( fread(&hdr, sizeof hdr, 1, file) != 1 ||
+      memcmp(hdr.magic, CAPTURE_MAGIC, sizeof hdr.magic) )
+  {
+    mce_log(LL_ERR, "%s: not a capture file", path);
+    goto cleanup;
+  }
+
+  if( hdr.devices > CAPTURE_MAX_DEVICES )
+  {
+    mce_log(LL_ERR, "%s: invalid number of devices: %u", path,
+            (unsigned)hdr.devices);
+    goto cleanup;
+  }
+
+  if( !(uinput = calloc(hdr.devices ?: 1, sizeof *uinput)) )
+  {
+    mce_log(LL_ERR, "%s: out of memory", path);
+    goto cleanup;
+  }
+
+  for( devices = 0; devices < hdr.devices; ++devices )
+  {
+    if( fread(&dev, sizeof dev, 1, file) != 1 )
+    {
+      mce_log(LL_ERR, "%s: truncated device table", path);
+      goto cleanup;
+    }
+
+    uinput[devices] = *dev.name ? replay_create_device(&dev) : -1;
+    printf("device %u: %s -> %s\n", devices,
+           *dev.name ? dev.name : "n/a",
+           uinput[devices] == -1 ? "skipped" : "created");
+  }
+
+  /* Give input device listeners time to notice the new devices */
+  sleep(REPLAY_SETTLE_DELAY);
+
+  long long cpu_beg  = replay_cpu_pid ? replay_get_cpu_ticks(replay_cpu_pid) : -1;
+  int64_t   tick_beg = replay_get_tick();
+  int64_t   target   = tick_beg;
+  int64_t   late_sum = 0;
+  int64_t   late_max = 0;
+  long      count    = 0;
+
+  while( fread(&rec, sizeof rec, 1, file) == 1 )
+  {
+    if( rec.device >= devices || uinput[rec.device] == -1 )
+    {
+      continue;
+    }
+
+    if( replay_speed > 0 )
+    {
+      target += (int64_t)(rec.delay / replay_speed);
+
+      int64_t now = replay_get_tick();
+      if( now < target )
+      {
+        struct timespec ts =
+        {
+          .tv_sec  = target / 1000000,
+          .tv_nsec = target % 1000000 * 1000,
+        };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0);
+      }
+
+      int64_t late = replay_get_tick() - target;
+      late_sum += late;
+      if( late_max < late )
+      {
+        late_max = late;
+      }
+    }
+
+    struct input_event e;
+    memset(&e, 0, sizeof e);
+    e.type  = rec.type;
+    e.code  = rec.code;
+    e.value = rec.value;
+
+    if( write(uinput[rec.device], &e, sizeof e) != sizeof e )
+    {
+      mce_log(LL_WARN, "uinput write: %m");
+    }
+    ++count;
+  }
+
+  int64_t   tick_end = replay_get_tick();
+  long long cpu_end  = replay_cpu_pid ? replay_get_cpu_ticks(replay_cpu_pid) : -1;
+
+  printf("events: %ld\n", count);
+  printf("duration: %.3f s\n", (tick_end - tick_beg) * 1e-6);
+  if( replay_speed > 0 && count > 0 )
+  {
+    printf("lateness: avg %.1f us, max %lld us\n",
+           (double)late_sum / count, (long long)late_max);
+  }
+  if( cpu_beg >= 0 && cpu_end >= 0 )
+  {
+    double ms = (cpu_end - cpu_beg) * 1000.0 / sysconf(_SC_CLK_TCK);
+    printf("cpu(pid=%d): %.0f ms", (int)replay_cpu_pid, ms);
+    if( count > 0 )
+    {
+      printf(", %.1f us/event", ms * 1000.0 / count);
+    }
+    printf("\n");
+  }
+
+  ack = true;
+
+cleanup:
+
+  for( uint32_t i = 0; i < devices; ++i )
+  {
+    if( uinput[i] != -1 )
+    {
+      ioctl(uinput[i], UI_DEV_DESTROY);
+      close(uinput[i]);
+    }
+  }
+  free(uinput);
+
+  if( file )
+  {
+    fclose(file);
+  }
+
+  return ack;
+}
+
 /** Configuration table for long command line options */
 static struct option optL[] =
 {
@@ -210,6 +825,11 @@ static struct option optL[] =
   { "show-readers",  0, 0, 'I' },
   { "emit-also-tod", 0, 0, 'e' },
   { "emit-only-tod", 0, 0, 'E' },
+  { "record",        1, 0, 'r' },
+  { "replay",        1, 0, 'p' },
+  { "speed",         1, 0, 's' },
+  { "cpu-pid",       1, 0, 'P' },
+  { "latency",       0, 0, 'l' },
   { 0,0,0,0 }
 };
 
@@ -221,6 +841,11 @@ static const char optS[] =
 "I" // --show-readers
 "e" // --emit-also-tod
 "E" // --emit-only-tod
+"r:" // --record
+"p:" // --replay
+"s:" // --speed
+"P:" // --cpu-pid
+"l" // --latency
 ;
 
 /** Program name string */
@@ -288,12 +913,24 @@ static void usage(void)
          "  -e, --emit-also-tod  -- emit also time of day\n"
          "  -E, --emit-only-tod  -- emit only time of day\n"
          "  -I, --show-readers   -- identify processes using devices\n"
+         "  -r, --record=FILE    -- trace and record input events to file\n"
+         "  -p, --replay=FILE    -- replay recorded events via uinput\n"
+         "  -s, --speed=FACTOR   -- replay speed multiplier, 0=no delays\n"
+         "  -P, --cpu-pid=PID    -- report cpu time used by PID during replay\n"
+         "  -l, --latency        -- emit event timestamp to read time latency\n"
          "\n"
          "NOTES\n"
          "  If no device paths are given, /dev/input/event* is assumed.\n"
          "  \n"
          "  Full device path is not required, \"/dev/input/event1\" can\n"
          "  be shortened to \"event1\" or just \"1\".\n"
+         "  \n"
+         "  On replay uinput devices with the same names and capabilities\n"
+         "  as the recorded ones are created, and recorded events are\n"
+         "  written to them with the original timing scaled by --speed.\n"
+         "  \n"
+         "  End-to-end latency of replayed events can be observed by\n"
+         "  tracing the replay devices with --latency while replaying.\n"
          "\n",
          progname);
 }
@@ -346,6 +983,9 @@ main(int argc, char **argv)
   int f_identify = 0;
   int f_readers  = 0;
 
+  const char *record_path = 0;
+  const char *replay_path = 0;
+
   setlinebuf(stdout);
 
   glob_t gb;
@@ -390,6 +1030,28 @@ main(int argc, char **argv)
       emit_event_time  = false;
       break;
 
+    case 'r':
+      record_path = optarg;
+      f_trace = 1;
+      break;
+
+    case 'p':
+      replay_path = optarg;
+      break;
+
+    case 's':
+      replay_speed = strtod(optarg, 0);
+      break;
+
+    case 'P':
+      replay_cpu_pid = strtol(optarg, 0, 0);
+      break;
+
+    case 'l':
+      emit_latency = true;
+      f_trace = 1;
+      break;
+
     case '?':
     case ':':
       goto cleanup;
@@ -400,6 +1062,21 @@ main(int argc, char **argv)
     }
   }
 
+  if( replay_path )
+  {
+    if( replay_capture(replay_path) )
+    {
+      result = EXIT_SUCCESS;
+    }
+    goto cleanup;
+  }
+
+  if( record_path && !(capture_file = fopen(record_path, "w")) )
+  {
+    fprintf(stderr, "%s: %m\n", record_path);
+    goto cleanup;
+  }
+
   if( !f_identify && !f_trace )
   {
     f_identify = 1;
@@ -444,5 +1121,10 @@ cleanup:
   globfree(&gb);
   fileusers_quit();
 
+  if( capture_file )
+  {
+    fclose(capture_file);
+  }
+
   return result;
 }
@@ -62,11 +62,50 @@ static void        fileuser_delete    (fileuser_t *self);
 static void        fileuser_delete_cb (void *self);
 
 /* ------------------------------------------------------------------------- *
- * MODULE_API
+ * FILEPROC_OBJS
  * ------------------------------------------------------------------------- */
 
-static void        fileusers_scan_pid_files (int pid);
-static void        fileusers_scan_pids      (void);
+/** Evdev file usage data for one process */
+typedef struct
+{
+    /** Process identifier */
+    int                 fp_pid;
+
+    /** Evdev files the process has open, list of fileuser_t objects */
+    GSList             *fp_users;
+} fileproc_t;
+
+static fileproc_t *fileproc_create    (int pid);
+static void        fileproc_delete    (fileproc_t *self);
+static void        fileproc_delete_cb (void *self);
+static void        fileproc_scan_files(fileproc_t *self);
+
+/* ------------------------------------------------------------------------- *
+ * FILEUSERS_SCAN
+ * ------------------------------------------------------------------------- */
+
+/** Upper limit for number of parallel scanning threads */
+#define FILEUSERS_MAX_THREADS 8
+
+/** Minimum number of processes to scan per thread */
+#define FILEUSERS_PIDS_PER_THREAD 32
+
+/** State shared between scanning threads */
+typedef struct
+{
+    /** Processes to scan, array of fileproc_t pointers */
+    GPtrArray          *fs_procs;
+
+    /** Index of the next process to scan */
+    gint                fs_next;
+} fileusers_scan_t;
+
+static gpointer    fileusers_scan_worker_cb    (gpointer aptr);
+static void        fileusers_scan_pids         (void);
+
+/* ------------------------------------------------------------------------- *
+ * MODULE_API
+ * ------------------------------------------------------------------------- */
 
 GSList            *fileusers_get  (const char *path);
 void               fileusers_init (void);
@@ -206,16 +245,45 @@ fileuser_delete_cb(void *self)
 }
 
 /* ========================================================================= *
- * MODULE_API
+ * FILEPROC_OBJS
  * ========================================================================= */
 
-/** Cache of evdev input files that at least one process has open */
-static GSList *fileusers_list = 0;
+/** Create fileproc object
+ */
+static fileproc_t *
+fileproc_create(int pid)
+{
+    fileproc_t *self = fu_calloc(1, sizeof *self);
+
+    self->fp_pid   = pid;
+    self->fp_users = 0;
+
+    return self;
+}
+
+/** Delete fileproc object
+ */
+static void
+fileproc_delete(fileproc_t *self)
+{
+    if( self ) {
+        g_slist_free_full(self->fp_users, fileuser_delete_cb);
+        free(self);
+    }
+}
+
+/** Type agnostic fileproc object delete function for use as a callback
+ */
+static void
+fileproc_delete_cb(void *self)
+{
+    fileproc_delete(self);
+}
 
 /** Scan evdev input files that a process has open
  */
 static void
-fileusers_scan_pid_files(int pid)
+fileproc_scan_files(fileproc_t *self)
 {
     static const char   pfix_str[] = "/dev/input/event";
     static const size_t pfix_len   = sizeof pfix_str - 1;
@@ -225,7 +293,7 @@ fileusers_scan_pid_files(int pid)
 
     char base[256];
 
-    snprintf(base, sizeof base, "/proc/%d/fd", pid);
+    snprintf(base, sizeof base, "/proc/%d/fd", self->fp_pid);
 
     if( !(dir = opendir(base)) ) {
         mce_log(LL_WARN, "%s: can't scan dir: %m", base);
@@ -269,12 +337,12 @@ fileusers_scan_pid_files(int pid)
         dest[rc] = 0;
 
         if( !cmd )
-            cmd = fu_get_command_name(pid);
+            cmd = fu_get_command_name(self->fp_pid);
 
         int fd = strtol(de->d_name, 0, 0);
 
-        fileuser_t *fu = fileuser_create(dest, cmd, pid, fd);
-        fileusers_list = g_slist_prepend(fileusers_list, fu);
+        fileuser_t *fu = fileuser_create(dest, cmd, self->fp_pid, fd);
+        self->fp_users = g_slist_prepend(self->fp_users, fu);
     }
 
 EXIT:
@@ -284,18 +352,53 @@ EXIT:
         closedir(dir);
 }
 
+/* ========================================================================= *
+ * FILEUSERS_SCAN
+ * ========================================================================= */
+
+/** Cache of evdev input files that at least one process has open */
+static GSList *fileusers_list = 0;
+
+/** Scanning thread main function
+ *
+ * Processes are picked from shared array one by one, so that
+ * slow to scan processes do not stall the other threads.
+ */
+static gpointer
+fileusers_scan_worker_cb(gpointer aptr)
+{
+    fileusers_scan_t *scan = aptr;
+
+    for( ;; ) {
+        guint i = (guint)g_atomic_int_add(&scan->fs_next, 1);
+        if( i >= scan->fs_procs->len )
+            break;
+
+        fileproc_scan_files(g_ptr_array_index(scan->fs_procs, i));
+    }
+
+    return 0;
+}
+
 /** Scan processes that might have evdev input files open
  */
 static void
 fileusers_scan_pids(void)
 {
-    DIR *dir = 0;
+    DIR              *dir      = 0;
+    GThread          *tid[FILEUSERS_MAX_THREADS];
+    int               threads  = 0;
+    fileusers_scan_t  scan     = {
+        .fs_procs = g_ptr_array_new_with_free_func(fileproc_delete_cb),
+        .fs_next  = 0,
+    };
 
     if( !(dir = opendir("/proc")) ) {
         mce_log(LL_WARN, "%s: can't scan dir: %m", "/proc");
         goto EXIT;
     }
 
+    /* Collect current processes */
     struct dirent *de;
 
     while( (de = readdir(dir)) ) {
@@ -306,14 +409,40 @@ fileusers_scan_pids(void)
             continue;
 
         int pid = strtol(de->d_name, 0, 0);
-        fileusers_scan_pid_files(pid);
+        g_ptr_array_add(scan.fs_procs, fileproc_create(pid));
+    }
+
+    /* Distribute scanning over available cpus */
+    threads = (int)(scan.fs_procs->len / FILEUSERS_PIDS_PER_THREAD);
+    threads = CLAMP(threads, 1, (int)g_get_num_processors());
+    threads = MIN(threads, FILEUSERS_MAX_THREADS);
+
+    for( int i = 1; i < threads; ++i )
+        tid[i] = g_thread_new("fileusers", fileusers_scan_worker_cb, &scan);
+
+    fileusers_scan_worker_cb(&scan);
+
+    for( int i = 1; i < threads; ++i )
+        g_thread_join(tid[i]);
+
+    /* Move per process results to the cache */
+    for( guint i = 0; i < scan.fs_procs->len; ++i ) {
+        fileproc_t *proc = g_ptr_array_index(scan.fs_procs, i);
+        fileusers_list = g_slist_concat(proc->fp_users, fileusers_list);
+        proc->fp_users = 0;
     }
 
 EXIT:
+    g_ptr_array_free(scan.fs_procs, TRUE);
+
     if( dir )
         closedir(dir);
 }
 
+/* ========================================================================= *
+ * MODULE_API
+ * ========================================================================= */
+
 /** Initialize open-evdev-files cache
  */
 void
@@ -53,6 +53,9 @@
 #include <errno.h>
 #include <math.h>
 #include <syslog.h>
+#include <time.h>
+
+#include <sys/wait.h>
 
 #include <dbus/dbus.h>
 
@@ -100,6 +103,32 @@ typedef struct
         int         val;
 } symbol_t;
 
+/* ------------------------------------------------------------------------- *
+ * MCETOOL BATCH MODE
+ * ------------------------------------------------------------------------- */
+
+/** Batch command details */
+typedef struct
+{
+        /** Sequence number within the batch */
+        guint   bc_seq;
+
+        /** Input line number */
+        guint   bc_line;
+
+        /** Method call or option name */
+        gchar  *bc_name;
+
+        /** True for pipelined method calls, false for options */
+        bool    bc_method;
+
+        /** Monotonic time when execution started [us] */
+        gint64  bc_started;
+
+        /** Output captured from option execution, or NULL */
+        gchar  *bc_output;
+} mcetool_batch_call_t;
+
 /* ========================================================================= *
  * Prototypes
  * ========================================================================= */
@@ -110,6 +139,7 @@ typedef struct
 
 static DBusConnection  *xdbus_init   (void);
 static void             xdbus_exit   (void);
+static void             xdbus_detach (void);
 static gboolean         xdbus_call_va(const gchar *const service, const gchar *const path, const gchar *const interface, const gchar *const name, DBusMessage **reply, int arg_type, va_list va);
 
 /* ------------------------------------------------------------------------- *
@@ -200,6 +230,10 @@ static void          xmce_get_compositor_dimming                       (void);
 static bool          xmce_set_cabc_mode                                (const char *args);
 static void          xmce_get_cabc_mode                                (void);
 static bool          xmce_reset_settings                               (const char *args);
+static int           xmce_config_batch_type                            (const char *name);
+static void          xmce_config_batch_append_basic                    (DBusMessageIter *iter, int type, const char *text);
+static void          xmce_config_batch_append                          (DBusMessageIter *dict, const char *key, char *spec);
+static bool          xmce_set_config_batch                             (const char *args);
 static bool          xmce_set_dim_timeout                              (const char *args);
 static void          xmce_get_dim_timeout                              (void);
 static bool          xmce_set_dim_with_kbd_timeout                     (const char *args);
@@ -374,6 +408,9 @@ static bool          xmce_set_suspend_policy                           (const ch
 static void          xmce_get_suspend_policy                           (void);
 static bool          xmce_get_suspend_stats                            (const char *args);
 static bool          xmce_get_display_stats                            (const char *args);
+static bool          xmce_get_mainloop_stats                           (const char *args);
+static bool          xmce_get_wakeup_report                            (const char *args);
+static bool          xmce_get_datapipe_graph                           (const char *args);
 static bool          xmce_set_fake_doubletap                           (const char *args);
 static void          xmce_get_fake_doubletap                           (void);
 static bool          xmce_tklock_open                                  (const char *args);
@@ -399,6 +436,7 @@ static gboolean      dbushelper_require_array_type (DBusMessageIter *iter, int w
 static DBusMessage  *dbushelper_call_method        (DBusMessage *req);
 static gboolean      dbushelper_read_at_end        (DBusMessageIter *iter);
 static gboolean      dbushelper_read_int           (DBusMessageIter *iter, gint *value);
+static gboolean      dbushelper_read_uint32        (DBusMessageIter *iter, guint *value);
 static gboolean      dbushelper_read_int64         (DBusMessageIter *iter, int64_t *value);
 static gboolean      dbushelper_read_string        (DBusMessageIter *iter, gchar **value);
 static gboolean      dbushelper_read_boolean       (DBusMessageIter *iter, gboolean *value);
@@ -475,6 +513,33 @@ static bool  mcetool_do_version            (const char *arg);
 static bool  mcetool_do_help               (const char *arg);
 static bool  mcetool_do_long_help          (const char *arg);
 
+/* ------------------------------------------------------------------------- *
+ * MCETOOL BATCH MODE
+ * ------------------------------------------------------------------------- */
+
+static void                  mcetool_batch_json_string   (GString *out, const char *str);
+static void                  mcetool_batch_json_value    (GString *out, DBusMessageIter *iter);
+static void                  mcetool_batch_emit          (const mcetool_batch_call_t *call, DBusMessage *rsp, const char *err);
+static mcetool_batch_call_t *mcetool_batch_call_create   (guint line, const char *name, bool method);
+static void                  mcetool_batch_call_delete_cb(void *aptr);
+static void                  mcetool_batch_call_notify_cb(DBusPendingCall *pc, void *aptr);
+static void                  mcetool_batch_wait          (guint limit);
+static bool                  mcetool_batch_append_arg    (DBusMessageIter *iter, const char *arg);
+static void                  mcetool_batch_send_call     (guint line, int argc, char **argv);
+static bool                  mcetool_batch_option_allowed(const char *arg);
+static void                  mcetool_batch_run_options   (guint line, int argc, char **argv);
+static bool                  mcetool_batch_execute       (const char *path);
+static bool                  mcetool_do_batch            (const char *args);
+
+/* ------------------------------------------------------------------------- *
+ * MCETOOL MONITOR MODE
+ * ------------------------------------------------------------------------- */
+
+static bool              mcetool_monitor_accept   (const char *member);
+static bool              mcetool_monitor_is_state (const char *member);
+static DBusHandlerResult mcetool_monitor_filter_cb(DBusConnection *con, DBusMessage *msg, void *aptr);
+static bool              mcetool_do_monitor       (const char *args);
+
 /* ------------------------------------------------------------------------- *
  * GENERIC DBUS HELPERS
  * ------------------------------------------------------------------------- */
@@ -494,7 +559,9 @@ static DBusConnection *xdbus_init(void)
                 DBusError err = DBUS_ERROR_INIT;
                 DBusBusType bus_type = DBUS_BUS_SYSTEM;
 
-                if( !(xdbus_con = dbus_bus_get(bus_type, &err)) ) {
+                /* Private connection, so that a forked child process
+                 * can make a connection of its own, see xdbus_detach() */
+                if( !(xdbus_con = dbus_bus_get_private(bus_type, &err)) ) {
                         errorf("Failed to open connection to message bus; %s: %s\n",
                                err.name, err.message);
                         dbus_error_free(&err);
@@ -523,12 +590,24 @@ static void xdbus_exit(void)
 {
         /* If there is an established D-Bus connection, unreference it */
         if (xdbus_con != NULL) {
+                dbus_connection_close(xdbus_con);
                 dbus_connection_unref(xdbus_con);
                 xdbus_con = NULL;
                 debugf("disconnected from system bus\n");
         }
 }
 
+/** Forget D-Bus connection inherited from parent process
+ *
+ * To be called in a forked child process. The connection is shared
+ * with the parent and must be left untouched; the next xdbus_init()
+ * call makes a new connection.
+ */
+static void xdbus_detach(void)
+{
+        xdbus_con = NULL;
+}
+
 /** Make sure the cached dbus connection is not used directly */
 #define xdbus_con something_that_will_generate_error
 
@@ -1028,6 +1107,26 @@ static gboolean dbushelper_read_int(DBusMessageIter *iter, gint *value)
         return *value = data, TRUE;
 }
 
+/** Helper for parsing uint32 value from D-Bus message iterator
+ *
+ * @param iter D-Bus message iterator
+ * @param value Where to store the value (not modified on failure)
+ *
+ * @return TRUE if value could be read, FALSE on failure
+ */
+static gboolean dbushelper_read_uint32(DBusMessageIter *iter, guint *value)
+{
+        dbus_uint32_t data = 0;
+
+        if( !dbushelper_require_type(iter, DBUS_TYPE_UINT32) )
+                return FALSE;
+
+        dbus_message_iter_get_basic(iter, &data);
+        dbus_message_iter_next(iter);
+
+        return *value = data, TRUE;
+}
+
 /** Helper for parsing int64 value from D-Bus message iterator
  *
  * @param iter D-Bus message iterator
@@ -3766,6 +3865,261 @@ static bool xmce_reset_settings(const char *args)
         return true;
 }
 
+/* ------------------------------------------------------------------------- *
+ * config batch
+ * ------------------------------------------------------------------------- */
+
+/** Lookup table for config batch value types */
+static const symbol_t config_batch_type_lut[] =
+{
+        { "bool",     DBUS_TYPE_BOOLEAN },
+        { "int",      DBUS_TYPE_INT32   },
+        { "double",   DBUS_TYPE_DOUBLE  },
+        { "string",   DBUS_TYPE_STRING  },
+        { "array",    DBUS_TYPE_ARRAY   },
+        { 0,          DBUS_TYPE_INVALID }
+};
+
+/** Convert config batch type name to D-Bus type
+ *
+ * @param name type name from batch file
+ *
+ * @return D-Bus type, or terminate on errors
+ */
+static int xmce_config_batch_type(const char *name)
+{
+        int type = lookup(config_batch_type_lut, name);
+        if( type == DBUS_TYPE_INVALID ) {
+                errorf("%s: not a valid value type\n", name);
+                exit(EXIT_FAILURE);
+        }
+        return type;
+}
+
+/** Append value parsed from text to D-Bus iterator
+ *
+ * @param iter write iterator
+ * @param type D-Bus type of the value
+ * @param text value from batch file
+ */
+static void xmce_config_batch_append_basic(DBusMessageIter *iter, int type,
+                                           const char *text)
+{
+        dbus_bool_t   b = FALSE;
+        dbus_int32_t  i = 0;
+        double        d = 0;
+        const void   *p = 0;
+
+        switch( type ) {
+        case DBUS_TYPE_BOOLEAN:
+                if( !strcmp(text, "true") || !strcmp(text, "1") )
+                        b = TRUE;
+                else if( !strcmp(text, "false") || !strcmp(text, "0") )
+                        b = FALSE;
+                else
+                        b = xmce_parse_enabled(text);
+                p = &b;
+                break;
+        case DBUS_TYPE_INT32:
+                i = xmce_parse_integer(text);
+                p = &i;
+                break;
+        case DBUS_TYPE_DOUBLE:
+                d = xmce_parse_double(text);
+                p = &d;
+                break;
+        case DBUS_TYPE_STRING:
+                p = &text;
+                break;
+        default:
+                errorf("%s: not a valid array element type\n",
+                       dbushelper_get_type_name(type));
+                exit(EXIT_FAILURE);
+        }
+
+        if( !dbus_message_iter_append_basic(iter, type, p) ) {
+                errorf("failed to add %s data\n",
+                       dbushelper_get_type_name(type));
+                exit(EXIT_FAILURE);
+        }
+}
+
+/** Append "key type:value" setting to dictionary
+ *
+ * Arrays are given as "key array:type:value1,value2,...".
+ *
+ * @param dict write iterator for a{sv} array
+ * @param key  setting key
+ * @param spec value specification
+ */
+static void xmce_config_batch_append(DBusMessageIter *dict, const char *key,
+                                     char *spec)
+{
+        DBusMessageIter entry, variant, array;
+
+        char *text  = strchr(spec, ':');
+        int   type  = DBUS_TYPE_INVALID;
+        int   etype = DBUS_TYPE_INVALID;
+        char  sig[3] = { 0, 0, 0 };
+
+        if( !text ) {
+                errorf("%s: expected type:value, got '%s'\n", key, spec);
+                exit(EXIT_FAILURE);
+        }
+        *text++ = 0;
+        sig[0] = type = xmce_config_batch_type(spec);
+
+        if( type == DBUS_TYPE_ARRAY ) {
+                char *elem = text;
+                if( !(text = strchr(elem, ':')) ) {
+                        errorf("%s: expected array:type:values\n", key);
+                        exit(EXIT_FAILURE);
+                }
+                *text++ = 0;
+                sig[1] = etype = xmce_config_batch_type(elem);
+        }
+
+        if( !dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY,
+                                              0, &entry) ||
+            !dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key) ||
+            !dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT,
+                                              sig, &variant) ) {
+                errorf("failed to construct request\n");
+                exit(EXIT_FAILURE);
+        }
+
+        if( type != DBUS_TYPE_ARRAY ) {
+                xmce_config_batch_append_basic(&variant, type, text);
+        }
+        else {
+                if( !dbus_message_iter_open_container(&variant,
+                                                      DBUS_TYPE_ARRAY,
+                                                      sig + 1, &array) ) {
+                        errorf("failed to construct request\n");
+                        exit(EXIT_FAILURE);
+                }
+                for( char *end; *text; text = end ) {
+                        if( (end = strchr(text, ',')) )
+                                *end++ = 0;
+                        else
+                                end = strchr(text, 0);
+                        xmce_config_batch_append_basic(&array, etype, text);
+                }
+                dbus_message_iter_close_container(&variant, &array);
+        }
+
+        if( !dbus_message_iter_close_container(&entry, &variant) ||
+            !dbus_message_iter_close_container(dict, &entry) ) {
+                errorf("failed to construct request\n");
+                exit(EXIT_FAILURE);
+        }
+}
+
+/** Apply settings from file in one transaction
+ *
+ * Each non-empty line that is not a comment should be of form
+ * "key type:value" or "key array:type:value,value,...", where
+ * type is one of: bool, int, double or string.
+ *
+ * Lines starting with '#' are comments. Everything after the type
+ * up to the end of line, minus trailing white space, is the value.
+ *
+ * @param args path to file, or "-" for stdin
+ */
+static bool xmce_set_config_batch(const char *args)
+{
+        static const char sig[] =
+                DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                DBUS_TYPE_STRING_AS_STRING
+                DBUS_TYPE_VARIANT_AS_STRING
+                DBUS_DICT_ENTRY_END_CHAR_AS_STRING;
+
+        bool         res  = false;
+        FILE        *file = 0;
+        char        *buff = 0;
+        size_t       size = 0;
+        int          line = 0;
+        int          used = 0;
+        DBusMessage *req  = 0;
+        DBusMessage *rsp  = 0;
+        gboolean     ack  = FALSE;
+
+        DBusMessageIter body, dict;
+
+        if( !strcmp(args, "-") )
+                file = stdin;
+        else if( !(file = fopen(args, "r")) ) {
+                errorf("%s: can't open: %m\n", args);
+                goto EXIT;
+        }
+
+        if( !(req = xmce_setting_request(MCE_CONFIG_SET_BATCH)) )
+                goto EXIT;
+
+        dbus_message_iter_init_append(req, &body);
+        if( !dbus_message_iter_open_container(&body, DBUS_TYPE_ARRAY,
+                                              sig, &dict) ) {
+                errorf("failed to initialize array write iterator\n");
+                goto EXIT;
+        }
+
+        while( getline(&buff, &size, file) > 0 ) {
+                ++line;
+
+                char *key = buff + strspn(buff, " \t");
+
+                /* Only whole line comments; values can contain '#' */
+                if( *key == '#' )
+                        continue;
+
+                /* Strip trailing white space, values can contain spaces */
+                char *end = strchr(key, 0);
+                while( end > key && strchr(" \t\r\n", end[-1]) )
+                        *--end = 0;
+
+                if( !*key )
+                        continue;
+
+                char *spec = key + strcspn(key, " \t=");
+                if( *spec )
+                        *spec++ = 0;
+                spec += strspn(spec, " \t=");
+
+                if( !*spec ) {
+                        errorf("%s:%d: value missing\n", args, line);
+                        exit(EXIT_FAILURE);
+                }
+
+                xmce_config_batch_append(&dict, key, spec);
+                ++used;
+        }
+
+        if( !dbus_message_iter_close_container(&body, &dict) ) {
+                errorf("failed to construct request\n");
+                goto EXIT;
+        }
+
+        if( !(rsp = dbushelper_call_method(req)) )
+                goto EXIT;
+        if( !dbushelper_init_read_iterator(rsp, &body) )
+                goto EXIT;
+        if( !dbushelper_read_boolean(&body, &ack) )
+                goto EXIT;
+
+        printf("%d settings applied\n", ack ? used : 0);
+        res = ack;
+
+EXIT:
+        if( rsp ) dbus_message_unref(rsp);
+        if( req ) dbus_message_unref(req);
+
+        if( file && file != stdin )
+                fclose(file);
+        free(buff);
+
+        return res;
+}
+
 /* ------------------------------------------------------------------------- *
  * dim timeout
  * ------------------------------------------------------------------------- */
@@ -6719,6 +7073,168 @@ EXIT:
         return true;
 }
 
+/* ------------------------------------------------------------------------- *
+ * main loop stall statistics
+ * ------------------------------------------------------------------------- */
+
+/** Get main loop latency histogram and stall offenders
+ */
+static bool xmce_get_mainloop_stats(const char *args)
+{
+        (void)args;
+
+        static const char * const bucket_name[] = {
+                "0 ... 9 ms",
+                "10 ... 99 ms",
+                "100 ... 999 ms",
+                "1 ... 9 s",
+                "10+ s",
+        };
+
+        DBusMessage *rsp  = NULL;
+        gchar       *name = 0;
+
+        DBusMessageIter body, hist, array, entry;
+
+        if( !xmce_ipc_message_reply(MCE_MAINLOOP_STATS_GET, &rsp, DBUS_TYPE_INVALID) )
+                goto EXIT;
+
+        if( !dbushelper_init_read_iterator(rsp, &body) )
+                goto EXIT;
+
+        if( !dbushelper_read_struct(&body, &hist) )
+                goto EXIT;
+
+        printf("Main loop latency:\n");
+        for( size_t i = 0; i < G_N_ELEMENTS(bucket_name); ++i ) {
+                guint count = 0;
+                if( !dbushelper_read_uint32(&hist, &count) )
+                        goto EXIT;
+                printf("  %-16s %u\n", bucket_name[i], count);
+        }
+
+        if( !dbushelper_require_array_type(&body, DBUS_TYPE_STRUCT) )
+                goto EXIT;
+
+        if( !dbushelper_read_array(&body, &array) )
+                goto EXIT;
+
+        printf("\n%-48s %8s %8s %10s\n",
+               "Stall offender", "count", "max_ms", "total_ms");
+
+        while( !dbushelper_read_at_end(&array) ) {
+                g_free(name), name = 0;
+
+                guint count    = 0;
+                guint max_ms   = 0;
+                guint total_ms = 0;
+
+                if( !dbushelper_read_struct(&array, &entry) )
+                        goto EXIT;
+
+                if( !dbushelper_read_string(&entry, &name) ||
+                    !dbushelper_read_uint32(&entry, &count) ||
+                    !dbushelper_read_uint32(&entry, &max_ms) ||
+                    !dbushelper_read_uint32(&entry, &total_ms) )
+                        goto EXIT;
+
+                printf("%-48s %8u %8u %10u\n", name, count, max_ms, total_ms);
+        }
+
+EXIT:
+        g_free(name);
+
+        if( rsp ) dbus_message_unref(rsp);
+
+        return true;
+}
+
+/* ------------------------------------------------------------------------- *
+ * wakeup source accounting
+ * ------------------------------------------------------------------------- */
+
+/** Get wakeup counts and wakelock hold times per originating subsystem
+ */
+static bool xmce_get_wakeup_report(const char *args)
+{
+        (void)args;
+
+        DBusMessage *rsp = NULL;
+        gchar       *tag = 0;
+
+        DBusMessageIter body, array, entry;
+
+        if( !xmce_ipc_message_reply(MCE_WAKEUP_REPORT_GET, &rsp, DBUS_TYPE_INVALID) )
+                goto EXIT;
+
+        if( !dbushelper_init_read_iterator(rsp, &body) )
+                goto EXIT;
+
+        if( !dbushelper_require_array_type(&body, DBUS_TYPE_STRUCT) )
+                goto EXIT;
+
+        if( !dbushelper_read_array(&body, &array) )
+                goto EXIT;
+
+        printf("%-56s %8s %8s %12s\n",
+               "Wakeup source", "wakes", "holds", "held_ms");
+
+        while( !dbushelper_read_at_end(&array) ) {
+                g_free(tag), tag = 0;
+
+                guint   wakes   = 0;
+                guint   holds   = 0;
+                int64_t held_ms = 0;
+
+                if( !dbushelper_read_struct(&array, &entry) )
+                        goto EXIT;
+
+                if( !dbushelper_read_string(&entry, &tag) ||
+                    !dbushelper_read_uint32(&entry, &wakes) ||
+                    !dbushelper_read_uint32(&entry, &holds) ||
+                    !dbushelper_read_int64(&entry, &held_ms) )
+                        goto EXIT;
+
+                printf("%-56s %8u %8u %12"PRIi64"\n",
+                       tag, wakes, holds, held_ms);
+        }
+
+EXIT:
+        g_free(tag);
+
+        if( rsp ) dbus_message_unref(rsp);
+
+        return true;
+}
+
+/* ------------------------------------------------------------------------- *
+ * datapipe graph
+ * ------------------------------------------------------------------------- */
+
+/** Get live datapipe dependency graph
+ *
+ * @param args output format: "dot" (default) or "json"
+ */
+static bool xmce_get_datapipe_graph(const char *args)
+{
+        char *graph = 0;
+
+        if( !args )
+                args = "dot";
+
+        if( !xmce_ipc_string_reply(MCE_DATAPIPE_GRAPH_GET, &graph,
+                                   DBUS_TYPE_STRING, &args,
+                                   DBUS_TYPE_INVALID) )
+                goto EXIT;
+
+        printf("%s", graph);
+
+EXIT:
+        free(graph);
+
+        return true;
+}
+
 /* ------------------------------------------------------------------------- *
  * use mouse clicks to emulate touchscreen doubletap policy
  * ------------------------------------------------------------------------- */
@@ -7242,18 +7758,49 @@ static const mce_opt_t options[] =
                         "as UNDEF.\n"
         },
         {
-                .name        = "blank-prevent",
-                .flag        = 'P',
-                .without_arg = xmce_prevent_display_blanking,
+                .name        = "get-mainloop-stats",
+                .without_arg = xmce_get_mainloop_stats,
                 .usage       =
-                        "send blank prevent request\n"
+                        "get main loop latency histogram and list of\n"
+                        "D-Bus handlers, datapipes, io monitors and timers\n"
+                        "that have stalled the main loop\n"
         },
         {
-                .name        = "cancel-blank-prevent",
-                .flag        = 'v',
-                .without_arg = xmce_allow_display_blanking,
+                .name        = "wakeup-report",
+                .without_arg = xmce_get_wakeup_report,
                 .usage       =
-                        "send cancel blank prevent request\n"
+                        "get number of wakeups, wakelock holds and cumulative\n"
+                        "wakelock hold time attributed to D-Bus clients, input\n"
+                        "devices and timers\n"
+                        "\n"
+                        "Accounting must be enabled via WakeupAccounting in\n"
+                        "the [Wakelock] group of mce configuration.\n"
+        },
+        {
+                .name        = "get-datapipe-graph",
+                .without_arg = xmce_get_datapipe_graph,
+                .with_arg    = xmce_get_datapipe_graph,
+                .values      = "dot|json",
+                .usage       =
+                        "get datapipe dependency graph with execution counts\n"
+                        "and times, and list of datapipe dependency cycles\n"
+                        "\n"
+                        "Output in dot format can be rendered with graphviz, e.g.\n"
+                        "  mcetool --get-datapipe-graph=dot | dot -Tsvg > dp.svg\n"
+        },
+        {
+                .name        = "blank-prevent",
+                .flag        = 'P',
+                .without_arg = xmce_prevent_display_blanking,
+                .usage       =
+                        "send blank prevent request\n"
+        },
+        {
+                .name        = "cancel-blank-prevent",
+                .flag        = 'v',
+                .without_arg = xmce_allow_display_blanking,
+                .usage       =
+                        "send cancel blank prevent request\n"
         },
         {
                 .name        = "set-blank-prevent-mode",
@@ -8348,6 +8895,58 @@ static const mce_opt_t options[] =
                 .usage       =
                         "output MCE status\n"
         },
+        {
+                .name        = "batch",
+                .with_arg    = mcetool_do_batch,
+                .values      = "file|-",
+                .usage       =
+                        "Execute commands read from file or stdin\n"
+                        "\n"
+                        "One command per line; empty lines and lines starting with '#'\n"
+                        "are ignored. Supported commands are:\n"
+                        "  call <method> [type:value ...]  mce method call\n"
+                        "  --<option>[=<arg>] ...           mcetool options\n"
+                        "\n"
+                        "Method calls are sent without waiting for replies to earlier\n"
+                        "calls. Options act as barriers: they are executed after all\n"
+                        "earlier calls have been replied to. Argument types are as in\n"
+                        "dbus-send: byte, boolean, int16, uint16, int32, uint32, int64,\n"
+                        "uint64, double, string and objpath.\n"
+                        "\n"
+                        "The result of each command is written to stdout as a JSON\n"
+                        "object on a line of its own, with fields: seq, line, call or\n"
+                        "option, ok, latency_us and reply or error. Output written by\n"
+                        "options is captured into field output, so stdout contains only\n"
+                        "JSON lines.\n"
+                        "\n"
+                        "Each option line is executed in a child process, so options\n"
+                        "can not affect mcetool state for later lines. Options --monitor\n"
+                        "and --batch are not allowed in a batch.\n"
+                        "\n"
+                        "The batch is executed after all other command line options\n"
+                        "have been processed.\n"
+        },
+        {
+                .name        = "monitor",
+                .without_arg = mcetool_do_monitor,
+                .with_arg    = mcetool_do_monitor,
+                .values      = "pattern[,pattern...]",
+                .usage       =
+                        "Show changes in mce state as signals arrive\n"
+                        "\n"
+                        "Subscribes to mce signals and prints one timestamped line\n"
+                        "per signal, with the signal name and its arguments. Repeated\n"
+                        "state indication signals with unchanged arguments are not\n"
+                        "shown; event signals such as button and feedback indications\n"
+                        "are always shown.\n"
+                        "\n"
+                        "The optional glob patterns select signals to show; patterns\n"
+                        "starting with '!' exclude signals. For example:\n"
+                        "  --monitor='display*,tklock*'\n"
+                        "  --monitor='!config_change_ind'\n"
+                        "\n"
+                        "Runs until interrupted.\n"
+        },
         {
                 .name        = "block",
                 .flag        = 'B',
@@ -8535,6 +9134,25 @@ static const mce_opt_t options[] =
                         "will be reset to defaults set in /etc/mce/*.conf files.\n"
                         "If no keyish is given, all settings are reset.\n"
         },
+        {
+                .name        = "set-config-batch",
+                .with_arg    = xmce_set_config_batch,
+                .values      = "file",
+                .usage       =
+                        "apply multiple settings from file in one go\n"
+                        "\n"
+                        "Each line in the file should be of form:\n"
+                        "  <key> <type>:<value>\n"
+                        "  <key> array:<type>:<value>,<value>,...\n"
+                        "Where type is one of: bool, int, double, string.\n"
+                        "Empty lines and lines starting with '#' are ignored.\n"
+                        "Values extend to the end of line, excluding trailing\n"
+                        "white space. Use '-' as file name to read from stdin.\n"
+                        "\n"
+                        "All values are validated before any of them are\n"
+                        "applied, i.e. either all or none of the settings\n"
+                        "get changed.\n"
+        },
         {
                 .name        = "set-inactivity-shutdown-delay",
                 .with_arg    = xmce_set_inactivity_shutdown_delay,
@@ -8715,6 +9333,949 @@ static __attribute__((__noreturn__)) bool mcetool_do_long_help(const char *arg)
         mcetool_do_help(arg ?: "all");
 }
 
+/* ========================================================================= *
+ * MCETOOL BATCH MODE
+ * ========================================================================= */
+
+/** Maximum number of batch method calls waiting for reply */
+#define BATCH_WINDOW_MAX 32
+
+/** Number of batch method calls waiting for reply */
+static guint mcetool_batch_inflight = 0;
+
+/** Number of failed batch commands */
+static guint mcetool_batch_failures = 0;
+
+/** Sequence number of the latest batch command */
+static guint mcetool_batch_seq = 0;
+
+/** Flag for: batch is being executed */
+static bool mcetool_batch_active = false;
+
+/** Batch file given via --batch, executed after option parsing */
+static gchar *mcetool_batch_path = 0;
+
+/** Input stream of the batch being executed */
+static FILE *mcetool_batch_input = 0;
+
+/** Exit code used by batch option child process for non-option args */
+#define MCETOOL_BATCH_EXIT_NONOPTION 2
+
+/** Append JSON string literal
+ *
+ * @param out  output buffer
+ * @param str  string to quote, or NULL
+ */
+static void mcetool_batch_json_string(GString *out, const char *str)
+{
+        g_string_append_c(out, '"');
+        for( const unsigned char *pos = (const void *)(str ?: ""); *pos; ++pos ) {
+                switch( *pos ) {
+                case '"':  g_string_append(out, "\\\""); break;
+                case '\\': g_string_append(out, "\\\\"); break;
+                case '\n': g_string_append(out, "\\n");  break;
+                case '\r': g_string_append(out, "\\r");  break;
+                case '\t': g_string_append(out, "\\t");  break;
+                default:
+                        if( *pos < 0x20 )
+                                g_string_append_printf(out, "\\u%04x", *pos);
+                        else
+                                g_string_append_c(out, (char)*pos);
+                        break;
+                }
+        }
+        g_string_append_c(out, '"');
+}
+
+/** Append D-Bus value at iterator position as JSON
+ *
+ * Arrays and structures are output as JSON arrays, except
+ * dictionaries with string keys, which are output as objects.
+ *
+ * @param out   output buffer
+ * @param iter  D-Bus message read iterator
+ */
+static void mcetool_batch_json_value(GString *out, DBusMessageIter *iter)
+{
+        DBusBasicValue  val = { .u64 = 0 };
+        DBusMessageIter sub;
+        int             type = dbus_message_iter_get_arg_type(iter);
+
+        if( dbus_type_is_basic(type) )
+                dbus_message_iter_get_basic(iter, &val);
+
+        switch( type ) {
+        case DBUS_TYPE_BYTE:
+                g_string_append_printf(out, "%u", val.byt);
+                break;
+        case DBUS_TYPE_BOOLEAN:
+                g_string_append(out, val.bool_val ? "true" : "false");
+                break;
+        case DBUS_TYPE_INT16:
+                g_string_append_printf(out, "%d", val.i16);
+                break;
+        case DBUS_TYPE_UINT16:
+                g_string_append_printf(out, "%u", val.u16);
+                break;
+        case DBUS_TYPE_INT32:
+                g_string_append_printf(out, "%" PRId32, val.i32);
+                break;
+        case DBUS_TYPE_UINT32:
+                g_string_append_printf(out, "%" PRIu32, val.u32);
+                break;
+        case DBUS_TYPE_INT64:
+                g_string_append_printf(out, "%" PRId64, val.i64);
+                break;
+        case DBUS_TYPE_UINT64:
+                g_string_append_printf(out, "%" PRIu64, val.u64);
+                break;
+        case DBUS_TYPE_UNIX_FD:
+                g_string_append_printf(out, "%d", val.fd);
+                break;
+        case DBUS_TYPE_DOUBLE:
+                if( isfinite(val.dbl) )
+                        g_string_append_printf(out, "%.17g", val.dbl);
+                else
+                        g_string_append(out, "null");
+                break;
+        case DBUS_TYPE_STRING:
+        case DBUS_TYPE_OBJECT_PATH:
+        case DBUS_TYPE_SIGNATURE:
+                mcetool_batch_json_string(out, val.str);
+                break;
+        case DBUS_TYPE_VARIANT:
+                dbus_message_iter_recurse(iter, &sub);
+                mcetool_batch_json_value(out, &sub);
+                break;
+        case DBUS_TYPE_ARRAY:
+                if( dbus_message_iter_get_element_type(iter) == DBUS_TYPE_DICT_ENTRY ) {
+                        bool first = true;
+                        g_string_append_c(out, '{');
+                        dbus_message_iter_recurse(iter, &sub);
+                        while( dbus_message_iter_get_arg_type(&sub) == DBUS_TYPE_DICT_ENTRY ) {
+                                DBusMessageIter ent;
+                                dbus_message_iter_recurse(&sub, &ent);
+                                if( !first )
+                                        g_string_append_c(out, ',');
+                                first = false;
+
+                                /* JSON keys are always strings */
+                                if( dbus_message_iter_get_arg_type(&ent) == DBUS_TYPE_STRING ) {
+                                        mcetool_batch_json_value(out, &ent);
+                                }
+                                else {
+                                        GString *key = g_string_new(0);
+                                        mcetool_batch_json_value(key, &ent);
+                                        mcetool_batch_json_string(out, key->str);
+                                        g_string_free(key, TRUE);
+                                }
+                                g_string_append_c(out, ':');
+                                dbus_message_iter_next(&ent);
+                                mcetool_batch_json_value(out, &ent);
+                                dbus_message_iter_next(&sub);
+                        }
+                        g_string_append_c(out, '}');
+                        break;
+                }
+                // fall through
+        case DBUS_TYPE_STRUCT:
+        case DBUS_TYPE_DICT_ENTRY:
+                g_string_append_c(out, '[');
+                dbus_message_iter_recurse(iter, &sub);
+                for( bool first = true;
+                     dbus_message_iter_get_arg_type(&sub) != DBUS_TYPE_INVALID;
+                     dbus_message_iter_next(&sub), first = false ) {
+                        if( !first )
+                                g_string_append_c(out, ',');
+                        mcetool_batch_json_value(out, &sub);
+                }
+                g_string_append_c(out, ']');
+                break;
+        default:
+                g_string_append(out, "null");
+                break;
+        }
+}
+
+/** Output result of a batch command as JSON line
+ *
+ * @param call     batch command details
+ * @param rsp      method return message, or NULL
+ * @param err      error description, or NULL on success
+ */
+static void mcetool_batch_emit(const mcetool_batch_call_t *call,
+                               DBusMessage *rsp, const char *err)
+{
+        GString *out = g_string_new(0);
+
+        g_string_append_printf(out, "{\"seq\":%u,\"line\":%u,",
+                               call->bc_seq, call->bc_line);
+        g_string_append(out, call->bc_method ? "\"call\":" : "\"option\":");
+        mcetool_batch_json_string(out, call->bc_name);
+        g_string_append_printf(out, ",\"ok\":%s,\"latency_us\":%" PRId64,
+                               err ? "false" : "true",
+                               g_get_monotonic_time() - call->bc_started);
+
+        if( call->bc_output ) {
+                g_string_append(out, ",\"output\":");
+                mcetool_batch_json_string(out, call->bc_output);
+        }
+
+        if( err ) {
+                g_string_append(out, ",\"error\":");
+                mcetool_batch_json_string(out, err);
+                mcetool_batch_failures += 1;
+        }
+        else if( rsp ) {
+                DBusMessageIter iter;
+                g_string_append(out, ",\"reply\":[");
+                dbus_message_iter_init(rsp, &iter);
+                for( bool first = true;
+                     dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_INVALID;
+                     dbus_message_iter_next(&iter), first = false ) {
+                        if( !first )
+                                g_string_append_c(out, ',');
+                        mcetool_batch_json_value(out, &iter);
+                }
+                g_string_append_c(out, ']');
+        }
+
+        g_string_append(out, "}\n");
+        fputs(out->str, stdout);
+        fflush(stdout);
+        g_string_free(out, TRUE);
+}
+
+/** Create batch command details
+ *
+ * @param line    input line number
+ * @param name    method call or option name
+ * @param method  true for pipelined method calls, false for options
+ *
+ * @return batch command details
+ */
+static mcetool_batch_call_t *mcetool_batch_call_create(guint line, const char *name,
+                                                       bool method)
+{
+        mcetool_batch_call_t *self = g_malloc0(sizeof *self);
+
+        self->bc_seq     = ++mcetool_batch_seq;
+        self->bc_line    = line;
+        self->bc_name    = g_strdup(name);
+        self->bc_method  = method;
+        self->bc_started = g_get_monotonic_time();
+
+        return self;
+}
+
+/** Delete batch command details
+ *
+ * @param aptr  batch command details as void pointer
+ */
+static void mcetool_batch_call_delete_cb(void *aptr)
+{
+        mcetool_batch_call_t *self = aptr;
+
+        if( self ) {
+                g_free(self->bc_name);
+                g_free(self->bc_output);
+                g_free(self);
+        }
+}
+
+/** Handle reply to pipelined batch method call
+ *
+ * @param pc    pending call object
+ * @param aptr  batch command details as void pointer
+ */
+static void mcetool_batch_call_notify_cb(DBusPendingCall *pc, void *aptr)
+{
+        mcetool_batch_call_t *call = aptr;
+        DBusMessage          *rsp  = dbus_pending_call_steal_reply(pc);
+        DBusError             err  = DBUS_ERROR_INIT;
+        gchar                *msg  = 0;
+
+        if( !rsp )
+                msg = g_strdup("no reply");
+        else if( dbus_set_error_from_message(&err, rsp) )
+                msg = g_strdup_printf("%s: %s", err.name, err.message);
+
+        mcetool_batch_emit(call, rsp, msg);
+
+        if( mcetool_batch_inflight > 0 )
+                mcetool_batch_inflight -= 1;
+
+        g_free(msg);
+        dbus_error_free(&err);
+        if( rsp )
+                dbus_message_unref(rsp);
+}
+
+/** Process replies until number of pending calls is at or below limit
+ *
+ * @param limit  number of pending calls allowed
+ */
+static void mcetool_batch_wait(guint limit)
+{
+        DBusConnection *bus = xdbus_init();
+
+        while( mcetool_batch_inflight > limit ) {
+                if( !dbus_connection_read_write_dispatch(bus, -1) ) {
+                        errorf("lost connection to system bus\n");
+                        exit(EXIT_FAILURE);
+                }
+        }
+}
+
+/** Append method call argument given in dbus-send style
+ *
+ * Supported types are: byte, boolean, int16, uint16, int32,
+ * uint32, int64, uint64, double, string and objpath.
+ *
+ * @param iter  D-Bus message write iterator
+ * @param arg   argument in TYPE:VALUE format
+ *
+ * @return true on success, false on failure
+ */
+static bool mcetool_batch_append_arg(DBusMessageIter *iter, const char *arg)
+{
+        static const symbol_t types[] = {
+                { "byte",    DBUS_TYPE_BYTE        },
+                { "boolean", DBUS_TYPE_BOOLEAN     },
+                { "int16",   DBUS_TYPE_INT16       },
+                { "uint16",  DBUS_TYPE_UINT16      },
+                { "int32",   DBUS_TYPE_INT32       },
+                { "uint32",  DBUS_TYPE_UINT32      },
+                { "int64",   DBUS_TYPE_INT64       },
+                { "uint64",  DBUS_TYPE_UINT64      },
+                { "double",  DBUS_TYPE_DOUBLE      },
+                { "string",  DBUS_TYPE_STRING      },
+                { "objpath", DBUS_TYPE_OBJECT_PATH },
+                { NULL,      -1                    }
+        };
+
+        bool            res  = false;
+        gchar          *key  = g_strdup(arg);
+        char           *str  = strchr(key, ':');
+        char           *end  = 0;
+        DBusBasicValue  val  = { .u64 = 0 };
+        int             type = -1;
+
+        if( !str )
+                goto EXIT;
+        *str++ = 0;
+
+        if( (type = lookup(types, key)) == -1 )
+                goto EXIT;
+
+        errno = 0;
+        switch( type ) {
+        case DBUS_TYPE_BYTE:    val.byt = (unsigned char)strtoul(str, &end, 0); break;
+        case DBUS_TYPE_INT16:   val.i16 = (dbus_int16_t)strtol(str, &end, 0);   break;
+        case DBUS_TYPE_UINT16:  val.u16 = (dbus_uint16_t)strtoul(str, &end, 0); break;
+        case DBUS_TYPE_INT32:   val.i32 = (dbus_int32_t)strtol(str, &end, 0);   break;
+        case DBUS_TYPE_UINT32:  val.u32 = (dbus_uint32_t)strtoul(str, &end, 0); break;
+        case DBUS_TYPE_INT64:   val.i64 = strtoll(str, &end, 0);                break;
+        case DBUS_TYPE_UINT64:  val.u64 = strtoull(str, &end, 0);               break;
+        case DBUS_TYPE_DOUBLE:  val.dbl = strtod(str, &end);                    break;
+        case DBUS_TYPE_BOOLEAN:
+                if( !strcmp(str, "true") )
+                        val.bool_val = TRUE, end = str + 4;
+                else if( !strcmp(str, "false") )
+                        val.bool_val = FALSE, end = str + 5;
+                break;
+        case DBUS_TYPE_OBJECT_PATH:
+                if( !dbus_validate_path(str, 0) )
+                        goto EXIT;
+                // fall through
+        default:
+                val.str = str;
+                break;
+        }
+
+        if( type != DBUS_TYPE_STRING && type != DBUS_TYPE_OBJECT_PATH ) {
+                if( !end || end == str || *end || errno )
+                        goto EXIT;
+        }
+
+        res = dbus_message_iter_append_basic(iter, type, &val);
+
+EXIT:
+        if( !res )
+                errorf("%s: invalid argument\n", arg);
+        g_free(key);
+
+        return res;
+}
+
+/** Send pipelined batch method call to mce
+ *
+ * @param line  input line number
+ * @param argc  number of tokens
+ * @param argv  "call", method name and arguments in TYPE:VALUE format
+ */
+static void mcetool_batch_send_call(guint line, int argc, char **argv)
+{
+        DBusConnection       *bus  = xdbus_init();
+        DBusMessage          *req  = 0;
+        DBusPendingCall      *pc   = 0;
+        mcetool_batch_call_t *call = 0;
+        DBusMessageIter       iter;
+
+        if( argc < 2 ) {
+                call = mcetool_batch_call_create(line, "", true);
+                mcetool_batch_emit(call, 0, "method name missing");
+                goto EXIT;
+        }
+
+        call = mcetool_batch_call_create(line, argv[1], true);
+
+        if( !dbus_validate_member(argv[1], 0) ) {
+                mcetool_batch_emit(call, 0, "invalid method name");
+                goto EXIT;
+        }
+
+        req = dbus_message_new_method_call(MCE_SERVICE, MCE_REQUEST_PATH,
+                                           MCE_REQUEST_IF, argv[1]);
+        dbus_message_set_auto_start(req, FALSE);
+
+        dbus_message_iter_init_append(req, &iter);
+        for( int i = 2; i < argc; ++i ) {
+                if( !mcetool_batch_append_arg(&iter, argv[i]) ) {
+                        mcetool_batch_emit(call, 0, "invalid argument");
+                        goto EXIT;
+                }
+        }
+
+        /* Keep the number of calls in flight bounded */
+        mcetool_batch_wait(BATCH_WINDOW_MAX - 1);
+
+        /* Latency is measured from the actual send */
+        call->bc_started = g_get_monotonic_time();
+
+        if( !dbus_connection_send_with_reply(bus, req, &pc, -1) || !pc ) {
+                mcetool_batch_emit(call, 0, "failed to send method call");
+                goto EXIT;
+        }
+
+        if( !dbus_pending_call_set_notify(pc, mcetool_batch_call_notify_cb,
+                                          call, mcetool_batch_call_delete_cb) ) {
+                dbus_pending_call_cancel(pc);
+                mcetool_batch_emit(call, 0, "failed to track method call");
+                goto EXIT;
+        }
+
+        call = 0;
+        mcetool_batch_inflight += 1;
+
+EXIT:
+        if( pc )
+                dbus_pending_call_unref(pc);
+        if( req )
+                dbus_message_unref(req);
+        mcetool_batch_call_delete_cb(call);
+}
+
+/** Check if mcetool option can be used in batch
+ *
+ * Options that would block indefinitely, or start another batch, are
+ * not allowed. Abbreviated long options are taken into account.
+ *
+ * @param arg  command line argument
+ *
+ * @return true if the option can be used, false otherwise
+ */
+static bool mcetool_batch_option_allowed(const char *arg)
+{
+        static const char * const denied[] = { "monitor", "batch", NULL };
+
+        if( strncmp(arg, "--", 2) )
+                return true;
+
+        arg += 2;
+        size_t len = strcspn(arg, "=");
+        if( len == 0 )
+                return true;
+
+        for( size_t i = 0; denied[i]; ++i ) {
+                if( !strncmp(denied[i], arg, len) )
+                        return false;
+        }
+        return true;
+}
+
+/** Execute mcetool command line options from batch
+ *
+ * Options are handled synchronously after replies to all
+ * previously sent method calls have been received.
+ *
+ * Option handlers terminate the process on invalid input, so the
+ * options are executed in a child process. Whatever the child writes
+ * to stdout is captured and included in the result line, so that
+ * stdout stays strictly JSON lines. As a consequence, options can not
+ * change mcetool internal state for the following batch lines.
+ *
+ * @param line  input line number
+ * @param argc  number of tokens
+ * @param argv  mcetool command line options
+ */
+static void mcetool_batch_run_options(guint line, int argc, char **argv)
+{
+        char                **args   = g_new0(char *, argc + 2);
+        mcetool_batch_call_t *call   = 0;
+        FILE                 *capt   = 0;
+        const char           *err    = 0;
+        pid_t                 pid    = -1;
+        int                   status = 0;
+
+        /* Preserve ordering of side effects */
+        mcetool_batch_wait(0);
+
+        call = mcetool_batch_call_create(line, argv[0], false);
+
+        args[0] = (char *)PROG_NAME;
+        for( int i = 0; i < argc; ++i ) {
+                if( !mcetool_batch_option_allowed(argv[i]) ) {
+                        mcetool_batch_emit(call, 0, "option not allowed in batch");
+                        goto EXIT;
+                }
+                args[i + 1] = argv[i];
+        }
+
+        if( !(capt = tmpfile()) ) {
+                mcetool_batch_emit(call, 0, "failed to capture output");
+                goto EXIT;
+        }
+
+        fflush(stdout);
+        fflush(stderr);
+
+        if( (pid = fork()) == -1 ) {
+                mcetool_batch_emit(call, 0, "failed to fork");
+                goto EXIT;
+        }
+
+        if( pid == 0 ) {
+                /* Child process: the batch input is shared with the
+                 * parent, make sure exit() does not reposition it */
+                close(fileno(mcetool_batch_input));
+
+                if( dup2(fileno(capt), STDOUT_FILENO) == -1 )
+                        _exit(EXIT_FAILURE);
+
+                xdbus_detach();
+
+                /* Force full getopt reinitialization */
+                optind = 0;
+
+                if( !mce_command_line_parse(options, argc + 1, args) )
+                        status = EXIT_FAILURE;
+                else if( optind <= argc )
+                        status = MCETOOL_BATCH_EXIT_NONOPTION;
+                else
+                        status = EXIT_SUCCESS;
+
+                fflush(stdout);
+                _exit(status);
+        }
+
+        while( waitpid(pid, &status, 0) == -1 ) {
+                if( errno != EINTR ) {
+                        status = -1;
+                        break;
+                }
+        }
+
+        if( status == -1 )
+                err = "failed to wait for option";
+        else if( WIFSIGNALED(status) )
+                err = "option terminated by signal";
+        else if( WEXITSTATUS(status) == MCETOOL_BATCH_EXIT_NONOPTION )
+                err = "unexpected non-option argument";
+        else if( WEXITSTATUS(status) != EXIT_SUCCESS )
+                err = "option failed";
+
+        /* Collect the captured output */
+        GString *out = g_string_new(0);
+        char     buf[256];
+        size_t   len;
+
+        rewind(capt);
+        while( (len = fread(buf, 1, sizeof buf, capt)) > 0 )
+                g_string_append_len(out, buf, len);
+
+        if( out->len > 0 )
+                call->bc_output = g_string_free(out, FALSE);
+        else
+                g_string_free(out, TRUE);
+
+        mcetool_batch_emit(call, 0, err);
+
+EXIT:
+        if( capt )
+                fclose(capt);
+        mcetool_batch_call_delete_cb(call);
+        g_free(args);
+}
+
+/** Execute batch file
+ *
+ * Reads commands from file, one per line. Lines starting with
+ * "call" are mce method calls that are sent without waiting for
+ * replies to earlier calls. Lines starting with "--" are normal
+ * mcetool options. Results are written to stdout as JSON lines.
+ *
+ * @param path  file name, or "-" for stdin
+ *
+ * @return true if all commands succeeded, false otherwise
+ */
+static bool mcetool_batch_execute(const char *path)
+{
+        FILE   *file = 0;
+        char   *buff = 0;
+        size_t  size = 0;
+        guint   line = 0;
+
+        mcetool_batch_active = true;
+
+        if( !strcmp(path, "-") )
+                file = stdin;
+        else if( !(file = fopen(path, "r")) ) {
+                errorf("%s: can't open: %m\n", path);
+                mcetool_batch_failures += 1;
+                goto EXIT;
+        }
+
+        mcetool_batch_input = file;
+
+        /* Connect once, the same connection is used for all method
+         * calls; options are executed in child processes that make
+         * connections of their own */
+        xdbus_init();
+
+        while( getline(&buff, &size, file) > 0 ) {
+                ++line;
+
+                char   *cmd  = buff + strspn(buff, " \t");
+                gchar **argv = 0;
+                gint    argc = 0;
+                GError *err  = 0;
+
+                cmd[strcspn(cmd, "\r\n")] = 0;
+                if( !*cmd || *cmd == '#' )
+                        continue;
+
+                if( !g_shell_parse_argv(cmd, &argc, &argv, &err) ) {
+                        mcetool_batch_call_t *call =
+                                mcetool_batch_call_create(line, cmd, false);
+                        mcetool_batch_emit(call, 0, err->message);
+                        mcetool_batch_call_delete_cb(call);
+                        g_clear_error(&err);
+                        continue;
+                }
+
+                if( !strcmp(argv[0], "call") ) {
+                        mcetool_batch_send_call(line, argc, argv);
+                }
+                else if( !strncmp(argv[0], "--", 2) ) {
+                        mcetool_batch_run_options(line, argc, argv);
+                }
+                else {
+                        mcetool_batch_call_t *call =
+                                mcetool_batch_call_create(line, argv[0], false);
+                        mcetool_batch_emit(call, 0, "unknown command");
+                        mcetool_batch_call_delete_cb(call);
+                }
+
+                g_strfreev(argv);
+        }
+
+        mcetool_batch_wait(0);
+
+EXIT:
+        if( file && file != stdin )
+                fclose(file);
+        free(buff);
+
+        mcetool_batch_input  = 0;
+        mcetool_batch_active = false;
+
+        return mcetool_batch_failures == 0;
+}
+
+/** Handle --batch command line option
+ *
+ * The batch is executed by main() after the whole command line has
+ * been parsed, so that batch options do not disturb the getopt state
+ * of the command line parsing.
+ *
+ * @param args  file name, or "-" for stdin
+ */
+static bool mcetool_do_batch(const char *args)
+{
+        if( mcetool_batch_active ) {
+                errorf("nested batches are not supported\n");
+                return false;
+        }
+
+        if( mcetool_batch_path ) {
+                errorf("only one batch can be given\n");
+                return false;
+        }
+
+        mcetool_batch_path = g_strdup(args);
+        return true;
+}
+
+/* ========================================================================= *
+ * MCETOOL MONITOR MODE
+ * ========================================================================= */
+
+/** Signal name patterns for --monitor, or NULL to show all signals */
+static gchar **mcetool_monitor_patterns = 0;
+
+/** Last shown arguments: signal name -> value representation */
+static GHashTable *mcetool_monitor_state = 0;
+
+/** Check if signal passes --monitor filter
+ *
+ * Patterns are matched with glob semantics. A signal is shown if
+ * it does not match any exclusion pattern (starting with '!'), and
+ * either matches one of the inclusion patterns or there are none.
+ *
+ * @param member  signal name
+ *
+ * @return true if the signal should be shown, false otherwise
+ */
+static bool mcetool_monitor_accept(const char *member)
+{
+        bool accept  = true;
+        bool include = false;
+
+        if( !mcetool_monitor_patterns )
+                goto EXIT;
+
+        accept = false;
+
+        for( size_t i = 0; mcetool_monitor_patterns[i]; ++i ) {
+                const char *pat = mcetool_monitor_patterns[i];
+
+                if( *pat == '!' ) {
+                        if( g_pattern_match_simple(pat + 1, member) ) {
+                                accept = false;
+                                goto EXIT;
+                        }
+                }
+                else if( *pat ) {
+                        include = true;
+                        if( g_pattern_match_simple(pat, member) )
+                                accept = true;
+                }
+        }
+
+        if( !include )
+                accept = true;
+
+EXIT:
+        return accept;
+}
+
+/** State indication signals that are subject to deduplication */
+static const char * const mcetool_monitor_state_signals[] =
+{
+        MCE_BATTERY_LEVEL_SIG,
+        MCE_BATTERY_STATE_SIG,
+        MCE_BATTERY_STATUS_SIG,
+        MCE_BLANKING_INHIBIT_SIG,
+        MCE_BLANKING_POLICY_SIG,
+        MCE_BUTTON_BACKLIGHT_SIG,
+        MCE_CALL_STATE_SIG,
+        MCE_CHARGER_STATE_SIG,
+        MCE_CHARGER_TYPE_SIG,
+        MCE_CHARGING_STATE_SIG,
+        MCE_COLOR_PROFILE_SIG,
+        MCE_CONFIG_CHANGE_SIG,
+        MCE_DISPLAY_SIG,
+        MCE_FORCED_CHARGING_SIG,
+        MCE_HARDWARE_KEYBOARD_STATE_SIG,
+        MCE_HARDWARE_MOUSE_STATE_SIG,
+        MCE_INACTIVITY_SIG,
+        MCE_LPM_UI_MODE_SIG,
+        MCE_MEMORY_LEVEL_SIG,
+        MCE_PREVENT_BLANK_ALLOWED_SIG,
+        MCE_PREVENT_BLANK_SIG,
+        MCE_PSM_STATE_SIG,
+        MCE_RADIO_STATES_SIG,
+        MCE_SLIDING_KEYBOARD_STATE_SIG,
+        MCE_TKLOCK_MODE_SIG,
+        MCE_TOUCH_INPUT_POLICY_SIG,
+        MCE_USB_CABLE_STATE_SIG,
+        MCE_VOLKEY_INPUT_POLICY_SIG,
+        NULL
+};
+
+/** Check if signal is a state indication
+ *
+ * Event signals, and signals not known to carry state, are
+ * never deduplicated.
+ *
+ * @param member  signal name
+ *
+ * @return true if the signal carries state, false otherwise
+ */
+static bool mcetool_monitor_is_state(const char *member)
+{
+        for( size_t i = 0; mcetool_monitor_state_signals[i]; ++i ) {
+                if( !strcmp(mcetool_monitor_state_signals[i], member) )
+                        return true;
+        }
+        return false;
+}
+
+/** D-Bus message filter for showing mce signals
+ *
+ * State indication signals are shown only on change: a signal that
+ * carries the same arguments as the previously shown one with the
+ * same name is skipped. For setting change signals the setting key
+ * is part of the name. Event signals are always shown.
+ *
+ * @param con   D-Bus connection (unused)
+ * @param msg   received message
+ * @param aptr  (unused)
+ *
+ * @return DBUS_HANDLER_RESULT_NOT_YET_HANDLED
+ */
+static DBusHandlerResult mcetool_monitor_filter_cb(DBusConnection *con,
+                                                   DBusMessage *msg,
+                                                   void *aptr)
+{
+        (void)con;
+        (void)aptr;
+
+        GString        *val = 0;
+        gchar          *key = 0;
+        const char     *member;
+        DBusMessageIter iter;
+
+        if( dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_SIGNAL )
+                goto EXIT;
+
+        if( !dbus_message_has_interface(msg, MCE_SIGNAL_IF) )
+                goto EXIT;
+
+        if( !(member = dbus_message_get_member(msg)) )
+                goto EXIT;
+
+        if( !mcetool_monitor_accept(member) )
+                goto EXIT;
+
+        val = g_string_new(0);
+        dbus_message_iter_init(msg, &iter);
+        for( bool first = true;
+             dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_INVALID;
+             dbus_message_iter_next(&iter), first = false ) {
+                if( !first )
+                        g_string_append_c(val, ' ');
+                mcetool_batch_json_value(val, &iter);
+        }
+
+        if( !strcmp(member, MCE_CONFIG_CHANGE_SIG) ) {
+                const char *setting = 0;
+                dbus_message_iter_init(msg, &iter);
+                if( dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_STRING )
+                        dbus_message_iter_get_basic(&iter, &setting);
+                key = g_strdup_printf("%s:%s", member, setting ?: "");
+        }
+        else {
+                key = g_strdup(member);
+        }
+
+        bool state = mcetool_monitor_is_state(member);
+
+        if( state ) {
+                const char *prev = g_hash_table_lookup(mcetool_monitor_state, key);
+                if( prev && !strcmp(prev, val->str) )
+                        goto EXIT;
+        }
+
+        gint64    now = g_get_real_time();
+        time_t    sec = (time_t)(now / G_USEC_PER_SEC);
+        struct tm tm;
+        char      stamp[32];
+
+        localtime_r(&sec, &tm);
+        strftime(stamp, sizeof stamp, "%H:%M:%S", &tm);
+
+        printf("%s.%03d %s %s\n", stamp,
+               (int)(now % G_USEC_PER_SEC / 1000), member, val->str);
+        fflush(stdout);
+
+        if( state ) {
+                g_hash_table_replace(mcetool_monitor_state, key,
+                                     g_string_free(val, FALSE));
+                key = 0, val = 0;
+        }
+
+EXIT:
+        g_free(key);
+        if( val )
+                g_string_free(val, TRUE);
+
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+/** Handle --monitor command line option
+ *
+ * Subscribes to mce signals and shows state changes until
+ * terminated or the system bus connection is lost.
+ *
+ * @param args  comma separated list of signal name patterns, or NULL
+ */
+static bool mcetool_do_monitor(const char *args)
+{
+        static const char rule[] =
+                "type='signal'"
+                ",sender='"MCE_SERVICE"'"
+                ",path='"MCE_SIGNAL_PATH"'"
+                ",interface='"MCE_SIGNAL_IF"'";
+
+        bool            res = false;
+        DBusConnection *bus = xdbus_init();
+        DBusError       err = DBUS_ERROR_INIT;
+
+        if( args && *args )
+                mcetool_monitor_patterns = g_strsplit(args, ",", 0);
+
+        mcetool_monitor_state = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                      g_free, g_free);
+
+        if( !dbus_connection_add_filter(bus, mcetool_monitor_filter_cb, 0, 0) ) {
+                errorf("failed to add message filter\n");
+                goto EXIT;
+        }
+
+        dbus_bus_add_match(bus, rule, &err);
+        if( dbus_error_is_set(&err) ) {
+                errorf("%s: %s: %s\n", rule, err.name, err.message);
+                goto EXIT;
+        }
+
+        while( dbus_connection_read_write_dispatch(bus, -1) )
+                ;
+
+        errorf("lost connection to system bus\n");
+
+EXIT:
+        dbus_error_free(&err);
+
+        dbus_connection_remove_filter(bus, mcetool_monitor_filter_cb, 0);
+
+        g_hash_table_unref(mcetool_monitor_state), mcetool_monitor_state = 0;
+        g_strfreev(mcetool_monitor_patterns), mcetool_monitor_patterns = 0;
+
+        return res;
+}
+
 /* ========================================================================= *
  * MCETOOL ENTRY POINT
  * ========================================================================= */
@@ -8742,9 +10303,14 @@ int main(int argc, char **argv)
                 mce_command_line_usage_keys(options, argv + optind);
         }
 
+        /* Batch is executed only after command line parsing is done */
+        if( mcetool_batch_path && !mcetool_batch_execute(mcetool_batch_path) )
+                goto EXIT;
+
         exitcode = EXIT_SUCCESS;
 
 EXIT:
+        g_free(mcetool_batch_path), mcetool_batch_path = 0;
         xdbus_exit();
 
         return exitcode;